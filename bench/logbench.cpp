@@ -0,0 +1,110 @@
+///////////////////////////////////////////////////////////////////////////////
+//
+//  The contents of this file are subject to the Mozilla Public License
+//  Version 1.1 (the "License"); you may not use this file except in
+//  compliance with the License. You may obtain a copy of the License at
+//  http://www.mozilla.org/MPL/
+//
+//  Software distributed under the License is distributed on an "AS IS"
+//  basis, WITHOUT WARRANTY OF ANY KIND, either express or implied. See the
+//  License for the specific language governing rights and limitations
+//  under the License.
+//
+//  The Original Code is MP4v2.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+// Measures the per-sample cost of MP4WriteSample() and MP4ReadSample() with
+// logging below the runtime level.  Build the library once with the default
+// MP4V2_MAX_LOG_LEVEL and once with e.g. -DMP4V2_MAX_LOG_LEVEL=2 to compare
+// runtime-disabled against compiled-out verbose logging.
+//
+// The file is written once and read 5 times; the best read is reported.
+
+#include <mp4v2/mp4v2.h>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+
+using namespace std::chrono;
+
+static double
+nsPerSample( steady_clock::time_point start, uint32_t numSamples )
+{
+    return double( duration_cast<nanoseconds>( steady_clock::now() - start ).count() ) / numSamples;
+}
+
+int
+main( int argc, char** argv )
+{
+    const char* fileName   = argc > 1 ? argv[1] : "logbench.mp4";
+    uint32_t    numSamples = argc > 2 ? strtoul( argv[2], NULL, 10 ) : 200000;
+    int         passes     = 5;
+
+    if( numSamples == 0 ) {
+        fprintf( stderr, "usage: %s [file] [samples]\n", argv[0] );
+        return 1;
+    }
+
+    uint8_t sample[64];
+    for( uint32_t i = 0; i < sizeof(sample); i++ )
+        sample[i] = (uint8_t)i;
+
+    // write
+    steady_clock::time_point start = steady_clock::now();
+
+    MP4FileHandle file = MP4Create( fileName );
+    if( file == MP4_INVALID_FILE_HANDLE ) {
+        fprintf( stderr, "%s: can't create %s\n", argv[0], fileName );
+        return 1;
+    }
+
+    MP4SetTimeScale( file, 90000 );
+    MP4TrackId track = MP4AddVideoTrack( file, 90000, 3000, 320, 240 );
+
+    for( uint32_t i = 0; i < numSamples; i++ )
+        MP4WriteSample( file, track, sample, sizeof(sample) - (i % 8), MP4_INVALID_DURATION, 0, (i % 30) == 0 );
+
+    MP4Close( file );
+    double writeNs = nsPerSample( start, numSamples );
+
+    // read, repeated to get a stable figure
+    file = MP4Read( fileName );
+    if( file == MP4_INVALID_FILE_HANDLE ) {
+        fprintf( stderr, "%s: can't read %s\n", argv[0], fileName );
+        return 1;
+    }
+    track = MP4FindTrackId( file, 0 );
+
+    double readNs = 0;
+    for( int pass = 0; pass < passes; pass++ ) {
+        start = steady_clock::now();
+        for( MP4SampleId id = 1; id <= numSamples; id++ ) {
+            uint8_t*     bytes    = sample;
+            uint32_t     numBytes = sizeof(sample);
+            MP4Timestamp startTime;
+            MP4Duration  duration;
+            MP4Duration  renderingOffset;
+            bool         isSync;
+
+            if( !MP4ReadSample( file, track, id, &bytes, &numBytes,
+                                &startTime, &duration, &renderingOffset, &isSync ))
+            {
+                fprintf( stderr, "%s: read of sample %u failed\n", argv[0], id );
+                return 1;
+            }
+        }
+        double ns = nsPerSample( start, numSamples );
+        if( pass == 0 || ns < readNs )
+            readNs = ns;
+    }
+
+    MP4Close( file );
+    remove( fileName );
+
+    printf( "samples          %u\n", numSamples );
+    printf( "write ns/sample  %.1f\n", writeNs );
+    printf( "read  ns/sample  %.1f (best of %d)\n", readNs, passes );
+
+    return 0;
+}
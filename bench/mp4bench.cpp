@@ -0,0 +1,516 @@
+///////////////////////////////////////////////////////////////////////////////
+//
+//  The contents of this file are subject to the Mozilla Public License
+//  Version 1.1 (the "License"); you may not use this file except in
+//  compliance with the License. You may obtain a copy of the License at
+//  http://www.mozilla.org/MPL/
+//
+//  Software distributed under the License is distributed on an "AS IS"
+//  basis, WITHOUT WARRANTY OF ANY KIND, either express or implied. See the
+//  License for the specific language governing rights and limitations
+//  under the License.
+//
+//  The Original Code is MP4v2.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+// Times the main library paths on files synthesized through the public API:
+// writing, hinting, opening, sequential and random sample access, hint
+// packet reading, optimizing and iTunes metadata storage. The generated
+// content is deterministic so runs are comparable over time; no sample media
+// is needed. Results are printed to stdout as JSON, and also written to a
+// file if one is named.
+//
+// The media file holds a variable frame rate H.264 track with composition
+// offsets, an AAC track written with one sample per chunk and RTP hint tracks
+// for both. The tag file carries a large ilst with several cover art images.
+
+#include <mp4v2/mp4v2.h>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+using namespace std;
+using namespace std::chrono;
+
+///////////////////////////////////////////////////////////////////////////////
+
+namespace {
+
+struct Result {
+    string   name;
+    int      iterations;
+    uint64_t items;
+    double   bestMs;
+    double   meanMs;
+};
+
+struct Stats {
+    uint32_t videoSamples;
+    uint32_t audioSamples;
+};
+
+const uint32_t VIDEO_TIMESCALE = 90000;
+const uint32_t AUDIO_TIMESCALE = 48000;
+const uint32_t AUDIO_DURATION  = 1024;
+const uint32_t ART_SIZE        = 512 * 1024;
+const uint32_t ART_COUNT       = 4;
+
+string          program;
+vector<Result>  results;
+vector<uint8_t> payload;
+
+// deterministic generator so every run synthesizes identical files
+uint32_t seed;
+
+uint32_t
+random32()
+{
+    seed = seed * 1103515245 + 12345;
+    return seed >> 8;
+}
+
+void
+fail( const string& what )
+{
+    fprintf( stderr, "%s: %s failed\n", program.c_str(), what.c_str() );
+    exit( 1 );
+}
+
+uint64_t
+fileSize( const string& name )
+{
+    FILE* file = fopen( name.c_str(), "rb" );
+    if( !file )
+        return 0;
+    fseek( file, 0, SEEK_END );
+    long size = ftell( file );
+    fclose( file );
+    return size < 0 ? 0 : (uint64_t)size;
+}
+
+// Runs body iterations times, calling setup untimed before each run.
+template <typename Setup, typename Body>
+void
+measure( const string& name, int iterations, uint64_t items, Setup setup, Body body )
+{
+    Result r;
+    r.name       = name;
+    r.iterations = iterations;
+    r.items      = items;
+    r.bestMs     = 0;
+    r.meanMs     = 0;
+
+    for( int i = 0; i < iterations; i++ ) {
+        setup();
+        steady_clock::time_point start = steady_clock::now();
+        if( !body() )
+            fail( name );
+        double ms = duration_cast<nanoseconds>( steady_clock::now() - start ).count() / 1e6;
+        if( i == 0 || ms < r.bestMs )
+            r.bestMs = ms;
+        r.meanMs += ms / iterations;
+    }
+
+    results.push_back( r );
+}
+
+template <typename Body>
+void
+measure( const string& name, int iterations, uint64_t items, Body body )
+{
+    measure( name, iterations, items, []{}, body );
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+// Writes the media file; video runs at a variable frame rate with B-frame
+// style composition offsets and audio gets a chunk per sample.
+bool
+writeMedia( const string& name, uint32_t scale, Stats& stats )
+{
+    MP4FileHandle file = MP4Create( name.c_str() );
+    if( file == MP4_INVALID_FILE_HANDLE )
+        return false;
+
+    MP4SetTimeScale( file, 1000 );
+
+    MP4TrackId video = MP4AddH264VideoTrack( file, VIDEO_TIMESCALE, MP4_INVALID_DURATION,
+                                             1280, 720, 77, 0x40, 31, 3 );
+    const uint8_t sps[] = { 0x67, 0x4d, 0x40, 0x1f, 0xda, 0x01, 0x40, 0x16, 0xe8 };
+    const uint8_t pps[] = { 0x68, 0xce, 0x3c, 0x80 };
+    MP4AddH264SequenceParameterSet( file, video, sps, sizeof(sps) );
+    MP4AddH264PictureParameterSet( file, video, pps, sizeof(pps) );
+
+    MP4TrackId audio = MP4AddAudioTrack( file, AUDIO_TIMESCALE, AUDIO_DURATION, MP4_MPEG4_AUDIO_TYPE );
+    const uint8_t config[] = { 0x11, 0x90 };
+    MP4SetTrackESConfiguration( file, audio, config, sizeof(config) );
+    MP4SetTrackDurationPerChunk( file, audio, AUDIO_DURATION );
+
+    if( video == MP4_INVALID_TRACK_ID || audio == MP4_INVALID_TRACK_ID ) {
+        MP4Close( file );
+        return false;
+    }
+
+    // frame durations cycle through 24, 30 and 60 fps sections
+    static const MP4Duration durations[] = { 3750, 3000, 1500 };
+
+    seed = 1;
+    stats.videoSamples = 18000 * scale;
+    stats.audioSamples = 0;
+
+    uint8_t      sample[64 * 1024];
+    MP4Timestamp videoTime = 0;
+    MP4Timestamp audioTime = 0;
+    bool         ok        = true;
+
+    for( uint32_t i = 0; i < stats.videoSamples && ok; i++ ) {
+        bool     isSync = ( i % 60 ) == 0;
+        uint32_t size   = isSync ? 20000 + random32() % 20000 : 200 + random32() % 3000;
+
+        // a single length prefixed NAL unit
+        uint32_t nalSize = size - 4;
+        sample[0] = (uint8_t)( nalSize >> 24 );
+        sample[1] = (uint8_t)( nalSize >> 16 );
+        sample[2] = (uint8_t)( nalSize >> 8 );
+        sample[3] = (uint8_t)nalSize;
+        sample[4] = isSync ? 0x65 : 0x41;
+        memcpy( &sample[5], &payload[random32() % 1024], size - 5 );
+
+        MP4Duration duration = durations[( i / 600 ) % 3];
+        MP4Duration offset   = isSync ? 0 : ( i % 3 ) * duration;
+        ok = MP4WriteSample( file, video, sample, size, duration, offset, isSync );
+        videoTime += duration;
+
+        // keep audio interleaved with video
+        while( ok && audioTime * VIDEO_TIMESCALE < videoTime * AUDIO_TIMESCALE ) {
+            uint32_t auSize = 200 + random32() % 400;
+            ok = MP4WriteSample( file, audio, &payload[random32() % 1024], auSize );
+            audioTime += AUDIO_DURATION;
+            stats.audioSamples++;
+        }
+    }
+
+    MP4Close( file );
+    return ok;
+}
+
+bool
+hintMedia( const string& name )
+{
+    MP4FileHandle file = MP4Modify( name.c_str() );
+    if( file == MP4_INVALID_FILE_HANDLE )
+        return false;
+
+    bool ok = MP4HintTrack( file, 1 ) != MP4_INVALID_TRACK_ID
+           && MP4HintTrack( file, 2 ) != MP4_INVALID_TRACK_ID;
+
+    MP4Close( file );
+    return ok;
+}
+
+bool
+readAll( const string& name )
+{
+    MP4FileHandle file = MP4Read( name.c_str() );
+    if( file == MP4_INVALID_FILE_HANDLE )
+        return false;
+
+    vector<uint8_t> buffer( 64 * 1024 );
+    bool ok = true;
+
+    uint32_t numTracks = MP4GetNumberOfTracks( file );
+    for( uint32_t i = 0; i < numTracks && ok; i++ ) {
+        MP4TrackId track      = MP4FindTrackId( file, i );
+        uint32_t   numSamples = MP4GetTrackNumberOfSamples( file, track );
+
+        for( MP4SampleId id = 1; id <= numSamples && ok; id++ ) {
+            uint8_t*     bytes    = &buffer[0];
+            uint32_t     numBytes = buffer.size();
+            MP4Timestamp startTime;
+            MP4Duration  duration;
+            MP4Duration  renderingOffset;
+            bool         isSync;
+
+            ok = MP4ReadSample( file, track, id, &bytes, &numBytes,
+                                &startTime, &duration, &renderingOffset, &isSync );
+        }
+    }
+
+    MP4Close( file );
+    return ok;
+}
+
+// Seeks to random decoding times, reading the sync sample at or after each
+// the way MP4GetSampleIdFromTime() reports it.
+bool
+seekRandom( const string& name, uint32_t seeks )
+{
+    MP4FileHandle file = MP4Read( name.c_str() );
+    if( file == MP4_INVALID_FILE_HANDLE )
+        return false;
+
+    vector<uint8_t> buffer( 64 * 1024 );
+    bool ok = true;
+
+    seed = 2;
+    for( MP4TrackId track = 1; track <= 2 && ok; track++ ) {
+        MP4Duration duration = MP4GetTrackDuration( file, track );
+
+        for( uint32_t i = 0; i < seeks && ok; i++ ) {
+            MP4Timestamp when = ( (uint64_t)random32() << 24 | random32() ) % duration;
+            MP4SampleId  id   = MP4GetSampleIdFromTime( file, track, when, true );
+
+            // there is no later sync sample near the end of the track
+            if( id == MP4_INVALID_SAMPLE_ID )
+                id = MP4GetSampleIdFromTime( file, track, when, false );
+
+            uint8_t* bytes    = &buffer[0];
+            uint32_t numBytes = buffer.size();
+            ok = id != MP4_INVALID_SAMPLE_ID
+              && MP4ReadSample( file, track, id, &bytes, &numBytes );
+        }
+    }
+
+    MP4Close( file );
+    return ok;
+}
+
+bool
+readHints( const string& name, uint64_t& packets )
+{
+    MP4FileHandle file = MP4Read( name.c_str() );
+    if( file == MP4_INVALID_FILE_HANDLE )
+        return false;
+
+    bool ok = true;
+    packets = 0;
+
+    uint32_t numTracks = MP4GetNumberOfTracks( file, MP4_HINT_TRACK_TYPE );
+    for( uint32_t i = 0; i < numTracks && ok; i++ ) {
+        MP4TrackId track    = MP4FindTrackId( file, i, MP4_HINT_TRACK_TYPE );
+        uint32_t   numHints = MP4GetTrackNumberOfSamples( file, track );
+
+        for( MP4SampleId id = 1; id <= numHints && ok; id++ ) {
+            uint16_t numPackets;
+            ok = MP4ReadRtpHint( file, track, id, &numPackets );
+
+            for( uint16_t p = 0; p < numPackets && ok; p++ ) {
+                uint8_t  packet[2048];
+                uint8_t* bytes    = packet;
+                uint32_t numBytes = sizeof(packet);
+                ok = MP4ReadRtpPacket( file, track, p, &bytes, &numBytes, 0, true, true );
+                packets++;
+            }
+        }
+    }
+
+    MP4Close( file );
+    return ok;
+}
+
+bool
+writeTagFile( const string& name )
+{
+    MP4FileHandle file = MP4Create( name.c_str() );
+    if( file == MP4_INVALID_FILE_HANDLE )
+        return false;
+
+    MP4SetTimeScale( file, 1000 );
+    MP4TrackId audio = MP4AddAudioTrack( file, AUDIO_TIMESCALE, AUDIO_DURATION, MP4_MPEG4_AUDIO_TYPE );
+    const uint8_t config[] = { 0x11, 0x90 };
+    MP4SetTrackESConfiguration( file, audio, config, sizeof(config) );
+
+    seed = 3;
+    for( uint32_t i = 0; i < 2000; i++ )
+        MP4WriteSample( file, audio, &payload[random32() % 1024], 200 + random32() % 400 );
+
+    MP4Close( file );
+    return true;
+}
+
+// Replaces the metadata with a large ilst: text items, a long lyrics item
+// and ART_COUNT cover images.
+bool
+storeTags( const string& name, const vector<uint8_t>& art, uint32_t generation )
+{
+    MP4FileHandle file = MP4Modify( name.c_str() );
+    if( file == MP4_INVALID_FILE_HANDLE )
+        return false;
+
+    const MP4Tags* tags = MP4TagsAlloc();
+    MP4TagsFetch( tags, file );
+
+    char title[64];
+    snprintf( title, sizeof(title), "Benchmark title %u", generation );
+    string lyrics;
+    for( uint32_t i = 0; i < 500; i++ )
+        lyrics += "the quick brown fox jumps over the lazy dog\n";
+
+    MP4TagsSetName( tags, title );
+    MP4TagsSetArtist( tags, "Benchmark Artist" );
+    MP4TagsSetAlbumArtist( tags, "Benchmark Album Artist" );
+    MP4TagsSetAlbum( tags, "Benchmark Album" );
+    MP4TagsSetComposer( tags, "Benchmark Composer" );
+    MP4TagsSetComments( tags, "Synthesized by mp4bench" );
+    MP4TagsSetGenre( tags, "Benchmark" );
+    MP4TagsSetReleaseDate( tags, "2010-01-01" );
+    MP4TagsSetLyrics( tags, lyrics.c_str() );
+    MP4TagsSetEncodingTool( tags, MP4V2_PROJECT_name_formal );
+
+    while( tags->artworkCount )
+        MP4TagsRemoveArtwork( tags, 0 );
+
+    for( uint32_t i = 0; i < ART_COUNT; i++ ) {
+        MP4TagArtwork artwork;
+        artwork.data = (void*)&art[i * ART_SIZE];
+        artwork.size = ART_SIZE;
+        artwork.type = MP4_ART_JPEG;
+        MP4TagsAddArtwork( tags, &artwork );
+    }
+
+    bool ok = MP4TagsStore( tags, file );
+    MP4TagsFree( tags );
+    MP4Close( file );
+    return ok;
+}
+
+bool
+fetchTags( const string& name )
+{
+    MP4FileHandle file = MP4Read( name.c_str() );
+    if( file == MP4_INVALID_FILE_HANDLE )
+        return false;
+
+    const MP4Tags* tags = MP4TagsAlloc();
+    bool ok = MP4TagsFetch( tags, file ) && tags->artworkCount == ART_COUNT;
+    MP4TagsFree( tags );
+    MP4Close( file );
+    return ok;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+void
+printJson( FILE* out, uint32_t scale, const Stats& stats, uint64_t mediaBytes, uint64_t tagBytes )
+{
+    fprintf( out, "{\n" );
+    fprintf( out, "  \"benchmark\": \"mp4bench\",\n" );
+    fprintf( out, "  \"version\": \"%s\",\n", MP4V2_PROJECT_version );
+    fprintf( out, "  \"scale\": %u,\n", scale );
+    fprintf( out, "  \"files\": {\n" );
+    fprintf( out, "    \"media\": { \"bytes\": %llu, \"videoSamples\": %u, \"audioSamples\": %u },\n",
+            (unsigned long long)mediaBytes, stats.videoSamples, stats.audioSamples );
+    fprintf( out, "    \"tags\": { \"bytes\": %llu, \"artwork\": %u }\n",
+            (unsigned long long)tagBytes, ART_COUNT );
+    fprintf( out, "  },\n" );
+    fprintf( out, "  \"results\": [\n" );
+    for( size_t i = 0; i < results.size(); i++ ) {
+        const Result& r = results[i];
+        fprintf( out, "    { \"name\": \"%s\", \"iterations\": %d, \"items\": %llu, "
+                "\"bestMs\": %.3f, \"meanMs\": %.3f, \"bestNsPerItem\": %.1f }%s\n",
+                r.name.c_str(), r.iterations, (unsigned long long)r.items,
+                r.bestMs, r.meanMs, r.items ? r.bestMs * 1e6 / r.items : 0.0,
+                i + 1 < results.size() ? "," : "" );
+    }
+    fprintf( out, "  ]\n" );
+    fprintf( out, "}\n" );
+}
+
+} // namespace
+
+///////////////////////////////////////////////////////////////////////////////
+
+int
+main( int argc, char** argv )
+{
+    program = argv[0];
+    string   dir   = argc > 1 ? argv[1] : ".";
+    uint32_t scale = argc > 2 ? strtoul( argv[2], NULL, 10 ) : 1;
+    const char* output = argc > 3 ? argv[3] : NULL;
+
+    if( scale == 0 ) {
+        fprintf( stderr, "usage: %s [workdir] [scale] [output.json]\n", argv[0] );
+        return 1;
+    }
+
+    MP4LogSetLevel( MP4_LOG_NONE );
+
+    const string media     = dir + "/mp4bench-media.mp4";
+    const string hinted    = dir + "/mp4bench-hinted.mp4";
+    const string optimized = dir + "/mp4bench-optimized.mp4";
+    const string tagged    = dir + "/mp4bench-tags.m4a";
+
+    payload.resize( 64 * 1024 + 1024 );
+    seed = 4;
+    for( size_t i = 0; i < payload.size(); i++ )
+        payload[i] = (uint8_t)random32();
+
+    // cover art content only has to be incompressible, not a real picture
+    vector<uint8_t> art( ART_SIZE * ART_COUNT );
+    seed = 5;
+    for( size_t i = 0; i < art.size(); i++ )
+        art[i] = (uint8_t)random32();
+
+    Stats stats;
+
+    measure( "write", 3, 0, [&]{ return writeMedia( media, scale, stats ); } );
+    results.back().items = stats.videoSamples + stats.audioSamples;
+
+    measure( "hint", 3, stats.videoSamples + stats.audioSamples,
+             [&]{ writeMedia( hinted, scale, stats ); },
+             [&]{ return hintMedia( hinted ); } );
+
+    uint32_t totalSamples = 0;
+    MP4FileHandle file = MP4Read( hinted.c_str() );
+    if( file == MP4_INVALID_FILE_HANDLE )
+        fail( "open" );
+    for( uint32_t i = 0; i < MP4GetNumberOfTracks( file ); i++ )
+        totalSamples += MP4GetTrackNumberOfSamples( file, MP4FindTrackId( file, i ));
+    MP4Close( file );
+
+    measure( "open", 10, 1, [&]{
+        MP4FileHandle handle = MP4Read( hinted.c_str() );
+        if( handle == MP4_INVALID_FILE_HANDLE )
+            return false;
+        MP4Close( handle );
+        return true;
+    });
+
+    measure( "readSequential", 3, totalSamples, [&]{ return readAll( hinted ); } );
+
+    const uint32_t seeks = 5000;
+    measure( "seekRandom", 3, 2 * seeks, [&]{ return seekRandom( hinted, seeks ); } );
+
+    uint64_t packets = 0;
+    readHints( hinted, packets );
+    measure( "readHints", 3, packets, [&]{ return readHints( hinted, packets ); } );
+
+    measure( "optimize", 3, totalSamples, [&]{ return MP4Optimize( hinted.c_str(), optimized.c_str() ); } );
+
+    if( !writeTagFile( tagged ))
+        fail( "tag file" );
+
+    uint32_t generation = 0;
+    measure( "tagStore", 5, 1, [&]{ return storeTags( tagged, art, generation++ ); } );
+    measure( "tagFetch", 10, 1, [&]{ return fetchTags( tagged ); } );
+
+    printJson( stdout, scale, stats, fileSize( hinted ), fileSize( tagged ));
+    if( output ) {
+        FILE* out = fopen( output, "w" );
+        if( !out )
+            fail( "writing results" );
+        printJson( out, scale, stats, fileSize( hinted ), fileSize( tagged ));
+        fclose( out );
+    }
+
+    remove( media.c_str() );
+    remove( hinted.c_str() );
+    remove( optimized.c_str() );
+    remove( tagged.c_str() );
+
+    return 0;
+}
@@ -38,6 +38,10 @@
 #define MP4_CREATE_64BIT_TIME 0x02
 /** Bit: do not recompute avg/max bitrates on file close. @note See http://code.google.com/p/mp4v2/issues/detail?id=66 */
 #define MP4_CLOSE_DO_NOT_COMPUTE_BITRATE 0x01
+/** Bit: write every table entry and all bytes in MP4DumpJson(). */
+#define MP4_DUMP_JSON_FULL 0x01
+/** Bit: include implicit properties in MP4DumpJson(). */
+#define MP4_DUMP_JSON_IMPLICITS 0x02
 
 /** Enumeration of file modes for custom file provider. */
 typedef enum MP4FileMode_e
@@ -270,6 +274,64 @@ bool MP4Dump(
     MP4FileHandle hFile,
     bool          dumpImplicits DEFAULT(0) );
 
+/** Dump mp4 file structure as JSON.
+ *
+ *  Writes a single JSON object describing the atom tree: each atom's type,
+ *  file offset, size, properties and children. Unlike MP4Dump() the output
+ *  does not go through the log and is streamed in large blocks, so it stays
+ *  fast on files with very large sample tables.
+ *
+ *  By default each table is summarized: its entry count, and for every
+ *  column the min/max of integer values plus the first and last
+ *  <b>tableEntries</b> values. Byte values are cut to their first 128 bytes.
+ *  With #MP4_DUMP_JSON_FULL tables are written in full as one array per
+ *  column and byte values are never cut.
+ *
+ *  @param hFile handle of file to dump.
+ *  @param fileName pathname of the file to write, or NULL for stdout.
+ *  @param flags bitmask of MP4_DUMP_JSON_* values, or 0.
+ *  @param tableEntries number of entries shown at each end of a
+ *      summarized table.
+ *
+ *  @return <b>true</b> on success, <b>false</b> on failure.
+ */
+MP4V2_EXPORT
+bool MP4DumpJson(
+    MP4FileHandle hFile,
+    const char*   fileName DEFAULT(NULL),
+    uint32_t      flags DEFAULT(0),
+    uint32_t      tableEntries DEFAULT(3) );
+
+/** Function receiving the output of MP4DumpJsonCallback().
+ *
+ *  Called with consecutive blocks of JSON text, which is not
+ *  NUL-terminated. Must return 0 upon success or a non-zero value to
+ *  indicate failure, which ends the dump.
+ */
+typedef int (*MP4DumpJsonWriteFunc)( void* handle, const char* text, uint32_t size );
+
+/** Dump mp4 file structure as JSON to a caller-supplied function.
+ *
+ *  Same as MP4DumpJson() but the output is passed to <b>write</b>
+ *  instead of being written to a file or stdout.
+ *
+ *  @param hFile handle of file to dump.
+ *  @param write function receiving the output.
+ *  @param handle value passed on to <b>write</b>.
+ *  @param flags bitmask of MP4_DUMP_JSON_* values, or 0.
+ *  @param tableEntries number of entries shown at each end of a
+ *      summarized table.
+ *
+ *  @return <b>true</b> on success, <b>false</b> on failure.
+ */
+MP4V2_EXPORT
+bool MP4DumpJsonCallback(
+    MP4FileHandle        hFile,
+    MP4DumpJsonWriteFunc write,
+    void*                handle,
+    uint32_t             flags DEFAULT(0),
+    uint32_t             tableEntries DEFAULT(3) );
+
 /** Return a textual summary of an mp4 file.
  *
  *  MP4FileInfo provides a string that contains a textual summary of the
@@ -312,6 +374,79 @@ char* MP4FileInfo(
     const char* fileName,
     MP4TrackId  trackId DEFAULT(MP4_INVALID_TRACK_ID) );
 
+/** Maximum number of tracks described by MP4ProbeInfo. */
+#define MP4_PROBE_MAX_TRACKS 16
+
+/** Per-track summary filled in by MP4Probe(). */
+typedef struct MP4ProbeTrack_s
+{
+    MP4TrackId  trackId;     /**< track id from <b>tkhd</b> */
+    char        type[5];     /**< handler type from <b>hdlr</b>, e.g. "vide" or "soun" */
+    char        codec[5];    /**< type of first sample description, e.g. "avc1" or "mp4a" */
+    uint32_t    timeScale;   /**< media timescale from <b>mdhd</b> */
+    MP4Duration duration;    /**< media duration from <b>mdhd</b> in timeScale units */
+    uint16_t    width;       /**< width of visual sample descriptions, otherwise 0 */
+    uint16_t    height;      /**< height of visual sample descriptions, otherwise 0 */
+    uint32_t    sampleRate;  /**< sample rate in Hz of audio sample descriptions, otherwise 0 */
+    uint16_t    channels;    /**< channel count of audio sample descriptions, otherwise 0 */
+} MP4ProbeTrack;
+
+/** File summary filled in by MP4Probe(). */
+typedef struct MP4ProbeInfo_s
+{
+    char          majorBrand[5];  /**< major brand from <b>ftyp</b>, or empty */
+    uint32_t      minorVersion;   /**< minor version from <b>ftyp</b> */
+    uint32_t      timeScale;      /**< movie timescale from <b>mvhd</b> */
+    MP4Duration   duration;       /**< movie duration from <b>mvhd</b> in timeScale units */
+    uint32_t      numTracks;      /**< number of tracks in the file */
+    MP4ProbeTrack tracks[MP4_PROBE_MAX_TRACKS]; /**< the first (up to #MP4_PROBE_MAX_TRACKS) tracks */
+} MP4ProbeInfo;
+
+/** Probe an mp4 file for a summary of its contents.
+ *
+ *  MP4Probe is a lightweight alternative to MP4Read() for callers that only
+ *  need to classify a file. Top-level boxes are walked by size only and
+ *  only the header boxes (<b>ftyp</b>, <b>mvhd</b>, <b>tkhd</b>,
+ *  <b>mdhd</b>, <b>hdlr</b> and <b>stsd</b>) are read; no atom tree or
+ *  tracks are built and the sample tables are never loaded.
+ *
+ *  @param fileName pathname of the file to be probed.
+ *      On Windows, this should be a UTF-8 encoded string.
+ *      On other platforms, it should be an 8-bit encoding that is
+ *      appropriate for the platform, locale, file system, etc.
+ *      (prefer to use UTF-8 when possible).
+ *  @param info structure receiving the summary. It is cleared first, so
+ *      it holds zeros if the file cannot be opened.
+ *
+ *  @return <b>true</b> if a <b>moov</b> box was found, <b>false</b> otherwise.
+ *
+ *  @see MP4ProbeCallbacks()
+ */
+MP4V2_EXPORT
+bool MP4Probe(
+    const char*   fileName,
+    MP4ProbeInfo* info );
+
+/** Probe an mp4 file for a summary of its contents using an I/O callbacks
+ *  structure.
+ *
+ *  @param callbacks custom implementation of I/O operations.
+ *      The size, seek and read callbacks must be implemented.
+ *  @param handle a custom handle that will be passed as the first argument to
+ *      any callback function call.
+ *  @param info structure receiving the summary. It is cleared first, so
+ *      it holds zeros if the file cannot be opened.
+ *
+ *  @return <b>true</b> if a <b>moov</b> box was found, <b>false</b> otherwise.
+ *
+ *  @see MP4Probe()
+ */
+MP4V2_EXPORT
+bool MP4ProbeCallbacks(
+    const MP4IOCallbacks* callbacks,
+    void*                 handle,
+    MP4ProbeInfo*         info );
+
 /** Accessor for the filename associated with a file handle
  *
  *  @param hFile a file handle
@@ -465,6 +600,109 @@ bool MP4Optimize(
     const char* fileName,
     const char* newFileName DEFAULT(NULL) );
 
+/** Remux tracks of an mp4 file into a new, optimized file.
+ *
+ *  MP4Remux copies the selected tracks of an open mp4 file, optionally
+ *  restricted to a time range, into a new file in a single pass. The new
+ *  file is written with its control information ahead of the media and
+ *  with the samples of all tracks interleaved in time order, i.e. with the
+ *  same layout MP4Optimize() produces, without requiring the intermediate
+ *  per-track copies that MP4CopyTrack() followed by MP4Optimize() would.
+ *
+ *  When a time range is given, each track starts at the sync sample at or
+ *  before <b>startTime</b>, and an edit list is added to skip the samples
+ *  before <b>startTime</b> on playback. Edit lists of the source tracks are
+ *  not applied, and file level metadata is not copied. Tracks MP4CloneTrack()
+ *  cannot recreate, such as text, chapter and subtitle tracks, have their
+ *  sample descriptions copied unchanged, and chapter track references are
+ *  kept between the selected tracks. Hint tracks can only be remuxed whole,
+ *  and together with their reference tracks.
+ *
+ *  @param hFile handle of the source file, opened with MP4Read().
+ *  @param newFileName pathname of the new file.
+ *      On Windows, this should be a UTF-8 encoded string.
+ *      On other platforms, it should be an 8-bit encoding that is
+ *      appropriate for the platform, locale, file system, etc.
+ *      (prefer to use UTF-8 when possible).
+ *  @param trackIds array of the tracks to copy, or NULL for all tracks.
+ *  @param numTracks number of entries in <b>trackIds</b>.
+ *  @param startTime start of the range to copy, in the movie time scale.
+ *  @param duration length of the range to copy, in the movie time scale.
+ *      #MP4_INVALID_DURATION copies up to the end of each track.
+ *  @param interleaveDuration duration of media from one track that is
+ *      stored contiguously, in the movie time scale. 0 selects one second.
+ *
+ *  @return <b>true</b> on success, <b>false</b> on failure.
+ *
+ *  @see MP4Optimize()
+ *  @see MP4CopyTrack()
+ */
+MP4V2_EXPORT
+bool MP4Remux(
+    MP4FileHandle     hFile,
+    const char*       newFileName,
+    const MP4TrackId* trackIds DEFAULT(NULL),
+    uint32_t          numTracks DEFAULT(0),
+    MP4Timestamp      startTime DEFAULT(0),
+    MP4Duration       duration DEFAULT(MP4_INVALID_DURATION),
+    MP4Duration       interleaveDuration DEFAULT(0) );
+
+/** Limit the number of external media files kept open.
+ *
+ *  Tracks whose data references point at other files (see
+ *  MP4ReferenceTrack()) have those files opened on demand when their samples
+ *  are read. Opened files are kept open and shared by all tracks of the
+ *  mp4 file, and the least recently used one is closed when the limit is
+ *  reached. The default limit is 8.
+ *
+ *  @param hFile handle of the file.
+ *  @param maxFiles maximum number of open external files, at least 1.
+ *
+ *  @return <b>true</b> on success, <b>false</b> on failure.
+ */
+MP4V2_EXPORT
+bool MP4SetMaxExternalFiles(
+    MP4FileHandle hFile,
+    uint32_t      maxFiles );
+
+/** Set the size of the write buffer of a file opened for writing.
+ *
+ *  Small writes, such as atom headers and table entries, are collected in
+ *  the buffer and written out together. Sizes and offsets patched into
+ *  data that is still buffered are updated in place. The default size is
+ *  64 KiB; a size of 0 disables buffering.
+ *
+ *  @param hFile handle of the file.
+ *  @param size buffer size in bytes.
+ *
+ *  @return <b>true</b> on success, <b>false</b> on failure.
+ */
+MP4V2_EXPORT
+bool MP4SetWriteBufferSize(
+    MP4FileHandle hFile,
+    uint32_t      size );
+
+/** Write out pending data of a file opened for writing.
+ *
+ *  Samples held back to form chunks and the contents of the write buffer
+ *  are written to the file. The file does not become a valid mp4 file
+ *  until it is closed with MP4Close().
+ *
+ *  Writing the held back samples ends the current chunk of every track,
+ *  so a file flushed while writing can end up with more, smaller chunks
+ *  than the same file written without MP4Flush() calls. The samples and
+ *  their timing are the same either way.
+ *
+ *  @param hFile handle of the file.
+ *
+ *  @return <b>true</b> on success, <b>false</b> on failure.
+ *
+ *  @see MP4SetWriteBufferSize()
+ */
+MP4V2_EXPORT
+bool MP4Flush(
+    MP4FileHandle hFile );
+
 /** Read an existing mp4 file.
  *
  *  MP4Read is the first call that should be used when you want to just
@@ -473,6 +711,19 @@ bool MP4Optimize(
  *  information is loaded into memory. Note that actual track samples are not
  *  read into memory until MP4ReadSample() is called.
  *
+ *  The returned handle may be shared by several threads for reading
+ *  samples: MP4ReadSample(), MP4ReadSampleFromTime(), MP4GetSampleSize(),
+ *  MP4GetSampleTime(), MP4GetSampleDuration(), MP4GetSampleRenderingOffset(),
+ *  MP4GetSampleSync(), MP4GetSampleIdFromTime(),
+ *  MP4GetSampleIdFromEditTime() and MP4GetNextEditSample() are serialized
+ *  per file. MP4ReadSample() only holds the lock for the sample table
+ *  lookups: where the platform reads at an offset without moving a shared
+ *  file position (POSIX), sample data stored in the file itself is read
+ *  concurrently. Other calls, including the stateful hint reading functions,
+ *  still require external synchronization. Distinct handles are independent
+ *  of each other.
+ *  Log verbosity and callback should be configured before threads start.
+ *
  *  @param fileName pathname of the file to be read.
  *      On Windows, this should be a UTF-8 encoded string.
  *      On other platforms, it should be an 8-bit encoding that is
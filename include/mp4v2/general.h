@@ -57,6 +57,24 @@ typedef enum {
     MP4_LOG_VERBOSE4 = 7
 }  MP4LogLevel;
 
+/** Status codes reported by MP4GetLastError().
+ *
+ *  Only the sample access and lookup functions which document it record a
+ *  status; all other failures are reported through the log handler.
+ */
+typedef enum {
+    MP4_ERROR_NONE = 0,          /**< No error. */
+    MP4_ERROR_FAILED,            /**< Unclassified failure, details were logged. */
+    MP4_ERROR_INVALID_HANDLE,    /**< File handle is invalid. */
+    MP4_ERROR_INVALID_TRACK,     /**< Track id does not exist. */
+    MP4_ERROR_INVALID_SAMPLE,    /**< Sample id is zero or past the last sample. */
+    MP4_ERROR_TIME_OUT_OF_RANGE, /**< Timestamp is past the end of the track. */
+    MP4_ERROR_BUFFER_TOO_SMALL,  /**< Caller supplied sample buffer is too small. */
+    MP4_ERROR_INACCESSIBLE_FILE, /**< Sample lives in an external file which can't be opened. */
+    MP4_ERROR_CORRUPT,           /**< Sample tables are inconsistent. */
+    MP4_ERROR_TRUNCATED          /**< Sample data extends past the end of the file. */
+} MP4Error;
+
 /*****************************************************************************/
 
 typedef void (*MP4LogCallback)(
@@ -453,7 +471,8 @@ uint32_t MP4GetTrackNumberOfEdits(
  *      desired.
  *
  *  @return The start time of the edit segment in track time scale units of the
- *      track in the mp4 file.
+ *      track in the mp4 file, or #MP4_INVALID_TIMESTAMP if the track has no
+ *      such edit segment.
  *
  *  @see MP4SetTrackEditStart()
  */
@@ -764,6 +783,44 @@ MP4SampleId MP4GetSampleIdFromEditTime(
     MP4Timestamp* pStartTime DEFAULT(NULL),
     MP4Duration*  pDuration DEFAULT(NULL) );
 
+/** Position of a walk through a track's samples in edit list order.
+ *
+ *  Set all members to zero to start at the beginning of the edit list.
+ */
+typedef struct MP4EditSampleCursor_s
+{
+    MP4SampleId  sampleId;  /**< current sample. */
+    MP4EditId    editId;    /**< edit segment the sample is played in. */
+    MP4Timestamp startTime; /**< start of the sample in the edit timeline. */
+    MP4Duration  duration;  /**< duration of the sample in the edit timeline. */
+} MP4EditSampleCursor;
+
+/** Advance to the next sample in the edit list timeline.
+ *
+ *  MP4GetNextEditSample visits the samples of a track in the order the edit
+ *  list plays them, with the same start times and durations that
+ *  MP4GetSampleIdFromEditTime() reports. Samples that are played more than
+ *  once are visited each time. Each step continues from the cursor, so
+ *  walking a whole track takes time linear in its number of samples and
+ *  edits, however long the edit list is. For a track without an edit list,
+ *  the samples are visited in media order.
+ *
+ *  @param hFile specifies the mp4 file to which the operation applies.
+ *  @param trackId specifies the track to which the operation applies.
+ *  @param cursor position of the walk, zero initialized before the first
+ *      call; updated to describe the next sample.
+ *
+ *  @return true (1) if the cursor was advanced to another sample, false (0)
+ *      at the end of the edit list or upon an error.
+ *
+ *  @see MP4GetSampleIdFromEditTime()
+ */
+MP4V2_EXPORT
+bool MP4GetNextEditSample(
+    MP4FileHandle        hFile,
+    MP4TrackId           trackId,
+    MP4EditSampleCursor* cursor );
+
 /* time conversion utilties */
 
 /* predefined values for timeScale parameter below */
@@ -999,6 +1056,37 @@ MP4V2_EXPORT
 void MP4LogSetLevel(
     MP4LogLevel verbosity );
 
+/** Get the status of the last sample access on this thread.
+ *
+ *  MP4GetLastError returns the status recorded by the most recent call made
+ *  on the calling thread to one of MP4ReadSample(), MP4ReadSampleFromTime(),
+ *  MP4GetSampleIdFromTime(), MP4GetSampleSize(), MP4GetSampleTime(),
+ *  MP4GetSampleDuration(), MP4GetSampleRenderingOffset() or
+ *  MP4GetSampleSync().
+ *
+ *  Expected failures of these functions, such as reading past the last
+ *  sample of a track, are reported only through this status and are not
+ *  passed to the log handler.
+ *
+ *  @return the status of the last sample access, MP4_ERROR_NONE on success.
+ *
+ *  @see MP4GetErrorString()
+ */
+MP4V2_EXPORT
+MP4Error MP4GetLastError( void );
+
+/** Get a description of a status code.
+ *
+ *  @param error specifies the status code to describe.
+ *
+ *  @return a static null terminated string describing @p error.
+ *
+ *  @see MP4GetLastError()
+ */
+MP4V2_EXPORT
+const char* MP4GetErrorString(
+    MP4Error error );
+
 /** @} ***********************************************************************/
 
 #endif /* MP4V2_GENERAL_H */
@@ -98,6 +98,46 @@ MP4TrackId MP4EncAndCopyTrack(
     bool                  applyEdits DEFAULT(false),
     MP4TrackId            dstHintTrackReferenceTrack DEFAULT(MP4_INVALID_TRACK_ID) );
 
+/** Make an encrypted copy of a track using several threads.
+ *
+ *  MP4EncAndCopyTrackParallel is MP4EncAndCopyTrack() with the calls to the
+ *  encryption function spread over a pool of threads. Samples are read and
+ *  written on the calling thread, in order, while the samples read ahead of
+ *  the writer are encrypted concurrently. The resulting track is the same as
+ *  the one MP4EncAndCopyTrack() creates.
+ *
+ *  @param srcFile source file handle.
+ *  @param srcTrackId source track id.
+ *  @param icPp ISMAcryp parameters for the new track.
+ *  @param encfcnp encryption function, called once per sample.
+ *  @param encfcnparam1 first argument passed to <b>encfcnp</b>.
+ *  @param numThreads number of threads encrypting samples, including the
+ *      calling thread. A value greater than 1 declares that <b>encfcnp</b>
+ *      is thread-safe, i.e. may be called concurrently with the same
+ *      <b>encfcnparam1</b>. 1 calls it from the calling thread only, as
+ *      MP4EncAndCopyTrack() does, and 0 uses one thread per processor.
+ *  @param dstFile destination file handle. If the value is
+ *      #MP4_INVALID_FILE_HANDLE, the copy is created in <b>srcFile</b>.
+ *  @param applyEdits if true the source track's edit list is applied.
+ *  @param dstHintTrackReferenceTrack reference track of a copied hint track.
+ *
+ *  @return On success, the track-id of the new track.
+ *      On error, #MP4_INVALID_TRACK_ID.
+ *
+ *  @see MP4EncAndCopyTrack()
+ */
+MP4V2_EXPORT
+MP4TrackId MP4EncAndCopyTrackParallel(
+    MP4FileHandle         srcFile,
+    MP4TrackId            srcTrackId,
+    mp4v2_ismacrypParams* icPp,
+    encryptFunc_t         encfcnp,
+    uint32_t              encfcnparam1,
+    uint32_t              numThreads,
+    MP4FileHandle         dstFile DEFAULT(MP4_INVALID_FILE_HANDLE),
+    bool                  applyEdits DEFAULT(false),
+    MP4TrackId            dstHintTrackReferenceTrack DEFAULT(MP4_INVALID_TRACK_ID) );
+
 /** Add ISMA compliant OD and Scene tracks.
  *
  *  MP4MakeIsmaCompliant modifies an mp4 file so that it complies with the
@@ -74,6 +74,9 @@
  *
  *****************************************************************************/
 
+/** Bit: do not fetch artwork in MP4TagsFetchFlags(). */
+#define MP4_TAGS_FETCH_NO_ARTWORK 0x01
+
 /** Enumeration of possible MP4TagArtwork::type values. */
 typedef enum MP4TagArtworkType_e
 {
@@ -207,6 +210,26 @@ bool MP4TagsFetch(
     const MP4Tags* tags,
     MP4FileHandle  hFile );
 
+/** Fetch data from mp4 file and populate structure, with options.
+ *
+ *  Same as MP4TagsFetch() but <b>flags</b> may limit what is fetched.
+ *  With #MP4_TAGS_FETCH_NO_ARTWORK no cover-art is copied and the
+ *  structure reports none. Artwork added afterwards is appended to the
+ *  file's cover-art by MP4TagsStore(), which never removes existing
+ *  cover-art in this mode, and is dropped from the structure once stored.
+ *
+ *  @param tags structure to fetch (write) into.
+ *  @param hFile handle of file to fetch data from.
+ *  @param flags bitmask of MP4_TAGS_FETCH_* values, or 0.
+ *
+ *  @return <b>true</b> on success, <b>false</b> on failure.
+ */
+MP4V2_EXPORT
+bool MP4TagsFetchFlags(
+    const MP4Tags* tags,
+    MP4FileHandle  hFile,
+    uint32_t       flags );
+
 /** Store data to mp4 file from structure.
  *
  *  The tags structure is pushed out to the mp4 file,
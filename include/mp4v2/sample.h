@@ -373,7 +373,44 @@ bool MP4EncAndCopySample(
     MP4TrackId    dstTrackId DEFAULT(MP4_INVALID_TRACK_ID),
     MP4Duration   dstSampleDuration DEFAULT(MP4_INVALID_DURATION) );
 
-/** Not implemented.
+/** Add a sample that refers to the data of an existing sample.
+ *
+ *  MP4ReferenceSample creates a new sample based on an existing sample
+ *  without copying the media data. If the destination is a different file,
+ *  the destination track gets a data reference (a <b>url</b> entry in
+ *  <b>dref</b>) naming the source file, and its chunk offsets point into
+ *  that file. Within the same file the new sample simply shares the data of
+ *  the source sample.
+ *
+ *  All samples of a track share a single data reference, so samples
+ *  referenced from one source file can't be mixed with samples from another
+ *  file or with samples written by MP4WriteSample(). Either call fails on a
+ *  track whose existing samples live elsewhere.
+ *
+ *  The data reference is the URL <b>file:</b> followed by the name the
+ *  source file was opened with, unchanged. A relative name stays relative
+ *  and readers resolve it against their own working directory, so open the
+ *  source by absolute pathname when the destination will be used from
+ *  elsewhere. Offsets beyond 4 GB require a destination created with
+ *  #MP4_CREATE_64BIT_DATA.
+ *
+ *  @param srcFile source sample file handle.
+ *  @param srcTrackId source sample track id.
+ *  @param srcSampleId source sample id.
+ *  @param dstFile destination file handle for new (referencing) sample.
+ *      If the value is #MP4_INVALID_FILE_HANDLE, the sample is created in
+ *      the same file as <b>srcFile</b>.
+ *  @param dstTrackId destination track id for new sample.
+ *      If the value is #MP4_INVALID_TRACK_ID, the the sample is created in
+ *      the same track as the <b>srcTrackId</b>.
+ *  @param dstSampleDuration duration in track timescale for new sample.
+ *      If the value is #MP4_INVALID_DURATION, then the duration of
+ *      the source sample is used.
+ *
+ *  @return <b>true</b> on success, <b>false</b> on failure.
+ *
+ *  @see MP4CopySample()
+ *  @see MP4ReferenceTrack()
  */
 MP4V2_EXPORT
 bool MP4ReferenceSample(
@@ -585,6 +622,147 @@ int8_t MP4GetSampleSync(
     MP4TrackId    trackId,
     MP4SampleId   sampleId );
 
+/** A cue of a text or subtitle track. */
+typedef struct MP4TextCue_s
+{
+    const char*  text;     /**< UTF-8 text, NUL terminated. */
+    MP4Timestamp start;    /**< start of the cue in track timescale. */
+    MP4Duration  duration; /**< duration of the cue in track timescale. */
+} MP4TextCue;
+
+/** Append cues to a text or subtitle track.
+ *
+ *  MP4WriteTextCues appends all cues in one call. Each cue becomes a text
+ *  sample holding a 16-bit length and the text. Where a cue starts after
+ *  the end of the previous one (or of the track), an empty sample fills
+ *  the gap. This is equivalent to calling MP4WriteSample() for every
+ *  sample, but the sample tables are extended in one pass.
+ *
+ *  Cues must be in order and must not overlap each other or the samples
+ *  already in the track. Texts are limited to 65535 bytes.
+ *
+ *  @param hFile handle of file for operation.
+ *  @param trackId id of a text (<b>text</b>) or subtitle (<b>sbtl</b>)
+ *      track.
+ *  @param cues array of cues.
+ *  @param numCues count of items in array.
+ *
+ *  @return <b>true</b> on success, <b>false</b> on failure.
+ *
+ *  @see MP4ReadTextCues()
+ */
+MP4V2_EXPORT
+bool MP4WriteTextCues(
+    MP4FileHandle     hFile,
+    MP4TrackId        trackId,
+    const MP4TextCue* cues,
+    uint32_t          numCues );
+
+/** Read all cues of a text or subtitle track.
+ *
+ *  MP4ReadTextCues returns the cues of a track in order, reading the
+ *  samples in large sequential runs. Empty samples, which fill the gaps
+ *  between cues, are skipped. Style and other modifier boxes following
+ *  the text of a sample are ignored.
+ *
+ *  @param hFile handle of file for operation.
+ *  @param trackId id of a text (<b>text</b>) or subtitle (<b>sbtl</b>)
+ *      track.
+ *  @param cues on success receives an array of cues, or NULL if the track
+ *      has none. The array and the texts it points to are a single block
+ *      which the caller must free with MP4Free().
+ *  @param numCues on success receives the count of items in array.
+ *
+ *  @return <b>true</b> on success, <b>false</b> on failure.
+ *
+ *  @see MP4WriteTextCues()
+ */
+MP4V2_EXPORT
+bool MP4ReadTextCues(
+    MP4FileHandle hFile,
+    MP4TrackId    trackId,
+    MP4TextCue**  cues,
+    uint32_t*     numCues );
+
+/** A sample listed by MP4GetDecodableSamples() or MP4GetSyncSampleIndex(). */
+typedef struct MP4DecodableSample_s
+{
+    MP4SampleId  sampleId;        /**< id of the sample. */
+    uint64_t     offset;          /**< file offset of the sample data. */
+    uint32_t     size;            /**< size of the sample data in bytes. */
+    MP4Timestamp startTime;       /**< decode time in track timescale. */
+    MP4Duration  duration;        /**< duration in track timescale. */
+    MP4Duration  renderingOffset; /**< presentation minus decode time. */
+    bool         isSyncSample;    /**< true for a sync sample. */
+} MP4DecodableSample;
+
+/** List the samples needed to decode a time range while skipping
+ *  disposable samples.
+ *
+ *  MP4GetDecodableSamples returns, in decode order, the samples from the
+ *  last sync sample at or before <b>startTime</b> up to the last sample
+ *  whose decode time is before <b>startTime</b> + <b>duration</b>.
+ *  Samples which the sample dependency (<b>sdtp</b>) atom marks as not
+ *  referenced by other samples are left out, except for sync samples.
+ *  Without that atom all samples of the range are returned.
+ *
+ *  The list is built from the sample tables alone, so no sample data is
+ *  read. It is meant for trick play, where the caller reads and decodes
+ *  only the returned samples. In a file open for writing, the last samples
+ *  written are not listed until their chunk has been written out.
+ *
+ *  @param hFile handle of file for operation.
+ *  @param trackId id of track for operation.
+ *  @param startTime start of the range in track timescale.
+ *  @param duration length of the range in track timescale.
+ *  @param samples on success receives an array of samples, or NULL if
+ *      the range holds none. The caller must free it with MP4Free().
+ *  @param numSamples on success receives the count of items in array.
+ *
+ *  @return <b>true</b> on success, <b>false</b> on failure.
+ *
+ *  @see MP4WriteSampleDependency()
+ */
+MP4V2_EXPORT
+bool MP4GetDecodableSamples(
+    MP4FileHandle        hFile,
+    MP4TrackId           trackId,
+    MP4Timestamp         startTime,
+    MP4Duration          duration,
+    MP4DecodableSample** samples,
+    uint32_t*            numSamples );
+
+/** List the sync samples of a track.
+ *
+ *  MP4GetSyncSampleIndex returns the time, position and size of every
+ *  sync sample (key frame) of a track, in order. It walks the sync sample
+ *  (<b>stss</b>) atom once and resolves times and file offsets along the
+ *  way, so the cost grows with the number of sync samples rather than with
+ *  the number of samples, and no sample data is read. A track without a
+ *  sync sample atom has only sync samples.
+ *
+ *  The result suits key frame indexes such as HLS I-frame playlists or
+ *  thumbnail extraction. As with MP4GetDecodableSamples(), samples whose
+ *  chunk has not been written out yet are not listed.
+ *
+ *  @param hFile handle of file for operation.
+ *  @param trackId id of track for operation.
+ *  @param samples on success receives an array of sync samples, all with
+ *      isSyncSample set, or NULL if the track has none. The caller must
+ *      free it with MP4Free().
+ *  @param numSamples on success receives the count of items in array.
+ *
+ *  @return <b>true</b> on success, <b>false</b> on failure.
+ *
+ *  @see MP4GetSampleSync()
+ */
+MP4V2_EXPORT
+bool MP4GetSyncSampleIndex(
+    MP4FileHandle        hFile,
+    MP4TrackId           trackId,
+    MP4DecodableSample** samples,
+    uint32_t*            numSamples );
+
 /** @} ***********************************************************************/
 
 #endif /* MP4V2_SAMPLE_H */
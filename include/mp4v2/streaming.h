@@ -283,6 +283,36 @@ MP4TrackId MP4GetHintTrackReferenceTrackId(
     MP4FileHandle hFile,
     MP4TrackId    hintTrackId );
 
+/** Hint a media track for RTP streaming.
+ *
+ *  MP4HintTrack adds a hint track for the specified media track and fills it
+ *  with hints that packetize the existing media samples, sets its RTP payload
+ *  and writes its SDP fragment including the a=fmtp line. Supported are H.264
+ *  (avc1) tracks, packetized per RFC 6184 in non-interleaved mode with single
+ *  NAL unit, STAP-A and FU-A packets, and AAC (mp4a) tracks, packetized per
+ *  RFC 3640 in AAC-hbr mode with several access units per packet. The RTP
+ *  clock of H.264 hint tracks is 90 kHz, AAC uses the media timescale.
+ *
+ *  The media samples are referenced, not copied, so the hint track adds
+ *  little more than the payload headers to the file.
+ *
+ *  @param hFile specifies the mp4 file to which the operation applies.
+ *  @param mediaTrackId specifies the media track to be hinted.
+ *  @param maxPayloadSize specifies the maximum RTP payload size in bytes,
+ *      0 selects the default of 1460 bytes.
+ *
+ *  @return On success, the track-id of the new hint track.
+ *      On error, #MP4_INVALID_TRACK_ID and no hint track is added.
+ *
+ *  @see MP4AddHintTrack()
+ *  @see MP4GetHintTrackSdp()
+ */
+MP4V2_EXPORT
+MP4TrackId MP4HintTrack(
+    MP4FileHandle hFile,
+    MP4TrackId    mediaTrackId,
+    uint16_t      maxPayloadSize DEFAULT(0) );
+
 /** Read an RTP hint.
  *
  *  MP4ReadRtpHint reads the specified hint sample from the specified hint
@@ -694,6 +724,148 @@ bool MP4WriteRtpHint(
     MP4Duration   duration,
     bool          isSyncSample DEFAULT(true) );
 
+/** Magic number of a compiled RTP packet schedule ("M4RS"). */
+#define MP4_RTP_SCHEDULE_MAGIC      0x4d345253
+/** Layout version of a compiled RTP packet schedule. */
+#define MP4_RTP_SCHEDULE_VERSION    1
+
+/** Segment flag: the bytes are in the schedule's own pool, not the mp4 file. */
+#define MP4_RTP_SEGMENT_POOL        0x01
+
+/** Header of a compiled RTP packet schedule.
+ *
+ *  A schedule is a single contiguous block without pointers: this header is
+ *  followed by <b>numPackets</b> #MP4RtpSchedulePacket entries, then
+ *  <b>numSegments</b> #MP4RtpScheduleSegment entries, then the byte pool
+ *  holding immediate packet data. All offsets are relative to the start of
+ *  the schedule, so it can be written to disk and memory-mapped as is. Values
+ *  are stored in host byte order.
+ */
+typedef struct MP4RtpSchedule_s {
+    uint32_t magic;             /**< #MP4_RTP_SCHEDULE_MAGIC. */
+    uint32_t version;           /**< #MP4_RTP_SCHEDULE_VERSION. */
+    uint64_t size;              /**< total size in bytes, including header. */
+    uint32_t timeScale;         /**< hint track time scale. */
+    uint32_t numPackets;        /**< number of packet entries. */
+    uint32_t numSegments;       /**< number of segment entries. */
+    uint32_t sequenceStart;     /**< default RTP sequence number start. */
+    uint32_t timestampStart;    /**< default RTP timestamp start. */
+    uint32_t reserved;
+    uint64_t packetsOffset;     /**< offset of the packet entries. */
+    uint64_t segmentsOffset;    /**< offset of the segment entries. */
+    uint64_t poolOffset;        /**< offset of the byte pool. */
+} MP4RtpSchedule;
+
+/** One RTP packet of a compiled schedule. */
+typedef struct MP4RtpSchedulePacket_s {
+    MP4Timestamp timestamp;     /**< hint sample time, in track time scale. */
+    MP4SampleId  hintSampleId;  /**< hint sample the packet belongs to. */
+    int32_t      transmitOffset;/**< relative transmit time of the packet. */
+    uint32_t     firstSegment;  /**< index of the first payload segment. */
+    uint16_t     numSegments;   /**< number of payload segments. */
+    uint16_t     sequenceNumber;/**< sequence number, before sequenceStart. */
+    uint32_t     payloadSize;   /**< payload size in bytes. */
+    uint8_t      header[2];     /**< first two bytes of the RTP header. */
+    uint8_t      isBFrame;      /**< packet carries B-frame data. */
+    uint8_t      reserved;
+} MP4RtpSchedulePacket;
+
+/** One contiguous piece of RTP payload. */
+typedef struct MP4RtpScheduleSegment_s {
+    uint64_t offset;            /**< offset in the mp4 file, or in the pool. */
+    uint32_t length;            /**< length in bytes. */
+    uint32_t flags;             /**< #MP4_RTP_SEGMENT_POOL or 0. */
+} MP4RtpScheduleSegment;
+
+/** Scatter/gather entry; same layout as a POSIX struct iovec. */
+typedef struct MP4RtpIoVec_s {
+    const void* base;
+    size_t      length;
+} MP4RtpIoVec;
+
+/** Compile the RTP packets of a hint track into a packet schedule.
+ *
+ *  MP4CompileRtpSchedule reads every hint sample of the hint track once and
+ *  records, for every RTP packet, its header fields and where its payload
+ *  is located: media and sample description bytes are referenced as ranges
+ *  of the mp4 file, immediate data and data that is not stored in the mp4
+ *  file itself are copied into the schedule.
+ *
+ *  The schedule is immutable and independent of the file handle, so a
+ *  streaming server can build it once, share it between sessions (or save
+ *  and memory-map it), and produce packets with
+ *  MP4BuildRtpSchedulePacket() without reading the hint track again.
+ *  Compiling replaces the hint selected with MP4ReadRtpHint(), and is only
+ *  possible for files opened for reading.
+ *
+ *  @param hFile specifies the mp4 file to which the operation applies.
+ *  @param hintTrackId specifies the hint track to compile.
+ *
+ *  @return Upon success, the schedule, to be released with MP4Free().
+ *      Upon an error, NULL.
+ *
+ *  @see MP4BuildRtpSchedulePacket()
+ */
+MP4V2_EXPORT
+MP4RtpSchedule* MP4CompileRtpSchedule(
+    MP4FileHandle hFile,
+    MP4TrackId    hintTrackId );
+
+/** Check the consistency of a compiled RTP packet schedule.
+ *
+ *  MP4CheckRtpSchedule verifies the header of a schedule that was loaded or
+ *  mapped from storage, and that all its entries lie within <b>size</b>.
+ *  Ranges of the mp4 file are only checked not to wrap around; that they
+ *  lie within the file is left to the caller.
+ *
+ *  @param schedule the schedule to check.
+ *  @param size number of bytes available at <b>schedule</b>.
+ *
+ *  @return true (1) if the schedule can be used, false (0) otherwise.
+ */
+MP4V2_EXPORT
+bool MP4CheckRtpSchedule(
+    const MP4RtpSchedule* schedule,
+    uint64_t              size );
+
+/** Produce one RTP packet of a compiled schedule as an I/O vector.
+ *
+ *  MP4BuildRtpSchedulePacket fills in the 12 byte RTP header of the packet
+ *  and an I/O vector with the header as its first entry followed by the
+ *  payload segments, suitable for sendmsg() or writev(). No memory is
+ *  allocated and no file I/O is done; payload taken from the mp4 file is
+ *  addressed relative to <b>fileData</b>, typically a memory mapping of the
+ *  whole mp4 file.
+ *
+ *  @param schedule the compiled schedule.
+ *  @param packetIndex index of the packet, from 0.
+ *  @param fileData start of the mp4 file contents.
+ *  @param ssrc specifies the RTP synchronization source identifier.
+ *  @param sequenceStart RTP sequence number start, e.g. the schedule's
+ *      <b>sequenceStart</b>.
+ *  @param timestampStart RTP timestamp start, e.g. the schedule's
+ *      <b>timestampStart</b>.
+ *  @param header buffer of 12 bytes that receives the RTP header.
+ *  @param iov I/O vector to fill in.
+ *  @param maxIov number of entries available in <b>iov</b>.
+ *
+ *  @return Upon success, the number of I/O vector entries used. Upon an
+ *      error, 0.
+ *
+ *  @see MP4CompileRtpSchedule()
+ */
+MP4V2_EXPORT
+uint32_t MP4BuildRtpSchedulePacket(
+    const MP4RtpSchedule* schedule,
+    uint32_t              packetIndex,
+    const uint8_t*        fileData,
+    uint32_t              ssrc,
+    uint32_t              sequenceStart,
+    uint32_t              timestampStart,
+    uint8_t*              header,
+    MP4RtpIoVec*          iov,
+    uint32_t              maxIov );
+
 /** @} ***********************************************************************/
 
 #endif /* MP4V2_STREAMING_H */
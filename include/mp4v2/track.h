@@ -459,6 +459,39 @@ MP4TrackId MP4CopyTrack(
     bool          applyEdits DEFAULT(false),
     MP4TrackId    dstHintTrackReferenceTrack DEFAULT(MP4_INVALID_TRACK_ID) );
 
+/** Make a copy of a specified track that refers to the source media.
+ *
+ *  MP4ReferenceTrack is similar to MP4CopyTrack() except that the media
+ *  samples are not copied. Instead the new track refers to the sample data
+ *  in the source file, see MP4ReferenceSample(). Building a derived file
+ *  this way only writes its metadata, but the result is only playable
+ *  while the source file remains available under the same name. That name
+ *  is recorded as given to MP4Read() or MP4Modify(), relative or not.
+ *
+ *  @param srcFile specifies the mp4 file of the source track of the operation.
+ *  @param srcTrackId specifies the track id of the track to be copied.
+ *  @param dstFile specifies the mp4 file of the new, referencing track. If
+ *      the value is MP4_INVALID_FILE_HANDLE, the new track is created in the
+ *      same file as the source track and shares its media data.
+ *  @param applyEdits specifies if the track edit list is to be applied
+ *      when selecting the samples to reference.
+ *  @param dstHintTrackReferenceTrack specifies the track id of the reference
+ *      track in the destination file when cloning a hint track.
+ *
+ *  @return Upon success, the track id of the new track. Upon an error,
+ *      MP4_INVALID_TRACK_ID.
+ *
+ *  @see MP4CopyTrack()
+ *  @see MP4ReferenceSample()
+ */
+MP4V2_EXPORT
+MP4TrackId MP4ReferenceTrack(
+    MP4FileHandle srcFile,
+    MP4TrackId    srcTrackId,
+    MP4FileHandle dstFile DEFAULT(MP4_INVALID_FILE_HANDLE),
+    bool          applyEdits DEFAULT(false),
+    MP4TrackId    dstHintTrackReferenceTrack DEFAULT(MP4_INVALID_TRACK_ID) );
+
 /** Delete a track.
  *
  *  MP4DeleteTrack deletes the control information associated with the
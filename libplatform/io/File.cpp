@@ -10,6 +10,9 @@ File::File( const std::string& name_, Mode mode_, FileProvider* provider_ )
     , _mode     ( mode_ )
     , _size     ( 0 )
     , _position ( 0 )
+    , _resync   ( false )
+    , _bufferStart ( 0 )
+    , _bufferUsed  ( 0 )
     , _provider ( provider_ ? *provider_ : standard() )
     , name      ( _name )
     , isOpen    ( _isOpen )
@@ -70,9 +73,67 @@ File::seek( Size pos )
     if( !_isOpen )
         return true;
 
-    if( _provider.seek( pos ))
+    // appending right after buffered data keeps combining writes
+    if( _bufferUsed && pos == _position )
+        return false;
+
+    if( flushBuffer() || _provider.seek( pos ))
         return true;
     _position = pos;
+    _resync = false;
+    return false;
+}
+
+// A non-positional provider moves its stream position on readAt()/writeAt(),
+// so the next sequential operation has to seek back first. While writes are
+// buffered the provider still has to be at the start of the buffered range.
+bool
+File::resync()
+{
+    if( !_resync )
+        return false;
+
+    if( _provider.seek( _bufferUsed ? _bufferStart : _position ))
+        return true;
+    _resync = false;
+    return false;
+}
+
+bool
+File::flushBuffer()
+{
+    if( _bufferUsed == 0 )
+        return false;
+
+    Size nout;
+    if( resync() || _provider.write( &_buffer[0], _bufferUsed, nout ) || nout != _bufferUsed )
+        return true;
+
+    _bufferUsed = 0;
+    return false;
+}
+
+bool
+File::flush()
+{
+    if( !_isOpen )
+        return false;
+
+    return flushBuffer() || _provider.flush();
+}
+
+bool
+File::setBufferSize( uint32_t size )
+{
+    if( flushBuffer() )
+        return true;
+
+    try {
+        _buffer.resize( size );
+    }
+    catch( std::bad_alloc& ) {
+        return true;
+    }
     return false;
 }
 
@@ -84,7 +145,7 @@ File::read( void* buffer, Size size, Size& nin )
     if( !_isOpen )
         return true;
 
-    if( _provider.read( buffer, size, nin ))
+    if( flushBuffer() || resync() || _provider.read( buffer, size, nin ))
         return true;
 
     _position += nin;
@@ -102,7 +163,26 @@ File::write( const void* buffer, Size size, Size& nout )
     if( !_isOpen )
         return true;
 
-    if( _provider.write( buffer, size, nout ))
+    if( !_buffer.empty() ) {
+        if( _bufferUsed + size > (Size)_buffer.size() && flushBuffer() )
+            return true;
+
+        if( size < (Size)_buffer.size() ) {
+            if( _bufferUsed == 0 )
+                _bufferStart = _position;
+            memcpy( &_buffer[_bufferUsed], buffer, size );
+            _bufferUsed += (uint32_t)size;
+            nout = size;
+
+            _position += nout;
+            if( _position > _size )
+                _size = _position;
+
+            return false;
+        }
+    }
+
+    if( resync() || _provider.write( buffer, size, nout ))
         return true;
 
     _position += nout;
@@ -112,13 +192,71 @@ File::write( const void* buffer, Size size, Size& nout )
     return false;
 }
 
+bool
+File::readAt( Size pos, void* buffer, Size size, Size& nin )
+{
+    nin = 0;
+
+    if( !_isOpen )
+        return true;
+
+    // reads must see buffered writes
+    if( _bufferUsed && pos < _bufferStart + _bufferUsed && pos + size > _bufferStart ) {
+        if( flushBuffer() )
+            return true;
+    }
+
+    if( !_provider.isPositional() )
+        _resync = true;
+
+    return _provider.readAt( pos, buffer, size, nin );
+}
+
+bool
+File::writeAt( Size pos, const void* buffer, Size size, Size& nout )
+{
+    nout = 0;
+
+    if( !_isOpen )
+        return true;
+
+    if( _bufferUsed && pos < _bufferStart + _bufferUsed && pos + size > _bufferStart ) {
+        // back-patches of data still in the buffer are done in place
+        if( pos >= _bufferStart && pos + size <= _bufferStart + _bufferUsed ) {
+            memcpy( &_buffer[pos - _bufferStart], buffer, size );
+            nout = size;
+            return false;
+        }
+
+        if( flushBuffer() )
+            return true;
+    }
+
+    if( !_provider.isPositional() )
+        _resync = true;
+
+    if( _provider.writeAt( pos, buffer, size, nout ))
+        return true;
+
+    if( pos + nout > _size )
+        _size = pos + nout;
+
+    return false;
+}
+
+bool
+File::isPositional() const
+{
+    return _provider.isPositional();
+}
+
 bool
 File::truncate( Size size )
 {
     if( !_isOpen )
         return true;
 
-    if( _provider.truncate( size ))
+    if( flushBuffer() || _provider.truncate( size ))
         return true;
 
     _size = size;
@@ -131,11 +269,17 @@ File::close()
 {
     if( !_isOpen )
         return false;
+
+    // buffered data that cannot be written out is dropped with the file
+    bool failed = flushBuffer();
+    _bufferUsed = 0;
+
     if( _provider.close() )
         return true;
 
     _isOpen = false;
-    return false;
+    _resync = false;
+    return failed;
 }
 
 bool
@@ -144,7 +288,27 @@ File::getSize( Size& nout )
     if( !_isOpen )
         return false;
 
-    return _provider.getSize( nout );
+    return flushBuffer() || _provider.getSize( nout );
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+bool
+FileProvider::readAt( Size pos, void* buffer, Size size, Size& nin )
+{
+    return seek( pos ) || read( buffer, size, nin );
+}
+
+bool
+FileProvider::writeAt( Size pos, const void* buffer, Size size, Size& nout )
+{
+    return seek( pos ) || write( buffer, size, nout );
+}
+
+bool
+FileProvider::flush()
+{
+    return false;
 }
 
 ///////////////////////////////////////////////////////////////////////////////
@@ -33,6 +33,18 @@ public:
     virtual bool close() = 0;
     virtual bool getSize( Size& nout ) = 0;
 
+    // Positional I/O at an absolute offset. Providers that override these
+    // with native positional calls must also override isPositional() so the
+    // stream position is known to be left untouched; the default
+    // implementations fall back to seek() followed by read()/write().
+    virtual bool readAt( Size pos, void* buffer, Size size, Size& nin );
+    virtual bool writeAt( Size pos, const void* buffer, Size size, Size& nout );
+    virtual bool isPositional() const { return false; }
+
+    // Pushes data buffered by the provider itself out to the operating
+    // system or sink. The default does nothing.
+    virtual bool flush();
+
 protected:
     FileProvider() { }
 };
@@ -188,12 +200,98 @@ public:
 
     bool getSize( Size& nout );
 
+    ///////////////////////////////////////////////////////////////////////////
+    //!
+    //! Binary read at an absolute file offset.
+    //!
+    //! The function reads up to a maximum <b>size</b> bytes starting at
+    //! <b>pos</b>, storing them in <b>buffer</b>. The current file position
+    //! is not changed. With the standard provider on POSIX systems this is
+    //! a single pread() call.
+    //!
+    //! @param pos file offset in bytes to read from.
+    //! @param buffer storage for data read from file.
+    //! @param size maximum number of bytes to read from file.
+    //! @param nin output indicating number of bytes read from file.
+    //!
+    //! @return true on failure, false on success.
+    //!
+    ///////////////////////////////////////////////////////////////////////////
+    bool readAt( Size pos, void* buffer, Size size, Size& nin );
+
+    ///////////////////////////////////////////////////////////////////////////
+    //!
+    //! Binary write at an absolute file offset.
+    //!
+    //! The function writes up to a maximum <b>size</b> bytes from
+    //! <b>buffer</b> to file starting at <b>pos</b>. The current file
+    //! position is not changed. With the standard provider on POSIX systems
+    //! this is a single pwrite() call.
+    //!
+    //! @param pos file offset in bytes to write to.
+    //! @param buffer data to be written out to file.
+    //! @param size maximum number of bytes to write to file.
+    //! @param nout output indicating number of bytes written to file.
+    //!
+    //! @return true on failure, false on success.
+    //!
+    ///////////////////////////////////////////////////////////////////////////
+    bool writeAt( Size pos, const void* buffer, Size size, Size& nout );
+
+    ///////////////////////////////////////////////////////////////////////////
+    //!
+    //! Query positional I/O support.
+    //!
+    //! @return true if the provider reads and writes at an offset without
+    //!     moving its position, so that readAt() calls from several threads
+    //!     do not interfere while no writes are buffered.
+    //!
+    ///////////////////////////////////////////////////////////////////////////
+    bool isPositional() const;
+
+    ///////////////////////////////////////////////////////////////////////////
+    //!
+    //! Set size of the write-combining buffer.
+    //!
+    //! Sequential writes smaller than the buffer are collected and handed
+    //! to the provider in one piece once the buffer is full, or before any
+    //! read, seek, truncate or close that needs them. Writes at an offset
+    //! still inside the buffer patch it in place. A size of 0, the default,
+    //! disables buffering. Pending data is flushed first.
+    //!
+    //! @param size buffer size in bytes.
+    //!
+    //! @return true on failure, false on success.
+    //!
+    ///////////////////////////////////////////////////////////////////////////
+    bool setBufferSize( uint32_t size );
+
+    ///////////////////////////////////////////////////////////////////////////
+    //!
+    //! Flush buffered writes.
+    //!
+    //! Writes out the write-combining buffer and asks the provider to flush
+    //! its own buffers.
+    //!
+    //! @return true on failure, false on success.
+    //!
+    ///////////////////////////////////////////////////////////////////////////
+    bool flush();
+
+private:
+    bool resync();
+    bool flushBuffer();
+
 private:
     std::string   _name;
     bool          _isOpen;
     Mode          _mode;
     Size          _size;
     Size          _position;
+    bool          _resync;
+    std::vector<uint8_t> _buffer;
+    Size          _bufferStart;
+    uint32_t      _bufferUsed;
     FileProvider& _provider;
 
 public:
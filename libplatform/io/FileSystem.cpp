@@ -91,8 +91,13 @@ FileSystem::pathnameTemp( string& name, const std::string& dir, const std::strin
             buf << '/';
     }
 
+    // the sequence number keeps names unique between threads, as the random
+    // number generator may be per-thread and identically seeded
+    static atomic<uint32_t> sequence( 0 );
+
     buf << prefix;
     buf << setfill('0') << setw(8) << number::random32();
+    buf << '-' << sequence++;
     buf << suffix;
 
     name = buf.str();
@@ -77,6 +77,23 @@ public:
 
     static bool getFileSize( const std::string& name, File::Size& size );
 
+    ///////////////////////////////////////////////////////////////////////////
+    //!
+    //! Query file identity.
+    //! Check if <b>name1</b> and <b>name2</b> both exist and refer to the
+    //! same file, e.g. through a link or a differently spelled pathname.
+    //! @param name1 first filename to compare.
+    //! @param name2 second filename to compare.
+    //!     On Windows, these should be UTF-8 encoded strings.
+    //!     On other platforms, they should be an 8-bit encoding that is
+    //!     appropriate for the platform, locale, file system, etc.
+    //!     (prefer to use UTF-8 when possible).
+    //! @return true if the same file, false otherwise.
+    //!
+    ///////////////////////////////////////////////////////////////////////////
+
+    static bool isSameFile( const std::string& name1, const std::string& name2 );
+
     ///////////////////////////////////////////////////////////////////////////
     //!
     //! Rename file or directory.
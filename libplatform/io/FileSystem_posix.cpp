@@ -49,6 +49,17 @@ FileSystem::getFileSize( const std::string& path_, File::Size& size_ )
 
 ///////////////////////////////////////////////////////////////////////////////
 
+bool
+FileSystem::isSameFile( const std::string& path1, const std::string& path2 )
+{
+    struct stat buf1, buf2;
+    if( stat( path1.c_str(), &buf1 ) || stat( path2.c_str(), &buf2 ))
+        return false;
+    return buf1.st_dev == buf2.st_dev && buf1.st_ino == buf2.st_ino;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
 bool
 FileSystem::rename( const std::string& from, const std::string& to )
 {
@@ -114,6 +114,53 @@ FileSystem::getFileSize( const std::string& path_, File::Size& size_ )
 
 ///////////////////////////////////////////////////////////////////////////////
 
+/**
+ * Query the volume and file index of a file
+ *
+ * @param path_ the path to query
+ * @param info_ receives the file information
+ *
+ * @retval true @p path_ can't be opened or queried
+ * @retval false success
+ */
+static bool
+getFileInformation ( const std::string& path_, BY_HANDLE_FILE_INFORMATION& info_ )
+{
+    win32::Utf8ToFilename filename(path_);
+
+    if (!filename.IsUTF16Valid())
+    {
+        return true;
+    }
+
+    HANDLE handle = ::CreateFileW( filename, FILE_READ_ATTRIBUTES,
+                                   FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE,
+                                   NULL, OPEN_EXISTING, FILE_FLAG_BACKUP_SEMANTICS, NULL );
+    if (handle == INVALID_HANDLE_VALUE)
+    {
+        return true;
+    }
+
+    BOOL result = ::GetFileInformationByHandle( handle, &info_ );
+    ::CloseHandle( handle );
+
+    return !result;
+}
+
+bool
+FileSystem::isSameFile( const std::string& path1, const std::string& path2 )
+{
+    BY_HANDLE_FILE_INFORMATION info1, info2;
+    if( getFileInformation( path1, info1 ) || getFileInformation( path2, info2 ))
+        return false;
+
+    return info1.dwVolumeSerialNumber == info2.dwVolumeSerialNumber
+        && info1.nFileIndexHigh == info2.nFileIndexHigh
+        && info1.nFileIndexLow == info2.nFileIndexLow;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
 bool
 FileSystem::rename( const std::string& from, const std::string& to )
 {
@@ -17,106 +17,210 @@ public:
     bool close();
     bool getSize( Size& nout );
 
+    bool readAt( Size pos, void* buffer, Size size, Size& nin );
+    bool writeAt( Size pos, const void* buffer, Size size, Size& nout );
+    bool isPositional() const { return true; }
+    bool flush();
+
 private:
-    bool         _seekg;
-    bool         _seekp;
-    std::fstream _fstream;
-    std::string  _name;
+    enum Op {
+        OP_NONE,
+        OP_READ,
+        OP_WRITE
+    };
+
+    bool sync( bool discardInput );
+
+    FILE*             _file;
+    Op                _lastOp;
+    bool              _streamRead;  // set by the first stream read, see writeAt()
+    std::vector<char> _buffer;
+    std::string       _name;
 };
 
 ///////////////////////////////////////////////////////////////////////////////
 
 StandardFileProvider::StandardFileProvider()
-    : _seekg ( false )
-    , _seekp ( false )
+    : _file       ( NULL )
+    , _lastOp     ( OP_NONE )
+    , _streamRead ( false )
 {
 }
 
 bool
 StandardFileProvider::open( const std::string& name, Mode mode )
 {
-    ios::openmode om = ios::binary;
+    const char* om;
     switch( mode ) {
         case MODE_UNDEFINED:
         case MODE_READ:
         default:
-            om |= ios::in;
-            _seekg = true;
-            _seekp = false;
+            om = "rb";
             break;
 
         case MODE_MODIFY:
-            om |= ios::in | ios::out;
-            _seekg = true;
-            _seekp = true;
+            om = "r+b";
             break;
 
         case MODE_CREATE:
-            om |= ios::in | ios::out | ios::trunc;
-            _seekg = true;
-            _seekp = true;
+            om = "w+b";
             break;
     }
 
-    _fstream.open( name.c_str(), om );
+    _file = fopen( name.c_str(), om );
+    _lastOp = OP_NONE;
+    _streamRead = false;
     _name = name;
-    return _fstream.fail();
+    if( _file == NULL )
+        return true;
+
+    // the stdio default is one filesystem block, too small for sample data
+    _buffer.resize( 64 * 1024 );
+    setvbuf( _file, &_buffer[0], _IOFBF, _buffer.size() );
+    return false;
+}
+
+// Bring the stream and its descriptor in line with each other. Buffered
+// output is written out; buffered input is only dropped when requested
+// because positional reads do not invalidate it.
+bool
+StandardFileProvider::sync( bool discardInput )
+{
+    if( _lastOp == OP_WRITE ) {
+        if( fflush( _file ))
+            return true;
+        _lastOp = OP_NONE;
+    }
+    else if( _lastOp == OP_READ && discardInput ) {
+        if( fseeko( _file, 0, SEEK_CUR ))
+            return true;
+        _lastOp = OP_NONE;
+    }
+    return false;
 }
 
 bool
 StandardFileProvider::seek( Size pos )
 {
-    if( _seekg )
-        _fstream.seekg( pos, ios::beg );
-    if( _seekp )
-        _fstream.seekp( pos, ios::beg );
-    return _fstream.fail();
+    _lastOp = OP_NONE;
+    return fseeko( _file, pos, SEEK_SET ) != 0;
 }
 
 bool
 StandardFileProvider::read( void* buffer, Size size, Size& nin )
 {
-    _fstream.read( (char*)buffer, size );
-    if( _fstream.fail() )
+    // stdio requires a flush or seek between output and input
+    if( _lastOp == OP_WRITE && sync( false ))
+        return true;
+    _lastOp = OP_READ;
+    _streamRead = true;
+
+    Size count = fread( buffer, 1, size, _file );
+    if( ferror( _file ))
         return true;
-    nin = _fstream.gcount();
+    nin = count;
     return false;
 }
 
 bool
 StandardFileProvider::write( const void* buffer, Size size, Size& nout )
 {
-    _fstream.write( (const char*)buffer, size );
-    if( _fstream.fail() )
+    // stdio requires a seek between input and output
+    if( _lastOp == OP_READ && sync( true ))
+        return true;
+    _lastOp = OP_WRITE;
+
+    Size count = fwrite( buffer, 1, size, _file );
+    if( ferror( _file ))
         return true;
-    nout = size;
+    nout = count;
     return false;
 }
 
 bool
-StandardFileProvider::truncate( Size size )
+StandardFileProvider::readAt( Size pos, void* buffer, Size size, Size& nin )
 {
-    // close the file prior to truncating it
-    _fstream.close();
+    if( sync( false ))
+        return true;
 
-    // truncate the file using the POSIX truncate function
-    if( ::truncate( _name.c_str(), size ) != 0)
+    int fd = fileno( _file );
+    nin = 0;
+    while( nin < size ) {
+        ssize_t n = ::pread( fd, (uint8_t*)buffer + nin, size - nin, pos + nin );
+        if( n < 0 ) {
+            if( errno == EINTR )
+                continue;
+            return true;
+        }
+        if( n == 0 )
+            break;
+        nin += n;
+    }
+    return false;
+}
+
+bool
+StandardFileProvider::writeAt( Size pos, const void* buffer, Size size, Size& nout )
+{
+    // Once the stream has read ahead, its buffer may cover the range about
+    // to be overwritten. Neither seeks nor switching to output reliably
+    // drop that input (glibc keeps it around), so pwrite would leave stale
+    // data for later reads. Such files are written through the stream,
+    // which keeps its buffer coherent.
+    if( _streamRead ) {
+        off_t cur = ftello( _file );
+        if( cur < 0 || sync( true ) || fseeko( _file, pos, SEEK_SET ))
+            return true;
+        nout = fwrite( buffer, 1, size, _file );
+        if( ferror( _file ) || fseeko( _file, cur, SEEK_SET ))
+            return true;
+        _lastOp = OP_NONE;
+        return false;
+    }
+
+    if( sync( false ))
+        return true;
+
+    int fd = fileno( _file );
+    nout = 0;
+    while( nout < size ) {
+        ssize_t n = ::pwrite( fd, (const uint8_t*)buffer + nout, size - nout, pos + nout );
+        if( n < 0 ) {
+            if( errno == EINTR )
+                continue;
+            return true;
+        }
+        nout += n;
+    }
+    return false;
+}
+
+bool
+StandardFileProvider::flush()
+{
+    return sync( false );
+}
+
+bool
+StandardFileProvider::truncate( Size size )
+{
+    if( sync( true ))
         return true;
 
-    // reopen the file and seek to the new end
-    _fstream.clear();
-    _fstream.open( _name.c_str(), ios::binary | ios::in | ios::out);
-    if ( _fstream.fail() )
+    // truncate the file using the POSIX ftruncate function
+    if( ::ftruncate( fileno( _file ), size ) != 0 )
         return true;
 
+    // seek to the new end
     return seek( size );
 }
 
 bool
 StandardFileProvider::close()
 {
-    _fstream.close();
-    return _fstream.fail();
+    int result = fclose( _file );
+    _file = NULL;
+    return result != 0;
 }
 
 bool
@@ -52,6 +52,7 @@ public:
     bool truncate( Size size );
     bool close();
     bool getSize( Size& nout );
+    bool flush();
 
 private:
     FILE* _file;
@@ -224,6 +225,18 @@ StandardFileProvider::truncate( Size size )
     return seek( size );
 }
 
+/**
+ * Flush buffered writes to the operating system
+ *
+ * @retval false successfully flushed the file
+ * @retval true error flushing the file
+ */
+bool
+StandardFileProvider::flush()
+{
+    return fflush( _file ) != 0;
+}
+
 /**
  * Close the file
  *
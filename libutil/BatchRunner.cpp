@@ -0,0 +1,256 @@
+///////////////////////////////////////////////////////////////////////////////
+//
+//  The contents of this file are subject to the Mozilla Public License
+//  Version 1.1 (the "License"); you may not use this file except in
+//  compliance with the License. You may obtain a copy of the License at
+//  http://www.mozilla.org/MPL/
+//
+//  Software distributed under the License is distributed on an "AS IS"
+//  basis, WITHOUT WARRANTY OF ANY KIND, either express or implied. See the
+//  License for the specific language governing rights and limitations
+//  under the License.
+//
+//  The Original Code is MP4v2.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#include "libutil/impl.h"
+
+namespace mp4v2 { namespace util {
+
+///////////////////////////////////////////////////////////////////////////////
+
+namespace {
+
+// Output of a job run in parallel, in order of writing. It is passed on to
+// stdout/stderr once the output of all earlier jobs has been.
+struct JobOutput {
+    list< pair<FILE*, string> > chunks;
+
+    void append( FILE* stream, const string& text )
+    {
+        if( !chunks.empty() && chunks.back().first == stream )
+            chunks.back().second += text;
+        else
+            chunks.push_back( make_pair( stream, text ));
+    }
+
+    void append( FILE* stream, const char* format, va_list ap )
+    {
+        va_list ap2;
+        va_copy( ap2, ap );
+        const int len = vsnprintf( NULL, 0, format, ap2 );
+        va_end( ap2 );
+        if( len <= 0 )
+            return;
+
+        string text( len + 1, '\0' );
+        vsnprintf( &text[0], text.size(), format, ap );
+        text.resize( len );
+        append( stream, text );
+    }
+
+    void flush()
+    {
+        const list< pair<FILE*, string> >::iterator ie = chunks.end();
+        for( list< pair<FILE*, string> >::iterator it = chunks.begin(); it != ie; ++it ) {
+            fputs( it->second.c_str(), it->first );
+            fflush( it->first );
+        }
+        chunks.clear();
+    }
+};
+
+// output of the job running on this thread, if any
+thread_local JobOutput* jobOutput = NULL;
+
+// log callback while jobs run in parallel, same output as the default
+void
+jobLog( MP4LogLevel, const char* format, va_list ap )
+{
+    if( !jobOutput ) {
+        vfprintf( stdout, format, ap );
+        fprintf( stdout, "\n" );
+        return;
+    }
+
+    jobOutput->append( stdout, format, ap );
+    jobOutput->append( stdout, string( "\n" ));
+}
+
+} // namespace
+
+///////////////////////////////////////////////////////////////////////////////
+
+struct BatchRunner::State {
+    struct Slot {
+        Slot() : done( false ), result( Utility::FAILURE ) { }
+
+        bool      done;
+        bool      result;
+        JobOutput output;
+    };
+
+    explicit State( uint32_t total )
+        : slots( total ), next( 0 ), stop( false ) { }
+
+    vector<Slot>       slots;
+    mutex              lock;
+    condition_variable jobDone;
+    uint32_t           next; //!< next job to start
+    bool               stop; //!< no further jobs are started
+};
+
+///////////////////////////////////////////////////////////////////////////////
+
+BatchRunner::BatchRunner( uint32_t threads, bool keepgoing )
+    : _threads   ( threads ? threads : 1 )
+    , _keepgoing ( keepgoing )
+    , _numFailed ( 0 )
+{
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+BatchRunner::~BatchRunner()
+{
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+bool
+BatchRunner::run( uint32_t total )
+{
+    _numFailed = 0;
+
+    // nothing to be done
+    if( !total )
+        return Utility::SUCCESS;
+
+    if( _threads > 1 && total > 1 )
+        return runParallel( total );
+
+    bool batchResult = Utility::FAILURE;
+    for( uint32_t i = 0; i < total; i++ ) {
+        if( tryJob( i ) == Utility::SUCCESS ) {
+            batchResult = Utility::SUCCESS;
+            continue;
+        }
+
+        _numFailed++;
+        if( !_keepgoing )
+            return Utility::FAILURE;
+    }
+
+    return batchResult;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+bool
+BatchRunner::runParallel( uint32_t total )
+{
+    State state( total );
+
+    MP4SetLogCallback( jobLog );
+
+    vector<thread> workers;
+    const uint32_t numWorkers = min( _threads, total );
+    for( uint32_t i = 0; i < numWorkers; i++ )
+        workers.push_back( thread( &BatchRunner::worker, this, ref( state )));
+
+    bool batchResult = Utility::FAILURE;
+    for( uint32_t i = 0; i < total; i++ ) {
+        State::Slot& slot = state.slots[i];
+        {
+            unique_lock<mutex> lock( state.lock );
+            while( !slot.done && !( state.stop && i >= state.next ))
+                state.jobDone.wait( lock );
+        }
+
+        // batch was stopped before this job started
+        if( !slot.done )
+            break;
+
+        slot.output.flush();
+        if( slot.result == Utility::SUCCESS )
+            batchResult = Utility::SUCCESS;
+        else
+            _numFailed++;
+    }
+
+    for( uint32_t i = 0; i < numWorkers; i++ )
+        workers[i].join();
+
+    MP4SetLogCallback( NULL );
+
+    if( !_keepgoing && _numFailed )
+        return Utility::FAILURE;
+
+    return batchResult;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+void
+BatchRunner::worker( State& state )
+{
+    unique_lock<mutex> lock( state.lock );
+    while( !state.stop && state.next < state.slots.size() ) {
+        const uint32_t index = state.next++;
+        State::Slot& slot = state.slots[index];
+        lock.unlock();
+
+        jobOutput = &slot.output;
+        const bool result = tryJob( index );
+        jobOutput = NULL;
+
+        lock.lock();
+        slot.result = result;
+        slot.done = true;
+        if( !_keepgoing && result == Utility::FAILURE )
+            state.stop = true;
+        state.jobDone.notify_all();
+    }
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+bool
+BatchRunner::tryJob( uint32_t index )
+{
+    try {
+        return runJob( index );
+    }
+    catch( Exception* x ) {
+        mp4v2::impl::log.errorf(*x);
+        delete x;
+    }
+    return Utility::FAILURE;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+void
+BatchRunner::print( FILE* stream, const char* format, ... )
+{
+    va_list ap;
+    va_start( ap, format );
+    vprint( stream, format, ap );
+    va_end( ap );
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+void
+BatchRunner::vprint( FILE* stream, const char* format, va_list ap )
+{
+    if( jobOutput )
+        jobOutput->append( stream, format, ap );
+    else
+        vfprintf( stream, format, ap );
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+}} // namespace mp4v2::util
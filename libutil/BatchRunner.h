@@ -0,0 +1,70 @@
+///////////////////////////////////////////////////////////////////////////////
+//
+//  The contents of this file are subject to the Mozilla Public License
+//  Version 1.1 (the "License"); you may not use this file except in
+//  compliance with the License. You may obtain a copy of the License at
+//  http://www.mozilla.org/MPL/
+//
+//  Software distributed under the License is distributed on an "AS IS"
+//  basis, WITHOUT WARRANTY OF ANY KIND, either express or implied. See the
+//  License for the specific language governing rights and limitations
+//  under the License.
+//
+//  The Original Code is MP4v2.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#ifndef MP4V2_UTIL_BATCHRUNNER_H
+#define MP4V2_UTIL_BATCHRUNNER_H
+
+namespace mp4v2 { namespace util {
+
+///////////////////////////////////////////////////////////////////////////////
+///
+/// Runs the numbered jobs of a batch, one file each, on a pool of threads.
+///
+/// Output of a job written with print(), and library log messages, are held
+/// back and printed in job order, so a parallel run reads the same as a
+/// serial one. Without keepgoing no further jobs are started after a
+/// failure; jobs already running are finished.
+///
+/// Jobs return Utility::SUCCESS or Utility::FAILURE.
+///
+///////////////////////////////////////////////////////////////////////////////
+class MP4V2_EXPORT BatchRunner
+{
+public:
+    BatchRunner( uint32_t threads, bool keepgoing );
+    virtual ~BatchRunner();
+
+    //! run jobs 0 to total-1; fails if no job succeeded, or if any job
+    //! failed without keepgoing
+    bool run( uint32_t total );
+
+    //! number of jobs which failed in the last run
+    uint32_t numFailed() const { return _numFailed; }
+
+    //! print to stream, held back while jobs run in parallel
+    static void print( FILE*, const char*, ... ) MP4V2_WFORMAT_PRINTF(2,3);
+    static void vprint( FILE*, const char*, va_list );
+
+protected:
+    virtual bool runJob( uint32_t index ) = 0; //!< process job index
+
+private:
+    struct State;
+    bool runParallel( uint32_t );
+    void worker( State& );
+    bool tryJob( uint32_t );
+
+private:
+    const uint32_t _threads;
+    const bool     _keepgoing;
+    uint32_t       _numFailed;
+};
+
+///////////////////////////////////////////////////////////////////////////////
+
+}} // namespace mp4v2::util
+
+#endif // MP4V2_UTIL_BATCHRUNNER_H
@@ -27,6 +27,30 @@ namespace mp4v2 { namespace util {
 
 ///////////////////////////////////////////////////////////////////////////////
 
+// Runs the jobs of batch() for one Utility.
+class Utility::Batch : public BatchRunner
+{
+public:
+    Batch( Utility& utility, int argi )
+        : BatchRunner( utility._jobs, utility._keepgoing )
+        , _utility( utility )
+        , _argi( argi )
+    {
+    }
+
+protected:
+    bool runJob( uint32_t index )
+    {
+        return _utility.job( _utility._argv[_argi + index], index );
+    }
+
+private:
+    Utility&  _utility;
+    const int _argi;
+};
+
+///////////////////////////////////////////////////////////////////////////////
+
 Utility::Utility( const string& name_, int argc_, char** argv_ )
     : _longOptions      ( NULL )
     , _name             ( name_ )
@@ -39,7 +63,7 @@ Utility::Utility( const string& name_, int argc_, char** argv_ )
     , _force            ( false )
     , _debug            ( 0 )
     , _verbosity        ( 1 )
-    , _jobCount         ( 0 )
+    , _jobs             ( 1 )
     , _jobTotal         ( 0 )
     , _debugImplicits   ( false )
     , _group            ( "OPTIONS" )
@@ -67,6 +91,7 @@ Utility::Utility( const string& name_, int argc_, char** argv_ )
     "\n  1  normal informative messages (default)"
     "\n  2  more informative messages"
     "\n  3  everything" )
+,STD_JOBS( 'j', true, "jobs", true, LC_JOBS, "process up to NUM files in parallel", "NUM" )
 ,STD_HELP( 'h', false, "help", false, LC_HELP, "print brief help or long-option for extended help" )
 ,STD_VERSION( 0, false, "version", false, LC_VERSION, "print version information and exit" )
 ,STD_VERSIONX( 0, false, "versionx", false, LC_VERSIONX, "print extended version information", "ARG", "", true )
@@ -91,32 +116,11 @@ Utility::~Utility()
 bool
 Utility::batch( int argi )
 {
-    _jobCount = 0;
     _jobTotal = _argc - argi;
 
-    // nothing to be done
-    if( !_jobTotal )
-        return SUCCESS;
-
-    bool batchResult = FAILURE;
-    for( int i = argi; i < _argc; i++ ) {
-        bool subResult = FAILURE;
-        try {
-            if( !job( _argv[i] )) {
-                batchResult = SUCCESS;
-                subResult = SUCCESS;
-            }
-        }
-        catch( Exception* x ) {
-            mp4v2::impl::log.errorf(*x);
-            delete x;
-        }
- 
-        if( !_keepgoing && subResult == FAILURE )
-            return FAILURE;
-    }
-    
-    return batchResult;
+    // jobs run in parallel with --jobs, see BatchRunner
+    Batch batch( *this, argi );
+    return batch.run( _jobTotal );
 }
 
 ///////////////////////////////////////////////////////////////////////////////
@@ -179,7 +183,7 @@ Utility::errf( const char* format, ... )
 {
     va_list ap;
     va_start( ap, format );
-    vfprintf( stderr, format, ap );
+    output( stderr, format, ap );
     va_end( ap );
 }
 
@@ -287,12 +291,12 @@ Utility::formatGroups()
 ///////////////////////////////////////////////////////////////////////////////
 
 bool
-Utility::job( const string& arg )
+Utility::job( const string& arg, uint32_t index )
 {
     verbose2f( "job begin: %s\n", arg.c_str() );
 
     // perform job
-    JobContext job( arg );
+    JobContext job( arg, index );
     bool result = FAILURE;
     try {
         result = utility_job( job );
@@ -322,7 +326,6 @@ Utility::job( const string& arg )
 
 
     verbose2f( "job end\n" );
-    _jobCount++;
     return result;
 }
 
@@ -334,14 +337,10 @@ Utility::herrf( const char* format, ... )
     va_list ap;
     va_start( ap, format );
 
-    if( _keepgoing ) {
-        fprintf( stdout, "WARNING: " );
-        vfprintf( stdout, format, ap );
-    }
-    else {
-        fprintf( stderr, "ERROR: " );
-        vfprintf( stderr, format, ap );
-    }
+    if( _keepgoing )
+        output( stdout, ( string( "WARNING: " ) + format ).c_str(), ap );
+    else
+        output( stderr, ( string( "ERROR: " ) + format ).c_str(), ap );
 
     va_end( ap );
     return FAILURE;
@@ -352,10 +351,9 @@ Utility::herrf( const char* format, ... )
 bool
 Utility::hwarnf( const char* format, ... )
 {
-    fprintf( stdout, "WARNING: " );
     va_list ap;
     va_start( ap, format );
-    vfprintf( stdout, format, ap );
+    output( stdout, ( string( "WARNING: " ) + format ).c_str(), ap );
     va_end( ap );
     return FAILURE;
 }
@@ -367,12 +365,20 @@ Utility::outf( const char* format, ... )
 {
     va_list ap;
     va_start( ap, format );
-    vfprintf( stdout, format, ap );
+    output( stdout, format, ap );
     va_end( ap );
 }
 
 ///////////////////////////////////////////////////////////////////////////////
 
+void
+Utility::output( FILE* stream, const char* format, va_list ap )
+{
+    BatchRunner::vprint( stream, format, ap );
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
 void
 Utility::printHelp( bool extended, bool toerr )
 {
@@ -524,6 +530,14 @@ Utility::process_impl()
                 debugUpdate( _debug + 1 );
                 break;
 
+            case 'j':
+            case LC_JOBS:
+            {
+                const uint32_t jobs = std::strtoul( prog::optarg, NULL, 0 );
+                _jobs = jobs ? jobs : 1;
+                break;
+            }
+
             case 'h':
                 printHelp( false, false );
                 return SUCCESS;
@@ -617,7 +631,7 @@ Utility::verbose( uint32_t level, const char* format, va_list ap )
 {
     if( level > _verbosity )
         return;
-    vfprintf( stdout, format, ap );
+    output( stdout, format, ap );
 }
 
 ///////////////////////////////////////////////////////////////////////////////
@@ -743,8 +757,9 @@ Utility::Option::Option(
 
 ///////////////////////////////////////////////////////////////////////////////
 
-Utility::JobContext::JobContext( const string& file_ )
+Utility::JobContext::JobContext( const string& file_, uint32_t index_ )
     : file               ( file_ )
+    , index              ( index_ )
     , fileHandle         ( MP4_INVALID_FILE_HANDLE )
     , optimizeApplicable ( false )
 {
@@ -58,6 +58,7 @@ protected:
         LC_HELP,
         LC_VERSION,
         LC_VERSIONX,
+        LC_JOBS,
         _LC_MAX // will be used to seeed derived-class long-codes enum
     };
 
@@ -102,9 +103,10 @@ protected:
     class MP4V2_EXPORT JobContext
     {
     public:
-        JobContext( const string& file_ );
+        JobContext( const string& file_, uint32_t index_ );
 
         const string  file;               //!< file job is working on
+        const uint32_t index;             //!< position of job in batch, starting at 0
         MP4FileHandle fileHandle;         //!< handle of file, if applicable to job
         bool          optimizeApplicable; //!< indicate file optimization is applicable
         list<void*>   tofree;             //!< memory to free at end of job
@@ -132,8 +134,8 @@ protected:
     void verbose2f ( const char*, ... ) MP4V2_WFORMAT_PRINTF(2,3);
     void verbose3f ( const char*, ... ) MP4V2_WFORMAT_PRINTF(2,3);
 
-    bool batch ( int );           //!< process all remaining arguments (jobs)
-    bool job   ( const string& ); //!< process next argument
+    bool batch ( int );                     //!< process all remaining arguments (jobs)
+    bool job   ( const string&, uint32_t ); //!< process next argument
 
     //! open file in consideration of overwrite/force options
     bool openFileForWriting( io::File& );
@@ -148,6 +150,9 @@ private:
     void formatGroups();
     void debugUpdate( uint32_t );
     void verbose( uint32_t, const char*, va_list );
+    void output( FILE*, const char*, va_list );
+
+    class Batch;
     bool process_impl();
 
 private:
@@ -169,8 +174,8 @@ protected:
     bool     _force;     //!< force overwriting a file even if read-only
     uint32_t _debug;     //!< mp4 file I/O verbosity
     uint32_t _verbosity; //!< verbosity level, default=1
+    uint32_t _jobs;      //!< number of jobs to run in parallel, default=1
 
-    uint32_t          _jobCount;
     uint32_t          _jobTotal;
     bool              _debugImplicits;
 
@@ -189,6 +194,7 @@ protected:
     const Option STD_QUIET;
     const Option STD_DEBUG;
     const Option STD_VERBOSE;
+    const Option STD_JOBS;
     const Option STD_HELP;
     const Option STD_VERSION;
     const Option STD_VERSIONX;
@@ -33,10 +33,8 @@ namespace mp4v2 { namespace util {
 
 ///////////////////////////////////////////////////////////////////////////////
 
-uint32_t
-crc32( const unsigned char* data, uint32_t size )
-{
-    static const uint32_t __crctab[256] = {
+namespace {
+    const uint32_t __crctab[256] = {
         0x0,
         0x04c11db7, 0x09823b6e, 0x0d4326d9, 0x130476dc, 0x17c56b6b,
         0x1a864db2, 0x1e475005, 0x2608edb8, 0x22c9f00f, 0x2f8ad6d6,
@@ -90,15 +88,36 @@ crc32( const unsigned char* data, uint32_t size )
         0x933eb0bb, 0x97ffad0c, 0xafb010b1, 0xab710d06, 0xa6322bdf,
         0xa2f33668, 0xbcb4666d, 0xb8757bda, 0xb5365d03, 0xb1f740b4,
     };
+}
 
 #define COMPUTE(var,ch) (var) = (var) << 8 ^ __crctab[(var) >> 24 ^ (ch)]
 
-    uint32_t crc = 0;
+///////////////////////////////////////////////////////////////////////////////
+
+uint32_t
+crc32( const unsigned char* data, uint32_t size )
+{
+    return crc32Finish( crc32Update( 0, data, size ), size );
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+uint32_t
+crc32Update( uint32_t crc, const unsigned char* data, uint32_t size )
+{
     const unsigned char* const max = data + size;
 
     for (const unsigned char* p = data; p < max; p++)
         COMPUTE( crc, *p );
 
+    return crc;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+uint32_t
+crc32Finish( uint32_t crc, uint32_t size )
+{
     for( ; size != 0; size >>= 8 )
         COMPUTE( crc, size & 0xff );
 
@@ -30,6 +30,10 @@ namespace mp4v2 { namespace util {
 
 uint32_t crc32( const unsigned char*, uint32_t ); // ISO/IEC 8802-3:1989
 
+// incremental form: crc32Finish( crc32Update( 0, ... ) ..., total size )
+uint32_t crc32Update( uint32_t, const unsigned char*, uint32_t );
+uint32_t crc32Finish( uint32_t, uint32_t );
+
 ///////////////////////////////////////////////////////////////////////////////
 
 }} // namespace mp4v2::util
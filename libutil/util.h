@@ -22,6 +22,7 @@ namespace mp4v2 { namespace util {
 
 ///////////////////////////////////////////////////////////////////////////////
 
+#include "BatchRunner.h"
 #include "Timecode.h"
 #include "TrackModifier.h"
 #include "Utility.h"
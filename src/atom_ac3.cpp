@@ -51,7 +51,10 @@ MP4Ac3Atom::MP4Ac3Atom(MP4File &file)
 
     AddReserved(*this,"reserved4", 2); /* 7 */
 
-    ExpectChildAtom("dac3", Required, OnlyOne);
+    static const MP4AtomInfo children[] = {
+        MP4AtomInfo("dac3", Required, OnlyOne),
+    };
+    ExpectChildAtoms(children);
 }
 
 void MP4Ac3Atom::Generate()
@@ -47,7 +47,10 @@ MP4AmrAtom::MP4AmrAtom(MP4File &file, const char *type)
 
     AddReserved(*this,"reserved3", 2); /* 4 */
 
-    ExpectChildAtom("damr", Required, OnlyOne);
+    static const MP4AtomInfo children[] = {
+        MP4AtomInfo("damr", Required, OnlyOne),
+    };
+    ExpectChildAtoms(children);
 }
 
 void MP4AmrAtom::Generate()
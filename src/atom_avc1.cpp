@@ -52,11 +52,14 @@ MP4Avc1Atom::MP4Avc1Atom(MP4File &file)
 
     AddReserved(*this, "reserved4", 4); /* 7 */
 
-    ExpectChildAtom("avcC", Required, OnlyOne);
-    ExpectChildAtom("btrt", Optional, OnlyOne);
-    ExpectChildAtom("colr", Optional, OnlyOne);
-    ExpectChildAtom("pasp", Optional, OnlyOne);
-    // for now ExpectChildAtom("m4ds", Optional, OnlyOne);
+    static const MP4AtomInfo children[] = {
+        MP4AtomInfo("avcC", Required, OnlyOne),
+        MP4AtomInfo("btrt", Optional, OnlyOne),
+        MP4AtomInfo("colr", Optional, OnlyOne),
+        MP4AtomInfo("pasp", Optional, OnlyOne),
+        // for now MP4AtomInfo("m4ds", Optional, OnlyOne),
+    };
+    ExpectChildAtoms(children);
 }
 
 void MP4Avc1Atom::Generate()
@@ -49,7 +49,10 @@ MP4D263Atom::MP4D263Atom(MP4File &file)
     AddProperty( /* 3 */
         new MP4Integer8Property(*this, "h263Profile"));
 
-    ExpectChildAtom("bitr", Optional, OnlyOne);
+    static const MP4AtomInfo children[] = {
+        MP4AtomInfo("bitr", Optional, OnlyOne),
+    };
+    ExpectChildAtoms(children);
 
 }
 
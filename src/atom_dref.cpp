@@ -36,9 +36,12 @@ MP4DrefAtom::MP4DrefAtom(MP4File &file)
     pCount->SetReadOnly();
     AddProperty(pCount);
 
-    ExpectChildAtom("url ", Optional, Many);
-    ExpectChildAtom("urn ", Optional, Many);
-    ExpectChildAtom("alis", Optional, Many);
+    static const MP4AtomInfo children[] = {
+        MP4AtomInfo("url ", Optional, Many),
+        MP4AtomInfo("urn ", Optional, Many),
+        MP4AtomInfo("alis", Optional, Many),
+    };
+    ExpectChildAtoms(children);
 }
 
 void MP4DrefAtom::Read()
@@ -27,16 +27,17 @@ namespace impl {
 MP4GminAtom::MP4GminAtom(MP4File &file)
         : MP4Atom(file, "gmin")
 {
-
-    AddVersionAndFlags(); /* 0, 1 */
-
-    AddProperty(new MP4Integer16Property(*this, "graphicsMode")); /* 2 */
-    AddProperty(new MP4Integer16Property(*this, "opColorRed")); /* 3 */
-    AddProperty(new MP4Integer16Property(*this, "opColorGreen")); /* 4 */
-    AddProperty(new MP4Integer16Property(*this, "opColorBlue")); /* 5 */
-    AddProperty(new MP4Integer16Property(*this, "balance")); /* 6 */
-    AddReserved(*this, "reserved", 2); /* 7 */
-
+    static const MP4PropertyInfo properties[] = {
+        MP4PropertyInfo(Integer8Property, "version"),        /* 0 */
+        MP4PropertyInfo(Integer24Property, "flags"),         /* 1 */
+        MP4PropertyInfo(Integer16Property, "graphicsMode"),  /* 2 */
+        MP4PropertyInfo(Integer16Property, "opColorRed"),    /* 3 */
+        MP4PropertyInfo(Integer16Property, "opColorGreen"),  /* 4 */
+        MP4PropertyInfo(Integer16Property, "opColorBlue"),   /* 5 */
+        MP4PropertyInfo(Integer16Property, "balance"),       /* 6 */
+        MP4PropertyInfo(BytesProperty, "reserved", 2, MP4PropertyInfo::ReadOnly), /* 7 */
+    };
+    AddProperties(properties);
 }
 
 void MP4GminAtom::Generate()
@@ -29,14 +29,15 @@ namespace impl {
 MP4HdlrAtom::MP4HdlrAtom(MP4File &file)
         : MP4Atom(file, "hdlr")
 {
-    AddVersionAndFlags(); /* 0, 1 */
-    AddReserved(*this, "reserved1", 4); /* 2 */
-    MP4StringProperty* pProp = new MP4StringProperty(*this, "handlerType");
-    pProp->SetFixedLength(4);
-    AddProperty(pProp); /* 3 */
-    AddReserved(*this, "reserved2", 12); /* 4 */
-    AddProperty( /* 5 */
-        new MP4StringProperty(*this, "name"));
+    static const MP4PropertyInfo properties[] = {
+        MP4PropertyInfo(Integer8Property, "version"),     /* 0 */
+        MP4PropertyInfo(Integer24Property, "flags"),      /* 1 */
+        MP4PropertyInfo(BytesProperty, "reserved1", 4, MP4PropertyInfo::ReadOnly),  /* 2 */
+        MP4PropertyInfo(StringProperty, "handlerType", 4),                          /* 3 */
+        MP4PropertyInfo(BytesProperty, "reserved2", 12, MP4PropertyInfo::ReadOnly), /* 4 */
+        MP4PropertyInfo(StringProperty, "name"),          /* 5 */
+    };
+    AddProperties(properties);
 }
 
 // There is a spec incompatiblity between QT and MP4
@@ -28,18 +28,21 @@ namespace mp4v2 { namespace impl {
 MP4HinfAtom::MP4HinfAtom(MP4File &file)
         : MP4Atom(file, "hinf")
 {
-    ExpectChildAtom("trpy", Optional, OnlyOne);
-    ExpectChildAtom("nump", Optional, OnlyOne);
-    ExpectChildAtom("tpyl", Optional, OnlyOne);
-    ExpectChildAtom("maxr", Optional, Many);
-    ExpectChildAtom("dmed", Optional, OnlyOne);
-    ExpectChildAtom("dimm", Optional, OnlyOne);
-    ExpectChildAtom("drep", Optional, OnlyOne);
-    ExpectChildAtom("tmin", Optional, OnlyOne);
-    ExpectChildAtom("tmax", Optional, OnlyOne);
-    ExpectChildAtom("pmax", Optional, OnlyOne);
-    ExpectChildAtom("dmax", Optional, OnlyOne);
-    ExpectChildAtom("payt", Optional, OnlyOne);
+    static const MP4AtomInfo children[] = {
+        MP4AtomInfo("trpy", Optional, OnlyOne),
+        MP4AtomInfo("nump", Optional, OnlyOne),
+        MP4AtomInfo("tpyl", Optional, OnlyOne),
+        MP4AtomInfo("maxr", Optional, Many),
+        MP4AtomInfo("dmed", Optional, OnlyOne),
+        MP4AtomInfo("dimm", Optional, OnlyOne),
+        MP4AtomInfo("drep", Optional, OnlyOne),
+        MP4AtomInfo("tmin", Optional, OnlyOne),
+        MP4AtomInfo("tmax", Optional, OnlyOne),
+        MP4AtomInfo("pmax", Optional, OnlyOne),
+        MP4AtomInfo("dmax", Optional, OnlyOne),
+        MP4AtomInfo("payt", Optional, OnlyOne),
+    };
+    ExpectChildAtoms(children);
 }
 
 void MP4HinfAtom::Generate()
@@ -48,9 +51,9 @@ void MP4HinfAtom::Generate()
     // are optional (on read), if we generate it for writing
     // we really want all the children
 
-    for (uint32_t i = 0; i < m_pChildAtomInfos.Size(); i++) {
+    for (uint32_t i = 0; i < m_numChildAtomInfos; i++) {
         MP4Atom* pChildAtom =
-            CreateAtom(m_File, this, m_pChildAtomInfos[i]->m_name);
+            CreateAtom(m_File, this, m_pChildAtomInfos[i].m_name);
 
         AddChildAtom(pChildAtom);
 
@@ -33,7 +33,10 @@ MP4HrefAtom::MP4HrefAtom(MP4File &file)
 
     AddProperty( /* 1 */
         new MP4Integer16Property(*this, "dataReferenceIndex"));
-    ExpectChildAtom("burl", Optional, OnlyOne);
+    static const MP4AtomInfo children[] = {
+        MP4AtomInfo("burl", Optional, OnlyOne),
+    };
+    ExpectChildAtoms(children);
 }
 
 void MP4HrefAtom::Generate()
@@ -66,9 +66,12 @@ MP4FullAtom::MP4FullAtom( MP4File &file, const char* type )
 MP4ItemAtom::MP4ItemAtom( MP4File &file, const char* type )
     : MP4Atom( file, type )
 {
-    ExpectChildAtom( "mean", Optional, OnlyOne );
-    ExpectChildAtom( "name", Optional, OnlyOne );
-    ExpectChildAtom( "data", Required, Many );
+    static const MP4AtomInfo children[] = {
+        MP4AtomInfo("mean", Optional, OnlyOne),
+        MP4AtomInfo("name", Optional, OnlyOne),
+        MP4AtomInfo("data", Required, Many),
+    };
+    ExpectChildAtoms(children);
 }
 
 ///////////////////////////////////////////////////////////////////////////////
@@ -33,7 +33,10 @@ MP4Mp4sAtom::MP4Mp4sAtom(MP4File &file)
     AddProperty(
         new MP4Integer16Property(*this, "dataReferenceIndex"));
 
-    ExpectChildAtom("esds", Required, OnlyOne);
+    static const MP4AtomInfo children[] = {
+        MP4AtomInfo("esds", Required, OnlyOne),
+    };
+    ExpectChildAtoms(children);
 }
 
 void MP4Mp4sAtom::Generate()
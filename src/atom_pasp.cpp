@@ -27,13 +27,11 @@ namespace impl {
 MP4PaspAtom::MP4PaspAtom(MP4File &file)
         : MP4Atom(file, "pasp")
 {
-
-    AddProperty( /* 0 */
-        new MP4Integer32Property(*this, "hSpacing"));
-
-    AddProperty( /* 1 */
-        new MP4Integer32Property(*this, "vSpacing"));
-
+    static const MP4PropertyInfo properties[] = {
+        MP4PropertyInfo(Integer32Property, "hSpacing"), /* 0 */
+        MP4PropertyInfo(Integer32Property, "vSpacing"), /* 1 */
+    };
+    AddProperties(properties);
 }
 
 void MP4PaspAtom::Generate()
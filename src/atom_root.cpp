@@ -32,13 +32,16 @@ MP4RootAtom::MP4RootAtom(MP4File &file)
     , m_rewrite_free         ( NULL )
     , m_rewrite_freePosition ( 0 )
 {
-    ExpectChildAtom( "moov", Required, OnlyOne );
-    ExpectChildAtom( "ftyp", Optional, OnlyOne );
-    ExpectChildAtom( "mdat", Optional, Many );
-    ExpectChildAtom( "free", Optional, Many );
-    ExpectChildAtom( "skip", Optional, Many );
-    ExpectChildAtom( "udta", Optional, Many );
-    ExpectChildAtom( "moof", Optional, Many );
+    static const MP4AtomInfo children[] = {
+        MP4AtomInfo("moov", Required, OnlyOne),
+        MP4AtomInfo("ftyp", Optional, OnlyOne),
+        MP4AtomInfo("mdat", Optional, Many),
+        MP4AtomInfo("free", Optional, Many),
+        MP4AtomInfo("skip", Optional, Many),
+        MP4AtomInfo("udta", Optional, Many),
+        MP4AtomInfo("moof", Optional, Many),
+    };
+    ExpectChildAtoms(children);
 }
 
 void MP4RootAtom::BeginWrite(bool use64)
@@ -96,17 +99,33 @@ void MP4RootAtom::FinishWrite(bool use64)
 
     // write all atoms after last mdat
     const uint32_t size = m_pChildAtoms.Size();
-    for ( uint32_t i = mdatIndex + 1; i < size; i++ )
-        m_pChildAtoms[i]->Write();
+    m_File.BeginBufferedWrite();
+    try {
+        for ( uint32_t i = mdatIndex + 1; i < size; i++ )
+            m_pChildAtoms[i]->Write();
+    }
+    catch (Exception*) {
+        m_File.AbortBufferedWrite();
+        throw;
+    }
+    m_File.FinishBufferedWrite();
 }
 
 void MP4RootAtom::BeginOptimalWrite()
 {
-    WriteAtomType("ftyp", OnlyOne);
-    WriteAtomType("moov", OnlyOne);
-    WriteAtomType("udta", Many);
+    m_File.BeginBufferedWrite();
+    try {
+        WriteAtomType("ftyp", OnlyOne);
+        WriteAtomType("moov", OnlyOne);
+        WriteAtomType("udta", Many);
 
-    m_pChildAtoms[GetLastMdatIndex()]->BeginWrite(m_File.Use64Bits("mdat"));
+        m_pChildAtoms[GetLastMdatIndex()]->BeginWrite(m_File.Use64Bits("mdat"));
+    }
+    catch (Exception*) {
+        m_File.AbortBufferedWrite();
+        throw;
+    }
+    m_File.FinishBufferedWrite();
 }
 
 void MP4RootAtom::FinishOptimalWrite()
@@ -132,7 +151,15 @@ void MP4RootAtom::FinishOptimalWrite()
     m_File.SetPosition(pMoovAtom->GetStart());
     uint64_t oldSize = pMoovAtom->GetSize();
 
-    pMoovAtom->Write();
+    m_File.BeginBufferedWrite();
+    try {
+        pMoovAtom->Write();
+    }
+    catch (Exception*) {
+        m_File.AbortBufferedWrite();
+        throw;
+    }
+    m_File.FinishBufferedWrite();
 
     // sanity check
     uint64_t newSize = pMoovAtom->GetSize();
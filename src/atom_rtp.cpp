@@ -50,9 +50,12 @@ void MP4RtpAtom::AddPropertiesStsdType()
     AddProperty( /* 4 */
         new MP4Integer32Property(*this, "maxPacketSize"));
 
-    ExpectChildAtom("tims", Required, OnlyOne);
-    ExpectChildAtom("tsro", Optional, OnlyOne);
-    ExpectChildAtom("snro", Optional, OnlyOne);
+    static const MP4AtomInfo children[] = {
+        MP4AtomInfo("tims", Required, OnlyOne),
+        MP4AtomInfo("tsro", Optional, OnlyOne),
+        MP4AtomInfo("snro", Optional, OnlyOne),
+    };
+    ExpectChildAtoms(children);
 }
 
 void MP4RtpAtom::AddPropertiesHntiType()
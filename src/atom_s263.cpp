@@ -51,7 +51,10 @@ MP4S263Atom::MP4S263Atom(MP4File &file)
     AddReserved(*this, "reserved3", 50); /* 5 */
 
 
-    ExpectChildAtom("d263", Required, OnlyOne);
+    static const MP4AtomInfo children[] = {
+        MP4AtomInfo("d263", Required, OnlyOne),
+    };
+    ExpectChildAtoms(children);
 }
 
 void MP4S263Atom::Generate()
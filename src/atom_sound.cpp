@@ -38,10 +38,16 @@ MP4SoundAtom::MP4SoundAtom(MP4File &file, const char *atomid)
     AddReserved( *this, "reserved2", 6); /* 3 */
 
     if (ATOMID(atomid) == ATOMID("mp4a")) {
-        ExpectChildAtom("esds", Required, OnlyOne);
-        ExpectChildAtom("wave", Optional, OnlyOne);
+        static const MP4AtomInfo children[] = {
+            MP4AtomInfo("esds", Required, OnlyOne),
+            MP4AtomInfo("wave", Optional, OnlyOne),
+        };
+        ExpectChildAtoms(children);
     } else if (ATOMID(atomid) == ATOMID("alac")) {
-        ExpectChildAtom("alac", Optional, Optional);
+        static const MP4AtomInfo children[] = {
+            MP4AtomInfo("alac", Optional, Optional),
+        };
+        ExpectChildAtoms(children);
         //AddProperty( new MP4BytesProperty(*this, "alacInfo", 36));
     }
 }
@@ -154,14 +160,14 @@ void MP4SoundAtom::Read()
             AddProperty(new MP4BytesProperty(*this, "decoderConfig", m_size));
             ReadProperties();
         }
-        if (m_pChildAtomInfos.Size() > 0) {
+        if (m_numChildAtomInfos > 0) {
             ReadChildAtoms();
         }
     } else {
         ReadProperties(0, 3); // read first 3 properties
         AddProperties(((MP4IntegerProperty *)m_pProperties[2])->GetValue());
         ReadProperties(3); // continue
-        if (m_pChildAtomInfos.Size() > 0) {
+        if (m_numChildAtomInfos > 0) {
             ReadChildAtoms();
         }
     }
@@ -28,390 +28,594 @@ namespace mp4v2 { namespace impl {
 MP4StandardAtom::MP4StandardAtom (MP4File &file, const char *type) : MP4Atom(file, type)
 {
     /*
-     * This is a big if else loop.  Make sure that you don't break it
-     * when adding new atoms, or you will set the unknown type flag
+     * This is a big switch on the atom id.  Types without a case here
+     * are flagged as unknown; types with a class of their own are
+     * dispatched by MP4Atom::factory() and never get here.
      *
-     * Try to keep it in alphabetical order - it should only be called
-     * 1 time per atom, so it's not that urgent.
+     * Try to keep it in alphabetical order.
      */
-    if (ATOMID(type) == ATOMID("bitr")) {
-        AddProperty( /* 0 */
-            new MP4Integer32Property(*this, "avgBitrate"));
-
-        AddProperty( /* 1 */
-            new MP4Integer32Property(*this, "maxBitrate"));
-
-    } else if (ATOMID(type) == ATOMID("btrt")) {
-        AddProperty( new MP4Integer32Property(*this, "bufferSizeDB")); /* 0 */
-        AddProperty( new MP4Integer32Property(*this, "avgBitrate"));   /* 1 */
-        AddProperty( new MP4Integer32Property(*this, "maxBitrate"));   /* 2 */
-    } else if (ATOMID(type) == ATOMID("burl")) {
-        AddProperty( new MP4StringProperty(*this, "base_url"));
-        /*
-         * c???
-         */
-    } else if (ATOMID(type) == ATOMID("co64")) {
-        AddVersionAndFlags();
-
-        MP4Integer32Property* pCount =
-            new MP4Integer32Property(*this, "entryCount");
-        AddProperty(pCount);
-
-        MP4TableProperty* pTable = new MP4TableProperty(*this, "entries", pCount);
-        AddProperty(pTable);
-
-        pTable->AddProperty(
-            new MP4Integer64Property(*this, "chunkOffset"));
-    } else if (ATOMID(type) == ATOMID("ctts")) {
-        AddVersionAndFlags();
-
-        MP4Integer32Property* pCount =
-            new MP4Integer32Property(*this, "entryCount");
-        AddProperty(pCount);
-
-        MP4TableProperty* pTable = new MP4TableProperty(*this, "entries", pCount);
-        AddProperty(pTable);
+    switch (ATOMID(type)) {
+    case ATOMID("bitr"): {
+        static const MP4PropertyInfo properties[] = {
+            MP4PropertyInfo(Integer32Property, "avgBitrate"),
+            MP4PropertyInfo(Integer32Property, "maxBitrate"),
+        };
+        AddProperties(properties);
+        break;
+    }
 
-        pTable->AddProperty(new MP4Integer32Property(pTable->GetParentAtom(), "sampleCount"));
-        pTable->AddProperty(new MP4Integer32Property(pTable->GetParentAtom(), "sampleOffset"));
-        /*
-         * d???
-         */
-    } else if (ATOMID(type) == ATOMID("dinf")) {
-        ExpectChildAtom("dref", Required, OnlyOne);
+    case ATOMID("btrt"): {
+        static const MP4PropertyInfo properties[] = {
+            MP4PropertyInfo(Integer32Property, "bufferSizeDB"),
+            MP4PropertyInfo(Integer32Property, "avgBitrate"),
+            MP4PropertyInfo(Integer32Property, "maxBitrate"),
+        };
+        AddProperties(properties);
+        break;
+    }
+    case ATOMID("burl"): {
+        static const MP4PropertyInfo properties[] = {
+            MP4PropertyInfo(StringProperty, "base_url"),
+        };
+        AddProperties(properties);
+        break;
+    }
+    /*
+     * c???
+     */
+    case ATOMID("co64"): {
+        static const MP4PropertyInfo properties[] = {
+            MP4PropertyInfo(Integer8Property, "version"),
+            MP4PropertyInfo(Integer24Property, "flags"),
+            MP4PropertyInfo(Integer32Property, "entryCount"),
+            MP4PropertyInfo(TableProperty, "entries", 1),
+                MP4PropertyInfo(Integer64Property, "chunkOffset"),
+        };
+        AddProperties(properties);
+        break;
+    }
+    case ATOMID("ctts"): {
+        static const MP4PropertyInfo properties[] = {
+            MP4PropertyInfo(Integer8Property, "version"),
+            MP4PropertyInfo(Integer24Property, "flags"),
+            MP4PropertyInfo(Integer32Property, "entryCount"),
+            MP4PropertyInfo(TableProperty, "entries", 2),
+                MP4PropertyInfo(Integer32Property, "sampleCount"),
+                MP4PropertyInfo(Integer32Property, "sampleOffset"),
+        };
+        AddProperties(properties);
+        break;
+    }
+    /*
+     * d???
+     */
+    case ATOMID("dinf"): {
+        static const MP4AtomInfo children[] = {
+            MP4AtomInfo("dref", Required, OnlyOne),
+        };
+        ExpectChildAtoms(children);
+        break;
+    }
 
-    } else if (ATOMID(type) == ATOMID("dimm")) {
-        AddProperty( // bytes of immediate data
-            new MP4Integer64Property(*this, "bytes"));
+    case ATOMID("dimm"): {
+        static const MP4PropertyInfo properties[] = {
+            MP4PropertyInfo(Integer64Property, "bytes"), // bytes of immediate data
+        };
+        AddProperties(properties);
+        break;
+    }
 
-    } else if (ATOMID(type) == ATOMID("dmax")) {
-        AddProperty( // max packet duration
-            new MP4Integer32Property(*this, "milliSecs"));
+    case ATOMID("dmax"): {
+        static const MP4PropertyInfo properties[] = {
+            MP4PropertyInfo(Integer32Property, "milliSecs"), // max packet duration
+        };
+        AddProperties(properties);
+        break;
+    }
 
-    } else if (ATOMID(type) == ATOMID("dmed")) {
-        AddProperty( // bytes sent from media data
-            new MP4Integer64Property(*this, "bytes"));
+    case ATOMID("dmed"): {
+        static const MP4PropertyInfo properties[] = {
+            MP4PropertyInfo(Integer64Property, "bytes"), // bytes sent from media data
+        };
+        AddProperties(properties);
+        break;
+    }
 
-    } else if (ATOMID(type) == ATOMID("drep")) {
-        AddProperty( // bytes of repeated data
-            new MP4Integer64Property(*this, "bytes"));
-        /*
-         * e???
-         */
-    } else if (ATOMID(type) == ATOMID("edts")) {
-        ExpectChildAtom("elst", Required, OnlyOne);
+    case ATOMID("drep"): {
+        static const MP4PropertyInfo properties[] = {
+            MP4PropertyInfo(Integer64Property, "bytes"), // bytes of repeated data
+        };
+        AddProperties(properties);
+        break;
+    }
+    /*
+     * e???
+     */
+    case ATOMID("edts"): {
+        static const MP4AtomInfo children[] = {
+            MP4AtomInfo("elst", Required, OnlyOne),
+        };
+        ExpectChildAtoms(children);
+        break;
+    }
 
-    } else if (ATOMID(type) == ATOMID("esds")) {
+    case ATOMID("esds"): {
         AddVersionAndFlags();
         AddProperty(
             new MP4DescriptorProperty(*this, NULL, MP4ESDescrTag, 0,
                                       Required, OnlyOne));
-        /*
-         * f???
-         */
-    } else if (ATOMID(type) == ATOMID("frma")) {
-        AddProperty( /* 0 */
-            new MP4Integer32Property(*this, "data-format"));
-        /*
-         * g???
-         */
-    } else if (ATOMID(type) == ATOMID("gmhd")) {
-        ExpectChildAtom("gmin", Required, OnlyOne);
-        ExpectChildAtom("tmcd", Optional, OnlyOne);
-        ExpectChildAtom("text", Optional, OnlyOne);
-    } else if (ATOMID(type) == ATOMID("hmhd")) {
-        AddVersionAndFlags();
+        break;
+    }
+    /*
+     * f???
+     */
+    case ATOMID("frma"): {
+        static const MP4PropertyInfo properties[] = {
+            MP4PropertyInfo(Integer32Property, "data-format"),
+        };
+        AddProperties(properties);
+        break;
+    }
+    /*
+     * g???
+     */
+    case ATOMID("gmhd"): {
+        static const MP4AtomInfo children[] = {
+            MP4AtomInfo("gmin", Required, OnlyOne),
+            MP4AtomInfo("tmcd", Optional, OnlyOne),
+            MP4AtomInfo("text", Optional, OnlyOne),
+        };
+        ExpectChildAtoms(children);
+        break;
+    }
+    case ATOMID("hmhd"): {
+        static const MP4PropertyInfo properties[] = {
+            MP4PropertyInfo(Integer8Property, "version"),
+            MP4PropertyInfo(Integer24Property, "flags"),
+            MP4PropertyInfo(Integer16Property, "maxPduSize"),
+            MP4PropertyInfo(Integer16Property, "avgPduSize"),
+            MP4PropertyInfo(Integer32Property, "maxBitRate"),
+            MP4PropertyInfo(Integer32Property, "avgBitRate"),
+            MP4PropertyInfo(Integer32Property, "slidingAvgBitRate"),
+        };
+        AddProperties(properties);
+        break;
+    }
+    /*
+     * i???
+     */
+    case ATOMID("iKMS"): {
+        static const MP4PropertyInfo properties[] = {
+            MP4PropertyInfo(Integer8Property, "version"),
+            MP4PropertyInfo(Integer24Property, "flags"),
+            MP4PropertyInfo(StringProperty, "kms_URI"),
+        };
+        AddProperties(properties);
+        break;
+    }
 
-        AddProperty(new MP4Integer16Property(*this, "maxPduSize"));
-        AddProperty(new MP4Integer16Property(*this, "avgPduSize"));
-        AddProperty(new MP4Integer32Property(*this, "maxBitRate"));
-        AddProperty(new MP4Integer32Property(*this, "avgBitRate"));
-        AddProperty(new MP4Integer32Property(*this, "slidingAvgBitRate"));
-        /*
-         * i???
-         */
-    } else if (ATOMID(type) == ATOMID("iKMS")) {
-        AddVersionAndFlags(); /* 0, 1 */
-        MP4StringProperty* pProp = new MP4StringProperty(*this, "kms_URI");
-        AddProperty(pProp); /* 2 */
+    case ATOMID("iSFM"): {
+        static const MP4PropertyInfo properties[] = {
+            MP4PropertyInfo(Integer8Property, "version"),
+            MP4PropertyInfo(Integer24Property, "flags"),
+            MP4PropertyInfo(Integer64Property, "selective-encryption", 1), // bitfields
+            MP4PropertyInfo(Integer64Property, "reserved", 7),
+            MP4PropertyInfo(Integer8Property, "key-indicator-length"),
+            MP4PropertyInfo(Integer8Property, "IV-length"),
+        };
+        AddProperties(properties);
+        break;
+    }
 
-    } else if (ATOMID(type) == ATOMID("iSFM")) {
-        AddVersionAndFlags(); /* 0, 1 */
-        AddProperty( /* 2 */
-            new MP4BitfieldProperty(*this, "selective-encryption", 1));
-        AddProperty( /* 3 */
-            new MP4BitfieldProperty(*this, "reserved", 7));
-        AddProperty( /* 4 */
-            new MP4Integer8Property(*this, "key-indicator-length"));
-        AddProperty( /* 5 */
-            new MP4Integer8Property(*this, "IV-length"));
-
-    } else if (ATOMID(type) == ATOMID("ilst")) {
-        ExpectChildAtom("\251nam", Optional, OnlyOne); /* name */
-        ExpectChildAtom("\251ART", Optional, OnlyOne); /* artist */
-        ExpectChildAtom("\251wrt", Optional, OnlyOne); /* writer */
-        ExpectChildAtom("\251alb", Optional, OnlyOne); /* album */
-        ExpectChildAtom("\251day", Optional, OnlyOne); /* date */
-        ExpectChildAtom("\251too", Optional, OnlyOne); /* tool */
-        ExpectChildAtom("\251cmt", Optional, OnlyOne); /* comment */
-        ExpectChildAtom("\251gen", Optional, OnlyOne); /* custom genre */
-        ExpectChildAtom("trkn", Optional, OnlyOne); /* tracknumber */
-        ExpectChildAtom("disk", Optional, OnlyOne); /* disknumber */
-        ExpectChildAtom("gnre", Optional, OnlyOne); /* genre (ID3v1 index + 1) */
-        ExpectChildAtom("cpil", Optional, OnlyOne); /* compilation */
-        ExpectChildAtom("tmpo", Optional, OnlyOne); /* BPM */
-        ExpectChildAtom("covr", Optional, OnlyOne); /* cover art */
-        ExpectChildAtom("aART", Optional, OnlyOne); /* album artist */
-        ExpectChildAtom("----", Optional, Many); /* ---- free form */
-        ExpectChildAtom("pgap", Optional, OnlyOne); /* part of gapless album */
-        ExpectChildAtom("tvsh", Optional, OnlyOne); /* TV show */
-        ExpectChildAtom("tvsn", Optional, OnlyOne); /* TV season */
-        ExpectChildAtom("tven", Optional, OnlyOne); /* TV episode number */
-        ExpectChildAtom("tvnn", Optional, OnlyOne); /* TV network name */
-        ExpectChildAtom("tves", Optional, OnlyOne); /* TV epsidoe */
-        ExpectChildAtom("desc", Optional, OnlyOne); /* description */
-        ExpectChildAtom("ldes", Optional, OnlyOne); /* long description */
-        ExpectChildAtom("soal", Optional, OnlyOne); /* sort album */
-        ExpectChildAtom("soar", Optional, OnlyOne); /* sort artist */
-        ExpectChildAtom("soaa", Optional, OnlyOne); /* sort album artist */
-        ExpectChildAtom("sonm", Optional, OnlyOne); /* sort name */
-        ExpectChildAtom("soco", Optional, OnlyOne); /* sort composer */
-        ExpectChildAtom("sosn", Optional, OnlyOne); /* sort show */
-        ExpectChildAtom("hdvd", Optional, OnlyOne); /* HD video */
-        ExpectChildAtom("\251enc", Optional, OnlyOne); /* Encoded by */
-        ExpectChildAtom("pcst", Optional, OnlyOne); /* Podcast flag */
-        ExpectChildAtom("keyw", Optional, OnlyOne); /* Keywords (for podcasts?) */
-        ExpectChildAtom("catg", Optional, OnlyOne); /* Category (for podcasts?) */
-        ExpectChildAtom("purl", Optional, OnlyOne); /* Podcast URL */
-        ExpectChildAtom("egid", Optional, OnlyOne); /* Podcast episode global unique ID */
-        ExpectChildAtom("rtng", Optional, OnlyOne); /* Content Rating */
-        ExpectChildAtom("stik", Optional, OnlyOne); /* MediaType */
-        ExpectChildAtom("\251grp", Optional, OnlyOne); /* Grouping */
-        ExpectChildAtom("\251lyr", Optional, OnlyOne); /* Lyrics */
-        ExpectChildAtom("cprt", Optional, OnlyOne); /* Copyright */
-        ExpectChildAtom("apID", Optional, OnlyOne); /* iTunes Account */
-        ExpectChildAtom("akID", Optional, OnlyOne); /* iTunes Account Type */
-        ExpectChildAtom("sfID", Optional, OnlyOne); /* iTunes Country */
-        ExpectChildAtom("cnID", Optional, OnlyOne); /* Content ID */
-        ExpectChildAtom("atID", Optional, OnlyOne); /* Artist ID */
-        ExpectChildAtom("plID", Optional, OnlyOne); /* Playlist ID */
-        ExpectChildAtom("geID", Optional, OnlyOne); /* Genre ID */
-        ExpectChildAtom("cmID", Optional, OnlyOne); /* Composer ID */
-        ExpectChildAtom("xid ", Optional, OnlyOne); /* XID */
-
-    }  else if (ATOMID(type) == ATOMID("imif")) {
+    case ATOMID("ilst"): {
+        static const MP4AtomInfo children[] = {
+            MP4AtomInfo("\251nam", Optional, OnlyOne), /* name */
+            MP4AtomInfo("\251ART", Optional, OnlyOne), /* artist */
+            MP4AtomInfo("\251wrt", Optional, OnlyOne), /* writer */
+            MP4AtomInfo("\251alb", Optional, OnlyOne), /* album */
+            MP4AtomInfo("\251day", Optional, OnlyOne), /* date */
+            MP4AtomInfo("\251too", Optional, OnlyOne), /* tool */
+            MP4AtomInfo("\251cmt", Optional, OnlyOne), /* comment */
+            MP4AtomInfo("\251gen", Optional, OnlyOne), /* custom genre */
+            MP4AtomInfo("trkn", Optional, OnlyOne), /* tracknumber */
+            MP4AtomInfo("disk", Optional, OnlyOne), /* disknumber */
+            MP4AtomInfo("gnre", Optional, OnlyOne), /* genre (ID3v1 index + 1) */
+            MP4AtomInfo("cpil", Optional, OnlyOne), /* compilation */
+            MP4AtomInfo("tmpo", Optional, OnlyOne), /* BPM */
+            MP4AtomInfo("covr", Optional, OnlyOne), /* cover art */
+            MP4AtomInfo("aART", Optional, OnlyOne), /* album artist */
+            MP4AtomInfo("----", Optional, Many), /* ---- free form */
+            MP4AtomInfo("pgap", Optional, OnlyOne), /* part of gapless album */
+            MP4AtomInfo("tvsh", Optional, OnlyOne), /* TV show */
+            MP4AtomInfo("tvsn", Optional, OnlyOne), /* TV season */
+            MP4AtomInfo("tven", Optional, OnlyOne), /* TV episode number */
+            MP4AtomInfo("tvnn", Optional, OnlyOne), /* TV network name */
+            MP4AtomInfo("tves", Optional, OnlyOne), /* TV epsidoe */
+            MP4AtomInfo("desc", Optional, OnlyOne), /* description */
+            MP4AtomInfo("ldes", Optional, OnlyOne), /* long description */
+            MP4AtomInfo("soal", Optional, OnlyOne), /* sort album */
+            MP4AtomInfo("soar", Optional, OnlyOne), /* sort artist */
+            MP4AtomInfo("soaa", Optional, OnlyOne), /* sort album artist */
+            MP4AtomInfo("sonm", Optional, OnlyOne), /* sort name */
+            MP4AtomInfo("soco", Optional, OnlyOne), /* sort composer */
+            MP4AtomInfo("sosn", Optional, OnlyOne), /* sort show */
+            MP4AtomInfo("hdvd", Optional, OnlyOne), /* HD video */
+            MP4AtomInfo("\251enc", Optional, OnlyOne), /* Encoded by */
+            MP4AtomInfo("pcst", Optional, OnlyOne), /* Podcast flag */
+            MP4AtomInfo("keyw", Optional, OnlyOne), /* Keywords (for podcasts?) */
+            MP4AtomInfo("catg", Optional, OnlyOne), /* Category (for podcasts?) */
+            MP4AtomInfo("purl", Optional, OnlyOne), /* Podcast URL */
+            MP4AtomInfo("egid", Optional, OnlyOne), /* Podcast episode global unique ID */
+            MP4AtomInfo("rtng", Optional, OnlyOne), /* Content Rating */
+            MP4AtomInfo("stik", Optional, OnlyOne), /* MediaType */
+            MP4AtomInfo("\251grp", Optional, OnlyOne), /* Grouping */
+            MP4AtomInfo("\251lyr", Optional, OnlyOne), /* Lyrics */
+            MP4AtomInfo("cprt", Optional, OnlyOne), /* Copyright */
+            MP4AtomInfo("apID", Optional, OnlyOne), /* iTunes Account */
+            MP4AtomInfo("akID", Optional, OnlyOne), /* iTunes Account Type */
+            MP4AtomInfo("sfID", Optional, OnlyOne), /* iTunes Country */
+            MP4AtomInfo("cnID", Optional, OnlyOne), /* Content ID */
+            MP4AtomInfo("atID", Optional, OnlyOne), /* Artist ID */
+            MP4AtomInfo("plID", Optional, OnlyOne), /* Playlist ID */
+            MP4AtomInfo("geID", Optional, OnlyOne), /* Genre ID */
+            MP4AtomInfo("cmID", Optional, OnlyOne), /* Composer ID */
+            MP4AtomInfo("xid ", Optional, OnlyOne), /* XID */
+        };
+        ExpectChildAtoms(children);
+        break;
+    }
+
+    case ATOMID("imif"): {
         AddVersionAndFlags();
         AddProperty(new MP4DescriptorProperty(*this, "ipmp_desc", MP4IPMPDescrTag,
                                               MP4IPMPDescrTag, Required, Many));
-    } else if (ATOMID(type) == ATOMID("iods")) {
+        break;
+    }
+    case ATOMID("iods"): {
         AddVersionAndFlags();
         AddProperty(
             new MP4DescriptorProperty(*this, NULL, MP4FileIODescrTag,
                                       MP4FileODescrTag,
                                       Required, OnlyOne));
-        /*
-         * m???
-         */
-    } else if (ATOMID(type) == ATOMID("maxr")) {
-        AddProperty(new MP4Integer32Property(*this, "granularity"));
-        AddProperty(new MP4Integer32Property(*this, "bytes"));
+        break;
+    }
+    /*
+     * m???
+     */
+    case ATOMID("maxr"): {
+        static const MP4PropertyInfo properties[] = {
+            MP4PropertyInfo(Integer32Property, "granularity"),
+            MP4PropertyInfo(Integer32Property, "bytes"),
+        };
+        AddProperties(properties);
+        break;
+    }
 
-    } else if (ATOMID(type) == ATOMID("mdia")) {
-        ExpectChildAtom("mdhd", Required, OnlyOne);
-        ExpectChildAtom("hdlr", Required, OnlyOne);
-        ExpectChildAtom("minf", Required, OnlyOne);
+    case ATOMID("mdia"): {
+        static const MP4AtomInfo children[] = {
+            MP4AtomInfo("mdhd", Required, OnlyOne),
+            MP4AtomInfo("hdlr", Required, OnlyOne),
+            MP4AtomInfo("minf", Required, OnlyOne),
+        };
+        ExpectChildAtoms(children);
+        break;
+    }
 
-    } else if (ATOMID(type) == ATOMID("meta")) { // iTunes
+    case ATOMID("meta"): { // iTunes
         AddVersionAndFlags(); /* 0, 1 */
-        ExpectChildAtom("hdlr", Required, OnlyOne);
-        ExpectChildAtom("ilst", Required, OnlyOne);
-
-    } else if (ATOMID(type) == ATOMID("mfhd")) {
-        AddVersionAndFlags();   /* 0, 1 */
-        AddProperty( /* 2 */
-            new MP4Integer32Property(*this, "sequenceNumber"));
-
-    } else if (ATOMID(type) == ATOMID("minf")) {
-        ExpectChildAtom("vmhd", Optional, OnlyOne);
-        ExpectChildAtom("smhd", Optional, OnlyOne);
-        ExpectChildAtom("hmhd", Optional, OnlyOne);
-        ExpectChildAtom("nmhd", Optional, OnlyOne);
-        ExpectChildAtom("gmhd", Optional, OnlyOne);
-        ExpectChildAtom("dinf", Required, OnlyOne);
-        ExpectChildAtom("stbl", Required, OnlyOne);
-
-    } else if (ATOMID(type) == ATOMID("moof")) {
-        ExpectChildAtom("mfhd", Required, OnlyOne);
-        ExpectChildAtom("traf", Optional, Many);
-
-    } else if (ATOMID(type) == ATOMID("moov")) {
-        ExpectChildAtom("mvhd", Required, OnlyOne);
-        ExpectChildAtom("iods", Optional, OnlyOne);
-        ExpectChildAtom("trak", Required, Many);
-        ExpectChildAtom("udta", Optional, Many);
-        ExpectChildAtom("mvex", Optional, OnlyOne);
-
-    } else if (ATOMID(type) == ATOMID("mvex")) {
-        ExpectChildAtom("trex", Required, Many);
+        static const MP4AtomInfo children[] = {
+            MP4AtomInfo("hdlr", Required, OnlyOne),
+            MP4AtomInfo("ilst", Required, OnlyOne),
+        };
+        ExpectChildAtoms(children);
+        break;
+    }
+
+    case ATOMID("mfhd"): {
+        static const MP4PropertyInfo properties[] = {
+            MP4PropertyInfo(Integer8Property, "version"),
+            MP4PropertyInfo(Integer24Property, "flags"),
+            MP4PropertyInfo(Integer32Property, "sequenceNumber"),
+        };
+        AddProperties(properties);
+        break;
+    }
+
+    case ATOMID("minf"): {
+        static const MP4AtomInfo children[] = {
+            MP4AtomInfo("vmhd", Optional, OnlyOne),
+            MP4AtomInfo("smhd", Optional, OnlyOne),
+            MP4AtomInfo("hmhd", Optional, OnlyOne),
+            MP4AtomInfo("nmhd", Optional, OnlyOne),
+            MP4AtomInfo("gmhd", Optional, OnlyOne),
+            MP4AtomInfo("dinf", Required, OnlyOne),
+            MP4AtomInfo("stbl", Required, OnlyOne),
+        };
+        ExpectChildAtoms(children);
+        break;
+    }
+
+    case ATOMID("moof"): {
+        static const MP4AtomInfo children[] = {
+            MP4AtomInfo("mfhd", Required, OnlyOne),
+            MP4AtomInfo("traf", Optional, Many),
+        };
+        ExpectChildAtoms(children);
+        break;
+    }
+
+    case ATOMID("moov"): {
+        static const MP4AtomInfo children[] = {
+            MP4AtomInfo("mvhd", Required, OnlyOne),
+            MP4AtomInfo("iods", Optional, OnlyOne),
+            MP4AtomInfo("trak", Required, Many),
+            MP4AtomInfo("udta", Optional, Many),
+            MP4AtomInfo("mvex", Optional, OnlyOne),
+        };
+        ExpectChildAtoms(children);
+        break;
+    }
+
+    case ATOMID("mvex"): {
+        static const MP4AtomInfo children[] = {
+            MP4AtomInfo("trex", Required, Many),
+        };
+        ExpectChildAtoms(children);
+        break;
+    }
 
         /*
          * n???
          */
-    } else if (ATOMID(type) == ATOMID("nmhd")) {
+    case ATOMID("nmhd"): {
         AddVersionAndFlags();
+        break;
+    }
 
-    } else if (ATOMID(type) == ATOMID("nump")) {
-        AddProperty( // packets sent
-            new MP4Integer64Property(*this, "packets"));
-        /*
-          * o???
-          */
-    } else if (ATOMID(type) == ATOMID("odkm")) {
+    case ATOMID("nump"): {
+        static const MP4PropertyInfo properties[] = {
+            MP4PropertyInfo(Integer64Property, "packets"), // packets sent
+        };
+        AddProperties(properties);
+        break;
+    }
+    /*
+     * o???
+     */
+    case ATOMID("odkm"): {
         AddVersionAndFlags();
-        ExpectChildAtom("ohdr", Required, OnlyOne);
-        /*
-         * p???
-         */
-    } else if (ATOMID(type) == ATOMID("payt")) {
-        AddProperty(new MP4Integer32Property(*this, "payloadNumber"));
-        AddProperty(new MP4StringProperty(*this, "rtpMap", Counted));
-
-    } else if (ATOMID(type) == ATOMID("pinf")) {
-        ExpectChildAtom("frma", Required, OnlyOne);
-    } else if (ATOMID(type) == ATOMID("pmax")) {
-        AddProperty( // max packet size
-            new MP4Integer32Property(*this, "bytes"));
-    } else if (ATOMID(type) == ATOMID("schi")) {
+        static const MP4AtomInfo children[] = {
+            MP4AtomInfo("ohdr", Required, OnlyOne),
+        };
+        ExpectChildAtoms(children);
+        break;
+    }
+    /*
+     * p???
+     */
+    case ATOMID("payt"): {
+        static const MP4PropertyInfo properties[] = {
+            MP4PropertyInfo(Integer32Property, "payloadNumber"),
+            MP4PropertyInfo(StringProperty, "rtpMap", 0, MP4PropertyInfo::CountedFormat),
+        };
+        AddProperties(properties);
+        break;
+    }
+
+    case ATOMID("pinf"): {
+        static const MP4AtomInfo children[] = {
+            MP4AtomInfo("frma", Required, OnlyOne),
+        };
+        ExpectChildAtoms(children);
+        break;
+    }
+    case ATOMID("pmax"): {
+        static const MP4PropertyInfo properties[] = {
+            MP4PropertyInfo(Integer32Property, "bytes"), // max packet size
+        };
+        AddProperties(properties);
+        break;
+    }
+    case ATOMID("schi"): {
         // not sure if this is child atoms or table of boxes
         // get clarification on spec 9.1.2.5
-        ExpectChildAtom("odkm", Optional, OnlyOne);
-        ExpectChildAtom("iKMS", Optional, OnlyOne);
-        ExpectChildAtom("iSFM", Optional, OnlyOne);
+        static const MP4AtomInfo children[] = {
+            MP4AtomInfo("odkm", Optional, OnlyOne),
+            MP4AtomInfo("iKMS", Optional, OnlyOne),
+            MP4AtomInfo("iSFM", Optional, OnlyOne),
+        };
+        ExpectChildAtoms(children);
+        break;
+    }
 
-    } else if (ATOMID(type) == ATOMID("schm")) {
-        AddVersionAndFlags(); /* 0, 1 */
-        AddProperty( /* 2 */
-            new MP4Integer32Property(*this, "scheme_type"));
-        AddProperty( /* 3 */
-            new MP4Integer32Property(*this, "scheme_version"));
+    case ATOMID("schm"): {
+        static const MP4PropertyInfo properties[] = {
+            MP4PropertyInfo(Integer8Property, "version"),
+            MP4PropertyInfo(Integer24Property, "flags"),
+            MP4PropertyInfo(Integer32Property, "scheme_type"),
+            MP4PropertyInfo(Integer32Property, "scheme_version"),
+        };
+        AddProperties(properties);
         // browser URI if flags set, TODO
+        break;
+    }
 
-    } else if (ATOMID(type) == ATOMID("sinf")) {
-        ExpectChildAtom("frma", Required, OnlyOne);
-        ExpectChildAtom("imif", Optional, OnlyOne);
-        ExpectChildAtom("schm", Optional, OnlyOne);
-        ExpectChildAtom("schi", Optional, OnlyOne);
-
-    } else if (ATOMID(type) == ATOMID("smhd")) {
-        AddVersionAndFlags();
-        AddReserved(*this, "reserved", 4);
-
-    } else if (ATOMID(type) == ATOMID("snro")) {
-        AddProperty(new MP4Integer32Property(*this, "offset"));
-
-    } else if (ATOMID(type) == ATOMID("stco")) {
-        AddVersionAndFlags();
+    case ATOMID("sinf"): {
+        static const MP4AtomInfo children[] = {
+            MP4AtomInfo("frma", Required, OnlyOne),
+            MP4AtomInfo("imif", Optional, OnlyOne),
+            MP4AtomInfo("schm", Optional, OnlyOne),
+            MP4AtomInfo("schi", Optional, OnlyOne),
+        };
+        ExpectChildAtoms(children);
+        break;
+    }
 
-        MP4Integer32Property* pCount = new MP4Integer32Property(*this, "entryCount");
-        AddProperty(pCount);
+    case ATOMID("smhd"): {
+        static const MP4PropertyInfo properties[] = {
+            MP4PropertyInfo(Integer8Property, "version"),
+            MP4PropertyInfo(Integer24Property, "flags"),
+            MP4PropertyInfo(BytesProperty, "reserved", 4, MP4PropertyInfo::ReadOnly),
+        };
+        AddProperties(properties);
+        break;
+    }
 
-        MP4TableProperty* pTable = new MP4TableProperty(*this, "entries", pCount);
-        AddProperty(pTable);
+    case ATOMID("snro"): {
+        static const MP4PropertyInfo properties[] = {
+            MP4PropertyInfo(Integer32Property, "offset"),
+        };
+        AddProperties(properties);
+        break;
+    }
 
-        pTable->AddProperty(new MP4Integer32Property(pTable->GetParentAtom(), "chunkOffset"));
+    case ATOMID("stco"): {
+        static const MP4PropertyInfo properties[] = {
+            MP4PropertyInfo(Integer8Property, "version"),
+            MP4PropertyInfo(Integer24Property, "flags"),
+            MP4PropertyInfo(Integer32Property, "entryCount"),
+            MP4PropertyInfo(TableProperty, "entries", 1),
+                MP4PropertyInfo(Integer32Property, "chunkOffset"),
+        };
+        AddProperties(properties);
+        break;
+    }
 
-    } else if (ATOMID(type) == ATOMID("stsh")) {
-        AddVersionAndFlags();
+    case ATOMID("stsh"): {
+        static const MP4PropertyInfo properties[] = {
+            MP4PropertyInfo(Integer8Property, "version"),
+            MP4PropertyInfo(Integer24Property, "flags"),
+            MP4PropertyInfo(Integer32Property, "entryCount"),
+            MP4PropertyInfo(TableProperty, "entries", 2),
+                MP4PropertyInfo(Integer32Property, "shadowedSampleNumber"),
+                MP4PropertyInfo(Integer32Property, "syncSampleNumber"),
+        };
+        AddProperties(properties);
+        break;
+    }
 
-        MP4Integer32Property* pCount = new MP4Integer32Property(*this, "entryCount");
-        AddProperty(pCount);
+    case ATOMID("stss"): {
+        static const MP4PropertyInfo properties[] = {
+            MP4PropertyInfo(Integer8Property, "version"),
+            MP4PropertyInfo(Integer24Property, "flags"),
+            MP4PropertyInfo(Integer32Property, "entryCount"),
+            MP4PropertyInfo(TableProperty, "entries", 1),
+                MP4PropertyInfo(Integer32Property, "sampleNumber"),
+        };
+        AddProperties(properties);
+        break;
+    }
 
-        MP4TableProperty* pTable = new MP4TableProperty(*this, "entries", pCount);
-        AddProperty(pTable);
+    case ATOMID("stts"): {
+        static const MP4PropertyInfo properties[] = {
+            MP4PropertyInfo(Integer8Property, "version"),
+            MP4PropertyInfo(Integer24Property, "flags"),
+            MP4PropertyInfo(Integer32Property, "entryCount"),
+            MP4PropertyInfo(TableProperty, "entries", 2),
+                MP4PropertyInfo(Integer32Property, "sampleCount"),
+                MP4PropertyInfo(Integer32Property, "sampleDelta"),
+        };
+        AddProperties(properties);
+        break;
+    }
+    case ATOMID("tims"): {
+        static const MP4PropertyInfo properties[] = {
+            MP4PropertyInfo(Integer32Property, "timeScale"),
+        };
+        AddProperties(properties);
+        break;
+    }
 
-        pTable->AddProperty(new MP4Integer32Property(pTable->GetParentAtom(), "shadowedSampleNumber"));
-        pTable->AddProperty(new MP4Integer32Property(pTable->GetParentAtom(), "syncSampleNumber"));
+    case ATOMID("tmin"): {
+        static const MP4PropertyInfo properties[] = {
+            MP4PropertyInfo(Integer32Property, "milliSecs"), // min relative xmit time
+        };
+        AddProperties(properties);
+        break;
+    }
 
-    } else if (ATOMID(type) == ATOMID("stss")) {
-        AddVersionAndFlags();
+    case ATOMID("tmax"): {
+        static const MP4PropertyInfo properties[] = {
+            MP4PropertyInfo(Integer32Property, "milliSecs"), // max relative xmit time
+        };
+        AddProperties(properties);
+        break;
+    }
 
-        MP4Integer32Property* pCount = new MP4Integer32Property(*this, "entryCount");
-        AddProperty(pCount);
+    case ATOMID("traf"): {
+        static const MP4AtomInfo children[] = {
+            MP4AtomInfo("tfhd", Required, OnlyOne),
+            MP4AtomInfo("trun", Optional, Many),
+        };
+        ExpectChildAtoms(children);
+        break;
+    }
 
-        MP4TableProperty* pTable = new MP4TableProperty(*this, "entries", pCount);
-        AddProperty(pTable);
+    case ATOMID("trak"): {
+        static const MP4AtomInfo children[] = {
+            MP4AtomInfo("tkhd", Required, OnlyOne),
+            MP4AtomInfo("tref", Optional, OnlyOne),
+            MP4AtomInfo("edts", Optional, OnlyOne),
+            MP4AtomInfo("mdia", Required, OnlyOne),
+            MP4AtomInfo("udta", Optional, Many),
+        };
+        ExpectChildAtoms(children);
+        break;
+    }
 
-        pTable->AddProperty(new MP4Integer32Property(pTable->GetParentAtom(), "sampleNumber"));
+    case ATOMID("tref"): {
+        static const MP4AtomInfo children[] = {
+            MP4AtomInfo("chap", Optional, OnlyOne),
+            MP4AtomInfo("dpnd", Optional, OnlyOne),
+            MP4AtomInfo("hint", Optional, OnlyOne),
+            MP4AtomInfo("ipir", Optional, OnlyOne),
+            MP4AtomInfo("mpod", Optional, OnlyOne),
+            MP4AtomInfo("sync", Optional, OnlyOne),
+        };
+        ExpectChildAtoms(children);
+        break;
+    }
 
-    } else if (ATOMID(type) == ATOMID("stts")) {
-        AddVersionAndFlags();
-        MP4Integer32Property* pCount = new MP4Integer32Property(*this, "entryCount");
-        AddProperty(pCount);
+    case ATOMID("trex"): {
+        static const MP4PropertyInfo properties[] = {
+            MP4PropertyInfo(Integer8Property, "version"),
+            MP4PropertyInfo(Integer24Property, "flags"),
+            MP4PropertyInfo(Integer32Property, "trackId"),
+            MP4PropertyInfo(Integer32Property, "defaultSampleDesriptionIndex"),
+            MP4PropertyInfo(Integer32Property, "defaultSampleDuration"),
+            MP4PropertyInfo(Integer32Property, "defaultSampleSize"),
+            MP4PropertyInfo(Integer32Property, "defaultSampleFlags"),
+        };
+        AddProperties(properties);
+        break;
+    }
 
-        MP4TableProperty* pTable = new MP4TableProperty(*this, "entries", pCount);
-        AddProperty(pTable);
+    case ATOMID("trpy"):
+    case ATOMID("tpyl"): {
+        static const MP4PropertyInfo properties[] = {
+            MP4PropertyInfo(Integer64Property, "bytes"), // bytes sent including RTP headers
+        };
+        AddProperties(properties);
+        break;
+    }
 
-        pTable->AddProperty(new MP4Integer32Property(pTable->GetParentAtom(), "sampleCount"));
-        pTable->AddProperty(new MP4Integer32Property(pTable->GetParentAtom(), "sampleDelta"));
-    } else if (ATOMID(type) == ATOMID("tims")) {
-        AddProperty(
-            new MP4Integer32Property(*this, "timeScale"));
-
-    } else if (ATOMID(type) == ATOMID("tmin")) {
-        AddProperty( // min relative xmit time
-            new MP4Integer32Property(*this, "milliSecs"));
-
-    } else if (ATOMID(type) == ATOMID("tmax")) {
-        AddProperty( // max relative xmit time
-            new MP4Integer32Property(*this, "milliSecs"));
-
-    } else if (ATOMID(type) == ATOMID("traf")) {
-        ExpectChildAtom("tfhd", Required, OnlyOne);
-        ExpectChildAtom("trun", Optional, Many);
-
-    } else if (ATOMID(type) == ATOMID("trak")) {
-        ExpectChildAtom("tkhd", Required, OnlyOne);
-        ExpectChildAtom("tref", Optional, OnlyOne);
-        ExpectChildAtom("edts", Optional, OnlyOne);
-        ExpectChildAtom("mdia", Required, OnlyOne);
-        ExpectChildAtom("udta", Optional, Many);
-
-    } else if (ATOMID(type) == ATOMID("tref")) {
-        ExpectChildAtom("chap", Optional, OnlyOne);
-        ExpectChildAtom("dpnd", Optional, OnlyOne);
-        ExpectChildAtom("hint", Optional, OnlyOne);
-        ExpectChildAtom("ipir", Optional, OnlyOne);
-        ExpectChildAtom("mpod", Optional, OnlyOne);
-        ExpectChildAtom("sync", Optional, OnlyOne);
-
-    } else if (ATOMID(type) == ATOMID("trex")) {
-        AddVersionAndFlags();   /* 0, 1 */
-        AddProperty( /* 2 */
-            new MP4Integer32Property(*this, "trackId"));
-        AddProperty( /* 3 */
-            new MP4Integer32Property(*this, "defaultSampleDesriptionIndex"));
-        AddProperty( /* 4 */
-            new MP4Integer32Property(*this, "defaultSampleDuration"));
-        AddProperty( /* 5 */
-            new MP4Integer32Property(*this, "defaultSampleSize"));
-        AddProperty( /* 6 */
-            new MP4Integer32Property(*this, "defaultSampleFlags"));
-
-    } else if (ATOMID(type) == ATOMID("trpy") ||
-               ATOMID(type) == ATOMID("tpyl")) {
-        AddProperty( // bytes sent including RTP headers
-            new MP4Integer64Property(*this, "bytes"));
-
-    } else if (ATOMID(type) == ATOMID("tsro")) {
-        AddProperty(
-            new MP4Integer32Property(*this, "offset"));
-    } else if (ATOMID(type) == ATOMID("wave")) {
-        ExpectChildAtom("esds", Required, OnlyOne);
-    } else {
-        /*
-         * default - unknown type
-         */
+    case ATOMID("tsro"): {
+        static const MP4PropertyInfo properties[] = {
+            MP4PropertyInfo(Integer32Property, "offset"),
+        };
+        AddProperties(properties);
+        break;
+    }
+    case ATOMID("wave"): {
+        static const MP4AtomInfo children[] = {
+            MP4AtomInfo("esds", Required, OnlyOne),
+        };
+        ExpectChildAtoms(children);
+        break;
+    }
+    default:
         SetUnknownType(true);
+        break;
     }
 }
 
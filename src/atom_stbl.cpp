@@ -28,18 +28,21 @@ namespace mp4v2 { namespace impl {
 MP4StblAtom::MP4StblAtom(MP4File &file)
         : MP4Atom(file, "stbl")
 {
-    ExpectChildAtom("stsd", Required, OnlyOne);
-    ExpectChildAtom("stts", Required, OnlyOne);
-    ExpectChildAtom("ctts", Optional, OnlyOne);
-    ExpectChildAtom("stsz", Required, OnlyOne);
-    ExpectChildAtom("stz2", Optional, OnlyOne);
-    ExpectChildAtom("stsc", Required, OnlyOne);
-    ExpectChildAtom("stco", Optional, OnlyOne);
-    ExpectChildAtom("co64", Optional, OnlyOne);
-    ExpectChildAtom("stss", Optional, OnlyOne);
-    ExpectChildAtom("stsh", Optional, OnlyOne);
-    ExpectChildAtom("stdp", Optional, OnlyOne);
-    ExpectChildAtom("sdtp", Optional, OnlyOne);
+    static const MP4AtomInfo children[] = {
+        MP4AtomInfo("stsd", Required, OnlyOne),
+        MP4AtomInfo("stts", Required, OnlyOne),
+        MP4AtomInfo("ctts", Optional, OnlyOne),
+        MP4AtomInfo("stsz", Required, OnlyOne),
+        MP4AtomInfo("stz2", Optional, OnlyOne),
+        MP4AtomInfo("stsc", Required, OnlyOne),
+        MP4AtomInfo("stco", Optional, OnlyOne),
+        MP4AtomInfo("co64", Optional, OnlyOne),
+        MP4AtomInfo("stss", Optional, OnlyOne),
+        MP4AtomInfo("stsh", Optional, OnlyOne),
+        MP4AtomInfo("stdp", Optional, OnlyOne),
+        MP4AtomInfo("sdtp", Optional, OnlyOne),
+    };
+    ExpectChildAtoms(children);
 }
 
 void MP4StblAtom::Generate()
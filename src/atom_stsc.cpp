@@ -29,28 +29,19 @@ namespace impl {
 MP4StscAtom::MP4StscAtom(MP4File &file)
         : MP4Atom(file, "stsc")
 {
-    AddVersionAndFlags();
-
-    MP4Integer32Property* pCount =
-        new MP4Integer32Property(*this, "entryCount");
-    AddProperty(pCount);
-
-    MP4TableProperty* pTable = new MP4TableProperty(*this, "entries", pCount);
-    AddProperty(pTable);
-
-    pTable->AddProperty(
-        new MP4Integer32Property(pTable->GetParentAtom(), "firstChunk"));
-    pTable->AddProperty(
-        new MP4Integer32Property(pTable->GetParentAtom(), "samplesPerChunk"));
-    pTable->AddProperty(
-        new MP4Integer32Property(pTable->GetParentAtom(), "sampleDescriptionIndex"));
-
     // As an optimization we add an implicit property to this table,
     // "firstSample" that corresponds to the first sample of the firstChunk
-    MP4Integer32Property* pSample =
-        new MP4Integer32Property(*this, "firstSample");
-    pSample->SetImplicit();
-    pTable->AddProperty(pSample);
+    static const MP4PropertyInfo properties[] = {
+        MP4PropertyInfo(Integer8Property, "version"),
+        MP4PropertyInfo(Integer24Property, "flags"),
+        MP4PropertyInfo(Integer32Property, "entryCount"),
+        MP4PropertyInfo(TableProperty, "entries", 4),
+            MP4PropertyInfo(Integer32Property, "firstChunk"),
+            MP4PropertyInfo(Integer32Property, "samplesPerChunk"),
+            MP4PropertyInfo(Integer32Property, "sampleDescriptionIndex"),
+            MP4PropertyInfo(Integer32Property, "firstSample", 0, MP4PropertyInfo::Implicit),
+    };
+    AddProperties(properties);
 }
 
 void MP4StscAtom::Read()
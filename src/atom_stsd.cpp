@@ -44,24 +44,27 @@ MP4StsdAtom::MP4StsdAtom(MP4File &file)
     pCount->SetReadOnly();
     AddProperty(pCount);
 
-    ExpectChildAtom("mp4a", Optional, Many);
-    ExpectChildAtom("enca", Optional, Many);
-    ExpectChildAtom("mp4s", Optional, Many);
-    ExpectChildAtom("mp4v", Optional, Many);
-    ExpectChildAtom("encv", Optional, Many);
-    ExpectChildAtom("rtp ", Optional, Many);
-    ExpectChildAtom("ipcm", Optional, Many);
-    ExpectChildAtom("lpcm", Optional, Many);
-    ExpectChildAtom("alaw", Optional, Many);
-    ExpectChildAtom("ulaw", Optional, Many);
-    ExpectChildAtom("samr", Optional, Many); // For AMR-NB
-    ExpectChildAtom("sawb", Optional, Many); // For AMR-WB
-    ExpectChildAtom("s263", Optional, Many); // For H.263
-    ExpectChildAtom("avc1", Optional, Many);
-    ExpectChildAtom("alac", Optional, Many);
-    ExpectChildAtom("text", Optional, Many);
-    ExpectChildAtom("tx3g", Optional, Many);
-    ExpectChildAtom("ac-3", Optional, Many);
+    static const MP4AtomInfo children[] = {
+        MP4AtomInfo("mp4a", Optional, Many),
+        MP4AtomInfo("enca", Optional, Many),
+        MP4AtomInfo("mp4s", Optional, Many),
+        MP4AtomInfo("mp4v", Optional, Many),
+        MP4AtomInfo("encv", Optional, Many),
+        MP4AtomInfo("rtp ", Optional, Many),
+        MP4AtomInfo("ipcm", Optional, Many),
+        MP4AtomInfo("lpcm", Optional, Many),
+        MP4AtomInfo("alaw", Optional, Many),
+        MP4AtomInfo("ulaw", Optional, Many),
+        MP4AtomInfo("samr", Optional, Many), /* For AMR-NB */
+        MP4AtomInfo("sawb", Optional, Many), /* For AMR-WB */
+        MP4AtomInfo("s263", Optional, Many), /* For H.263 */
+        MP4AtomInfo("avc1", Optional, Many),
+        MP4AtomInfo("alac", Optional, Many),
+        MP4AtomInfo("text", Optional, Many),
+        MP4AtomInfo("tx3g", Optional, Many),
+        MP4AtomInfo("ac-3", Optional, Many),
+    };
+    ExpectChildAtoms(children);
 }
 
 void MP4StsdAtom::Read()
@@ -29,16 +29,12 @@ namespace impl {
 MP4TrefTypeAtom::MP4TrefTypeAtom(MP4File &file, const char* type)
         : MP4Atom(file, type)
 {
-    MP4Integer32Property* pCount =
-        new MP4Integer32Property(*this, "entryCount");
-    pCount->SetImplicit();
-    AddProperty(pCount); /* 0 */
-
-    MP4TableProperty* pTable = new MP4TableProperty(*this, "entries", pCount);
-    AddProperty(pTable); /* 1 */
-
-    pTable->AddProperty( /* 1, 0 */
-        new MP4Integer32Property(pTable->GetParentAtom(), "trackId"));
+    static const MP4PropertyInfo properties[] = {
+        MP4PropertyInfo(Integer32Property, "entryCount", 0, MP4PropertyInfo::Implicit), /* 0 */
+        MP4PropertyInfo(TableProperty, "entries", 1),   /* 1 */
+            MP4PropertyInfo(Integer32Property, "trackId"),  /* 1, 0 */
+    };
+    AddProperties(properties);
 }
 
 void MP4TrefTypeAtom::Read()
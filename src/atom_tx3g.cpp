@@ -56,7 +56,10 @@ MP4Tx3gAtom::MP4Tx3gAtom(MP4File &file)
     AddProperty(new MP4Integer8Property(*this, "fontColorBlue")); /* 21 */
     AddProperty(new MP4Integer8Property(*this, "fontColorAlpha")); /* 22 */
 
-    ExpectChildAtom("ftab", Optional, Many);
+    static const MP4AtomInfo children[] = {
+        MP4AtomInfo("ftab", Optional, Many),
+    };
+    ExpectChildAtoms(children);
 }
 
 void MP4Tx3gAtom::Generate()
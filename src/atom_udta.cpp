@@ -26,25 +26,36 @@ namespace impl {
 
 ///////////////////////////////////////////////////////////////////////////////
 
+namespace {
+    // a track's udta also holds hint information and the track name
+    const MP4AtomInfo trakChildren[] = {
+        MP4AtomInfo("chpl", Optional, OnlyOne),
+        MP4AtomInfo("cprt", Optional, Many),
+        MP4AtomInfo("hnti", Optional, OnlyOne),
+        MP4AtomInfo("meta", Optional, OnlyOne),
+        MP4AtomInfo("\251cpy", Optional, OnlyOne),
+        MP4AtomInfo("\251des", Optional, OnlyOne),
+        MP4AtomInfo("\251nam", Optional, OnlyOne),
+        MP4AtomInfo("\251cmt", Optional, OnlyOne),
+        MP4AtomInfo("\251prd", Optional, OnlyOne),
+        MP4AtomInfo("hinf", Optional, OnlyOne),
+        MP4AtomInfo("name", Optional, OnlyOne),
+    };
+
+    // all but the last two entries of trakChildren
+    const uint32_t NUM_CHILDREN = sizeof(trakChildren) / sizeof(trakChildren[0]) - 2;
+}
+
 MP4UdtaAtom::MP4UdtaAtom(MP4File &file)
         : MP4Atom(file, "udta")
 {
-    ExpectChildAtom("chpl", Optional, OnlyOne);
-    ExpectChildAtom("cprt", Optional, Many);
-    ExpectChildAtom("hnti", Optional, OnlyOne);
-    ExpectChildAtom("meta", Optional, OnlyOne);
-    ExpectChildAtom("\251cpy", Optional, OnlyOne);
-    ExpectChildAtom("\251des", Optional, OnlyOne);
-    ExpectChildAtom("\251nam", Optional, OnlyOne);
-    ExpectChildAtom("\251cmt", Optional, OnlyOne);
-    ExpectChildAtom("\251prd", Optional, OnlyOne);
+    ExpectChildAtoms(trakChildren, NUM_CHILDREN);
 }
 
 void MP4UdtaAtom::Read()
 {
     if (ATOMID(m_pParentAtom->GetType()) == ATOMID("trak")) {
-        ExpectChildAtom("hinf", Optional, OnlyOne);
-        ExpectChildAtom("name", Optional, OnlyOne);
+        ExpectChildAtoms(trakChildren);
     }
 
     MP4Atom::Read();
@@ -119,6 +119,14 @@ MP4TagsFree( const MP4Tags* tags )
 
 bool
 MP4TagsFetch( const MP4Tags* tags, MP4FileHandle hFile )
+{
+    return MP4TagsFetchFlags( tags, hFile, 0 );
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+bool
+MP4TagsFetchFlags( const MP4Tags* tags, MP4FileHandle hFile, uint32_t flags )
 {
     if( !MP4_IS_VALID_FILE_HANDLE( hFile ))
         return false;
@@ -130,7 +138,7 @@ MP4TagsFetch( const MP4Tags* tags, MP4FileHandle hFile )
     MP4Tags* c = const_cast<MP4Tags*>(tags);
 
     try {
-        cpp->c_fetch( c, hFile );
+        cpp->c_fetch( c, hFile, !(flags & MP4_TAGS_FETCH_NO_ARTWORK) );
         return true;
     }
     catch( Exception* x ) {
@@ -121,4 +121,56 @@ PlatformException::msg() const
 
 ///////////////////////////////////////////////////////////////////////////////
 
+static thread_local MP4Error lastError = MP4_ERROR_NONE;
+
+void
+SetLastErrorCode( MP4Error error )
+{
+    lastError = error;
+}
+
+MP4Error
+GetLastErrorCode()
+{
+    return lastError;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+const char*
+ErrorString( MP4Error error )
+{
+    switch( error ) {
+        case MP4_ERROR_NONE:              return "no error";
+        case MP4_ERROR_FAILED:            return "failed";
+        case MP4_ERROR_INVALID_HANDLE:    return "invalid file handle";
+        case MP4_ERROR_INVALID_TRACK:     return "track id doesn't exist";
+        case MP4_ERROR_INVALID_SAMPLE:    return "sample id out of range";
+        case MP4_ERROR_TIME_OUT_OF_RANGE: return "time out of range";
+        case MP4_ERROR_BUFFER_TOO_SMALL:  return "sample buffer is too small";
+        case MP4_ERROR_INACCESSIBLE_FILE: return "sample is located in an inaccessible file";
+        case MP4_ERROR_CORRUPT:           return "sample tables are inconsistent";
+        case MP4_ERROR_TRUNCATED:         return "sample data extends past end of file";
+    }
+    return "unknown error";
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
 }} // namespace mp4v2::impl
+
+///////////////////////////////////////////////////////////////////////////////
+
+using namespace mp4v2::impl;
+
+extern "C"
+MP4Error MP4GetLastError( void )
+{
+    return GetLastErrorCode();
+}
+
+extern "C"
+const char* MP4GetErrorString( MP4Error error )
+{
+    return ErrorString( error );
+}
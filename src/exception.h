@@ -76,6 +76,13 @@ public:
 
 ///////////////////////////////////////////////////////////////////////////////
 
+// Thread-local status for the exception-free sample access paths.
+void        SetLastErrorCode( MP4Error error );
+MP4Error    GetLastErrorCode();
+const char* ErrorString( MP4Error error );
+
+///////////////////////////////////////////////////////////////////////////////
+
 }} // namespace mp4v2::impl
 
 #endif // MP4V2_IMPL_MP4EXCEPTION_H
@@ -91,10 +91,8 @@ void MP4File::MakeIsmaCompliant(bool addIsmaComplianceSdp)
                        GetFilename().c_str(), video_media_data_name);
             return;
         }
-        MP4LogLevel verb = log.verbosity;
-        log.setVerbosity(MP4_LOG_NONE);
+        Log::Silence silence;
         videoProfile = MP4GetVideoProfileLevel(this, videoTrackId);
-        log.setVerbosity(verb);
     }
 
     m_useIsma = true;
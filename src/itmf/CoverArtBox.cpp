@@ -58,6 +58,11 @@ CoverArtBox::Item::~Item()
 CoverArtBox::Item&
 CoverArtBox::Item::operator=( const Item& rhs )
 {
+    if( this == &rhs )
+        return *this;
+
+    reset();
+
     type     = rhs.type;
     size     = rhs.size;
     autofree = rhs.autofree;
@@ -171,16 +176,57 @@ CoverArtBox::list( MP4FileHandle hFile, ItemList& out )
 {
     out.clear();
     MP4File& file = *((MP4File*)hFile);
-    MP4ItmfItemList* itemList = genericGetItemsByCode( file, "covr" ); // alloc
 
-    if( itemList->size ) {
-        MP4ItmfDataList& dataList = itemList->elements[0].dataList;
-        out.resize( dataList.size );
-        for( uint32_t i = 0; i < dataList.size; i++ )
-            get( hFile, out[i], i );
+    MP4Atom* covr = file.FindAtom( "moov.udta.meta.ilst.covr" );
+    if( !covr )
+        return false;
+
+    // one copy per image, straight from the data atoms
+    const uint32_t atomc = covr->GetNumberOfChildAtoms();
+    out.resize( atomc );
+    for( uint32_t i = 0; i < atomc; i++ )
+        get( hFile, out[i], i );
+
+    return false;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+bool
+CoverArtBox::list( MP4FileHandle hFile, InfoList& out )
+{
+    out.clear();
+    MP4File& file = *((MP4File*)hFile);
+
+    MP4Atom* covr = file.FindAtom( "moov.udta.meta.ilst.covr" );
+    if( !covr )
+        return false;
+
+    const uint32_t atomc = covr->GetNumberOfChildAtoms();
+    out.reserve( atomc );
+    for( uint32_t i = 0; i < atomc; i++ ) {
+        MP4Atom* atom = covr->GetChildAtom( i );
+
+        // keep indices in step with get(); unusable atoms list as empty
+        ItemInfo info;
+        info.type   = BT_UNDEFINED;
+        info.size   = 0;
+        info.offset = 0;
+
+        MP4BytesProperty* metadata = NULL;
+        if( atom->FindProperty( "data.metadata", (MP4Property**)&metadata )) {
+            info.type = static_cast<MP4DataAtom*>( atom )->typeCode.GetValue();
+            info.size = metadata->GetCount() ? metadata->GetValueSize() : 0;
+
+            // image data is the tail of the data atom
+            const uint64_t end = atom->GetEnd();
+            if( end && end >= info.size )
+                info.offset = end - info.size;
+        }
+
+        out.push_back( info );
     }
 
-    genericItemListFree( itemList ); // free
     return false;
 }
 
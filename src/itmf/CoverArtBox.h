@@ -60,6 +60,21 @@ public:
     /// Object representing a list of covr-box items.
     typedef vector<Item> ItemList;
 
+    /// Description of a covr-box item without its data.
+    /// <b>offset</b> is the position of the image bytes in the file as of
+    /// the last read or write of the data atom, or 0 if the atom has never
+    /// been written. It is meaningless for items modified since.
+    ///
+    struct MP4V2_EXPORT ItemInfo
+    {
+        BasicType type;     ///< covr-box type.
+        uint32_t  size;     ///< size of image data in bytes.
+        uint64_t  offset;   ///< file offset of image data.
+    };
+
+    /// Object representing a list of covr-box item descriptions.
+    typedef vector<ItemInfo> InfoList;
+
     /// Fetch list of covr-box items from file.
     ///
     /// @param hFile on which to operate.
@@ -69,6 +84,16 @@ public:
     ///
     static bool list( MP4FileHandle hFile, ItemList& out );
 
+    /// Fetch type, size and file offset of each covr-box item.
+    /// No image data is copied; use the offsets to read images on demand.
+    ///
+    /// @param hFile on which to operate.
+    /// @param out vector of ItemInfo objects.
+    ///
+    /// @return <b>true</b> on failure, <b>false</b> on success.
+    ///
+    static bool list( MP4FileHandle hFile, InfoList& out );
+
     /// Add covr-box item to file.
     /// Any necessary metadata atoms are first created.
     /// Additionally, if an empty data-atom exists it will be used,
@@ -32,6 +32,7 @@ namespace mp4v2 { namespace impl { namespace itmf {
 
 Tags::Tags()
     : hasMetadata(false)
+    , artworkFetched(true)
 {
 }
 
@@ -48,7 +49,6 @@ Tags::c_addArtwork( MP4Tags*& tags, MP4TagArtwork& c_artwork )
 {
     artwork.resize( artwork.size() + 1 );
     c_setArtwork( tags, (uint32_t)artwork.size() - 1, c_artwork );
-    updateArtworkShadow( tags );
 }
 
 ///////////////////////////////////////////////////////////////////////////////
@@ -64,18 +64,19 @@ Tags::c_alloc( MP4Tags*& tags )
 ///////////////////////////////////////////////////////////////////////////////
 
 void
-Tags::c_fetch( MP4Tags*& tags, MP4FileHandle hFile )
+Tags::c_fetch( MP4Tags*& tags, MP4FileHandle hFile, bool fetchArtwork )
 {
     MP4Tags& c = *tags;
     MP4File& file = *static_cast<MP4File*>(hFile);
 
-    MP4ItmfItemList* itemList = genericGetItems( file ); // alloc
+    // cover-art is fetched separately below, if at all
+    MP4ItmfItemList* itemList = genericGetItemsExceptCode( file, "covr" ); // alloc
 
-    hasMetadata = (itemList->size > 0);
+    MP4Atom* ilst = file.FindAtom( "moov.udta.meta.ilst" );
+    hasMetadata = (ilst && ilst->GetNumberOfChildAtoms() > 0);
 
     /* create code -> item map.
-     * map will only be used for items which do not repeat; we do not care if
-     * cover-art is inserted multiple times.
+     * map will only be used for items which do not repeat.
      */
     CodeItemMap cim;
     for( uint32_t i = 0; i < itemList->size; i++ ) {
@@ -144,16 +145,18 @@ Tags::c_fetch( MP4Tags*& tags, MP4FileHandle hFile )
 
     genericItemListFree( itemList ); // free
 
-    // fetch full list and overwrite our copy, otherwise clear
-    {
+    // fetch full list and take it over, otherwise clear.
+    // when skipped, artwork only holds what is added later and c_store
+    // appends it, leaving the file's cover-art alone
+    artwork.clear();
+    artworkFetched = fetchArtwork;
+    if( fetchArtwork ) {
         CoverArtBox::ItemList items;
-        if( CoverArtBox::list( hFile, items ))
-            artwork.clear();
-        else
-            artwork = items;
-
-        updateArtworkShadow( tags );
+        if( !CoverArtBox::list( hFile, items ))
+            artwork.swap( items );
     }
+
+    updateArtworkShadow( tags );
 }
 
 ///////////////////////////////////////////////////////////////////////////////
@@ -398,12 +401,18 @@ Tags::c_store( MP4Tags*& tags, MP4FileHandle hFile )
     storeInteger( file, CODE_COMPOSERID,        composerID,        c.composerID );
     storeString(  file, CODE_XID,               xid,               c.xid );
 
-    // destroy all cover-art then add each
-    {
+    // destroy all cover-art then add each; if cover-art was never fetched
+    // only append what was added since, and drop it so it is stored once
+    if( artworkFetched )
         CoverArtBox::remove( hFile );
-        const CoverArtBox::ItemList::size_type max = artwork.size();
-        for( CoverArtBox::ItemList::size_type i = 0; i < max; i++ )
-            CoverArtBox::add( hFile, artwork[i] );
+
+    const CoverArtBox::ItemList::size_type max = artwork.size();
+    for( CoverArtBox::ItemList::size_type i = 0; i < max; i++ )
+        CoverArtBox::add( hFile, artwork[i] );
+
+    if( !artworkFetched ) {
+        artwork.clear();
+        updateArtworkShadow( tags );
     }
 }
 
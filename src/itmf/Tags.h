@@ -150,13 +150,14 @@ public:
     string   xid;
 
     bool     hasMetadata;
+    bool     artworkFetched; // artwork reflects the file, else only holds additions
 
 public:
     Tags();
     ~Tags();
 
     void c_alloc ( MP4Tags*& );
-    void c_fetch ( MP4Tags*&, MP4FileHandle );
+    void c_fetch ( MP4Tags*&, MP4FileHandle, bool fetchArtwork = true );
     void c_store ( MP4Tags*&, MP4FileHandle );
     void c_free  ( MP4Tags*& );
 
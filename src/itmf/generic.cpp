@@ -346,6 +346,40 @@ genericGetItemsByCode( MP4File& file, const string& code )
 
 ///////////////////////////////////////////////////////////////////////////////
 
+MP4ItmfItemList*
+genericGetItemsExceptCode( MP4File& file, const string& code )
+{
+    MP4Atom* ilst = file.FindAtom( "moov.udta.meta.ilst" );
+    if( !ilst )
+        return __itemListAlloc();
+
+    // pass 1: filter out code and populate indexList
+    const uint32_t childCount = ilst->GetNumberOfChildAtoms();
+    vector<uint32_t> indexList;
+    for( uint32_t i = 0; i < childCount; i++ ) {
+        if( ATOMID( ilst->GetChildAtom( i )->GetType() ) == ATOMID( code.c_str() ))
+            continue;
+        indexList.push_back( i );
+    }
+
+    if( indexList.size() < 1 )
+        return __itemListAlloc();
+
+    MP4ItmfItemList& list = *__itemListAlloc();
+    __itemListResize( list, (uint32_t)indexList.size() );
+
+    // pass 2: process each atom
+    const vector<uint32_t>::size_type max = indexList.size();
+    for( vector<uint32_t>::size_type i = 0; i < max; i++ ) {
+        uint32_t& aidx = indexList[i];
+        __itemAtomToModel( *(MP4ItemAtom*)ilst->GetChildAtom( aidx ), list.elements[i] );
+    }
+
+    return &list;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
 MP4ItmfItemList*
 genericGetItemsByMeaning( MP4File& file, const string& meaning, const string& name )
 {
@@ -45,6 +45,9 @@ genericGetItems( MP4File& file );
 MP4ItmfItemList*
 genericGetItemsByCode( MP4File& file, const string& code );
 
+MP4ItmfItemList*
+genericGetItemsExceptCode( MP4File& file, const string& code );
+
 MP4ItmfItemList*
 genericGetItemsByMeaning( MP4File& file, const string& meaning, const string& name );
 
@@ -29,6 +29,14 @@ namespace mp4v2 { namespace impl {
 
 MP4LogCallback Log::_cb_func = NULL;
 
+// Serializes output and access to the callback, so messages from different
+// threads don't interleave and a callback is never entered concurrently.
+// Recursive in case a callback logs.
+static recursive_mutex outputLock;
+
+// number of Silence objects alive on this thread
+static thread_local uint32_t silenceDepth = 0;
+
 // There's no mechanism to set the log level at runtime at
 // the moment so construct this so it only logs important
 // stuff.
@@ -64,6 +72,7 @@ Log::~Log()
 void
 Log::setLogCallback( MP4LogCallback value )
 {
+    lock_guard<recursive_mutex> lock( outputLock );
     Log::_cb_func = value;
 }
 
@@ -153,6 +162,9 @@ Log::verbose1f( const char* format,
 {
     va_list     ap;
 
+    if (MP4_LOG_VERBOSE1 > this->_verbosity)
+        return;
+
     va_start(ap,format);
     this->vprintf(MP4_LOG_VERBOSE1,format,ap);
     va_end(ap);
@@ -173,6 +185,9 @@ Log::verbose2f( const char* format,
 {
     va_list     ap;
 
+    if (MP4_LOG_VERBOSE2 > this->_verbosity)
+        return;
+
     va_start(ap,format);
     this->vprintf(MP4_LOG_VERBOSE2,format,ap);
     va_end(ap);
@@ -193,6 +208,9 @@ Log::verbose3f( const char* format,
 {
     va_list     ap;
 
+    if (MP4_LOG_VERBOSE3 > this->_verbosity)
+        return;
+
     va_start(ap,format);
     this->vprintf(MP4_LOG_VERBOSE3,format,ap);
     va_end(ap);
@@ -213,6 +231,9 @@ Log::verbose4f( const char* format,
 {
     va_list     ap;
 
+    if (MP4_LOG_VERBOSE4 > this->_verbosity)
+        return;
+
     va_start(ap,format);
     this->vprintf(MP4_LOG_VERBOSE4,format,ap);
     va_end(ap);
@@ -272,12 +293,14 @@ Log::vdump( uint8_t     indent,
     ASSERT(format);
     ASSERT(format[0] != '\0');
 
-    if (verbosity_ > this->_verbosity)
+    if (verbosity_ > this->_verbosity || silenceDepth)
     {
         // We're not set verbose enough to log this
         return;
     }
 
+    lock_guard<recursive_mutex> lock( outputLock );
+
     if (Log::_cb_func)
     {
         ostringstream   new_format;
@@ -353,12 +376,14 @@ Log::vprintf( MP4LogLevel       verbosity_,
     ASSERT(verbosity_ != MP4_LOG_NONE);
     ASSERT(format);
 
-    if (verbosity_ > this->_verbosity)
+    if (verbosity_ > this->_verbosity || silenceDepth)
     {
         // We're not set verbose enough to log this
         return;
     }
 
+    lock_guard<recursive_mutex> lock( outputLock );
+
     if (Log::_cb_func)
     {
         Log::_cb_func(verbosity_,format,ap);
@@ -403,7 +428,7 @@ Log::hexDump( uint8_t           indent,
     ASSERT(pBytes || (numBytes == 0));
     ASSERT(format);
 
-    if (verbosity_ > this->_verbosity)
+    if (verbosity_ > this->_verbosity || silenceDepth)
     {
         // We're not set verbose enough to log this
         return;
@@ -500,6 +525,20 @@ Log::errorf ( const Exception&      x )
 
 ///////////////////////////////////////////////////////////////////////////////
 
+Log::Silence::Silence()
+{
+    silenceDepth++;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+Log::Silence::~Silence()
+{
+    silenceDepth--;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
 }} // namespace mp4v2::impl
 
 using namespace mp4v2::impl;
@@ -75,6 +75,20 @@ public:
 
     void errorf ( const Exception&      x );
 
+    /**
+     * Suppresses all logging from the calling thread for the
+     * lifetime of the object, without affecting other threads
+     */
+    class MP4V2_EXPORT Silence {
+    public:
+        Silence();
+        ~Silence();
+
+    private:
+        Silence ( const Silence &src );
+        Silence &operator= ( const Silence &src );
+    };
+
 private:
     Log ( const Log &src );
     Log &operator= ( const Log &src );
@@ -90,4 +104,39 @@ extern Log log;
 
 }} // namespace mp4v2::impl
 
+///////////////////////////////////////////////////////////////////////////////
+
+/**
+ * Highest log level compiled into the library.  Messages logged through
+ * the LOG_* macros below a more verbose level than this are removed at
+ * compile time.  Set by the MP4V2_MAX_LOG_LEVEL CMake option; other builds
+ * define it on the compiler command line, e.g. with
+ * <tt>./configure CPPFLAGS=-DMP4V2_MAX_LOG_LEVEL=2</tt> or in the
+ * preprocessor definitions of the libmp4v2 project.
+ */
+#ifndef MP4V2_MAX_LOG_LEVEL
+#   define MP4V2_MAX_LOG_LEVEL MP4_LOG_VERBOSE4
+#endif
+
+/**
+ * True if a message of level @p level would be logged.  The compile-time
+ * limit is tested first so disabled levels fold to a constant.
+ */
+#define LOG_ENABLED(level) \
+    ((level) <= MP4V2_MAX_LOG_LEVEL && (level) <= mp4v2::impl::log.verbosity)
+
+/**
+ * Level-checked logging for per-sample and per-atom paths.  Unlike calling
+ * the Log methods directly, the arguments are only evaluated when the
+ * message will actually be logged.
+ */
+#define LOG_VERBOSE1F(...) \
+    do { if( LOG_ENABLED(MP4_LOG_VERBOSE1) ) mp4v2::impl::log.verbose1f(__VA_ARGS__); } while( 0 )
+#define LOG_VERBOSE2F(...) \
+    do { if( LOG_ENABLED(MP4_LOG_VERBOSE2) ) mp4v2::impl::log.verbose2f(__VA_ARGS__); } while( 0 )
+#define LOG_VERBOSE3F(...) \
+    do { if( LOG_ENABLED(MP4_LOG_VERBOSE3) ) mp4v2::impl::log.verbose3f(__VA_ARGS__); } while( 0 )
+#define LOG_VERBOSE4F(...) \
+    do { if( LOG_ENABLED(MP4_LOG_VERBOSE4) ) mp4v2::impl::log.verbose4f(__VA_ARGS__); } while( 0 )
+
 #endif // MP4V2_IMPL_LOG_H
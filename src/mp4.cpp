@@ -326,6 +326,100 @@ MP4FileHandle MP4ModifyCallbacks(const MP4IOCallbacks* callbacks,
         return false;
     }
 
+    bool MP4Remux(MP4FileHandle hFile,
+                  const char* newFileName,
+                  const MP4TrackId* trackIds,
+                  uint32_t numTracks,
+                  MP4Timestamp startTime,
+                  MP4Duration duration,
+                  MP4Duration interleaveDuration)
+    {
+        if (!MP4_IS_VALID_FILE_HANDLE(hFile) || newFileName == NULL)
+            return false;
+
+        MP4File* pFile = ConstructMP4File();
+        if (!pFile)
+            return false;
+
+        try {
+            pFile->Remux(*(MP4File*)hFile, newFileName, trackIds, numTracks,
+                         startTime, duration, interleaveDuration);
+            delete pFile;
+            return true;
+        }
+        catch( Exception* x ) {
+            mp4v2::impl::log.errorf(*x);
+            delete x;
+        }
+        catch( ... ) {
+            mp4v2::impl::log.errorf("%s(%s) failed", __FUNCTION__,
+                                    newFileName );
+        }
+
+        delete pFile;
+        return false;
+    }
+
+    bool MP4SetMaxExternalFiles(MP4FileHandle hFile, uint32_t maxFiles)
+    {
+        if (!MP4_IS_VALID_FILE_HANDLE(hFile))
+            return false;
+
+        try {
+            ((MP4File*)hFile)->SetMaxExternalFiles(maxFiles);
+            return true;
+        }
+        catch( Exception* x ) {
+            mp4v2::impl::log.errorf(*x);
+            delete x;
+        }
+        catch( ... ) {
+            mp4v2::impl::log.errorf("%s: failed", __FUNCTION__ );
+        }
+
+        return false;
+    }
+
+    bool MP4SetWriteBufferSize(MP4FileHandle hFile, uint32_t size)
+    {
+        if (!MP4_IS_VALID_FILE_HANDLE(hFile))
+            return false;
+
+        try {
+            ((MP4File*)hFile)->SetWriteBufferSize(size);
+            return true;
+        }
+        catch( Exception* x ) {
+            mp4v2::impl::log.errorf(*x);
+            delete x;
+        }
+        catch( ... ) {
+            mp4v2::impl::log.errorf("%s: failed", __FUNCTION__ );
+        }
+
+        return false;
+    }
+
+    bool MP4Flush(MP4FileHandle hFile)
+    {
+        if (!MP4_IS_VALID_FILE_HANDLE(hFile))
+            return false;
+
+        try {
+            ((MP4File*)hFile)->Flush();
+            return true;
+        }
+        catch( Exception* x ) {
+            mp4v2::impl::log.errorf(*x);
+            delete x;
+        }
+        catch( ... ) {
+            mp4v2::impl::log.errorf("%s: failed", __FUNCTION__ );
+        }
+
+        return false;
+    }
+
     void MP4Close(MP4FileHandle hFile, uint32_t  flags)
     {
         if( !MP4_IS_VALID_FILE_HANDLE( hFile ))
@@ -366,6 +460,51 @@ MP4FileHandle MP4ModifyCallbacks(const MP4IOCallbacks* callbacks,
         return false;
     }
 
+    bool MP4DumpJson(
+        MP4FileHandle hFile,
+        const char* fileName,
+        uint32_t flags,
+        uint32_t tableEntries)
+    {
+        if (MP4_IS_VALID_FILE_HANDLE(hFile)) {
+            try {
+                ((MP4File*)hFile)->DumpJson(fileName, flags, tableEntries);
+                return true;
+            }
+            catch( Exception* x ) {
+                mp4v2::impl::log.errorf(*x);
+                delete x;
+            }
+            catch( ... ) {
+                mp4v2::impl::log.errorf( "%s: failed", __FUNCTION__ );
+            }
+        }
+        return false;
+    }
+
+    bool MP4DumpJsonCallback(
+        MP4FileHandle hFile,
+        MP4DumpJsonWriteFunc write,
+        void* handle,
+        uint32_t flags,
+        uint32_t tableEntries)
+    {
+        if (MP4_IS_VALID_FILE_HANDLE(hFile) && write) {
+            try {
+                ((MP4File*)hFile)->DumpJson(write, handle, flags, tableEntries);
+                return true;
+            }
+            catch( Exception* x ) {
+                mp4v2::impl::log.errorf(*x);
+                delete x;
+            }
+            catch( ... ) {
+                mp4v2::impl::log.errorf( "%s: failed", __FUNCTION__ );
+            }
+        }
+        return false;
+    }
+
     MP4Duration MP4GetDuration(MP4FileHandle hFile)
     {
         if (MP4_IS_VALID_FILE_HANDLE(hFile)) {
@@ -1833,13 +1972,14 @@ MP4FileHandle MP4ModifyCallbacks(const MP4IOCallbacks* callbacks,
             // copy track ES configuration
             uint8_t* pConfig = NULL;
             uint32_t configSize = 0;
-            MP4LogLevel verb = mp4v2::impl::log.verbosity;
-            mp4v2::impl::log.setVerbosity(MP4_LOG_NONE);
-            bool haveEs = MP4GetTrackESConfiguration(srcFile,
-                          srcTrackId,
-                          &pConfig,
-                          &configSize);
-            mp4v2::impl::log.setVerbosity(verb);
+            bool haveEs;
+            {
+                Log::Silence silence;
+                haveEs = MP4GetTrackESConfiguration(srcFile,
+                                                    srcTrackId,
+                                                    &pConfig,
+                                                    &configSize);
+            }
             if (haveEs &&
                     pConfig != NULL && configSize != 0) {
                 if (!MP4SetTrackESConfiguration(
@@ -2041,14 +2181,13 @@ MP4FileHandle MP4ModifyCallbacks(const MP4IOCallbacks* callbacks,
         return dstTrackId;
     }
 
-    MP4TrackId MP4CopyTrack(MP4FileHandle srcFile,
-                            MP4TrackId srcTrackId,
-                            MP4FileHandle dstFile,
-                            bool applyEdits,
-                            MP4TrackId dstHintTrackReferenceTrack)
+    static MP4TrackId CopyTrack(MP4FileHandle srcFile,
+                                MP4TrackId srcTrackId,
+                                MP4FileHandle dstFile,
+                                bool applyEdits,
+                                MP4TrackId dstHintTrackReferenceTrack,
+                                bool copySamples)
     {
-        bool copySamples = true;  // LATER allow false => reference samples
-
         MP4TrackId dstTrackId =
             MP4CloneTrack(srcFile, srcTrackId, dstFile, dstHintTrackReferenceTrack);
 
@@ -2063,7 +2202,28 @@ MP4FileHandle MP4ModifyCallbacks(const MP4IOCallbacks* callbacks,
         MP4SampleId numSamples =
             MP4GetTrackNumberOfSamples(srcFile, srcTrackId);
 
-        MP4Timestamp when = 0;
+        // a straight copy can move whole chunks at a time
+        if (copySamples && !viaEdits) {
+            try {
+                if (MP4File::CopyChunks((MP4File*)srcFile, srcTrackId,
+                                        (MP4File*)dstFile, dstTrackId)) {
+                    return dstTrackId;
+                }
+            }
+            catch (Exception* x) {
+                mp4v2::impl::log.errorf(*x);
+                delete x;
+                MP4DeleteTrack(dstFile ? dstFile : srcFile, dstTrackId);
+                return MP4_INVALID_TRACK_ID;
+            }
+            catch (...) {
+                mp4v2::impl::log.errorf("%s: failed", __FUNCTION__);
+                MP4DeleteTrack(dstFile ? dstFile : srcFile, dstTrackId);
+                return MP4_INVALID_TRACK_ID;
+            }
+        }
+
+        MP4EditSampleCursor cursor = {};
         MP4Duration editsDuration =
             MP4GetTrackEditTotalDuration(srcFile, srcTrackId);
 
@@ -2071,22 +2231,16 @@ MP4FileHandle MP4ModifyCallbacks(const MP4IOCallbacks* callbacks,
             MP4Duration sampleDuration = MP4_INVALID_DURATION;
 
             if (viaEdits) {
-                sampleId = MP4GetSampleIdFromEditTime(
-                               srcFile,
-                               srcTrackId,
-                               when,
-                               NULL,
-                               &sampleDuration);
-
-                // in theory, this shouldn't happen
-                if (sampleId == MP4_INVALID_SAMPLE_ID) {
+                // in theory, this shouldn't fail
+                if (!MP4GetNextEditSample(srcFile, srcTrackId, &cursor)) {
                     MP4DeleteTrack(dstFile, dstTrackId);
                     return MP4_INVALID_TRACK_ID;
                 }
 
-                when += sampleDuration;
+                sampleId = cursor.sampleId;
+                sampleDuration = cursor.duration;
 
-                if (when >= editsDuration) {
+                if (cursor.startTime + cursor.duration >= editsDuration) {
                     break;
                 }
             } else {
@@ -2126,6 +2280,26 @@ MP4FileHandle MP4ModifyCallbacks(const MP4IOCallbacks* callbacks,
         return dstTrackId;
     }
 
+    MP4TrackId MP4CopyTrack(MP4FileHandle srcFile,
+                            MP4TrackId srcTrackId,
+                            MP4FileHandle dstFile,
+                            bool applyEdits,
+                            MP4TrackId dstHintTrackReferenceTrack)
+    {
+        return CopyTrack(srcFile, srcTrackId, dstFile, applyEdits,
+                         dstHintTrackReferenceTrack, true);
+    }
+
+    MP4TrackId MP4ReferenceTrack(MP4FileHandle srcFile,
+                                 MP4TrackId srcTrackId,
+                                 MP4FileHandle dstFile,
+                                 bool applyEdits,
+                                 MP4TrackId dstHintTrackReferenceTrack)
+    {
+        return CopyTrack(srcFile, srcTrackId, dstFile, applyEdits,
+                         dstHintTrackReferenceTrack, false);
+    }
+
 // Given a source track in a source file, make an encrypted copy of
 // the track in the destination file, including sample encryption
     MP4TrackId MP4EncAndCopyTrack(MP4FileHandle srcFile,
@@ -2138,8 +2312,23 @@ MP4FileHandle MP4ModifyCallbacks(const MP4IOCallbacks* callbacks,
                                   MP4TrackId dstHintTrackReferenceTrack
                                  )
     {
-        bool copySamples = true;  // LATER allow false => reference samples
+        return MP4EncAndCopyTrackParallel(srcFile, srcTrackId, icPp,
+                                          encfcnp, encfcnparam1, 1,
+                                          dstFile, applyEdits,
+                                          dstHintTrackReferenceTrack);
+    }
 
+    MP4TrackId MP4EncAndCopyTrackParallel(MP4FileHandle srcFile,
+                                          MP4TrackId srcTrackId,
+                                          mp4v2_ismacrypParams *icPp,
+                                          encryptFunc_t encfcnp,
+                                          uint32_t encfcnparam1,
+                                          uint32_t numThreads,
+                                          MP4FileHandle dstFile,
+                                          bool applyEdits,
+                                          MP4TrackId dstHintTrackReferenceTrack
+                                         )
+    {
         MP4TrackId dstTrackId =
             MP4EncAndCloneTrack(srcFile, srcTrackId,
                                 icPp,
@@ -2149,75 +2338,32 @@ MP4FileHandle MP4ModifyCallbacks(const MP4IOCallbacks* callbacks,
             return dstTrackId;
         }
 
-        bool viaEdits =
-            applyEdits && MP4GetTrackNumberOfEdits(srcFile, srcTrackId);
-
-        MP4SampleId sampleId = 0;
-        MP4SampleId numSamples =
-            MP4GetTrackNumberOfSamples(srcFile, srcTrackId);
-
-        MP4Timestamp when = 0;
-        MP4Duration editsDuration =
-            MP4GetTrackEditTotalDuration(srcFile, srcTrackId);
-
-        while (true) {
-            MP4Duration sampleDuration = MP4_INVALID_DURATION;
-
-            if (viaEdits) {
-                sampleId = MP4GetSampleIdFromEditTime(srcFile,
-                                                      srcTrackId,
-                                                      when,
-                                                      NULL,
-                                                      &sampleDuration);
-
-                // in theory, this shouldn't happen
-                if (sampleId == MP4_INVALID_SAMPLE_ID) {
-                    MP4DeleteTrack(dstFile, dstTrackId);
-                    return MP4_INVALID_TRACK_ID;
-                }
-
-                when += sampleDuration;
-
-                if (when >= editsDuration) {
-                    break;
-                }
-            } else {
-                sampleId++;
-                if (sampleId > numSamples) {
-                    break;
-                }
-            }
-
-            bool rc = false;
-
-            if (copySamples) {
-                // encrypt and copy
-                rc = MP4EncAndCopySample(srcFile,
-                                         srcTrackId,
-                                         sampleId,
-                                         encfcnp,
-                                         encfcnparam1,
-                                         dstFile,
-                                         dstTrackId,
-                                         sampleDuration);
-
-            } else {
-                // not sure what these are - encrypt?
-                rc = MP4ReferenceSample(srcFile,
-                                        srcTrackId,
-                                        sampleId,
-                                        dstFile,
-                                        dstTrackId,
-                                        sampleDuration);
-            }
+        if (dstFile == MP4_INVALID_FILE_HANDLE) {
+            dstFile = srcFile;
+        }
 
-            if (!rc) {
-                MP4DeleteTrack(dstFile, dstTrackId);
-                return MP4_INVALID_TRACK_ID;
-            }
+        try {
+            MP4File::EncAndCopySamples(
+                (MP4File*)srcFile,
+                srcTrackId,
+                encfcnp,
+                encfcnparam1,
+                numThreads,
+                (MP4File*)dstFile,
+                dstTrackId,
+                applyEdits );
+            return dstTrackId;
+        }
+        catch( Exception* x ) {
+            mp4v2::impl::log.errorf(*x);
+            delete x;
+        }
+        catch( ... ) {
+            mp4v2::impl::log.errorf( "%s: failed", __FUNCTION__ );
         }
 
-        return dstTrackId;
+        MP4DeleteTrack(dstFile, dstTrackId);
+        return MP4_INVALID_TRACK_ID;
     }
 
     bool MP4DeleteTrack(
@@ -2820,8 +2966,7 @@ MP4FileHandle MP4ModifyCallbacks(const MP4IOCallbacks* callbacks,
         MP4FileHandle hFile, MP4TrackId trackId)
     {
         bool retval = false;
-        MP4LogLevel verb = mp4v2::impl::log.verbosity;
-        mp4v2::impl::log.setVerbosity(MP4_LOG_NONE);
+        Log::Silence silence;
 
         if (MP4_IS_VALID_FILE_HANDLE(hFile)) {
             try {
@@ -2835,7 +2980,6 @@ MP4FileHandle MP4ModifyCallbacks(const MP4IOCallbacks* callbacks,
                 mp4v2::impl::log.errorf( "%s: failed", __FUNCTION__ );
             }
         }
-        mp4v2::impl::log.setVerbosity(verb);
         return retval;
     }
 
@@ -3045,9 +3189,10 @@ MP4FileHandle MP4ModifyCallbacks(const MP4IOCallbacks* callbacks,
         MP4Duration* pRenderingOffset,
         bool* pIsSyncSample)
     {
+        MP4Error error = MP4_ERROR_INVALID_HANDLE;
         if (MP4_IS_VALID_FILE_HANDLE(hFile)) {
             try {
-                ((MP4File*)hFile)->ReadSample(
+                error = ((MP4File*)hFile)->TryReadSample(
                     trackId,
                     sampleId,
                     ppBytes,
@@ -3056,16 +3201,20 @@ MP4FileHandle MP4ModifyCallbacks(const MP4IOCallbacks* callbacks,
                     pDuration,
                     pRenderingOffset,
                     pIsSyncSample);
-                return true;
             }
             catch( Exception* x ) {
                 mp4v2::impl::log.errorf(*x);
                 delete x;
+                error = MP4_ERROR_FAILED;
             }
             catch( ... ) {
                 mp4v2::impl::log.errorf( "%s: failed", __FUNCTION__ );
+                error = MP4_ERROR_FAILED;
             }
         }
+        SetLastErrorCode(error);
+        if (error == MP4_ERROR_NONE)
+            return true;
         *pNumBytes = 0;
         return false;
     }
@@ -3083,32 +3232,38 @@ MP4FileHandle MP4ModifyCallbacks(const MP4IOCallbacks* callbacks,
         MP4Duration* pRenderingOffset,
         bool* pIsSyncSample)
     {
+        MP4Error error = MP4_ERROR_INVALID_HANDLE;
         if (MP4_IS_VALID_FILE_HANDLE(hFile)) {
             try {
-                MP4SampleId sampleId =
-                    ((MP4File*)hFile)->GetSampleIdFromTime(
-                        trackId, when, false);
+                MP4SampleId sampleId;
+                error = ((MP4File*)hFile)->TryGetSampleIdFromTime(
+                            trackId, when, false, sampleId);
 
-                ((MP4File*)hFile)->ReadSample(
-                    trackId,
-                    sampleId,
-                    ppBytes,
-                    pNumBytes,
-                    pStartTime,
-                    pDuration,
-                    pRenderingOffset,
-                    pIsSyncSample);
-
-                return true;
+                if (error == MP4_ERROR_NONE) {
+                    error = ((MP4File*)hFile)->TryReadSample(
+                        trackId,
+                        sampleId,
+                        ppBytes,
+                        pNumBytes,
+                        pStartTime,
+                        pDuration,
+                        pRenderingOffset,
+                        pIsSyncSample);
+                }
             }
             catch( Exception* x ) {
                 mp4v2::impl::log.errorf(*x);
                 delete x;
+                error = MP4_ERROR_FAILED;
             }
             catch( ... ) {
                 mp4v2::impl::log.errorf( "%s: failed", __FUNCTION__ );
+                error = MP4_ERROR_FAILED;
             }
         }
+        SetLastErrorCode(error);
+        if (error == MP4_ERROR_NONE)
+            return true;
         *pNumBytes = 0;
         return false;
     }
@@ -3144,6 +3299,105 @@ MP4FileHandle MP4ModifyCallbacks(const MP4IOCallbacks* callbacks,
         return false;
     }
 
+    bool MP4WriteTextCues(
+        MP4FileHandle     hFile,
+        MP4TrackId        trackId,
+        const MP4TextCue* cues,
+        uint32_t          numCues )
+    {
+        if( MP4_IS_VALID_FILE_HANDLE( hFile )) {
+            try {
+                ((MP4File*)hFile)->WriteTextCues( trackId, cues, numCues );
+                return true;
+            }
+            catch( Exception* x ) {
+                mp4v2::impl::log.errorf(*x);
+                delete x;
+            }
+            catch( ... ) {
+                mp4v2::impl::log.errorf( "%s: failed", __FUNCTION__ );
+            }
+        }
+        return false;
+    }
+
+    bool MP4ReadTextCues(
+        MP4FileHandle hFile,
+        MP4TrackId    trackId,
+        MP4TextCue**  cues,
+        uint32_t*     numCues )
+    {
+        if( !cues || !numCues )
+            return false;
+
+        if( MP4_IS_VALID_FILE_HANDLE( hFile )) {
+            try {
+                ((MP4File*)hFile)->ReadTextCues( trackId, cues, numCues );
+                return true;
+            }
+            catch( Exception* x ) {
+                mp4v2::impl::log.errorf(*x);
+                delete x;
+            }
+            catch( ... ) {
+                mp4v2::impl::log.errorf( "%s: failed", __FUNCTION__ );
+            }
+        }
+        return false;
+    }
+
+    bool MP4GetDecodableSamples(
+        MP4FileHandle        hFile,
+        MP4TrackId           trackId,
+        MP4Timestamp         startTime,
+        MP4Duration          duration,
+        MP4DecodableSample** samples,
+        uint32_t*            numSamples )
+    {
+        if( !samples || !numSamples )
+            return false;
+
+        if( MP4_IS_VALID_FILE_HANDLE( hFile )) {
+            try {
+                ((MP4File*)hFile)->GetDecodableSamples( trackId, startTime, duration, samples, numSamples );
+                return true;
+            }
+            catch( Exception* x ) {
+                mp4v2::impl::log.errorf(*x);
+                delete x;
+            }
+            catch( ... ) {
+                mp4v2::impl::log.errorf( "%s: failed", __FUNCTION__ );
+            }
+        }
+        return false;
+    }
+
+    bool MP4GetSyncSampleIndex(
+        MP4FileHandle        hFile,
+        MP4TrackId           trackId,
+        MP4DecodableSample** samples,
+        uint32_t*            numSamples )
+    {
+        if( !samples || !numSamples )
+            return false;
+
+        if( MP4_IS_VALID_FILE_HANDLE( hFile )) {
+            try {
+                ((MP4File*)hFile)->GetSyncSampleIndex( trackId, samples, numSamples );
+                return true;
+            }
+            catch( Exception* x ) {
+                mp4v2::impl::log.errorf(*x);
+                delete x;
+            }
+            catch( ... ) {
+                mp4v2::impl::log.errorf( "%s: failed", __FUNCTION__ );
+            }
+        }
+        return false;
+    }
+
     bool MP4WriteSampleDependency(
         MP4FileHandle  hFile,
         MP4TrackId     trackId,
@@ -3253,7 +3507,27 @@ MP4FileHandle MP4ModifyCallbacks(const MP4IOCallbacks* callbacks,
         MP4TrackId dstTrackId,
         MP4Duration dstSampleDuration)
     {
-        // LATER Not yet implemented
+        if( !MP4_IS_VALID_FILE_HANDLE( srcFile ))
+            return false;
+
+        try {
+            MP4File::ReferenceSample(
+                (MP4File*)srcFile,
+                srcTrackId,
+                srcSampleId,
+                (MP4File*)dstFile,
+                dstTrackId,
+                dstSampleDuration );
+            return true;
+        }
+        catch( Exception* x ) {
+            mp4v2::impl::log.errorf(*x);
+            delete x;
+        }
+        catch( ... ) {
+            mp4v2::impl::log.errorf( "%s: failed", __FUNCTION__ );
+        }
+
         return false;
     }
 
@@ -3262,19 +3536,29 @@ MP4FileHandle MP4ModifyCallbacks(const MP4IOCallbacks* callbacks,
         MP4TrackId trackId,
         MP4SampleId sampleId)
     {
+        MP4Error error = MP4_ERROR_INVALID_HANDLE;
         if (MP4_IS_VALID_FILE_HANDLE(hFile)) {
             try {
-                return ((MP4File*)hFile)->GetSampleSize(
-                           trackId, sampleId);
+                error = ((MP4File*)hFile)->CheckSampleId(trackId, sampleId);
+
+                if (error == MP4_ERROR_NONE) {
+                    uint32_t result =
+                        ((MP4File*)hFile)->GetSampleSize(trackId, sampleId);
+                    SetLastErrorCode(error);
+                    return result;
+                }
             }
             catch( Exception* x ) {
                 mp4v2::impl::log.errorf(*x);
                 delete x;
+                error = MP4_ERROR_FAILED;
             }
             catch( ... ) {
                 mp4v2::impl::log.errorf( "%s: failed", __FUNCTION__ );
+                error = MP4_ERROR_FAILED;
             }
         }
+        SetLastErrorCode(error);
         return 0;
     }
 
@@ -3303,19 +3587,29 @@ MP4FileHandle MP4ModifyCallbacks(const MP4IOCallbacks* callbacks,
         MP4Timestamp when,
         bool wantSyncSample)
     {
+        MP4Error error = MP4_ERROR_INVALID_HANDLE;
         if (MP4_IS_VALID_FILE_HANDLE(hFile)) {
             try {
-                return ((MP4File*)hFile)->GetSampleIdFromTime(
-                           trackId, when, wantSyncSample);
+                MP4SampleId sampleId;
+                error = ((MP4File*)hFile)->TryGetSampleIdFromTime(
+                            trackId, when, wantSyncSample, sampleId);
+
+                if (error == MP4_ERROR_NONE) {
+                    SetLastErrorCode(error);
+                    return sampleId;
+                }
             }
             catch( Exception* x ) {
                 mp4v2::impl::log.errorf(*x);
                 delete x;
+                error = MP4_ERROR_FAILED;
             }
             catch( ... ) {
                 mp4v2::impl::log.errorf( "%s: failed", __FUNCTION__ );
+                error = MP4_ERROR_FAILED;
             }
         }
+        SetLastErrorCode(error);
         return MP4_INVALID_SAMPLE_ID;
     }
 
@@ -3324,19 +3618,29 @@ MP4FileHandle MP4ModifyCallbacks(const MP4IOCallbacks* callbacks,
         MP4TrackId trackId,
         MP4SampleId sampleId)
     {
+        MP4Error error = MP4_ERROR_INVALID_HANDLE;
         if (MP4_IS_VALID_FILE_HANDLE(hFile)) {
             try {
-                return ((MP4File*)hFile)->GetSampleTime(
-                           trackId, sampleId);
+                error = ((MP4File*)hFile)->CheckSampleId(trackId, sampleId);
+
+                if (error == MP4_ERROR_NONE) {
+                    MP4Timestamp result =
+                        ((MP4File*)hFile)->GetSampleTime(trackId, sampleId);
+                    SetLastErrorCode(error);
+                    return result;
+                }
             }
             catch( Exception* x ) {
                 mp4v2::impl::log.errorf(*x);
                 delete x;
+                error = MP4_ERROR_FAILED;
             }
             catch( ... ) {
                 mp4v2::impl::log.errorf( "%s: failed", __FUNCTION__ );
+                error = MP4_ERROR_FAILED;
             }
         }
+        SetLastErrorCode(error);
         return MP4_INVALID_TIMESTAMP;
     }
 
@@ -3345,19 +3649,29 @@ MP4FileHandle MP4ModifyCallbacks(const MP4IOCallbacks* callbacks,
         MP4TrackId trackId,
         MP4SampleId sampleId)
     {
+        MP4Error error = MP4_ERROR_INVALID_HANDLE;
         if (MP4_IS_VALID_FILE_HANDLE(hFile)) {
             try {
-                return ((MP4File*)hFile)->GetSampleDuration(
-                           trackId, sampleId);
+                error = ((MP4File*)hFile)->CheckSampleId(trackId, sampleId);
+
+                if (error == MP4_ERROR_NONE) {
+                    MP4Duration result =
+                        ((MP4File*)hFile)->GetSampleDuration(trackId, sampleId);
+                    SetLastErrorCode(error);
+                    return result;
+                }
             }
             catch( Exception* x ) {
                 mp4v2::impl::log.errorf(*x);
                 delete x;
+                error = MP4_ERROR_FAILED;
             }
             catch( ... ) {
                 mp4v2::impl::log.errorf( "%s: failed", __FUNCTION__ );
+                error = MP4_ERROR_FAILED;
             }
         }
+        SetLastErrorCode(error);
         return MP4_INVALID_DURATION;
     }
 
@@ -3366,19 +3680,29 @@ MP4FileHandle MP4ModifyCallbacks(const MP4IOCallbacks* callbacks,
         MP4TrackId trackId,
         MP4SampleId sampleId)
     {
+        MP4Error error = MP4_ERROR_INVALID_HANDLE;
         if (MP4_IS_VALID_FILE_HANDLE(hFile)) {
             try {
-                return ((MP4File*)hFile)->GetSampleRenderingOffset(
-                           trackId, sampleId);
+                error = ((MP4File*)hFile)->CheckSampleId(trackId, sampleId);
+
+                if (error == MP4_ERROR_NONE) {
+                    MP4Duration result =
+                        ((MP4File*)hFile)->GetSampleRenderingOffset(trackId, sampleId);
+                    SetLastErrorCode(error);
+                    return result;
+                }
             }
             catch( Exception* x ) {
                 mp4v2::impl::log.errorf(*x);
                 delete x;
+                error = MP4_ERROR_FAILED;
             }
             catch( ... ) {
                 mp4v2::impl::log.errorf( "%s: failed", __FUNCTION__ );
+                error = MP4_ERROR_FAILED;
             }
         }
+        SetLastErrorCode(error);
         return MP4_INVALID_DURATION;
     }
 
@@ -3410,19 +3734,29 @@ MP4FileHandle MP4ModifyCallbacks(const MP4IOCallbacks* callbacks,
         MP4TrackId trackId,
         MP4SampleId sampleId)
     {
+        MP4Error error = MP4_ERROR_INVALID_HANDLE;
         if (MP4_IS_VALID_FILE_HANDLE(hFile)) {
             try {
-                return ((MP4File*)hFile)->GetSampleSync(
-                           trackId, sampleId);
+                error = ((MP4File*)hFile)->CheckSampleId(trackId, sampleId);
+
+                if (error == MP4_ERROR_NONE) {
+                    int8_t result =
+                        ((MP4File*)hFile)->GetSampleSync(trackId, sampleId);
+                    SetLastErrorCode(error);
+                    return result;
+                }
             }
             catch( Exception* x ) {
                 mp4v2::impl::log.errorf(*x);
                 delete x;
+                error = MP4_ERROR_FAILED;
             }
             catch( ... ) {
                 mp4v2::impl::log.errorf( "%s: failed", __FUNCTION__ );
+                error = MP4_ERROR_FAILED;
             }
         }
+        SetLastErrorCode(error);
         return -1;
     }
 
@@ -3729,6 +4063,27 @@ MP4FileHandle MP4ModifyCallbacks(const MP4IOCallbacks* callbacks,
         return MP4_INVALID_TRACK_ID;
     }
 
+    MP4TrackId MP4HintTrack(
+        MP4FileHandle hFile,
+        MP4TrackId mediaTrackId,
+        uint16_t maxPayloadSize)
+    {
+        if (MP4_IS_VALID_FILE_HANDLE(hFile)) {
+            try {
+                return ((MP4File*)hFile)->
+                       HintTrack(mediaTrackId, maxPayloadSize);
+            }
+            catch( Exception* x ) {
+                mp4v2::impl::log.errorf(*x);
+                delete x;
+            }
+            catch( ... ) {
+                mp4v2::impl::log.errorf( "%s: failed", __FUNCTION__ );
+            }
+        }
+        return MP4_INVALID_TRACK_ID;
+    }
+
     bool MP4ReadRtpHint(
         MP4FileHandle hFile,
         MP4TrackId hintTrackId,
@@ -3842,6 +4197,138 @@ MP4FileHandle MP4ModifyCallbacks(const MP4IOCallbacks* callbacks,
         return false;
     }
 
+    MP4RtpSchedule* MP4CompileRtpSchedule(
+        MP4FileHandle hFile,
+        MP4TrackId hintTrackId)
+    {
+        if (MP4_IS_VALID_FILE_HANDLE(hFile)) {
+            try {
+                return ((MP4File*)hFile)->CompileRtpSchedule(hintTrackId);
+            }
+            catch( Exception* x ) {
+                mp4v2::impl::log.errorf(*x);
+                delete x;
+            }
+            catch( ... ) {
+                mp4v2::impl::log.errorf( "%s: failed", __FUNCTION__ );
+            }
+        }
+        return NULL;
+    }
+
+    bool MP4CheckRtpSchedule(
+        const MP4RtpSchedule* schedule,
+        uint64_t size)
+    {
+        if (schedule == NULL || size < sizeof(MP4RtpSchedule))
+            return false;
+
+        if (schedule->magic != MP4_RTP_SCHEDULE_MAGIC ||
+                schedule->version != MP4_RTP_SCHEDULE_VERSION ||
+                schedule->size > size)
+            return false;
+
+        // compare against differences, so offsets near 2^64 can't wrap
+        if (schedule->packetsOffset < sizeof(MP4RtpSchedule) ||
+                schedule->packetsOffset > schedule->segmentsOffset ||
+                schedule->segmentsOffset > schedule->poolOffset ||
+                schedule->poolOffset > schedule->size)
+            return false;
+
+        if ((schedule->segmentsOffset - schedule->packetsOffset) /
+                    sizeof(MP4RtpSchedulePacket) < schedule->numPackets ||
+                (schedule->poolOffset - schedule->segmentsOffset) /
+                    sizeof(MP4RtpScheduleSegment) < schedule->numSegments)
+            return false;
+
+        const MP4RtpSchedulePacket* packets = (const MP4RtpSchedulePacket*)
+            ((const uint8_t*)schedule + schedule->packetsOffset);
+        for (uint32_t i = 0; i < schedule->numPackets; i++) {
+            if ((uint64_t)packets[i].firstSegment + packets[i].numSegments >
+                    schedule->numSegments)
+                return false;
+        }
+
+        uint64_t poolSize = schedule->size - schedule->poolOffset;
+        const MP4RtpScheduleSegment* segments = (const MP4RtpScheduleSegment*)
+            ((const uint8_t*)schedule + schedule->segmentsOffset);
+        for (uint32_t i = 0; i < schedule->numSegments; i++) {
+            const MP4RtpScheduleSegment& segment = segments[i];
+
+            // file ranges can only be checked against the file by the
+            // caller, and must not wrap around for that either
+            if (segment.offset > (uint64_t)-1 - segment.length)
+                return false;
+
+            if ((segment.flags & MP4_RTP_SEGMENT_POOL) &&
+                    segment.offset + segment.length > poolSize)
+                return false;
+        }
+
+        return true;
+    }
+
+    uint32_t MP4BuildRtpSchedulePacket(
+        const MP4RtpSchedule* schedule,
+        uint32_t packetIndex,
+        const uint8_t* fileData,
+        uint32_t ssrc,
+        uint32_t sequenceStart,
+        uint32_t timestampStart,
+        uint8_t* header,
+        MP4RtpIoVec* iov,
+        uint32_t maxIov)
+    {
+        if (schedule == NULL || packetIndex >= schedule->numPackets ||
+                header == NULL || iov == NULL)
+            return 0;
+
+        const uint8_t* base = (const uint8_t*)schedule;
+        const MP4RtpSchedulePacket& packet =
+            ((const MP4RtpSchedulePacket*)(base + schedule->packetsOffset))[packetIndex];
+
+        if (packet.numSegments + 1u > maxIov)
+            return 0;
+
+        // same header as MP4ReadRtpPacket() produces
+        uint16_t sequenceNumber = (uint16_t)(sequenceStart + packet.sequenceNumber);
+        uint32_t timestamp = timestampStart + (uint32_t)packet.timestamp;
+
+        header[0] = packet.header[0];
+        header[1] = packet.header[1];
+        header[2] = (uint8_t)(sequenceNumber >> 8);
+        header[3] = (uint8_t)sequenceNumber;
+        header[4] = (uint8_t)(timestamp >> 24);
+        header[5] = (uint8_t)(timestamp >> 16);
+        header[6] = (uint8_t)(timestamp >> 8);
+        header[7] = (uint8_t)timestamp;
+        header[8] = (uint8_t)(ssrc >> 24);
+        header[9] = (uint8_t)(ssrc >> 16);
+        header[10] = (uint8_t)(ssrc >> 8);
+        header[11] = (uint8_t)ssrc;
+
+        iov[0].base = header;
+        iov[0].length = 12;
+
+        const MP4RtpScheduleSegment* segments =
+            (const MP4RtpScheduleSegment*)(base + schedule->segmentsOffset) +
+            packet.firstSegment;
+        const uint8_t* pool = base + schedule->poolOffset;
+
+        for (uint32_t i = 0; i < packet.numSegments; i++) {
+            if (segments[i].flags & MP4_RTP_SEGMENT_POOL) {
+                iov[i + 1].base = pool + segments[i].offset;
+            } else {
+                if (fileData == NULL)
+                    return 0;
+                iov[i + 1].base = fileData + segments[i].offset;
+            }
+            iov[i + 1].length = segments[i].length;
+        }
+
+        return packet.numSegments + 1;
+    }
+
     MP4Timestamp MP4GetRtpTimestampStart(
         MP4FileHandle hFile,
         MP4TrackId hintTrackId)
@@ -4253,6 +4740,27 @@ MP4FileHandle MP4ModifyCallbacks(const MP4IOCallbacks* callbacks,
         return MP4_INVALID_TIMESTAMP;
     }
 
+    MP4Timestamp MP4GetTrackEditStart(
+        MP4FileHandle hFile,
+        MP4TrackId trackId,
+        MP4EditId editId)
+    {
+        if (MP4_IS_VALID_FILE_HANDLE(hFile)) {
+            try {
+                return ((MP4File*)hFile)->GetTrackEditStart(
+                           trackId, editId);
+            }
+            catch( Exception* x ) {
+                mp4v2::impl::log.errorf(*x);
+                delete x;
+            }
+            catch( ... ) {
+                mp4v2::impl::log.errorf("%s: failed", __FUNCTION__ );
+            }
+        }
+        return MP4_INVALID_TIMESTAMP;
+    }
+
     MP4Duration MP4GetTrackEditTotalDuration(
         MP4FileHandle hFile,
         MP4TrackId trackId,
@@ -4437,6 +4945,26 @@ MP4FileHandle MP4ModifyCallbacks(const MP4IOCallbacks* callbacks,
         return MP4_INVALID_SAMPLE_ID;
     }
 
+    bool MP4GetNextEditSample(
+        MP4FileHandle hFile,
+        MP4TrackId trackId,
+        MP4EditSampleCursor* cursor)
+    {
+        if (MP4_IS_VALID_FILE_HANDLE(hFile) && cursor) {
+            try {
+                return ((MP4File*)hFile)->GetNextEditSample(trackId, *cursor);
+            }
+            catch( Exception* x ) {
+                mp4v2::impl::log.errorf(*x);
+                delete x;
+            }
+            catch( ... ) {
+                mp4v2::impl::log.errorf("%s: failed", __FUNCTION__ );
+            }
+        }
+        return false;
+    }
+
     /* Utlities */
 
     char* MP4BinaryToBase16(
@@ -53,6 +53,14 @@ public:
         return m_maxNumElements;
     }
 
+    // make room for size elements up front
+    void Reserve(MP4ArrayIndex size) {
+        if (size > m_maxNumElements) {
+            m_elements = (type*)MP4Realloc(m_elements, size * sizeof(type));
+            m_maxNumElements = size;
+        }
+    }
+
     inline void Add(type newElement) {
         Insert(newElement, m_numElements);
     }
@@ -112,6 +120,336 @@ protected:
     MP4ArrayIndex   m_maxNumElements;
 };
 
+///////////////////////////////////////////////////////////////////////////////
+
+/// Segmented array for potentially large tables.
+///
+/// Elements are stored in a directory of segments holding at most
+/// SegmentSize elements each.  Appending never moves elements that are
+/// already stored, and inserting or deleting in the middle only moves
+/// elements within a single segment (a full segment is split in two).
+/// As long as every segment but the last one is full, which is the case
+/// for tables that are only read or appended to, an index is mapped to
+/// its segment with a shift and a mask.
+///
+/// Most arrays hold a single value (scalar properties), so the first
+/// segment and its first element live inside the array itself and such
+/// arrays never touch the heap.
+
+template<class type> class MP4SegmentedArray {
+public:
+    enum {
+        SegmentShift = 12,
+        SegmentSize  = 1 << SegmentShift,
+        SegmentMask  = SegmentSize - 1
+    };
+
+    MP4SegmentedArray() {
+        m_segments = &m_inlineSegment;
+        m_numSegments = 0;
+        m_maxNumSegments = 1;
+        m_numElements = 0;
+        m_uniform = true;
+        m_cachedSegment = 0;
+    }
+
+    ~MP4SegmentedArray() {
+        Clear();
+        if (m_segments != &m_inlineSegment) {
+            MP4Free(m_segments);
+        }
+    }
+
+    inline bool ValidIndex(MP4ArrayIndex index) {
+        return (index < m_numElements);
+    }
+
+    inline MP4ArrayIndex Size(void) {
+        return m_numElements;
+    }
+
+    void Add(type newElement) {
+        Segment* pLast = AppendSegmentIfFull();
+        Reserve(*pLast, pLast->count + 1);
+        pLast->elements[pLast->count++] = newElement;
+        m_numElements++;
+    }
+
+    // append count elements, copying up to a segment at a time
+    void Append(const type* newElements, MP4ArrayIndex count) {
+        if ( ((uint64_t) m_numElements + count) * sizeof(type) > 0xFFFFFFFF )
+            throw new PLATFORM_EXCEPTION("requested array size exceeds 4GB", ERANGE); /* prevent overflow */
+
+        while (count) {
+            Segment* pLast = AppendSegmentIfFull();
+            uint32_t n = min(count, (MP4ArrayIndex)(SegmentSize - pLast->count));
+            Reserve(*pLast, pLast->count + n);
+            memcpy(&pLast->elements[pLast->count], newElements, n * sizeof(type));
+            pLast->count += n;
+            m_numElements += n;
+            newElements += n;
+            count -= n;
+        }
+    }
+
+    void Insert(type newElement, MP4ArrayIndex newIndex) {
+        if (newIndex > m_numElements) {
+            throw new PLATFORM_EXCEPTION("illegal array index", ERANGE);
+        }
+        if (newIndex == m_numElements) {
+            Add(newElement);
+            return;
+        }
+
+        MP4ArrayIndex offset;
+        uint32_t s = Locate(newIndex, offset);
+        bool split = false;
+
+        if (m_segments[s].count == SegmentSize) {
+            // move the upper half of the full segment into a new one
+            const uint32_t half = SegmentSize / 2;
+            InsertSegment(s + 1, half);
+            Segment& lower = m_segments[s];
+            Segment& upper = m_segments[s + 1];
+            memcpy(upper.elements, &lower.elements[half], half * sizeof(type));
+            upper.first = lower.first + half;
+            upper.count = half;
+            lower.count = half;
+            if (offset >= half) {
+                s++;
+                offset -= half;
+            }
+            split = true;
+        }
+
+        Segment& seg = m_segments[s];
+        Reserve(seg, seg.count + 1);
+        memmove(&seg.elements[offset + 1], &seg.elements[offset],
+            (seg.count - offset) * sizeof(type));
+        seg.elements[offset] = newElement;
+        seg.count++;
+        for (uint32_t i = s + 1; i < m_numSegments; i++) {
+            m_segments[i].first++;
+        }
+        m_numElements++;
+
+        if (split || s + 1 < m_numSegments) {
+            m_uniform = false;
+        }
+    }
+
+    void Delete(MP4ArrayIndex index) {
+        if (!ValidIndex(index)) {
+            ostringstream msg;
+            msg << "illegal array index: " << index << " of " << m_numElements;
+            throw new PLATFORM_EXCEPTION(msg.str().c_str(), ERANGE);
+        }
+
+        MP4ArrayIndex offset;
+        uint32_t s = Locate(index, offset);
+        const bool wasLast = (s + 1 == m_numSegments);
+
+        Segment& seg = m_segments[s];
+        seg.count--;
+        memmove(&seg.elements[offset], &seg.elements[offset + 1],
+            (seg.count - offset) * sizeof(type));
+        for (uint32_t i = s + 1; i < m_numSegments; i++) {
+            m_segments[i].first--;
+        }
+        m_numElements--;
+
+        if (seg.count == 0 && m_numSegments > 1) {
+            RemoveSegment(s);
+        }
+        if (!wasLast) {
+            m_uniform = false;
+        }
+    }
+
+    void Resize(MP4ArrayIndex newSize) {
+        if ( (uint64_t) newSize * sizeof(type) > 0xFFFFFFFF )
+            throw new PLATFORM_EXCEPTION("requested array size exceeds 4GB", ERANGE); /* prevent overflow */
+
+        if (newSize == 0) {
+            Clear();
+            return;
+        }
+
+        // shrink from the end
+        while (m_numElements > newSize) {
+            Segment& last = m_segments[m_numSegments - 1];
+            MP4ArrayIndex excess = m_numElements - newSize;
+            if (excess >= last.count && m_numSegments > 1) {
+                m_numElements -= last.count;
+                RemoveSegment(m_numSegments - 1);
+            } else {
+                last.count -= excess;
+                m_numElements -= excess;
+            }
+        }
+
+        // grow at the end, leaving new elements uninitialized
+        while (m_numElements < newSize) {
+            Segment* pLast = AppendSegmentIfFull();
+            uint32_t n = min(newSize - m_numElements,
+                             (MP4ArrayIndex)(SegmentSize - pLast->count));
+            Reserve(*pLast, pLast->count + n);
+            pLast->count += n;
+            m_numElements += n;
+        }
+    }
+
+    type& operator[](MP4ArrayIndex index) {
+        if (ValidIndex(index)) {
+            if (m_uniform) {
+                return m_segments[index >> SegmentShift].elements[index & SegmentMask];
+            }
+            MP4ArrayIndex offset;
+            uint32_t s = Locate(index, offset);
+            return m_segments[s].elements[offset];
+        }
+        else {
+            ostringstream msg;
+            msg << "illegal array index: " << index << " of " << m_numElements;
+            throw new PLATFORM_EXCEPTION(msg.str().c_str(), ERANGE);
+        }
+    }
+
+protected:
+    struct Segment {
+        type*           elements;
+        MP4ArrayIndex   first;      // index of elements[0] in the whole array
+        uint32_t        count;
+        uint32_t        maxCount;
+    };
+
+    // find the segment holding a valid index
+    uint32_t Locate(MP4ArrayIndex index, MP4ArrayIndex& offset) {
+        if (m_uniform) {
+            offset = index & SegmentMask;
+            return index >> SegmentShift;
+        }
+
+        Segment* pCached = &m_segments[m_cachedSegment];
+        if (index < pCached->first || index >= pCached->first + pCached->count) {
+            uint32_t lo = 0;
+            uint32_t hi = m_numSegments - 1;
+            while (lo < hi) {
+                uint32_t mid = (lo + hi + 1) / 2;
+                if (m_segments[mid].first <= index) {
+                    lo = mid;
+                } else {
+                    hi = mid - 1;
+                }
+            }
+            m_cachedSegment = lo;
+            pCached = &m_segments[lo];
+        }
+
+        offset = index - pCached->first;
+        return m_cachedSegment;
+    }
+
+    // make sure a segment can hold count elements
+    void Reserve(Segment& seg, uint32_t count) {
+        if (count <= seg.maxCount) {
+            return;
+        }
+        if (seg.maxCount == 0 && count == 1) {
+            // only a new first segment starts empty, so the inline
+            // element is not in use
+            seg.elements = &m_inlineElement;
+            seg.maxCount = 1;
+            return;
+        }
+        uint32_t newMax = max(count, min(seg.maxCount * 2, (uint32_t)SegmentSize));
+        if (seg.elements == &m_inlineElement) {
+            seg.elements = (type*)MP4Malloc(newMax * sizeof(type));
+            seg.elements[0] = m_inlineElement;
+        } else {
+            seg.elements = (type*)MP4Realloc(seg.elements, newMax * sizeof(type));
+        }
+        seg.maxCount = newMax;
+    }
+
+    // return the last segment, appending a new one if it is full.
+    // Only the first segment grows gradually, so small arrays stay small.
+    Segment* AppendSegmentIfFull() {
+        if (m_numSegments && m_segments[m_numSegments - 1].count < SegmentSize) {
+            return &m_segments[m_numSegments - 1];
+        }
+        return InsertSegment(m_numSegments, m_numSegments ? SegmentSize : 0);
+    }
+
+    Segment* InsertSegment(uint32_t pos, uint32_t maxCount) {
+        if (m_numSegments == m_maxNumSegments) {
+            uint32_t newSize = m_maxNumSegments * 2;
+            if (m_segments == &m_inlineSegment) {
+                m_segments = (Segment*)MP4Malloc(newSize * sizeof(Segment));
+                m_segments[0] = m_inlineSegment;
+            } else {
+                m_segments = (Segment*)MP4Realloc(m_segments,
+                    newSize * sizeof(Segment));
+            }
+            m_maxNumSegments = newSize;
+        }
+
+        MP4ArrayIndex first = (pos < m_numSegments) ? m_segments[pos].first : m_numElements;
+        memmove(&m_segments[pos + 1], &m_segments[pos],
+            (m_numSegments - pos) * sizeof(Segment));
+        m_numSegments++;
+
+        Segment& seg = m_segments[pos];
+        seg.elements = maxCount ? (type*)MP4Malloc(maxCount * sizeof(type)) : NULL;
+        seg.first = first;
+        seg.count = 0;
+        seg.maxCount = maxCount;
+
+        m_cachedSegment = 0;
+        return &seg;
+    }
+
+    void FreeElements(Segment& seg) {
+        if (seg.elements != &m_inlineElement) {
+            MP4Free(seg.elements);
+        }
+    }
+
+    void RemoveSegment(uint32_t pos) {
+        FreeElements(m_segments[pos]);
+        m_numSegments--;
+        memmove(&m_segments[pos], &m_segments[pos + 1],
+            (m_numSegments - pos) * sizeof(Segment));
+        m_cachedSegment = 0;
+    }
+
+    void Clear() {
+        for (uint32_t i = 0; i < m_numSegments; i++) {
+            FreeElements(m_segments[i]);
+        }
+        m_numSegments = 0;
+        m_numElements = 0;
+        m_uniform = true;
+        m_cachedSegment = 0;
+    }
+
+protected:
+    Segment*        m_segments;
+    uint32_t        m_numSegments;
+    uint32_t        m_maxNumSegments;
+    MP4ArrayIndex   m_numElements;
+    bool            m_uniform;
+    uint32_t        m_cachedSegment;
+    Segment         m_inlineSegment;
+    type            m_inlineElement;
+
+private:
+    MP4SegmentedArray ( const MP4SegmentedArray &src );
+    MP4SegmentedArray &operator= ( const MP4SegmentedArray &src );
+};
+
+///////////////////////////////////////////////////////////////////////////////
+
 typedef MP4Array<uint8_t> MP4Integer8Array;
 typedef MP4Array<uint16_t> MP4Integer16Array;
 typedef MP4Array<uint32_t> MP4Integer32Array;
@@ -37,14 +37,6 @@ namespace mp4v2 { namespace impl {
 
 ///////////////////////////////////////////////////////////////////////////////
 
-MP4AtomInfo::MP4AtomInfo(const char* name, bool mandatory, bool onlyOne)
-{
-    m_name = name;
-    m_mandatory = mandatory;
-    m_onlyOne = onlyOne;
-    m_count = 0;
-}
-
 MP4Atom::MP4Atom(MP4File& file, const char* type)
     : m_File(file)
 {
@@ -56,6 +48,8 @@ MP4Atom::MP4Atom(MP4File& file, const char* type)
     m_size = 0;
     m_pParentAtom = NULL;
     m_depth = 0xFF;
+    m_pChildAtomInfos = NULL;
+    m_numChildAtomInfos = 0;
 }
 
 MP4Atom::~MP4Atom()
@@ -65,9 +59,6 @@ MP4Atom::~MP4Atom()
     for (i = 0; i < m_pProperties.Size(); i++) {
         delete m_pProperties[i];
     }
-    for (i = 0; i < m_pChildAtomInfos.Size(); i++) {
-        delete m_pChildAtomInfos[i];
-    }
     for (i = 0; i < m_pChildAtoms.Size(); i++) {
         delete m_pChildAtoms[i];
     }
@@ -93,13 +84,13 @@ void MP4Atom::Generate()
     }
 
     // for all mandatory, single child atom types
-    for (i = 0; i < m_pChildAtomInfos.Size(); i++) {
-        if (m_pChildAtomInfos[i]->m_mandatory
-                && m_pChildAtomInfos[i]->m_onlyOne) {
+    for (i = 0; i < m_numChildAtomInfos; i++) {
+        if (m_pChildAtomInfos[i].m_mandatory
+                && m_pChildAtomInfos[i].m_onlyOne) {
 
             // create the mandatory, single child atom
             MP4Atom* pChildAtom =
-                CreateAtom(m_File, this, m_pChildAtomInfos[i]->m_name);
+                CreateAtom(m_File, this, m_pChildAtomInfos[i].m_name);
 
             AddChildAtom(pChildAtom);
 
@@ -116,7 +107,7 @@ MP4Atom* MP4Atom::ReadAtom(MP4File& file, MP4Atom* pParentAtom)
 
     uint64_t pos = file.GetPosition();
 
-    log.verbose1f("\"%s\": pos = 0x%" PRIx64, file.GetFilename().c_str(), pos);
+    LOG_VERBOSE1F("\"%s\": pos = 0x%" PRIx64, file.GetFilename().c_str(), pos);
 
     uint64_t dataSize = file.ReadUInt32();
 
@@ -152,7 +143,7 @@ MP4Atom* MP4Atom::ReadAtom(MP4File& file, MP4Atom* pParentAtom)
     }
     dataSize -= hdrSize;
 
-    log.verbose1f("\"%s\": type = \"%s\" data-size = %" PRIu64 " (0x%" PRIx64 ") hdr %u",
+    LOG_VERBOSE1F("\"%s\": type = \"%s\" data-size = %" PRIu64 " (0x%" PRIx64 ") hdr %u",
                   file.GetFilename().c_str(), type, dataSize, dataSize, hdrSize);
 
     if (pos + hdrSize + dataSize > pParentAtom->GetEnd()) {
@@ -160,7 +151,7 @@ MP4Atom* MP4Atom::ReadAtom(MP4File& file, MP4Atom* pParentAtom)
                    __FUNCTION__, file.GetFilename().c_str(), pParentAtom->GetType(), type,
                    pos + hdrSize + dataSize,
                    pParentAtom->GetEnd());
-        log.verbose1f("\"%s\": parent %s (%" PRIu64 ") pos %" PRIu64 " hdr %d data %" PRIu64 " sum %" PRIu64,
+        LOG_VERBOSE1F("\"%s\": parent %s (%" PRIu64 ") pos %" PRIu64 " hdr %d data %" PRIu64 " sum %" PRIu64,
                       file.GetFilename().c_str(), pParentAtom->GetType(),
                       pParentAtom->GetEnd(),
                       pos,
@@ -186,7 +177,7 @@ MP4Atom* MP4Atom::ReadAtom(MP4File& file, MP4Atom* pParentAtom)
             log.warningf("%s: \"%s\": atom type %s is suspect", __FUNCTION__, file.GetFilename().c_str(),
                          pAtom->GetType());
         } else {
-            log.verbose1f("\"%s\": Info: atom type %s is unknown", file.GetFilename().c_str(),
+            LOG_VERBOSE1F("\"%s\": Info: atom type %s is unknown", file.GetFilename().c_str(),
                           pAtom->GetType());
         }
 
@@ -230,14 +221,14 @@ bool MP4Atom::IsReasonableType(const char* type)
 void MP4Atom::Read()
 {
     if (ATOMID(m_type) != 0 && m_size > 1000000) {
-        log.verbose1f("%s: \"%s\": %s atom size %" PRIu64 " is suspect", __FUNCTION__,
+        LOG_VERBOSE1F("%s: \"%s\": %s atom size %" PRIu64 " is suspect", __FUNCTION__,
                      m_File.GetFilename().c_str(), m_type, m_size);
     }
 
     ReadProperties();
 
     // read child atoms, if we expect there to be some
-    if (m_pChildAtomInfos.Size() > 0) {
+    if (m_numChildAtomInfos > 0) {
         ReadChildAtoms();
     }
 
@@ -247,7 +238,7 @@ void MP4Atom::Read()
 void MP4Atom::Skip()
 {
     if (m_File.GetPosition() != m_end) {
-        log.verbose1f("\"%s\": Skip: %" PRIu64 " bytes",
+        LOG_VERBOSE1F("\"%s\": Skip: %" PRIu64 " bytes",
                       m_File.GetFilename().c_str(), m_end - m_File.GetPosition());
     }
     m_File.SetPosition(m_end);
@@ -260,7 +251,7 @@ MP4Atom* MP4Atom::FindAtom(const char* name)
     }
 
     if (!IsRootAtom()) {
-        log.verbose1f("\"%s\": FindAtom: matched %s", 
+        LOG_VERBOSE1F("\"%s\": FindAtom: matched %s", 
                       GetFile().GetFilename().c_str(), name);
 
         name = MP4NameAfterFirst(name);
@@ -283,7 +274,7 @@ bool MP4Atom::FindProperty(const char *name,
     }
 
     if (!IsRootAtom()) {
-        log.verbose1f("\"%s\": FindProperty: matched %s", 
+        LOG_VERBOSE1F("\"%s\": FindProperty: matched %s", 
                       GetFile().GetFilename().c_str(), name);
 
         name = MP4NameAfterFirst(name);
@@ -368,7 +359,7 @@ bool MP4Atom::FindContainedProperty(const char *name,
         }
     }
 
-    log.verbose1f("\"%s\": FindProperty: no match for %s", 
+    LOG_VERBOSE1F("\"%s\": FindProperty: no match for %s", 
                   GetFile().GetFilename().c_str(), name);
     return false;
 }
@@ -383,7 +374,7 @@ void MP4Atom::ReadProperties(uint32_t startIndex, uint32_t count)
         m_pProperties[i]->Read(m_File);
 
         if (m_File.GetPosition() > m_end) {
-            log.verbose1f("ReadProperties: insufficient data for property: %s pos 0x%" PRIx64 " atom end 0x%" PRIx64,
+            LOG_VERBOSE1F("ReadProperties: insufficient data for property: %s pos 0x%" PRIx64 " atom end 0x%" PRIx64,
                           m_pProperties[i]->GetName(),
                           m_File.GetPosition(), m_end);
 
@@ -407,7 +398,10 @@ void MP4Atom::ReadChildAtoms()
 {
     bool this_is_udta = ATOMID(m_type) == ATOMID("udta");
 
-    log.verbose1f("\"%s\": of %s", m_File.GetFilename().c_str(), m_type[0] ? m_type : "root");
+    // how often each expected child atom type was seen
+    vector<uint32_t> counts(m_numChildAtomInfos, 0);
+
+    LOG_VERBOSE1F("\"%s\": of %s", m_File.GetFilename().c_str(), m_type[0] ? m_type : "root");
     for (uint64_t position = m_File.GetPosition();
             position < m_end;
             position = m_File.GetPosition()) {
@@ -436,21 +430,22 @@ void MP4Atom::ReadChildAtoms()
 
         AddChildAtom(pChildAtom);
 
-        MP4AtomInfo* pChildAtomInfo = FindAtomInfo(pChildAtom->GetType());
+        uint32_t infoIndex;
+        bool expected = FindAtomInfo(pChildAtom->GetType(), infoIndex);
 
         // if child atom is of known type
         // but not expected here print warning
-        if (pChildAtomInfo == NULL && !pChildAtom->IsUnknownType()) {
-            log.verbose1f("%s: \"%s\": In atom %s unexpected child atom %s", __FUNCTION__,
+        if (!expected && !pChildAtom->IsUnknownType()) {
+            LOG_VERBOSE1F("%s: \"%s\": In atom %s unexpected child atom %s", __FUNCTION__,
                           m_File.GetFilename().c_str(), GetType(), pChildAtom->GetType());
         }
 
         // if child atoms should have just one instance
         // and this is more than one, print warning
-        if (pChildAtomInfo) {
-            pChildAtomInfo->m_count++;
+        if (expected) {
+            counts[infoIndex]++;
 
-            if (pChildAtomInfo->m_onlyOne && pChildAtomInfo->m_count > 1) {
+            if (m_pChildAtomInfos[infoIndex].m_onlyOne && counts[infoIndex] > 1) {
                 log.warningf("%s: \"%s\": In atom %s multiple child atoms %s", __FUNCTION__,
                              m_File.GetFilename().c_str(), GetType(), pChildAtom->GetType());
             }
@@ -459,27 +454,26 @@ void MP4Atom::ReadChildAtoms()
     }
 
     // if mandatory child atom doesn't exist, print warning
-    uint32_t numAtomInfo = m_pChildAtomInfos.Size();
-    for (uint32_t i = 0; i < numAtomInfo; i++) {
-        if (m_pChildAtomInfos[i]->m_mandatory
-                && m_pChildAtomInfos[i]->m_count == 0) {
+    for (uint32_t i = 0; i < m_numChildAtomInfos; i++) {
+        if (m_pChildAtomInfos[i].m_mandatory && counts[i] == 0) {
             log.warningf("%s: \"%s\": In atom %s missing child atom %s", __FUNCTION__,
-                         m_File.GetFilename().c_str(), GetType(), m_pChildAtomInfos[i]->m_name);
+                         m_File.GetFilename().c_str(), GetType(), m_pChildAtomInfos[i].m_name);
         }
     }
 
-    log.verbose1f("\"%s\": finished %s", m_File.GetFilename().c_str(), m_type);
+    LOG_VERBOSE1F("\"%s\": finished %s", m_File.GetFilename().c_str(), m_type);
 }
 
-MP4AtomInfo* MP4Atom::FindAtomInfo(const char* name)
+bool MP4Atom::FindAtomInfo(const char* name, uint32_t& index)
 {
-    uint32_t numAtomInfo = m_pChildAtomInfos.Size();
-    for (uint32_t i = 0; i < numAtomInfo; i++) {
-        if (ATOMID(m_pChildAtomInfos[i]->m_name) == ATOMID(name)) {
-            return m_pChildAtomInfos[i];
+    const uint32_t id = ATOMID(name);
+    for (uint32_t i = 0; i < m_numChildAtomInfos; i++) {
+        if (m_pChildAtomInfos[i].m_id == id) {
+            index = i;
+            return true;
         }
     }
-    return NULL;
+    return false;
 }
 
 // generic write
@@ -530,18 +524,22 @@ void MP4Atom::FinishWrite(bool use64)
     m_end = m_File.GetPosition();
     m_size = (m_end - m_start);
 
-    log.verbose1f("end: type %s %" PRIu64 " %" PRIu64 " size %" PRIu64,
+    LOG_VERBOSE1F("end: type %s %" PRIu64 " %" PRIu64 " size %" PRIu64,
                        m_type,m_start, m_end, m_size);
     //use64 = m_File.Use64Bits();
+    uint8_t sizeBytes[8];
     if (use64) {
-        m_File.SetPosition(m_start + 8);
-        m_File.WriteUInt64(m_size);
+        for (int i = 0; i < 8; i++) {
+            sizeBytes[i] = (uint8_t)(m_size >> (56 - 8 * i));
+        }
+        m_File.WriteBytesAt(m_start + 8, sizeBytes, 8);
     } else {
         ASSERT(m_size <= (uint64_t)0xFFFFFFFF);
-        m_File.SetPosition(m_start);
-        m_File.WriteUInt32(m_size);
+        for (int i = 0; i < 4; i++) {
+            sizeBytes[i] = (uint8_t)(m_size >> (24 - 8 * i));
+        }
+        m_File.WriteBytesAt(m_start, sizeBytes, 4);
     }
-    m_File.SetPosition(m_end);
 
     // adjust size to just reflect data portion of atom
     m_size -= (use64 ? 16 : 8);
@@ -554,7 +552,7 @@ void MP4Atom::WriteProperties(uint32_t startIndex, uint32_t count)
 {
     uint32_t numProperties = min(count, m_pProperties.Size() - startIndex);
 
-    log.verbose1f("Write: \"%s\": type %s", m_File.GetFilename().c_str(), m_type);
+    LOG_VERBOSE1F("Write: \"%s\": type %s", m_File.GetFilename().c_str(), m_type);
 
     for (uint32_t i = startIndex; i < startIndex + numProperties; i++) {
         m_pProperties[i]->Write(m_File);
@@ -577,7 +575,7 @@ void MP4Atom::WriteChildAtoms()
         m_pChildAtoms[i]->Write();
     }
 
-    log.verbose1f("Write: \"%s\": finished %s", m_File.GetFilename().c_str(), m_type);
+    LOG_VERBOSE1F("Write: \"%s\": finished %s", m_File.GetFilename().c_str(), m_type);
 }
 
 void MP4Atom::AddProperty(MP4Property* pProperty)
@@ -586,10 +584,91 @@ void MP4Atom::AddProperty(MP4Property* pProperty)
     m_pProperties.Add(pProperty);
 }
 
+static MP4Property* CreateProperty(MP4Atom& atom, const MP4PropertyInfo& info)
+{
+    MP4Property* pProperty;
+
+    switch (info.m_type) {
+    case Integer8Property:
+        pProperty = new MP4Integer8Property(atom, info.m_name);
+        break;
+    case Integer16Property:
+        pProperty = new MP4Integer16Property(atom, info.m_name);
+        break;
+    case Integer24Property:
+        pProperty = new MP4Integer24Property(atom, info.m_name);
+        break;
+    case Integer32Property:
+        pProperty = new MP4Integer32Property(atom, info.m_name);
+        break;
+    case Integer64Property:
+        if (info.m_size) {
+            pProperty = new MP4BitfieldProperty(atom, info.m_name, info.m_size);
+        } else {
+            pProperty = new MP4Integer64Property(atom, info.m_name);
+        }
+        break;
+    case StringProperty: {
+        MP4StringProperty* pString = new MP4StringProperty(atom, info.m_name,
+            (info.m_flags & MP4PropertyInfo::CountedFormat) != 0);
+        if (info.m_size) {
+            pString->SetFixedLength(info.m_size);
+        }
+        pProperty = pString;
+        break;
+    }
+    case BytesProperty:
+        pProperty = new MP4BytesProperty(atom, info.m_name, info.m_size);
+        break;
+    default:
+        throw new EXCEPTION("property type not supported in a property table");
+    }
+
+    if (info.m_flags & MP4PropertyInfo::ReadOnly) {
+        pProperty->SetReadOnly();
+    }
+    if (info.m_flags & MP4PropertyInfo::Implicit) {
+        pProperty->SetImplicit();
+    }
+    return pProperty;
+}
+
+// infos is a static table describing the properties of this atom type in
+// file order.  A table property is counted by the entry before it, which
+// must be an integer, and takes the m_size entries after it as columns.
+void MP4Atom::AddProperties(const MP4PropertyInfo* infos, uint32_t count)
+{
+    m_pProperties.Reserve(m_pProperties.Size() + count);
+
+    for (uint32_t i = 0; i < count; i++) {
+        if (infos[i].m_type != TableProperty) {
+            AddProperty(CreateProperty(*this, infos[i]));
+            continue;
+        }
+
+        ASSERT(m_pProperties.Size() > 0);
+        MP4IntegerProperty* pCount =
+            (MP4IntegerProperty*)m_pProperties[m_pProperties.Size() - 1];
+        MP4TableProperty* pTable =
+            new MP4TableProperty(*this, infos[i].m_name, pCount);
+        AddProperty(pTable);
+
+        uint32_t numColumns = infos[i].m_size;
+        ASSERT(i + numColumns < count);
+        for (uint32_t j = 1; j <= numColumns; j++) {
+            pTable->AddProperty(CreateProperty(*this, infos[i + j]));
+        }
+        i += numColumns;
+    }
+}
+
 void MP4Atom::AddVersionAndFlags()
 {
-    AddProperty(new MP4Integer8Property(*this, "version"));
-    AddProperty(new MP4Integer24Property(*this, "flags"));
+    static const MP4PropertyInfo properties[] = {
+        MP4PropertyInfo(Integer8Property, "version"),
+        MP4PropertyInfo(Integer24Property, "flags"),
+    };
+    AddProperties(properties);
 }
 
 void MP4Atom::AddReserved(MP4Atom& parentAtom, const char* name, uint32_t size)
@@ -599,9 +678,12 @@ void MP4Atom::AddReserved(MP4Atom& parentAtom, const char* name, uint32_t size)
     AddProperty(pReserved);
 }
 
-void MP4Atom::ExpectChildAtom(const char* name, bool mandatory, bool onlyOne)
+// infos is a static table describing the children expected by this atom
+// type; it is not copied, so it must outlive the atom
+void MP4Atom::ExpectChildAtoms(const MP4AtomInfo* infos, uint32_t count)
 {
-    m_pChildAtomInfos.Add(new MP4AtomInfo(name, mandatory, onlyOne));
+    m_pChildAtomInfos = infos;
+    m_numChildAtomInfos = count;
 }
 
 uint8_t MP4Atom::GetVersion()
@@ -685,6 +767,54 @@ void MP4Atom::Dump(uint8_t indent, bool dumpImplicits)
     }
 }
 
+void MP4Atom::DumpJson(MP4JsonWriter& json)
+{
+    uint32_t i;
+    uint32_t size;
+
+    json.BeginObject();
+
+    json.Key("type");
+    json.String(m_type);
+    json.Key("offset");
+    json.Integer(m_start);
+    json.Key("size");
+    json.Integer(m_end - m_start);
+
+    // tables are summarized by the properties themselves unless in full mode
+    size = m_pProperties.Size();
+    if (size) {
+        json.Key("properties");
+        json.BeginObject();
+        for (i = 0; i < size; i++) {
+            MP4Property* const property = m_pProperties[i];
+
+            // implicit tables just can't be dumped
+            if (property->IsImplicit()
+                    && (!json.dumpImplicits || property->GetType() == TableProperty)) {
+                continue;
+            }
+
+            // unnamed descriptor properties just hold the nested descriptors
+            json.Key(property->GetName() ? property->GetName() : "descriptors");
+            property->DumpJson(json);
+        }
+        json.EndObject();
+    }
+
+    size = m_pChildAtoms.Size();
+    if (size) {
+        json.Key("children");
+        json.BeginArray();
+        for (i = 0; i < size; i++) {
+            m_pChildAtoms[i]->DumpJson(json);
+        }
+        json.EndArray();
+    }
+
+    json.EndObject();
+}
+
 uint8_t MP4Atom::GetDepth()
 {
     if (m_depth < 0xFF) {
@@ -723,55 +853,164 @@ MP4Atom::descendsFrom( MP4Atom* parent, const char* type )
 }
 
 // UDTA child atom types to be constructed as MP4UdtaElementAtom.
-// List gleaned from QTFF 2007-09-04.
-static const char* const UDTA_ELEMENTS[] = {
-    "\xA9" "arg",
-    "\xA9" "ark",
-    "\xA9" "cok",
-    "\xA9" "com",
-    "\xA9" "cpy",
-    "\xA9" "day",
-    "\xA9" "dir",
-    "\xA9" "ed1",
-    "\xA9" "ed2",
-    "\xA9" "ed3",
-    "\xA9" "ed4",
-    "\xA9" "ed5",
-    "\xA9" "ed6",
-    "\xA9" "ed7",
-    "\xA9" "ed8",
-    "\xA9" "ed9",
-    "\xA9" "fmt",
-    "\xA9" "inf",
-    "\xA9" "isr",
-    "\xA9" "lab",
-    "\xA9" "lal",
-    "\xA9" "mak",
-    "\xA9" "nak",
-    "\xA9" "nam",
-    "\xA9" "pdk",
-    "\xA9" "phg",
-    "\xA9" "prd",
-    "\xA9" "prf",
-    "\xA9" "prk",
-    "\xA9" "prl",
-    "\xA9" "req",
-    "\xA9" "snk",
-    "\xA9" "snm",
-    "\xA9" "src",
-    "\xA9" "swf",
-    "\xA9" "swk",
-    "\xA9" "swr",
-    "\xA9" "wrt",
-    "Allf",
-    "name",
-    "LOOP",
-    "ptv ",
-    "SelO",
-    "WLOC",
-    NULL // must be last
+// List gleaned from QTFF 2007-09-04, sorted by id for binary search.
+static const uint32_t UDTA_ELEMENTS[] = {
+    ATOMID("Allf"),
+    ATOMID("LOOP"),
+    ATOMID("SelO"),
+    ATOMID("WLOC"),
+    ATOMID("name"),
+    ATOMID("ptv "),
+    ATOMID("\xA9" "arg"),
+    ATOMID("\xA9" "ark"),
+    ATOMID("\xA9" "cok"),
+    ATOMID("\xA9" "com"),
+    ATOMID("\xA9" "cpy"),
+    ATOMID("\xA9" "day"),
+    ATOMID("\xA9" "dir"),
+    ATOMID("\xA9" "ed1"),
+    ATOMID("\xA9" "ed2"),
+    ATOMID("\xA9" "ed3"),
+    ATOMID("\xA9" "ed4"),
+    ATOMID("\xA9" "ed5"),
+    ATOMID("\xA9" "ed6"),
+    ATOMID("\xA9" "ed7"),
+    ATOMID("\xA9" "ed8"),
+    ATOMID("\xA9" "ed9"),
+    ATOMID("\xA9" "fmt"),
+    ATOMID("\xA9" "inf"),
+    ATOMID("\xA9" "isr"),
+    ATOMID("\xA9" "lab"),
+    ATOMID("\xA9" "lal"),
+    ATOMID("\xA9" "mak"),
+    ATOMID("\xA9" "nak"),
+    ATOMID("\xA9" "nam"),
+    ATOMID("\xA9" "pdk"),
+    ATOMID("\xA9" "phg"),
+    ATOMID("\xA9" "prd"),
+    ATOMID("\xA9" "prf"),
+    ATOMID("\xA9" "prk"),
+    ATOMID("\xA9" "prl"),
+    ATOMID("\xA9" "req"),
+    ATOMID("\xA9" "snk"),
+    ATOMID("\xA9" "snm"),
+    ATOMID("\xA9" "src"),
+    ATOMID("\xA9" "swf"),
+    ATOMID("\xA9" "swk"),
+    ATOMID("\xA9" "swr"),
+    ATOMID("\xA9" "wrt"),
+};
+
+namespace {
+
+typedef MP4Atom* (*AtomCreator)( MP4File& file, const char* type );
+
+template <class T>
+MP4Atom* make( MP4File& file, const char* )
+{
+    return new T(file);
+}
+
+template <class T>
+MP4Atom* makeTyped( MP4File& file, const char* type )
+{
+    return new T(file, type);
+}
+
+struct AtomFactoryEntry {
+    uint32_t    id;
+    AtomCreator create;
+
+    bool operator<( uint32_t other ) const { return id < other; }
+};
+
+// Atom types with a class of their own, independent of context.
+// Must stay sorted by id: it is searched with lower_bound().
+constexpr AtomFactoryEntry ATOM_FACTORY[] = {
+    { ATOMID("SMI "), make<MP4SmiAtom> },
+    { ATOMID("SVQ3"), makeTyped<MP4VideoAtom> },
+    { ATOMID("ac-3"), make<MP4Ac3Atom> },
+    { ATOMID("alac"), makeTyped<MP4SoundAtom> },
+    { ATOMID("alaw"), makeTyped<MP4SoundAtom> },
+    { ATOMID("alis"), makeTyped<MP4UrlAtom> },
+    { ATOMID("avc1"), make<MP4Avc1Atom> },
+    { ATOMID("avcC"), make<MP4AvcCAtom> },
+    { ATOMID("chap"), makeTyped<MP4TrefTypeAtom> },
+    { ATOMID("chpl"), make<MP4ChplAtom> },
+    { ATOMID("colr"), make<MP4ColrAtom> },
+    { ATOMID("d263"), make<MP4D263Atom> },
+    { ATOMID("dac3"), make<MP4DAc3Atom> },
+    { ATOMID("damr"), make<MP4DamrAtom> },
+    { ATOMID("dpnd"), makeTyped<MP4TrefTypeAtom> },
+    { ATOMID("dref"), make<MP4DrefAtom> },
+    { ATOMID("elst"), make<MP4ElstAtom> },
+    { ATOMID("enca"), make<MP4EncaAtom> },
+    { ATOMID("encv"), make<MP4EncvAtom> },
+    { ATOMID("free"), make<MP4FreeAtom> },
+    { ATOMID("ftab"), make<MP4FtabAtom> },
+    { ATOMID("ftyp"), make<MP4FtypAtom> },
+    { ATOMID("gmin"), make<MP4GminAtom> },
+    { ATOMID("h263"), makeTyped<MP4VideoAtom> },
+    { ATOMID("hdlr"), make<MP4HdlrAtom> },
+    { ATOMID("hint"), makeTyped<MP4TrefTypeAtom> },
+    { ATOMID("href"), make<MP4HrefAtom> },
+    { ATOMID("ima4"), makeTyped<MP4SoundAtom> },
+    { ATOMID("ipcm"), makeTyped<MP4SoundAtom> },
+    { ATOMID("ipir"), makeTyped<MP4TrefTypeAtom> },
+    { ATOMID("jpeg"), makeTyped<MP4VideoAtom> },
+    { ATOMID("lpcm"), makeTyped<MP4SoundAtom> },
+    { ATOMID("mdat"), make<MP4MdatAtom> },
+    { ATOMID("mdhd"), make<MP4MdhdAtom> },
+    { ATOMID("mp4a"), makeTyped<MP4SoundAtom> },
+    { ATOMID("mp4s"), make<MP4Mp4sAtom> },
+    { ATOMID("mp4v"), make<MP4Mp4vAtom> },
+    { ATOMID("mpod"), makeTyped<MP4TrefTypeAtom> },
+    { ATOMID("mvhd"), make<MP4MvhdAtom> },
+    { ATOMID("nmhd"), make<MP4NmhdAtom> },
+    { ATOMID("ohdr"), make<MP4OhdrAtom> },
+    { ATOMID("pasp"), make<MP4PaspAtom> },
+    { ATOMID("raw "), makeTyped<MP4VideoAtom> },
+    { ATOMID("rtp "), make<MP4RtpAtom> },
+    { ATOMID("s263"), make<MP4S263Atom> },
+    { ATOMID("samr"), makeTyped<MP4AmrAtom> },
+    { ATOMID("sawb"), makeTyped<MP4AmrAtom> },
+    { ATOMID("sdp "), make<MP4SdpAtom> },
+    { ATOMID("sdtp"), make<MP4SdtpAtom> },
+    { ATOMID("skip"), makeTyped<MP4FreeAtom> },
+    { ATOMID("sowt"), makeTyped<MP4SoundAtom> },
+    { ATOMID("stbl"), make<MP4StblAtom> },
+    { ATOMID("stdp"), make<MP4StdpAtom> },
+    { ATOMID("stsc"), make<MP4StscAtom> },
+    { ATOMID("stsd"), make<MP4StsdAtom> },
+    { ATOMID("stsz"), make<MP4StszAtom> },
+    { ATOMID("stz2"), make<MP4Stz2Atom> },
+    { ATOMID("sync"), makeTyped<MP4TrefTypeAtom> },
+    { ATOMID("text"), make<MP4TextAtom> },
+    { ATOMID("tfhd"), make<MP4TfhdAtom> },
+    { ATOMID("tkhd"), make<MP4TkhdAtom> },
+    { ATOMID("trun"), make<MP4TrunAtom> },
+    { ATOMID("twos"), makeTyped<MP4SoundAtom> },
+    { ATOMID("tx3g"), make<MP4Tx3gAtom> },
+    { ATOMID("udta"), make<MP4UdtaAtom> },
+    { ATOMID("ulaw"), makeTyped<MP4SoundAtom> },
+    { ATOMID("url "), make<MP4UrlAtom> },
+    { ATOMID("urn "), make<MP4UrnAtom> },
+    { ATOMID("vmhd"), make<MP4VmhdAtom> },
+    { ATOMID("yuv2"), makeTyped<MP4VideoAtom> },
 };
 
+constexpr size_t ATOM_FACTORY_SIZE = sizeof(ATOM_FACTORY) / sizeof(ATOM_FACTORY[0]);
+
+constexpr bool
+sortedFrom( const AtomFactoryEntry* table, size_t i, size_t size )
+{
+    return i + 1 >= size || ( table[i].id < table[i+1].id && sortedFrom( table, i + 1, size ));
+}
+
+static_assert( sortedFrom( ATOM_FACTORY, 0, ATOM_FACTORY_SIZE ), "ATOM_FACTORY must be sorted by id" );
+
+} // namespace
+
 MP4Atom*
 MP4Atom::factory( MP4File &file, MP4Atom* parent, const char* type )
 {
@@ -779,249 +1018,48 @@ MP4Atom::factory( MP4File &file, MP4Atom* parent, const char* type )
     if( !type )
         return new MP4RootAtom(file);
 
+    const uint32_t id = ATOMID( type );
+
     // construct atoms which are context-savvy
     if( parent ) {
-        const char* const ptype = parent->GetType();
+        const uint32_t pid = ATOMID( parent->GetType() );
 
         if( descendsFrom( parent, "ilst" )) {
-            if( ATOMID( ptype ) == ATOMID( "ilst" )) {
-               ASSERT( ATOMID( type ) != ATOMID( "ilst" ));  // don't allow ilst to be a child of ilst
+            if( pid == ATOMID( "ilst" )) {
+               ASSERT( id != ATOMID( "ilst" ));  // don't allow ilst to be a child of ilst
                return new MP4ItemAtom( file, type );
             }
 
-            if( ATOMID( type ) == ATOMID( "data" ))
+            if( id == ATOMID( "data" ))
                 return new MP4DataAtom(file);
 
-            if( ATOMID( ptype ) == ATOMID( "----" )) {
-                if( ATOMID( type ) == ATOMID( "mean" ))
+            if( pid == ATOMID( "----" )) {
+                if( id == ATOMID( "mean" ))
                     return new MP4MeanAtom(file);
-                if( ATOMID( type ) == ATOMID( "name" ))
+                if( id == ATOMID( "name" ))
                     return new MP4NameAtom(file);
             }
         }
-        else if( ATOMID( ptype ) == ATOMID( "meta" )) {
-            if( ATOMID( type ) == ATOMID( "hdlr" ))
+        else if( pid == ATOMID( "meta" )) {
+            if( id == ATOMID( "hdlr" ))
                 return new MP4ItmfHdlrAtom(file);
         }
-        else if( ATOMID( ptype ) == ATOMID( "udta" )) {
-            if( ATOMID( type ) == ATOMID( "hnti" ))
+        else if( pid == ATOMID( "udta" )) {
+            if( id == ATOMID( "hnti" ))
                 return new MP4HntiAtom(file);
-            if( ATOMID( type ) == ATOMID( "hinf" ))
+            if( id == ATOMID( "hinf" ))
                 return new MP4HinfAtom(file);
-            for( const char* const* p = UDTA_ELEMENTS; *p; p++ )
-                if( strequal( type, *p ))
-                    return new MP4UdtaElementAtom( file, type );
+            const uint32_t* const end = UDTA_ELEMENTS + sizeof(UDTA_ELEMENTS) / sizeof(UDTA_ELEMENTS[0]);
+            if( binary_search( UDTA_ELEMENTS, end, id ))
+                return new MP4UdtaElementAtom( file, type );
         }
     }
 
     // no-context construction (old-style)
-    switch( (uint8_t)type[0] ) {
-        case 'S':
-            if( ATOMID(type) == ATOMID("SVQ3") )
-                return new MP4VideoAtom( file, type );
-            if( ATOMID(type) == ATOMID("SMI ") )
-                return new MP4SmiAtom(file);
-            break;
-
-        case 'a':
-            if( ATOMID(type) == ATOMID("avc1") )
-                return new MP4Avc1Atom(file);
-            if( ATOMID(type) == ATOMID("ac-3") )
-                return new MP4Ac3Atom(file);
-            if( ATOMID(type) == ATOMID("avcC") )
-                return new MP4AvcCAtom(file);
-            if( ATOMID(type) == ATOMID("alis") )
-                return new MP4UrlAtom( file, type );
-            if( ATOMID(type) == ATOMID("alaw") )
-                return new MP4SoundAtom( file, type );
-            if( ATOMID(type) == ATOMID("alac") )
-                return new MP4SoundAtom( file, type );
-            break;
-
-        case 'c':
-            if( ATOMID(type) == ATOMID("chap") )
-                return new MP4TrefTypeAtom( file, type );
-            if( ATOMID(type) == ATOMID("chpl") )
-                return new MP4ChplAtom(file);
-            if( ATOMID(type) == ATOMID("colr") )
-                return new MP4ColrAtom(file);
-            break;
-
-        case 'd':
-            if( ATOMID(type) == ATOMID("d263") )
-                return new MP4D263Atom(file);
-            if( ATOMID(type) == ATOMID("damr") )
-                return new MP4DamrAtom(file);
-            if( ATOMID(type) == ATOMID("dref") )
-                return new MP4DrefAtom(file);
-            if( ATOMID(type) == ATOMID("dpnd") )
-                return new MP4TrefTypeAtom( file, type );
-            if( ATOMID(type) == ATOMID("dac3") )
-                return new MP4DAc3Atom(file);
-            break;
-
-        case 'e':
-            if( ATOMID(type) == ATOMID("elst") )
-                return new MP4ElstAtom(file);
-            if( ATOMID(type) == ATOMID("enca") )
-                return new MP4EncaAtom(file);
-            if( ATOMID(type) == ATOMID("encv") )
-                return new MP4EncvAtom(file);
-            break;
-
-        case 'f':
-            if( ATOMID(type) == ATOMID("free") )
-                return new MP4FreeAtom(file);
-            if( ATOMID(type) == ATOMID("ftyp") )
-                return new MP4FtypAtom(file);
-            if( ATOMID(type) == ATOMID("ftab") )
-                return new MP4FtabAtom(file);
-            break;
-
-        case 'g':
-            if( ATOMID(type) == ATOMID("gmin") )
-                return new MP4GminAtom(file);
-            break;
-
-        case 'h':
-            if( ATOMID(type) == ATOMID("hdlr") )
-                return new MP4HdlrAtom(file);
-            if( ATOMID(type) == ATOMID("hint") )
-                return new MP4TrefTypeAtom( file, type );
-            if( ATOMID(type) == ATOMID("h263") )
-                return new MP4VideoAtom( file, type );
-            if( ATOMID(type) == ATOMID("href") )
-                return new MP4HrefAtom(file);
-            break;
-
-        case 'i':
-            if( ATOMID(type) == ATOMID("ipir") )
-                return new MP4TrefTypeAtom( file, type );
-            if( ATOMID(type) == ATOMID("ima4") )
-                return new MP4SoundAtom( file, type );
-            if( ATOMID(type) == ATOMID("ipcm") )
-                return new MP4SoundAtom( file, type );
-            break;
-
-        case 'j':
-            if( ATOMID(type) == ATOMID("jpeg") )
-                return new MP4VideoAtom(file, "jpeg");
-            break;
-
-        case 'l':
-            if( ATOMID(type) == ATOMID("lpcm") )
-                return new MP4SoundAtom( file, type );
-            break;
-
-        case 'm':
-            if( ATOMID(type) == ATOMID("mdhd") )
-                return new MP4MdhdAtom(file);
-            if( ATOMID(type) == ATOMID("mvhd") )
-                return new MP4MvhdAtom(file);
-            if( ATOMID(type) == ATOMID("mdat") )
-                return new MP4MdatAtom(file);
-            if( ATOMID(type) == ATOMID("mpod") )
-                return new MP4TrefTypeAtom( file, type );
-            if( ATOMID(type) == ATOMID("mp4a") )
-                return new MP4SoundAtom( file, type );
-            if( ATOMID(type) == ATOMID("mp4s") )
-                return new MP4Mp4sAtom(file);
-            if( ATOMID(type) == ATOMID("mp4v") )
-                return new MP4Mp4vAtom(file);
-            break;
-
-        case 'n':
-            if( ATOMID(type) == ATOMID("nmhd") )
-                return new MP4NmhdAtom(file);
-            break;
-
-        case 'o':
-            if( ATOMID(type) == ATOMID("ohdr") )
-                return new MP4OhdrAtom(file);
-            break;
-
-        case 'p':
-            if( ATOMID(type) == ATOMID("pasp") )
-                return new MP4PaspAtom(file);
-            break;
-
-        case 'r':
-            if( ATOMID(type) == ATOMID("rtp ") )
-                return new MP4RtpAtom(file);
-            if( ATOMID(type) == ATOMID("raw ") )
-                return new MP4VideoAtom( file, type );
-            break;
-
-        case 's':
-            if( ATOMID(type) == ATOMID("s263") )
-                return new MP4S263Atom(file);
-            if( ATOMID(type) == ATOMID("samr") )
-                return new MP4AmrAtom( file, type );
-            if( ATOMID(type) == ATOMID("sawb") )
-                return new MP4AmrAtom( file, type );
-            if( ATOMID(type) == ATOMID("sdtp") )
-                return new MP4SdtpAtom(file);
-            if( ATOMID(type) == ATOMID("stbl") )
-                return new MP4StblAtom(file);
-            if( ATOMID(type) == ATOMID("stsd") )
-                return new MP4StsdAtom(file);
-            if( ATOMID(type) == ATOMID("stsz") )
-                return new MP4StszAtom(file);
-            if( ATOMID(type) == ATOMID("stsc") )
-                return new MP4StscAtom(file);
-            if( ATOMID(type) == ATOMID("stz2") )
-                return new MP4Stz2Atom(file);
-            if( ATOMID(type) == ATOMID("stdp") )
-                return new MP4StdpAtom(file);
-            if( ATOMID(type) == ATOMID("sdp ") )
-                return new MP4SdpAtom(file);
-            if( ATOMID(type) == ATOMID("sync") )
-                return new MP4TrefTypeAtom( file, type );
-            if( ATOMID(type) == ATOMID("skip") )
-                return new MP4FreeAtom( file, type );
-            if (ATOMID(type) == ATOMID("sowt") )
-                return new MP4SoundAtom( file, type );
-            break;
-
-        case 't':
-            if( ATOMID(type) == ATOMID("text") )
-                return new MP4TextAtom(file);
-            if( ATOMID(type) == ATOMID("tx3g") )
-                return new MP4Tx3gAtom(file);
-            if( ATOMID(type) == ATOMID("tkhd") )
-                return new MP4TkhdAtom(file);
-            if( ATOMID(type) == ATOMID("tfhd") )
-                return new MP4TfhdAtom(file);
-            if( ATOMID(type) == ATOMID("trun") )
-                return new MP4TrunAtom(file);
-            if( ATOMID(type) == ATOMID("twos") )
-                return new MP4SoundAtom( file, type );
-            break;
-
-        case 'u':
-            if( ATOMID(type) == ATOMID("udta") )
-                return new MP4UdtaAtom(file);
-            if( ATOMID(type) == ATOMID("url ") )
-                return new MP4UrlAtom(file);
-            if( ATOMID(type) == ATOMID("urn ") )
-                return new MP4UrnAtom(file);
-            if( ATOMID(type) == ATOMID("ulaw") )
-                return new MP4SoundAtom( file, type );
-            break;
-
-        case 'v':
-            if( ATOMID(type) == ATOMID("vmhd") )
-                return new MP4VmhdAtom(file);
-            break;
-
-        case 'y':
-            if( ATOMID(type) == ATOMID("yuv2") )
-                return new MP4VideoAtom( file, type );
-            break;
-
-        default:
-            break;
-    }
+    const AtomFactoryEntry* const end = ATOM_FACTORY + ATOM_FACTORY_SIZE;
+    const AtomFactoryEntry* entry = lower_bound( ATOM_FACTORY, end, id );
+    if( entry != end && entry->id == id )
+        return entry->create( file, type );
 
     // default to MP4StandardAtom implementation
     return new MP4StandardAtom( file, type ); 
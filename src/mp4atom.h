@@ -42,24 +42,51 @@ typedef MP4Array<MP4Atom*> MP4AtomArray;
 #define Many        false
 #define Counted     true
 
+// same result as STRTOINT32 but constexpr, so that ATOMID("....") is a
+// compile-time constant and can be used as a case label
+constexpr uint32_t ATOMID(const char* type) {
+    return (uint32_t)(uint8_t)type[0] << 24
+         | (uint32_t)(uint8_t)type[1] << 16
+         | (uint32_t)(uint8_t)type[2] << 8
+         | (uint32_t)(uint8_t)type[3];
+}
+
 /* helper class */
 class MP4AtomInfo {
 public:
-    MP4AtomInfo() {
-        m_name = NULL;
-        m_mandatory = Optional;
-        m_onlyOne = OnlyOne;
-        m_count = 0;
-    }
-    MP4AtomInfo(const char* name, bool mandatory, bool onlyOne);
+    constexpr MP4AtomInfo()
+        : m_name(NULL), m_id(0), m_mandatory(Optional), m_onlyOne(OnlyOne) {}
+    constexpr MP4AtomInfo(const char* name, bool mandatory, bool onlyOne)
+        : m_name(name), m_id(ATOMID(name)), m_mandatory(mandatory), m_onlyOne(onlyOne) {}
 
     const char* m_name;
+    uint32_t m_id;
     bool m_mandatory;
     bool m_onlyOne;
-    uint32_t m_count;
 };
 
-typedef MP4Array<MP4AtomInfo*> MP4AtomInfoArray;
+/* helper class, one entry of a static table describing the properties
+ * shared by all atoms of a type, see MP4Atom::AddProperties() */
+class MP4PropertyInfo {
+public:
+    enum {
+        ReadOnly = 0x01,
+        Implicit = 0x02,
+        CountedFormat = 0x04,   // string with a leading length byte
+    };
+
+    constexpr MP4PropertyInfo(MP4PropertyType type, const char* name,
+                              uint32_t size = 0, uint8_t flags = 0)
+        : m_type(type), m_name(name), m_size(size), m_flags(flags) {}
+
+    MP4PropertyType m_type;
+    const char* m_name;
+    // bits of a bitfield (Integer64Property), fixed length of a string or
+    // bytes property, number of columns following a table
+    uint32_t m_size;
+    uint8_t m_flags;
+};
+
 
 class MP4Atom
 {
@@ -195,20 +222,30 @@ public:
     virtual void Rewrite();
     virtual void FinishWrite(bool use64 = false);
     virtual void Dump(uint8_t indent, bool dumpImplicits);
+    virtual void DumpJson(MP4JsonWriter& json);
 
     bool GetLargesizeMode();
 
 protected:
     void AddProperty(MP4Property* pProperty);
 
+    void AddProperties(const MP4PropertyInfo* infos, uint32_t count);
+    template <uint32_t N>
+    void AddProperties(const MP4PropertyInfo (&infos)[N]) {
+        AddProperties(infos, N);
+    }
+
     void AddVersionAndFlags();
 
     void AddReserved(MP4Atom& parentAtom, const char* name, uint32_t size);
 
-    void ExpectChildAtom(const char* name,
-                         bool mandatory, bool onlyOne = true);
+    void ExpectChildAtoms(const MP4AtomInfo* infos, uint32_t count);
+    template <uint32_t N>
+    void ExpectChildAtoms(const MP4AtomInfo (&infos)[N]) {
+        ExpectChildAtoms(infos, N);
+    }
 
-    MP4AtomInfo* FindAtomInfo(const char* name);
+    bool FindAtomInfo(const char* name, uint32_t& index);
 
     bool IsMe(const char* name);
 
@@ -242,7 +279,8 @@ protected:
     uint8_t m_depth;
 
     MP4PropertyArray    m_pProperties;
-    MP4AtomInfoArray    m_pChildAtomInfos;
+    const MP4AtomInfo*  m_pChildAtomInfos;   // static table shared by all atoms of a type
+    uint32_t            m_numChildAtomInfos;
     MP4AtomArray        m_pChildAtoms;
 private:
     MP4Atom();
@@ -250,10 +288,6 @@ private:
     MP4Atom &operator= ( const MP4Atom &src );
 };
 
-inline uint32_t ATOMID(const char* type) {
-    return STRTOINT32(type);
-}
-
 // inverse ATOMID - 32 bit id to string
 inline void IDATOM(uint32_t type, char *s) {
     INT32TOSTR(type, s);
@@ -204,6 +204,34 @@ void MP4Descriptor::Dump(uint8_t indent, bool dumpImplicits)
     }
 }
 
+void MP4Descriptor::DumpJson(MP4JsonWriter& json)
+{
+    // call virtual function to adapt properties before dumping
+    Mutate();
+
+    json.BeginObject();
+    json.Key("tag");
+    json.Integer(m_tag);
+
+    json.Key("properties");
+    json.BeginObject();
+    uint32_t numProperties = m_pProperties.Size();
+    for (uint32_t i = 0; i < numProperties; i++) {
+        MP4Property* const property = m_pProperties[i];
+        if (property->IsImplicit()
+                && (!json.dumpImplicits || property->GetType() == TableProperty)) {
+            continue;
+        }
+
+        // unnamed descriptor properties just hold the nested descriptors
+        json.Key(property->GetName() ? property->GetName() : "descriptors");
+        property->DumpJson(json);
+    }
+    json.EndObject();
+
+    json.EndObject();
+}
+
 uint8_t MP4Descriptor::GetDepth()
 {
     return m_parentAtom.GetDepth();
@@ -46,6 +46,7 @@ public:
     virtual void Read(MP4File& file);
     virtual void Write(MP4File& file);
     virtual void Dump(uint8_t indent, bool dumpImplicits);
+    virtual void DumpJson(MP4JsonWriter& json);
 
     MP4Property* GetProperty(uint32_t index) {
         return m_pProperties[index];
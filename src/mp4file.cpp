@@ -64,6 +64,7 @@ void MP4File::Init()
     m_memoryBuffer = NULL;
     m_memoryBufferSize = 0;
     m_memoryBufferPosition = 0;
+    m_memoryBufferBase = 0;
 
     m_numReadBits = 0;
     m_bufReadBits = 0;
@@ -72,6 +73,9 @@ void MP4File::Init()
 
     m_editName[0] = 0;
     m_trakName[0] = 0;
+
+    m_maxExternalFiles = 8;
+    m_writeBufferSize = 64 * 1024;
 }
 
 MP4File::~MP4File()
@@ -80,6 +84,7 @@ MP4File::~MP4File()
     for( uint32_t i = 0; i < m_pTracks.Size(); i++ )
         delete m_pTracks[i];
     MP4Free( m_memoryBuffer ); // just in case
+    CloseExternalFiles();
     delete m_file;
 }
 
@@ -315,6 +320,8 @@ void MP4File::Optimize( const char* srcFileName, const char* dstFileName )
         // finish writing
         ((MP4RootAtom*)m_pRootAtom)->FinishOptimalWrite();
 
+        if( dst->flush() )
+            throw new PLATFORM_EXCEPTION("write failed", sys::getLastError());
     }
     catch (...) {
         // cleanup and rethrow.  Without this, we'd leak memory and an open file handle(s).
@@ -337,71 +344,457 @@ void MP4File::Optimize( const char* srcFileName, const char* dstFileName )
         Rename( dname.c_str(), srcFileName );
 }
 
-void MP4File::RewriteMdat( File& src, File& dst )
+// Walks the chunks of a set of tracks in the order they are laid out in
+// mdat: by start time in the movie time scale, with a hint track's chunk
+// ahead of media chunks starting at the same time.
+class ChunkOrder
 {
-    uint32_t numTracks = m_pTracks.Size();
+public:
+    ChunkOrder( uint32_t movieTimeScale )
+        : m_movieTimeScale( movieTimeScale )
+    { }
 
-    MP4ChunkId* chunkIds = new MP4ChunkId[numTracks];
-    MP4ChunkId* maxChunkIds = new MP4ChunkId[numTracks];
-    MP4Timestamp* nextChunkTimes = new MP4Timestamp[numTracks];
-
-    for( uint32_t i = 0; i < numTracks; i++ ) {
-        chunkIds[i] = 1;
-        maxChunkIds[i] = m_pTracks[i]->GetNumberOfChunks();
-        nextChunkTimes[i] = MP4_INVALID_TIMESTAMP;
-    }
-
-    for( ;; ) {
+    // startTime is added to the track's chunk times, in its time scale
+    void AddTrack( MP4Track& track, MP4Timestamp startTime = 0 )
+    {
+        TrackChunks chunks;
+        chunks.track = &track;
+        chunks.startTime = startTime;
+        chunks.chunkId = 1;
+        chunks.maxChunkId = track.GetNumberOfChunks();
+        chunks.nextTime = MP4_INVALID_TIMESTAMP;
+        chunks.isHint = strequal( track.GetType(), MP4_HINT_TRACK_TYPE );
+        m_tracks.push_back( chunks );
+    }
+
+    // the index of the track in the order it was added and the id of its
+    // next chunk, or false once all chunks have been visited
+    bool Next( uint32_t& trackIndex, MP4ChunkId& chunkId )
+    {
         uint32_t nextTrackIndex = (uint32_t)-1;
         MP4Timestamp nextTime = MP4_INVALID_TIMESTAMP;
 
-        for( uint32_t i = 0; i < numTracks; i++ ) {
-            if( chunkIds[i] > maxChunkIds[i] )
+        for( uint32_t i = 0; i < m_tracks.size(); i++ ) {
+            TrackChunks& chunks = m_tracks[i];
+            if( chunks.chunkId > chunks.maxChunkId )
                 continue;
 
-            if( nextChunkTimes[i] == MP4_INVALID_TIMESTAMP ) {
-                MP4Timestamp chunkTime = m_pTracks[i]->GetChunkTime( chunkIds[i] );
-                nextChunkTimes[i] = MP4ConvertTime( chunkTime, m_pTracks[i]->GetTimeScale(), GetTimeScale() );
+            if( chunks.nextTime == MP4_INVALID_TIMESTAMP ) {
+                MP4Timestamp chunkTime = chunks.track->GetChunkTime( chunks.chunkId ) + chunks.startTime;
+                chunks.nextTime = MP4ConvertTime( chunkTime, chunks.track->GetTimeScale(), m_movieTimeScale );
             }
 
             // time is not earliest so far
-            if( nextChunkTimes[i] > nextTime )
+            if( chunks.nextTime > nextTime )
                 continue;
 
             // prefer hint tracks to media tracks if times are equal
-            if( nextChunkTimes[i] == nextTime && !strequal( m_pTracks[i]->GetType(), MP4_HINT_TRACK_TYPE ))
+            if( chunks.nextTime == nextTime && !chunks.isHint )
                 continue;
 
             // this is our current choice of tracks
-            nextTime = nextChunkTimes[i];
+            nextTime = chunks.nextTime;
             nextTrackIndex = i;
         }
 
         if( nextTrackIndex == (uint32_t)-1 )
-            break;
+            return false;
+
+        TrackChunks& chunks = m_tracks[nextTrackIndex];
+        trackIndex = nextTrackIndex;
+        chunkId = chunks.chunkId++;
+        chunks.nextTime = MP4_INVALID_TIMESTAMP;
+        return true;
+    }
 
+private:
+    struct TrackChunks {
+        MP4Track*    track;
+        MP4Timestamp startTime;
+        MP4ChunkId   chunkId;
+        MP4ChunkId   maxChunkId;
+        MP4Timestamp nextTime;
+        bool         isHint;
+    };
+
+    const uint32_t      m_movieTimeScale;
+    vector<TrackChunks> m_tracks;
+};
+
+void MP4File::RewriteMdat( File& src, File& dst )
+{
+    ChunkOrder order( GetTimeScale() );
+    for( uint32_t i = 0; i < m_pTracks.Size(); i++ )
+        order.AddTrack( *m_pTracks[i] );
+
+    uint32_t trackIndex;
+    MP4ChunkId chunkId;
+    while( order.Next( trackIndex, chunkId )) {
         uint8_t* pChunk;
         uint32_t chunkSize;
 
         // point into original mp4 file for read chunk call
         m_file = &src;
-        m_pTracks[nextTrackIndex]->ReadChunk( chunkIds[nextTrackIndex], &pChunk, &chunkSize );
+        m_pTracks[trackIndex]->ReadChunk( chunkId, &pChunk, &chunkSize );
 
         // point back at the new mp4 file for write chunk
         m_file = &dst;
-        m_pTracks[nextTrackIndex]->RewriteChunk( chunkIds[nextTrackIndex], pChunk, chunkSize );
+        m_pTracks[trackIndex]->RewriteChunk( chunkId, pChunk, chunkSize );
 
         MP4Free( pChunk );
+    }
+}
+
+void MP4File::Remux( MP4File&          srcFile,
+                     const char*       dstFileName,
+                     const MP4TrackId* trackIds,
+                     uint32_t          numTracks,
+                     MP4Timestamp      startTime,
+                     MP4Duration       duration,
+                     MP4Duration       interleaveDuration )
+{
+    if( srcFile.IsWriteMode() )
+        throw new EXCEPTION("source file must be opened for reading");
+
+    if( srcFile.GetFilename() == dstFileName || FileSystem::isSameFile( srcFile.GetFilename(), dstFileName ))
+        throw new EXCEPTION("cannot remux a file onto itself");
+
+    // no selection means all tracks
+    if( !trackIds || !numTracks ) {
+        numTracks = srcFile.m_pTracks.Size();
+        trackIds = NULL;
+    }
+
+    uint32_t movieTimeScale = srcFile.GetTimeScale();
+    bool wholeFile = startTime == 0 && duration == MP4_INVALID_DURATION;
+
+    if( interleaveDuration == 0 )
+        interleaveDuration = movieTimeScale;
+
+    vector<MP4Track*>    srcTracks( numTracks );
+    vector<MP4TrackId>   dstTrackIds( numTracks );
+    vector<MP4SampleId>  firstSampleIds( numTracks );
+    vector<uint32_t>     numSamples( numTracks );
+    vector<MP4Timestamp> firstSampleTimes( numTracks );
+    ChunkOrder           order( movieTimeScale );
+
+    try {
+        // select the sample range of each track, starting from the sync
+        // sample at or before startTime
+        uint64_t mediaSize = 0;
+
+        for( uint32_t i = 0; i < numTracks; i++ ) {
+            MP4Track* pTrack = trackIds
+                ? srcFile.GetTrack( trackIds[i] )
+                : srcFile.m_pTracks[i];
+            uint32_t timeScale = pTrack->GetTimeScale();
+
+            srcTracks[i] = pTrack;
+            dstTrackIds[i] = MP4_INVALID_TRACK_ID;
+            firstSampleIds[i] = 1;
+            numSamples[i] = pTrack->GetNumberOfSamples();
+            firstSampleTimes[i] = 0;
+
+            if( wholeFile ) {
+                mediaSize += pTrack->GetTotalOfSampleSizes();
+                continue;
+            }
+
+            if( !strcmp( pTrack->GetType(), MP4_HINT_TRACK_TYPE ))
+                throw new EXCEPTION("hint tracks can only be remuxed whole");
+
+            MP4SampleId firstSampleId, lastSampleId;
+            MP4Timestamp trackStart = MP4ConvertTime( startTime, movieTimeScale, timeScale );
+
+            if( pTrack->TryGetSampleIdFromTime( trackStart, false, firstSampleId ) != MP4_ERROR_NONE ) {
+                numSamples[i] = 0;
+                continue;
+            }
+            while( firstSampleId > 1 && !pTrack->IsSyncSample( firstSampleId ))
+                firstSampleId--;
+
+            lastSampleId = numSamples[i];
+            if( duration != MP4_INVALID_DURATION ) {
+                MP4Timestamp trackEnd = MP4ConvertTime( startTime + duration, movieTimeScale, timeScale );
+                if( trackEnd <= trackStart ||
+                        pTrack->TryGetSampleIdFromTime( trackEnd - 1, false, lastSampleId ) != MP4_ERROR_NONE ) {
+                    lastSampleId = trackEnd <= trackStart ? firstSampleId : numSamples[i];
+                }
+            }
+
+            firstSampleIds[i] = firstSampleId;
+            numSamples[i] = lastSampleId - firstSampleId + 1;
+            pTrack->GetSampleTimes( firstSampleId, &firstSampleTimes[i], NULL );
+
+            for( MP4SampleId sampleId = firstSampleId; sampleId <= lastSampleId; sampleId++ )
+                mediaSize += pTrack->GetSampleSize( sampleId );
+        }
+
+        // chunk offset widths are fixed when the tracks are created, so
+        // leave generous room for moov when deciding on 64-bit offsets
+        uint32_t flags = 0;
+        if( mediaSize >= 0xF0000000 )
+            flags |= MP4_CREATE_64BIT_DATA;
+
+        // destination skeleton, as in Create() but without writing anything
+        m_createFlags = flags;
+        Open( dstFileName, File::MODE_CREATE );
+
+        m_pRootAtom = MP4Atom::CreateAtom( *this, NULL, NULL );
+        m_pRootAtom->Generate();
+
+        if( MP4FtypAtom* ftyp = (MP4FtypAtom*)srcFile.FindAtom( "ftyp" )) {
+            uint32_t numBrands = ftyp->compatibleBrands.GetCount();
+            char** brands = new char*[numBrands ? numBrands : 1];
+            for( uint32_t i = 0; i < numBrands; i++ )
+                brands[i] = (char*)ftyp->compatibleBrands.GetValue( i );
+
+            MakeFtypAtom( (char*)ftyp->majorBrand.GetValue(),
+                          ftyp->minorVersion.GetValue(),
+                          brands, numBrands );
+            delete [] brands;
+        }
+
+        CacheProperties();
+        (void)InsertChildAtom( m_pRootAtom, "mdat", FindAtom( "ftyp" ) ? 1 : 0 );
+        if( srcFile.FindAtom( "moov.iods" ))
+            (void)AddChildAtom( "moov", "iods" );
+
+        SetTimeScale( movieTimeScale );
+
+        // media tracks first, so hint tracks can refer to their copies
+        for( int pass = 0; pass < 2; pass++ ) {
+            for( uint32_t i = 0; i < numTracks; i++ ) {
+                bool isHint = !strcmp( srcTracks[i]->GetType(), MP4_HINT_TRACK_TYPE );
+                if( isHint != (pass == 1) )
+                    continue;
+
+                MP4TrackId refTrackId = MP4_INVALID_TRACK_ID;
+                if( isHint ) {
+                    MP4TrackId srcRefTrackId =
+                        srcFile.GetHintTrackReferenceTrackId( srcTracks[i]->GetId() );
+                    for( uint32_t j = 0; j < numTracks; j++ ) {
+                        if( srcTracks[j]->GetId() == srcRefTrackId )
+                            refTrackId = dstTrackIds[j];
+                    }
+                    if( refTrackId == MP4_INVALID_TRACK_ID )
+                        throw new EXCEPTION("hint track selected without its reference track");
+                }
+
+                // MP4CloneTrack() rebuilds the sample descriptions it knows
+                // from their properties, anything else is copied as is
+                const char* type = srcTracks[i]->GetType();
+                const char* dataName = NULL;
+                MP4Atom* pStsdAtom = srcTracks[i]->GetTrakAtom().FindAtom( "trak.mdia.minf.stbl.stsd" );
+                if( pStsdAtom && pStsdAtom->GetNumberOfChildAtoms() == 1 )
+                    dataName = pStsdAtom->GetChildAtom( 0 )->GetType();
+
+                bool rebuild = isHint || MP4_IS_OD_TRACK_TYPE( type ) || MP4_IS_SCENE_TRACK_TYPE( type );
+                if( dataName && MP4_IS_VIDEO_TRACK_TYPE( type ))
+                    rebuild = ATOMID( dataName ) == ATOMID( "mp4v" ) || ATOMID( dataName ) == ATOMID( "avc1" );
+                else if( dataName && MP4_IS_AUDIO_TRACK_TYPE( type ))
+                    rebuild = ATOMID( dataName ) == ATOMID( "mp4a" );
+
+                if( rebuild )
+                    dstTrackIds[i] = MP4CloneTrack( &srcFile, srcTracks[i]->GetId(), this, refTrackId );
+                else
+                    dstTrackIds[i] = CloneTrackAtoms( srcFile, srcTracks[i]->GetId() );
+                if( dstTrackIds[i] == MP4_INVALID_TRACK_ID )
+                    throw new EXCEPTION("failed to clone track");
+            }
+        }
+
+        // keep chapter tracks attached to the copies of their tracks
+        for( uint32_t i = 0; i < numTracks; i++ ) {
+            MP4Integer32Property* pCountProperty = NULL;
+            MP4Integer32Property* pTrackIdProperty = NULL;
+            srcFile.GetTrackReferenceProperties( srcFile.MakeTrackName( srcTracks[i]->GetId(), "tref.chap" ),
+                                                 (MP4Property**)&pCountProperty,
+                                                 (MP4Property**)&pTrackIdProperty );
+            if( !pCountProperty || !pTrackIdProperty )
+                continue;
+
+            for( uint32_t k = 0; k < pCountProperty->GetValue(); k++ ) {
+                for( uint32_t j = 0; j < numTracks; j++ ) {
+                    if( srcTracks[j]->GetId() != pTrackIdProperty->GetValue( k ))
+                        continue;
+
+                    (void)AddDescendantAtoms( MakeTrackName( dstTrackIds[i], NULL ), "tref.chap" );
+                    AddTrackReference( MakeTrackName( dstTrackIds[i], "tref.chap" ), dstTrackIds[j] );
+                }
+            }
+        }
+
+        // build the complete sample tables, chunked by interleaveDuration
+        for( uint32_t i = 0; i < numTracks; i++ ) {
+            MP4Track* pSrcTrack = srcTracks[i];
+            MP4Track* pDstTrack = GetTrack( dstTrackIds[i] );
+            uint32_t timeScale = pSrcTrack->GetTimeScale();
+
+            MP4Duration chunkDuration = MP4ConvertTime( interleaveDuration, movieTimeScale, timeScale );
+            if( chunkDuration == 0 )
+                chunkDuration = 1;
+
+            MP4SampleId sampleId = firstSampleIds[i];
+            MP4SampleId endSampleId = sampleId + numSamples[i];
+
+            while( sampleId < endSampleId ) {
+                MP4Timestamp chunkStart;
+                MP4Duration sampleDuration;
+                pSrcTrack->GetSampleTimes( sampleId, &chunkStart, &sampleDuration );
+
+                MP4Timestamp when = chunkStart + sampleDuration;
+                uint32_t chunkSamples = 1;
+                while( sampleId + chunkSamples < endSampleId && when < chunkStart + chunkDuration ) {
+                    pSrcTrack->GetSampleTimes( sampleId + chunkSamples, NULL, &sampleDuration );
+                    when += sampleDuration;
+                    chunkSamples++;
+                }
+
+                pDstTrack->AddRemuxChunk( *pSrcTrack, sampleId, chunkSamples );
+                sampleId += chunkSamples;
+            }
+
+            // skip the lead-in from the preceding sync sample
+            MP4Timestamp trackStart = MP4ConvertTime( startTime, movieTimeScale, timeScale );
+            if( numSamples[i] && trackStart > firstSampleTimes[i] ) {
+                MP4Duration mediaStart = trackStart - firstSampleTimes[i];
+                MP4Duration editDuration = pDstTrack->GetDuration() - mediaStart;
+                if( duration != MP4_INVALID_DURATION )
+                    editDuration = min( editDuration, MP4ConvertTime( duration, movieTimeScale, timeScale ));
+
+                MP4AddTrackEdit( this, dstTrackIds[i], MP4_INVALID_EDIT_ID, mediaStart,
+                                 MP4ConvertTime( editDuration, timeScale, movieTimeScale ));
+            }
+
+            order.AddTrack( *pDstTrack, firstSampleTimes[i] );
+        }
+
+        FinishMoov( 0 );
+
+        // moov now has its final size, so it can go ahead of the media
+        ((MP4RootAtom*)m_pRootAtom)->BeginOptimalWrite();
+
+        // copy chunks in time order, as RewriteMdat() does
+        uint32_t trackIndex;
+        MP4ChunkId chunkId;
+        while( order.Next( trackIndex, chunkId ))
+            GetTrack( dstTrackIds[trackIndex] )->WriteRemuxChunk(
+                chunkId, *srcTracks[trackIndex], firstSampleIds[trackIndex] );
+
+        ((MP4RootAtom*)m_pRootAtom)->FinishOptimalWrite();
+
+        if( m_file->flush() )
+            throw new PLATFORM_EXCEPTION("write failed", sys::getLastError());
+    }
+    catch (...) {
+        delete m_file;
+        m_file = NULL;
+        throw;
+    }
+
+    delete m_file;
+    m_file = NULL;
+}
+
+// Creates a track with the header and sample descriptions of a track of
+// another file, copying the atoms MP4CloneTrack() has no specific code for.
+MP4TrackId MP4File::CloneTrackAtoms( MP4File& srcFile, MP4TrackId srcTrackId )
+{
+    MP4Track* pSrcTrack = srcFile.GetTrack( srcTrackId );
+    MP4TrackId trackId = AddTrack( pSrcTrack->GetType(), pSrcTrack->GetTimeScale() );
+
+    static const char* const integerProperties[] = {
+        "tkhd.flags", "tkhd.layer", "tkhd.alternate_group", NULL
+    };
+    for( const char* const* name = integerProperties; *name; name++ )
+        SetTrackIntegerProperty( trackId, *name, srcFile.GetTrackIntegerProperty( srcTrackId, *name ));
+
+    static const char* const floatProperties[] = {
+        "tkhd.volume", "tkhd.width", "tkhd.height", NULL
+    };
+    for( const char* const* name = floatProperties; *name; name++ )
+        SetTrackFloatProperty( trackId, *name, srcFile.GetTrackFloatProperty( srcTrackId, *name ));
+
+    uint8_t* pMatrix = NULL;
+    uint32_t matrixSize = 0;
+    srcFile.GetTrackBytesProperty( srcTrackId, "tkhd.matrix", &pMatrix, &matrixSize );
+    SetTrackBytesProperty( trackId, "tkhd.matrix", pMatrix, matrixSize );
+    MP4Free( pMatrix );
+
+    char language[4];
+    if( srcFile.GetTrackLanguage( srcTrackId, language ))
+        SetTrackLanguage( trackId, language );
+
+    MP4StringProperty* pNameProperty = NULL;
+    if( pSrcTrack->GetTrakAtom().FindProperty( "trak.mdia.hdlr.name", (MP4Property**)&pNameProperty ) && pNameProperty )
+        SetTrackStringProperty( trackId, "mdia.hdlr.name", pNameProperty->GetValue() );
+
+    // media header (vmhd, smhd, gmhd, ...) ahead of dinf and stbl
+    MP4Atom* pSrcMinf = pSrcTrack->GetTrakAtom().FindAtom( "trak.mdia.minf" );
+    MP4Atom* pMinf = FindTrackAtom( trackId, "mdia.minf" );
+    ASSERT( pSrcMinf && pMinf );
+
+    uint32_t index = 0;
+    for( uint32_t i = 0; i < pSrcMinf->GetNumberOfChildAtoms(); i++ ) {
+        MP4Atom* pChild = pSrcMinf->GetChildAtom( i );
+        if( ATOMID( pChild->GetType() ) == ATOMID( "dinf" ) ||
+                ATOMID( pChild->GetType() ) == ATOMID( "stbl" ) ||
+                pMinf->FindChildAtom( pChild->GetType() ))
+            continue;
+
+        CopyAtom( srcFile, *pChild, *pMinf, index++ );
+    }
+
+    MP4Atom* pSrcStsd = pSrcTrack->GetTrakAtom().FindAtom( "trak.mdia.minf.stbl.stsd" );
+    MP4Atom* pStsd = FindTrackAtom( trackId, "mdia.minf.stbl.stsd" );
+    ASSERT( pSrcStsd && pStsd );
+
+    MP4Integer32Property* pStsdCountProperty;
+    FindIntegerProperty( MakeTrackName( trackId, "mdia.minf.stbl.stsd.entryCount" ),
+                         (MP4Property**)&pStsdCountProperty );
+
+    for( uint32_t i = 0; i < pSrcStsd->GetNumberOfChildAtoms(); i++ ) {
+        CopyAtom( srcFile, *pSrcStsd->GetChildAtom( i ), *pStsd, pStsd->GetNumberOfChildAtoms() );
+        pStsdCountProperty->IncrementValue();
+    }
+
+    return trackId;
+}
+
+// Inserts a copy of an atom of another file, parsed from its bytes on disk
+// rather than from its in-memory state, under parentAtom at index.
+void MP4File::CopyAtom( MP4File& srcFile, MP4Atom& srcAtom, MP4Atom& parentAtom, uint32_t index )
+{
+    uint64_t size = srcAtom.GetEnd() - srcAtom.GetStart();
+    if( size > 0xFFFFFFFF )
+        throw new EXCEPTION("atom too large to copy");
+
+    vector<uint8_t> bytes( (size_t)size );
+    srcFile.ReadBytesAt( srcAtom.GetStart(), &bytes[0], (uint32_t)size );
 
-        chunkIds[nextTrackIndex]++;
-        nextChunkTimes[nextTrackIndex] = MP4_INVALID_TIMESTAMP;
+    // ReadAtom() bounds the atom by the end of its parent
+    uint64_t parentEnd = parentAtom.GetEnd();
+    parentAtom.SetEnd( size );
+    EnableMemoryBuffer( &bytes[0], size );
+
+    MP4Atom* pAtom;
+    try {
+        pAtom = MP4Atom::ReadAtom( *this, &parentAtom );
     }
+    catch (...) {
+        DisableMemoryBuffer();
+        parentAtom.SetEnd( parentEnd );
+        throw;
+    }
+
+    DisableMemoryBuffer();
+    parentAtom.SetEnd( parentEnd );
 
-    delete [] chunkIds;
-    delete [] maxChunkIds;
-    delete [] nextChunkTimes;
+    parentAtom.InsertChildAtom( pAtom, index );
 }
 
+
 void MP4File::Open( const char*            fileName,
                     File::Mode             mode,
                     const MP4FileProvider* fileProvider,
@@ -426,6 +819,9 @@ void MP4File::Open( const char*            fileName,
         throw new EXCEPTION(msg.str());
     }
 
+    if( mode != File::MODE_READ && m_file->setBufferSize( m_writeBufferSize ))
+        throw new PLATFORM_EXCEPTION("failed to set write buffer size", sys::getLastError());
+
     switch( mode ) {
         case File::MODE_READ:
         case File::MODE_MODIFY:
@@ -541,7 +937,7 @@ void MP4File::BeginWrite()
     m_pRootAtom->BeginWrite();
 }
 
-void MP4File::FinishWrite(uint32_t options)
+void MP4File::FinishMoov(uint32_t options)
 {
     // remove empty moov.udta.meta.ilst
     if( MP4Atom* ilst = FindAtom( "moov.udta.meta.ilst" ) ) {
@@ -589,6 +985,11 @@ void MP4File::FinishWrite(uint32_t options)
         ASSERT( m_pTracks[i] );
         m_pTracks[i]->FinishWrite(options);
     }
+}
+
+void MP4File::FinishWrite(uint32_t options)
+{
+    FinishMoov(options);
 
     // ask root atom to write
     m_pRootAtom->FinishWrite();
@@ -623,6 +1024,10 @@ void MP4File::FinishWrite(uint32_t options)
         // inserting the free atom afterwards
         m_file->truncate(endPosition);
     }
+
+    // push out buffered writes while errors can still be reported
+    if( m_file->flush() )
+        throw new PLATFORM_EXCEPTION("write failed", sys::getLastError());
 }
 
 void MP4File::MoveMoovAtomToFront()
@@ -655,24 +1060,31 @@ void MP4File::MoveMoovAtomToFront()
             m_pRootAtom->InsertChildAtom(moov, i);
 
             delete atom;
-
-            m_file->seek(freeStart);
-
-            moov->Write();
+            atom = NULL;
         }
         else if (freeSize >= moovSize + 8) {
             m_pRootAtom->DeleteChildAtom(moov);
             m_pRootAtom->InsertChildAtom(moov, i);
 
             atom->SetSize(freeSize - moovSize - 8);
+        }
+        else
+            continue;
 
-            m_file->seek(freeStart);
+        // moov and the remaining free space go out in a single write
+        m_file->seek(freeStart);
 
+        BeginBufferedWrite();
+        try {
             moov->Write();
-            atom->Write();
+            if (atom)
+                atom->Write();
         }
-        else
-            continue;
+        catch (Exception*) {
+            AbortBufferedWrite();
+            throw;
+        }
+        FinishBufferedWrite();
 
         // position file pointer after last mdat atom
         numAtoms = m_pRootAtom->GetNumberOfChildAtoms();
@@ -705,6 +1117,56 @@ void MP4File::Dump( bool dumpImplicits )
     m_pRootAtom->Dump( 0, dumpImplicits);
 }
 
+static int
+WriteJsonToFile( void* handle, const char* text, uint32_t size )
+{
+    File::Size nout;
+    return static_cast<File*>(handle)->write( text, size, nout ) ? -1 : 0;
+}
+
+static int
+WriteJsonToStream( void* handle, const char* text, uint32_t size )
+{
+    return ::fwrite( text, 1, size, static_cast<FILE*>(handle) ) == size ? 0 : -1;
+}
+
+void MP4File::DumpJson( const char* fileName, uint32_t flags, uint32_t tableEntries )
+{
+    if( !fileName ) {
+        DumpJson( WriteJsonToStream, stdout, flags, tableEntries );
+        return;
+    }
+
+    File out( fileName, File::MODE_CREATE );
+    if( out.open() )
+        throw new PLATFORM_EXCEPTION("open failed", sys::getLastError());
+
+    DumpJson( WriteJsonToFile, &out, flags, tableEntries );
+}
+
+void MP4File::DumpJson( MP4DumpJsonWriteFunc write, void* handle, uint32_t flags, uint32_t tableEntries )
+{
+    MP4JsonWriter json( write, handle,
+                        (flags & MP4_DUMP_JSON_FULL) != 0,
+                        tableEntries,
+                        (flags & MP4_DUMP_JSON_IMPLICITS) != 0 );
+
+    json.BeginObject();
+    json.Key( "file" );
+    json.String( m_file->name.c_str() );
+    json.Key( "size" );
+    json.Integer( GetSize() );
+    json.Key( "atoms" );
+    json.BeginArray();
+    const uint32_t size = m_pRootAtom->GetNumberOfChildAtoms();
+    for( uint32_t i = 0; i < size; i++ )
+        m_pRootAtom->GetChildAtom( i )->DumpJson( json );
+    json.EndArray();
+    json.EndObject();
+
+    json.Flush();
+}
+
 void MP4File::Close(uint32_t options)
 {
     if( IsWriteMode() ) {
@@ -712,10 +1174,55 @@ void MP4File::Close(uint32_t options)
         FinishWrite(options);
     }
 
+    CloseExternalFiles();
+
     delete m_file;
     m_file = NULL;
 }
 
+uint32_t MP4File::GetMaxExternalFiles()
+{
+    lock_guard<recursive_mutex> lock( m_sampleLock );
+    return m_maxExternalFiles;
+}
+
+void MP4File::SetMaxExternalFiles( uint32_t max )
+{
+    lock_guard<recursive_mutex> lock( m_sampleLock );
+    if( max == 0 )
+        throw new EXCEPTION("at least one external file must be allowed");
+
+    m_maxExternalFiles = max;
+
+    // trim now rather than on the next open
+    while( m_externalFiles.size() > m_maxExternalFiles ) {
+        delete m_externalFiles.back().file;
+        m_externalFiles.pop_back();
+    }
+}
+
+void MP4File::SetWriteBufferSize( uint32_t size )
+{
+    m_writeBufferSize = size;
+
+    if( m_file && IsWriteMode() && m_file->setBufferSize( size ))
+        throw new PLATFORM_EXCEPTION("write failed", sys::getLastError());
+}
+
+void MP4File::Flush()
+{
+    if( !m_file || !IsWriteMode() )
+        throw new EXCEPTION("file not open for writing");
+
+    // sample data waiting in the track chunk buffers goes out first; this
+    // ends the open chunk of each track, see MP4Flush()
+    for( uint32_t i = 0; i < m_pTracks.Size(); i++ )
+        m_pTracks[i]->WriteChunkBuffer();
+
+    if( m_file->flush() )
+        throw new PLATFORM_EXCEPTION("write failed", sys::getLastError());
+}
+
 void MP4File::Rename(const char* oldFileName, const char* newFileName)
 {
     if( FileSystem::rename( oldFileName, newFileName ))
@@ -865,6 +1372,18 @@ void MP4File::SetIntegerProperty(const char* name, uint64_t value)
     FindIntegerProperty(name, &pProperty, &index);
 
     ((MP4IntegerProperty*)pProperty)->SetValue(value, index);
+
+    // tracks keep running totals of their edit and sample durations
+    uint32_t atomId = ATOMID(pProperty->GetParentAtom().GetType());
+    if (atomId == ATOMID("elst")) {
+        for (uint32_t i = 0; i < m_pTracks.Size(); i++) {
+            m_pTracks[i]->InvalidateEditIndex();
+        }
+    } else if (atomId == ATOMID("stts")) {
+        for (uint32_t i = 0; i < m_pTracks.Size(); i++) {
+            m_pTracks[i]->InvalidateSttsIndex();
+        }
+    }
 }
 
 void MP4File::FindFloatProperty(const char* name,
@@ -1241,6 +1760,11 @@ void MP4File::AddDataReference(MP4TrackId trackId, const char* url)
     } else {
         pUrlAtom->SetFlags(pUrlAtom->GetFlags() | 1);
     }
+
+    // resolved again on the next read
+    if (MP4Track* pTrack = LookupTrack(trackId)) {
+        pTrack->InvalidateSampleFileRefs();
+    }
 }
 
 MP4TrackId MP4File::AddSystemsTrack(const char* type, uint32_t timeScale)
@@ -2622,11 +3146,6 @@ MP4ChapterType MP4File::GetChapters(MP4Chapter_t ** chapterList, uint32_t * chap
 
     if (MP4ChapterTypeAny == fromChapterType || MP4ChapterTypeQt == fromChapterType)
     {
-        uint8_t * sample = 0;
-        uint32_t sampleSize = 0;
-        MP4Timestamp startTime = 0;
-        MP4Duration duration = 0;
-
         // get the chapter track
         MP4TrackId chapterTrackId = FindChapterTrack();
         if (MP4_INVALID_TRACK_ID == chapterTrackId)
@@ -2647,28 +3166,28 @@ MP4ChapterType MP4File::GetChapters(MP4Chapter_t ** chapterList, uint32_t * chap
                 uint32_t timescale = pChapterTrack->GetTimeScale();
                 MP4Chapter_t * chapters = (MP4Chapter_t*)MP4Malloc(sizeof(MP4Chapter_t) * counter);
 
-                // process all chapter sample
-                for (uint32_t i = 0; i < counter; ++i)
-                {
-                    // get the sample corresponding to the starttime
-                    MP4SampleId sampleId = pChapterTrack->GetSampleIdFromTime(startTime + duration, true);
-                    pChapterTrack->ReadSample(sampleId, &sample, &sampleSize);
-
-                    // get the starttime and duration
-                    pChapterTrack->GetSampleTimes(sampleId, &startTime, &duration);
-
-                    // we know that sample+2 contains the title (sample[0] and sample[1] is the length)
-                    const char * title = (const char *)&(sample[2]);
-                    int titleLen = min((uint32_t)((sample[0] << 8) | sample[1]), (uint32_t)MP4V2_CHAPTER_TITLE_MAX);
-                    strncpy(chapters[i].title, title, titleLen);
-                    chapters[i].title[titleLen] = 0;
-
-                    // write the duration (in milliseconds)
-                    chapters[i].duration = MP4ConvertTime(duration, timescale, MP4_MILLISECONDS_TIME_SCALE);
-
-                    // we're done with this sample
-                    MP4Free(sample);
-                    sample = 0;
+                // every sample is a chapter
+                string titles;
+                vector<uint32_t> titleOffsets;
+                vector<uint32_t> titleLengths;
+                try {
+                    pChapterTrack->ReadTextSamples(titles, titleOffsets, titleLengths);
+
+                    for (uint32_t i = 0; i < counter; ++i)
+                    {
+                        uint32_t titleLen = min(titleLengths[i], (uint32_t)MP4V2_CHAPTER_TITLE_MAX);
+                        strncpy(chapters[i].title, &titles[titleOffsets[i]], titleLen);
+                        chapters[i].title[titleLen] = 0;
+
+                        // write the duration (in milliseconds)
+                        MP4Duration duration = 0;
+                        pChapterTrack->GetSampleTimes(i + 1, NULL, &duration);
+                        chapters[i].duration = MP4ConvertTime(duration, timescale, MP4_MILLISECONDS_TIME_SCALE);
+                    }
+                }
+                catch (Exception*) {
+                    MP4Free(chapters);
+                    throw;
                 }
 
                 *chapterList = chapters;
@@ -3042,6 +3561,16 @@ uint16_t MP4File::FindTrackIndex(MP4TrackId trackId)
     throw new EXCEPTION(msg.str());
 }
 
+MP4Track* MP4File::LookupTrack(MP4TrackId trackId)
+{
+    for (uint32_t i = 0; i < m_pTracks.Size(); i++) {
+        if (m_pTracks[i]->GetId() == trackId) {
+            return m_pTracks[i];
+        }
+    }
+    return NULL;
+}
+
 uint16_t MP4File::FindTrakAtomIndex(MP4TrackId trackId)
 {
     if (trackId) {
@@ -3059,24 +3588,48 @@ uint16_t MP4File::FindTrakAtomIndex(MP4TrackId trackId)
 
 uint32_t MP4File::GetSampleSize(MP4TrackId trackId, MP4SampleId sampleId)
 {
+    lock_guard<recursive_mutex> lock( m_sampleLock );
     return m_pTracks[FindTrackIndex(trackId)]->GetSampleSize(sampleId);
 }
 
 uint32_t MP4File::GetTrackMaxSampleSize(MP4TrackId trackId)
 {
+    lock_guard<recursive_mutex> lock( m_sampleLock );
     return m_pTracks[FindTrackIndex(trackId)]->GetMaxSampleSize();
 }
 
 MP4SampleId MP4File::GetSampleIdFromTime(MP4TrackId trackId,
         MP4Timestamp when, bool wantSyncSample)
 {
+    lock_guard<recursive_mutex> lock( m_sampleLock );
     return m_pTracks[FindTrackIndex(trackId)]->
            GetSampleIdFromTime(when, wantSyncSample);
 }
 
+MP4Error MP4File::TryGetSampleIdFromTime(MP4TrackId trackId,
+        MP4Timestamp when, bool wantSyncSample, MP4SampleId& sampleId)
+{
+    lock_guard<recursive_mutex> lock( m_sampleLock );
+    MP4Track* pTrack = LookupTrack(trackId);
+    if (pTrack == NULL) {
+        return MP4_ERROR_INVALID_TRACK;
+    }
+    return pTrack->TryGetSampleIdFromTime(when, wantSyncSample, sampleId);
+}
+
+MP4Error MP4File::CheckSampleId(MP4TrackId trackId, MP4SampleId sampleId)
+{
+    MP4Track* pTrack = LookupTrack(trackId);
+    if (pTrack == NULL) {
+        return MP4_ERROR_INVALID_TRACK;
+    }
+    return pTrack->CheckSampleId(sampleId);
+}
+
 MP4Timestamp MP4File::GetSampleTime(
     MP4TrackId trackId, MP4SampleId sampleId)
 {
+    lock_guard<recursive_mutex> lock( m_sampleLock );
     MP4Timestamp timestamp;
     m_pTracks[FindTrackIndex(trackId)]->
     GetSampleTimes(sampleId, &timestamp, NULL);
@@ -3086,6 +3639,7 @@ MP4Timestamp MP4File::GetSampleTime(
 MP4Duration MP4File::GetSampleDuration(
     MP4TrackId trackId, MP4SampleId sampleId)
 {
+    lock_guard<recursive_mutex> lock( m_sampleLock );
     MP4Duration duration;
     m_pTracks[FindTrackIndex(trackId)]->
     GetSampleTimes(sampleId, NULL, &duration);
@@ -3095,12 +3649,14 @@ MP4Duration MP4File::GetSampleDuration(
 MP4Duration MP4File::GetSampleRenderingOffset(
     MP4TrackId trackId, MP4SampleId sampleId)
 {
+    lock_guard<recursive_mutex> lock( m_sampleLock );
     return m_pTracks[FindTrackIndex(trackId)]->
            GetSampleRenderingOffset(sampleId);
 }
 
 bool MP4File::GetSampleSync(MP4TrackId trackId, MP4SampleId sampleId)
 {
+    lock_guard<recursive_mutex> lock( m_sampleLock );
     return m_pTracks[FindTrackIndex(trackId)]->IsSyncSample(sampleId);
 }
 
@@ -3116,6 +3672,7 @@ void MP4File::ReadSample(
     bool*         hasDependencyFlags,
     uint32_t*     dependencyFlags )
 {
+    // the track takes m_sampleLock itself, for the table lookups only
     m_pTracks[FindTrackIndex(trackId)]->ReadSample(
         sampleId,
         ppBytes,
@@ -3128,6 +3685,31 @@ void MP4File::ReadSample(
         dependencyFlags );
 }
 
+MP4Error MP4File::TryReadSample(
+    MP4TrackId    trackId,
+    MP4SampleId   sampleId,
+    uint8_t**     ppBytes,
+    uint32_t*     pNumBytes,
+    MP4Timestamp* pStartTime,
+    MP4Duration*  pDuration,
+    MP4Duration*  pRenderingOffset,
+    bool*         pIsSyncSample )
+{
+    // the track takes m_sampleLock itself, for the table lookups only
+    MP4Track* pTrack = LookupTrack(trackId);
+    if (pTrack == NULL) {
+        return MP4_ERROR_INVALID_TRACK;
+    }
+    return pTrack->TryReadSample(
+        sampleId,
+        ppBytes,
+        pNumBytes,
+        pStartTime,
+        pDuration,
+        pRenderingOffset,
+        pIsSyncSample );
+}
+
 void MP4File::WriteSample(
     MP4TrackId     trackId,
     const uint8_t* pBytes,
@@ -3157,6 +3739,173 @@ void MP4File::WriteSampleDependency(
     m_pModificationProperty->SetValue( MP4GetAbsTimestamp() );
 }
 
+// Text and subtitle samples hold a 16-bit big endian text length followed
+// by the UTF-8 text and possibly modifier boxes, which are ignored here.
+static MP4Track* CheckTextTrack(MP4Track* pTrack)
+{
+    const char* type = pTrack->GetType();
+    if (!strequal(type, MP4_TEXT_TRACK_TYPE) && !strequal(type, MP4_SUBTITLE_TRACK_TYPE)) {
+        throw new EXCEPTION("track is not a text or subtitle track");
+    }
+    return pTrack;
+}
+
+void MP4File::WriteTextCues(
+    MP4TrackId        trackId,
+    const MP4TextCue* cues,
+    uint32_t          numCues )
+{
+    PROTECT_WRITE_OPERATION();
+    MP4Track* pTrack = CheckTextTrack(m_pTracks[FindTrackIndex(trackId)]);
+
+    if (numCues == 0) {
+        return;
+    }
+    if (cues == NULL) {
+        throw new EXCEPTION("no cues");
+    }
+
+    // one sample per cue, and an empty sample for each gap between cues
+    // so that every cue starts on time
+    vector<uint8_t> data;
+    vector<uint32_t> sizes;
+    vector<MP4Duration> durations;
+    sizes.reserve(numCues * 2);
+    durations.reserve(numCues * 2);
+
+    MP4Timestamp end = pTrack->GetDuration();
+
+    for (uint32_t i = 0; i < numCues; i++) {
+        const MP4TextCue& cue = cues[i];
+
+        if (cue.start < end) {
+            ostringstream msg;
+            msg << "text cue " << i << " starts before the end of the track or previous cue";
+            throw new EXCEPTION(msg.str().c_str());
+        }
+        size_t length = cue.text ? strlen(cue.text) : 0;
+        if (length > 0xFFFF) {
+            ostringstream msg;
+            msg << "text of cue " << i << " is too long";
+            throw new EXCEPTION(msg.str().c_str());
+        }
+
+        if (cue.start > end) {
+            data.push_back(0);
+            data.push_back(0);
+            sizes.push_back(2);
+            durations.push_back(cue.start - end);
+        }
+
+        data.push_back((uint8_t)(length >> 8));
+        data.push_back((uint8_t)length);
+        data.insert(data.end(), cue.text, cue.text + length);
+        sizes.push_back(2 + (uint32_t)length);
+        durations.push_back(cue.duration);
+
+        end = cue.start + cue.duration;
+    }
+
+    pTrack->WriteSamples(&data[0], (uint32_t)sizes.size(), &sizes[0], &durations[0]);
+    m_pModificationProperty->SetValue( MP4GetAbsTimestamp() );
+}
+
+void MP4File::ReadTextCues(
+    MP4TrackId   trackId,
+    MP4TextCue** ppCues,
+    uint32_t*    pNumCues )
+{
+    lock_guard<recursive_mutex> lock( m_sampleLock );
+    MP4Track* pTrack = CheckTextTrack(m_pTracks[FindTrackIndex(trackId)]);
+
+    *ppCues = NULL;
+    *pNumCues = 0;
+
+    // the texts are copied behind the cue array so that the caller frees
+    // a single block
+    string texts;
+    vector<uint32_t> textOffsets;
+    vector<uint32_t> textLengths;
+    pTrack->ReadTextSamples(texts, textOffsets, textLengths);
+
+    // empty samples fill the gaps between cues
+    uint32_t numSamples = (uint32_t)textLengths.size();
+    uint32_t numCues = 0;
+    for (uint32_t i = 0; i < numSamples; i++) {
+        if (textLengths[i]) {
+            numCues++;
+        }
+    }
+    if (numCues == 0) {
+        return;
+    }
+
+    MP4TextCue* cues = (MP4TextCue*)MP4Malloc(numCues * sizeof(MP4TextCue) + texts.size());
+    char* text = (char*)&cues[numCues];
+    memcpy(text, texts.data(), texts.size());
+
+    try {
+        MP4TextCue* cue = cues;
+        for (uint32_t i = 0; i < numSamples; i++) {
+            if (textLengths[i]) {
+                cue->text = &text[textOffsets[i]];
+                pTrack->GetSampleTimes(i + 1, &cue->start, &cue->duration);
+                cue++;
+            }
+        }
+    }
+    catch (Exception*) {
+        MP4Free(cues);
+        throw;
+    }
+
+    *ppCues = cues;
+    *pNumCues = numCues;
+}
+
+void MP4File::GetDecodableSamples(
+    MP4TrackId           trackId,
+    MP4Timestamp         startTime,
+    MP4Duration          duration,
+    MP4DecodableSample** ppSamples,
+    uint32_t*            pNumSamples )
+{
+    lock_guard<recursive_mutex> lock( m_sampleLock );
+
+    vector<MP4DecodableSample> samples;
+    m_pTracks[FindTrackIndex(trackId)]->
+    GetDecodableSamples(startTime, duration, samples);
+
+    *ppSamples = NULL;
+    *pNumSamples = (uint32_t)samples.size();
+    if (samples.empty()) {
+        return;
+    }
+
+    *ppSamples = (MP4DecodableSample*)MP4Malloc(samples.size() * sizeof(MP4DecodableSample));
+    memcpy(*ppSamples, &samples[0], samples.size() * sizeof(MP4DecodableSample));
+}
+
+void MP4File::GetSyncSampleIndex(
+    MP4TrackId           trackId,
+    MP4DecodableSample** ppSamples,
+    uint32_t*            pNumSamples )
+{
+    lock_guard<recursive_mutex> lock( m_sampleLock );
+
+    vector<MP4DecodableSample> samples;
+    m_pTracks[FindTrackIndex(trackId)]->GetSyncSampleIndex(samples);
+
+    *ppSamples = NULL;
+    *pNumSamples = (uint32_t)samples.size();
+    if (samples.empty()) {
+        return;
+    }
+
+    *ppSamples = (MP4DecodableSample*)MP4Malloc(samples.size() * sizeof(MP4DecodableSample));
+    memcpy(*ppSamples, &samples[0], samples.size() * sizeof(MP4DecodableSample));
+}
+
 void MP4File::SetSampleRenderingOffset(MP4TrackId trackId,
                                        MP4SampleId sampleId, MP4Duration renderingOffset)
 {
@@ -3218,6 +3967,11 @@ void MP4File::SetTrackIntegerProperty(MP4TrackId trackId, const char* name,
                                       int64_t value)
 {
     SetIntegerProperty(MakeTrackName(trackId, name), value);
+
+    // url flags and sample entry indexes decide where samples are read from
+    if (strstr(name, "dinf.dref") || strstr(name, "dataReferenceIndex")) {
+        GetTrack(trackId)->InvalidateSampleFileRefs();
+    }
 }
 
 float MP4File::GetTrackFloatProperty(MP4TrackId trackId, const char* name)
@@ -3246,6 +4000,10 @@ void MP4File::SetTrackStringProperty(MP4TrackId trackId, const char* name,
                                      const char* value)
 {
     SetStringProperty(MakeTrackName(trackId, name), value);
+
+    if (strstr(name, "dinf.dref")) {
+        GetTrack(trackId)->InvalidateSampleFileRefs();
+    }
 }
 
 void MP4File::GetTrackBytesProperty(MP4TrackId trackId, const char* name,
@@ -3895,6 +4653,123 @@ void MP4File::SetHintTrackRtpPayload(MP4TrackId hintTrackId,
         include_rtp_map, include_mpeg4_esid);
 }
 
+MP4TrackId MP4File::HintTrack(MP4TrackId mediaTrackId, uint16_t maxPayloadSize)
+{
+    const char* mediaName = GetTrackMediaDataName(mediaTrackId);
+    bool isH264 = mediaName && !strcasecmp(mediaName, "avc1");
+    bool isAac = mediaName && !strcasecmp(mediaName, "mp4a") &&
+                 MP4_IS_AAC_AUDIO_TYPE(GetTrackEsdsObjectTypeId(mediaTrackId));
+
+    if (!isH264 && !isAac) {
+        throw new EXCEPTION("track media type can't be hinted");
+    }
+    if (maxPayloadSize == 0) {
+        maxPayloadSize = 1460;
+    }
+
+    MP4TrackId hintTrackId = AddHintTrack(mediaTrackId);
+
+    try {
+        MP4RtpHintTrack* pHintTrack =
+            (MP4RtpHintTrack*)m_pTracks[FindTrackIndex(hintTrackId)];
+        uint8_t payloadNumber = MP4_SET_DYNAMIC_PAYLOAD;
+        char fmtp[128];
+
+        if (isH264) {
+            uint32_t lengthSize = 1 + (uint32_t)GetTrackIntegerProperty(mediaTrackId,
+                                  "mdia.minf.stbl.stsd.*[0].avcC.lengthSizeMinusOne");
+
+            // the RTP clock for video is 90 kHz whatever the media timescale
+            SetTrackTimeScale(hintTrackId, 90000);
+            SetTrackIntegerProperty(hintTrackId,
+                                    "mdia.minf.stbl.stsd.rtp .tims.timeScale", 90000);
+            SetHintTrackRtpPayload(hintTrackId, "H264", &payloadNumber,
+                                   maxPayloadSize, NULL, true, false);
+
+            uint8_t** ppSeqHeaders;
+            uint32_t* pSeqHeaderSizes;
+            uint8_t** ppPictHeaders;
+            uint32_t* pPictHeaderSizes;
+            GetTrackH264SeqPictHeaders(mediaTrackId,
+                                       &ppSeqHeaders, &pSeqHeaderSizes,
+                                       &ppPictHeaders, &pPictHeaderSizes);
+
+            string sprop;
+            char profileLevelId[8] = "";
+            for (uint32_t i = 0; ppSeqHeaders && pSeqHeaderSizes[i]; i++) {
+                if (i == 0 && pSeqHeaderSizes[i] >= 4) {
+                    snprintf(profileLevelId, sizeof(profileLevelId), "%02x%02x%02x",
+                             ppSeqHeaders[i][1], ppSeqHeaders[i][2], ppSeqHeaders[i][3]);
+                }
+                char* b64 = MP4ToBase64(ppSeqHeaders[i], pSeqHeaderSizes[i]);
+                sprop += sprop.empty() ? "" : ",";
+                sprop += b64;
+                MP4Free(b64);
+            }
+            for (uint32_t i = 0; ppPictHeaders && pPictHeaderSizes[i]; i++) {
+                char* b64 = MP4ToBase64(ppPictHeaders[i], pPictHeaderSizes[i]);
+                sprop += sprop.empty() ? "" : ",";
+                sprop += b64;
+                MP4Free(b64);
+            }
+            if (ppSeqHeaders && ppPictHeaders) {
+                MP4FreeH264SeqPictHeaders(ppSeqHeaders, pSeqHeaderSizes,
+                                          ppPictHeaders, pPictHeaderSizes);
+            }
+
+            snprintf(fmtp, sizeof(fmtp), "a=fmtp:%u packetization-mode=1",
+                     payloadNumber);
+            string sdp = fmtp;
+            if (profileLevelId[0]) {
+                sdp += "; profile-level-id=";
+                sdp += profileLevelId;
+            }
+            if (!sprop.empty()) {
+                sdp += "; sprop-parameter-sets=";
+                sdp += sprop;
+            }
+            sdp += "\015\012";
+            AppendHintTrackSdp(hintTrackId, sdp.c_str());
+
+            pHintTrack->HintH264(maxPayloadSize, lengthSize);
+        } else {
+            char channels[16];
+            snprintf(channels, sizeof(channels), "%d",
+                     GetTrackAudioChannels(mediaTrackId));
+            SetHintTrackRtpPayload(hintTrackId, "mpeg4-generic", &payloadNumber,
+                                   maxPayloadSize, channels, true, false);
+
+            uint8_t* pConfig = NULL;
+            uint32_t configSize = 0;
+            GetTrackESConfiguration(mediaTrackId, &pConfig, &configSize);
+
+            string config;
+            for (uint32_t i = 0; i < configSize; i++) {
+                char hex[3];
+                snprintf(hex, sizeof(hex), "%02x", pConfig[i]);
+                config += hex;
+            }
+            MP4Free(pConfig);
+
+            snprintf(fmtp, sizeof(fmtp),
+                     "a=fmtp:%u streamtype=5; profile-level-id=15; mode=AAC-hbr; config=",
+                     payloadNumber);
+            string sdp = fmtp;
+            sdp += config;
+            sdp += "; SizeLength=13; IndexLength=3; IndexDeltaLength=3\015\012";
+            AppendHintTrackSdp(hintTrackId, sdp.c_str());
+
+            pHintTrack->HintAac(maxPayloadSize);
+        }
+    }
+    catch (Exception*) {
+        DeleteTrack(hintTrackId);
+        throw;
+    }
+
+    return hintTrackId;
+}
+
 uint8_t MP4File::AllocRtpPayloadNumber()
 {
     MP4Integer32Array usedPayloads;
@@ -4017,6 +4892,23 @@ void MP4File::ReadRtpPacket(
         ssrc, includeHeader, includePayload);
 }
 
+MP4RtpSchedule* MP4File::CompileRtpSchedule(
+    MP4TrackId hintTrackId)
+{
+    MP4Track* pTrack = m_pTracks[FindTrackIndex(hintTrackId)];
+
+    if (!strequal(pTrack->GetType(), MP4_HINT_TRACK_TYPE)) {
+        throw new EXCEPTION("track is not a hint track");
+    }
+
+    // file offsets are only final once the file has been written
+    if (IsWriteMode()) {
+        throw new EXCEPTION("operation not permitted in write mode");
+    }
+
+    return ((MP4RtpHintTrack*)pTrack)->CompileSchedule();
+}
+
 MP4Timestamp MP4File::GetRtpTimestampStart(
     MP4TrackId hintTrackId)
 {
@@ -4230,6 +5122,7 @@ MP4Duration MP4File::GetTrackEditTotalDuration(
     MP4TrackId trackId,
     MP4EditId editId)
 {
+    lock_guard<recursive_mutex> lock( m_sampleLock );
     return m_pTracks[FindTrackIndex(trackId)]->GetEditTotalDuration(editId);
 }
 
@@ -4237,6 +5130,7 @@ MP4Timestamp MP4File::GetTrackEditStart(
     MP4TrackId trackId,
     MP4EditId editId)
 {
+    lock_guard<recursive_mutex> lock( m_sampleLock );
     return m_pTracks[FindTrackIndex(trackId)]->GetEditStart(editId);
 }
 
@@ -4300,10 +5194,19 @@ MP4SampleId MP4File::GetSampleIdFromEditTime(
     MP4Timestamp* pStartTime,
     MP4Duration* pDuration)
 {
+    lock_guard<recursive_mutex> lock( m_sampleLock );
     return m_pTracks[FindTrackIndex(trackId)]->GetSampleIdFromEditTime(
                when, pStartTime, pDuration);
 }
 
+bool MP4File::GetNextEditSample(
+    MP4TrackId trackId,
+    MP4EditSampleCursor& cursor)
+{
+    lock_guard<recursive_mutex> lock( m_sampleLock );
+    return m_pTracks[FindTrackIndex(trackId)]->GetNextEditSample(cursor);
+}
+
 MP4Duration MP4File::GetTrackDurationPerChunk( MP4TrackId trackId )
 {
     return m_pTracks[FindTrackIndex(trackId)]->GetDurationPerChunk();
@@ -4379,6 +5282,83 @@ void MP4File::CopySample(
     free( pBytes );
 }
 
+bool MP4File::CopyChunks(
+    MP4File*    srcFile,
+    MP4TrackId  srcTrackId,
+    MP4File*    dstFile,
+    MP4TrackId  dstTrackId )
+{
+    // returns false, with nothing written, if the track has to be copied
+    // sample by sample instead
+
+    if( !dstFile )
+        dstFile = srcFile;
+
+    if( !dstFile->IsWriteMode() )
+        throw new EXCEPTION("operation not permitted in read mode");
+
+    MP4Track* pSrcTrack = srcFile->GetTrack( srcTrackId );
+    MP4Track* pDstTrack = dstFile->GetTrack( dstTrackId );
+
+    if( pSrcTrack == pDstTrack || !pDstTrack->CanCopyChunksFrom( *pSrcTrack ))
+        return false;
+
+    pDstTrack->CopyChunksFrom( *pSrcTrack );
+
+    dstFile->m_pModificationProperty->SetValue( MP4GetAbsTimestamp() );
+    return true;
+}
+
+void MP4File::ReferenceSample(
+    MP4File*    srcFile,
+    MP4TrackId  srcTrackId,
+    MP4SampleId srcSampleId,
+    MP4File*    dstFile,
+    MP4TrackId  dstTrackId,
+    MP4Duration dstSampleDuration )
+{
+    // as with CopySample, compatibility of the tracks is up to the caller
+
+    if( !dstFile )
+        dstFile = srcFile;
+
+    if( dstTrackId == MP4_INVALID_TRACK_ID )
+        dstTrackId = srcTrackId;
+
+    if( !dstFile->IsWriteMode() )
+        throw new EXCEPTION("operation not permitted in read mode");
+
+    MP4Track* pSrcTrack = srcFile->GetTrack( srcTrackId );
+    MP4Track* pDstTrack = dstFile->GetTrack( dstTrackId );
+
+    if( pSrcTrack->CheckSampleId( srcSampleId ) != MP4_ERROR_NONE )
+        throw new EXCEPTION("sample id out of range");
+
+    if( !pSrcTrack->IsSampleInFile( srcSampleId ))
+        throw new EXCEPTION("source sample is itself located in a referenced file");
+
+    MP4Duration sampleDuration;
+    pSrcTrack->GetSampleTimes( srcSampleId, NULL, &sampleDuration );
+
+    if( dstSampleDuration != MP4_INVALID_DURATION )
+        sampleDuration = dstSampleDuration;
+
+    // within one file the data can simply be shared
+    string url;
+    if( dstFile != srcFile )
+        url = "file:" + srcFile->GetFilename();
+
+    pDstTrack->ReferenceSample(
+        url.empty() ? NULL : url.c_str(),
+        pSrcTrack->GetSampleFileOffset( srcSampleId ),
+        pSrcTrack->GetSampleSize( srcSampleId ),
+        sampleDuration,
+        pSrcTrack->GetSampleRenderingOffset( srcSampleId ),
+        pSrcTrack->IsSyncSample( srcSampleId ));
+
+    dstFile->m_pModificationProperty->SetValue( MP4GetAbsTimestamp() );
+}
+
 void MP4File::EncAndCopySample(
     MP4File*      srcFile,
     MP4TrackId    srcTrackId,
@@ -4436,8 +5416,8 @@ void MP4File::EncAndCopySample(
     if( hasDependencyFlags ) {
         dstFile->WriteSampleDependency(
             dstTrackId,
-            pBytes,
-            numBytes,
+            encSampleData,
+            encSampleLength,
             sampleDuration,
             renderingOffset,
             isSyncSample,
@@ -4459,6 +5439,226 @@ void MP4File::EncAndCopySample(
         free( encSampleData );
 }
 
+// The track encryption below keeps all file I/O on the calling thread, as
+// MP4File isn't thread-safe, and runs only the encryption callback on the
+// worker threads. Samples are read ahead into a window, encrypted in any
+// order and written back in sample order as soon as the oldest is done.
+
+struct EncSampleJob {
+    MP4SampleId sampleId;
+    uint8_t*    pBytes;
+    uint32_t    numBytes;
+    MP4Duration duration;
+    MP4Duration renderingOffset;
+    bool        isSyncSample;
+    bool        hasDependencyFlags;
+    uint32_t    dependencyFlags;
+    uint8_t*    pEncBytes;
+    uint32_t    encNumBytes;
+    uint32_t    encResult;
+    bool        done;
+};
+
+struct EncSamplePool {
+    encryptFunc_t           encfcnp;
+    uint32_t                encfcnparam1;
+    mutex                   lock;
+    condition_variable      workReady;
+    condition_variable      jobDone;
+    deque<EncSampleJob*>    toEncrypt;
+    bool                    stop;
+};
+
+static void
+encryptSampleJob( EncSamplePool& pool, unique_lock<mutex>& lock )
+{
+    EncSampleJob* job = pool.toEncrypt.front();
+    pool.toEncrypt.pop_front();
+
+    lock.unlock();
+    job->encResult = pool.encfcnp( pool.encfcnparam1, job->numBytes, job->pBytes,
+                                   &job->encNumBytes, &job->pEncBytes );
+    lock.lock();
+
+    job->done = true;
+    pool.jobDone.notify_one();
+}
+
+static void
+encryptSampleWorker( EncSamplePool* pool )
+{
+    unique_lock<mutex> lock( pool->lock );
+    for( ;; ) {
+        while( !pool->stop && pool->toEncrypt.empty() )
+            pool->workReady.wait( lock );
+        if( pool->toEncrypt.empty() )
+            return;
+        encryptSampleJob( *pool, lock );
+    }
+}
+
+static void
+freeSampleJob( EncSampleJob* job )
+{
+    free( job->pBytes );
+    free( job->pEncBytes );
+    delete job;
+}
+
+void MP4File::EncAndCopySamples(
+    MP4File*      srcFile,
+    MP4TrackId    srcTrackId,
+    encryptFunc_t encfcnp,
+    uint32_t      encfcnparam1,
+    uint32_t      numThreads,
+    MP4File*      dstFile,
+    MP4TrackId    dstTrackId,
+    bool          applyEdits )
+{
+    ASSERT(srcFile);
+    ASSERT(dstFile);
+
+    if( numThreads == 0 )
+        numThreads = max( thread::hardware_concurrency(), 1U );
+
+    bool viaEdits = applyEdits && srcFile->GetTrackNumberOfEdits( srcTrackId );
+    MP4SampleId numSamples = srcFile->GetTrackNumberOfSamples( srcTrackId );
+    MP4Duration editsDuration = srcFile->GetTrackEditTotalDuration( srcTrackId, MP4_INVALID_EDIT_ID );
+    MP4SampleId sampleId = 0;
+    MP4EditSampleCursor cursor = {};
+    bool more = true;
+
+    EncSamplePool pool;
+    pool.encfcnp = encfcnp;
+    pool.encfcnparam1 = encfcnparam1;
+    pool.stop = false;
+
+    // the calling thread encrypts too while it waits, so it counts as one
+    vector<thread> workers;
+    const size_t window = 4 * numThreads;
+    deque<EncSampleJob*> inFlight;
+
+    try {
+        for( uint32_t i = 1; i < numThreads; i++ )
+            workers.push_back( thread( encryptSampleWorker, &pool ));
+
+        while( more || !inFlight.empty() ) {
+            while( more && inFlight.size() < window ) {
+                MP4Duration sampleDuration = MP4_INVALID_DURATION;
+
+                if( viaEdits ) {
+                    // in theory, this shouldn't happen
+                    if( !srcFile->GetNextEditSample( srcTrackId, cursor ))
+                        throw new EXCEPTION( "no sample at edit time" );
+
+                    sampleId = cursor.sampleId;
+                    sampleDuration = cursor.duration;
+
+                    if( cursor.startTime + cursor.duration >= editsDuration ) {
+                        more = false;
+                        break;
+                    }
+                }
+                else if( ++sampleId > numSamples ) {
+                    more = false;
+                    break;
+                }
+
+                EncSampleJob* job = new EncSampleJob();
+                job->sampleId = sampleId;
+                inFlight.push_back( job );
+
+                srcFile->ReadSample(
+                    srcTrackId,
+                    sampleId,
+                    &job->pBytes,
+                    &job->numBytes,
+                    NULL,
+                    &job->duration,
+                    &job->renderingOffset,
+                    &job->isSyncSample,
+                    &job->hasDependencyFlags,
+                    &job->dependencyFlags );
+
+                if( sampleDuration != MP4_INVALID_DURATION )
+                    job->duration = sampleDuration;
+
+                lock_guard<mutex> lock( pool.lock );
+                pool.toEncrypt.push_back( job );
+                pool.workReady.notify_one();
+            }
+
+            if( inFlight.empty() )
+                break;
+
+            EncSampleJob* job = inFlight.front();
+            {
+                unique_lock<mutex> lock( pool.lock );
+                while( !job->done ) {
+                    if( !pool.toEncrypt.empty() )
+                        encryptSampleJob( pool, lock );
+                    else
+                        pool.jobDone.wait( lock );
+                }
+            }
+            inFlight.pop_front();
+
+            try {
+                if( job->encResult != 0 )
+                    log.errorf("%s(%s,%s) Can't encrypt the sample and add its header %u",
+                               __FUNCTION__, srcFile->GetFilename().c_str(), dstFile->GetFilename().c_str(), job->sampleId );
+
+                if( job->hasDependencyFlags ) {
+                    dstFile->WriteSampleDependency(
+                        dstTrackId,
+                        job->pEncBytes,
+                        job->encNumBytes,
+                        job->duration,
+                        job->renderingOffset,
+                        job->isSyncSample,
+                        job->dependencyFlags );
+                }
+                else {
+                    dstFile->WriteSample(
+                        dstTrackId,
+                        job->pEncBytes,
+                        job->encNumBytes,
+                        job->duration,
+                        job->renderingOffset,
+                        job->isSyncSample );
+                }
+            }
+            catch( ... ) {
+                freeSampleJob( job );
+                throw;
+            }
+            freeSampleJob( job );
+        }
+    }
+    catch( ... ) {
+        // let the workers finish what they started, then drop the rest
+        {
+            lock_guard<mutex> lock( pool.lock );
+            pool.toEncrypt.clear();
+            pool.stop = true;
+            pool.workReady.notify_all();
+        }
+        for( size_t i = 0; i < workers.size(); i++ )
+            workers[i].join();
+        for( size_t i = 0; i < inFlight.size(); i++ )
+            freeSampleJob( inFlight[i] );
+        throw;
+    }
+
+    {
+        lock_guard<mutex> lock( pool.lock );
+        pool.stop = true;
+        pool.workReady.notify_all();
+    }
+    for( size_t i = 0; i < workers.size(); i++ )
+        workers[i].join();
+}
+
 ///////////////////////////////////////////////////////////////////////////////
 
 }} // namespace mp4v2::impl
@@ -56,6 +56,20 @@ public:
         MP4TrackId  dstTrackId,
         MP4Duration dstSampleDuration );
 
+    static bool CopyChunks(
+        MP4File*    srcFile,
+        MP4TrackId  srcTrackId,
+        MP4File*    dstFile,
+        MP4TrackId  dstTrackId );
+
+    static void ReferenceSample(
+        MP4File*    srcFile,
+        MP4TrackId  srcTrackId,
+        MP4SampleId srcSampleId,
+        MP4File*    dstFile,
+        MP4TrackId  dstTrackId,
+        MP4Duration dstSampleDuration );
+
     static void EncAndCopySample(
         MP4File*      srcFile,
         MP4TrackId    srcTrackId,
@@ -66,6 +80,16 @@ public:
         MP4TrackId    dstTrackId,
         MP4Duration   dstSampleDuration );
 
+    static void EncAndCopySamples(
+        MP4File*      srcFile,
+        MP4TrackId    srcTrackId,
+        encryptFunc_t encfcnp,
+        uint32_t      encfcnparam1,
+        uint32_t      numThreads,
+        MP4File*      dstFile,
+        MP4TrackId    dstTrackId,
+        bool          applyEdits );
+
 public:
     MP4File();
     ~MP4File();
@@ -97,8 +121,17 @@ public:
                  void*                 handle );
 
     void Optimize( const char* srcFileName, const char* dstFileName = NULL );
+    void Remux( MP4File&          srcFile,
+                const char*       dstFileName,
+                const MP4TrackId* trackIds,
+                uint32_t          numTracks,
+                MP4Timestamp      startTime,
+                MP4Duration       duration,
+                MP4Duration       interleaveDuration );
     bool CopyClose( const string& copyFileName );
     void Dump( bool dumpImplicits = false );
+    void DumpJson( const char* fileName, uint32_t flags = 0, uint32_t tableEntries = 3 );
+    void DumpJson( MP4DumpJsonWriteFunc write, void* handle, uint32_t flags = 0, uint32_t tableEntries = 3 );
     void Close(uint32_t flags = 0);
 
     bool Use64Bits(const char *atomName);
@@ -157,6 +190,7 @@ public:
     MP4TrackId FindTrackId(uint16_t trackIndex,
                            const char* type = NULL, uint8_t subType = 0);
     uint16_t FindTrackIndex(MP4TrackId trackId);
+    MP4Track* LookupTrack(MP4TrackId trackId);  // NULL if not found
     uint16_t FindTrakAtomIndex(MP4TrackId trackId);
 
     /* track properties */
@@ -199,6 +233,13 @@ public:
     MP4SampleId GetSampleIdFromTime(MP4TrackId trackId,
                                     MP4Timestamp when, bool wantSyncSample = false);
 
+    // exception-free variants, expected failures are returned as a status
+    MP4Error TryGetSampleIdFromTime(MP4TrackId trackId,
+                                    MP4Timestamp when, bool wantSyncSample,
+                                    MP4SampleId& sampleId);
+
+    MP4Error CheckSampleId(MP4TrackId trackId, MP4SampleId sampleId);
+
     MP4Timestamp GetSampleTime(
         MP4TrackId trackId, MP4SampleId sampleId);
 
@@ -225,6 +266,18 @@ public:
         bool*         hasDependencyFlags = NULL,
         uint32_t*     dependencyFlags = NULL );
 
+    MP4Error TryReadSample(
+        // input parameters
+        MP4TrackId trackId,
+        MP4SampleId sampleId,
+        // output parameters
+        uint8_t**     ppBytes,
+        uint32_t*     pNumBytes,
+        MP4Timestamp* pStartTime = NULL,
+        MP4Duration*  pDuration = NULL,
+        MP4Duration*  pRenderingOffset = NULL,
+        bool*         pIsSyncSample = NULL );
+
     void WriteSample(
         MP4TrackId     trackId,
         const uint8_t* pBytes,
@@ -242,6 +295,29 @@ public:
         bool           isSyncSample,
         uint32_t       dependencyFlags );
 
+    // bulk access to the cues of a text or subtitle track
+    void WriteTextCues(
+        MP4TrackId        trackId,
+        const MP4TextCue* cues,
+        uint32_t          numCues );
+
+    void ReadTextCues(
+        MP4TrackId   trackId,
+        MP4TextCue** ppCues,
+        uint32_t*    pNumCues );
+
+    void GetDecodableSamples(
+        MP4TrackId           trackId,
+        MP4Timestamp         startTime,
+        MP4Duration          duration,
+        MP4DecodableSample** ppSamples,
+        uint32_t*            pNumSamples );
+
+    void GetSyncSampleIndex(
+        MP4TrackId           trackId,
+        MP4DecodableSample** ppSamples,
+        uint32_t*            pNumSamples );
+
     void SetSampleRenderingOffset(
         MP4TrackId  trackId,
         MP4SampleId sampleId,
@@ -655,6 +731,10 @@ public:
     MP4TrackId GetHintTrackReferenceTrackId(
         MP4TrackId hintTrackId);
 
+    MP4TrackId HintTrack(
+        MP4TrackId mediaTrackId,
+        uint16_t maxPayloadSize);
+
     void ReadRtpHint(
         MP4TrackId hintTrackId,
         MP4SampleId hintSampleId,
@@ -680,6 +760,9 @@ public:
         bool includeHeader = true,
         bool includePayload = true);
 
+    MP4RtpSchedule* CompileRtpSchedule(
+        MP4TrackId hintTrackId);
+
     MP4Timestamp GetRtpTimestampStart(
         MP4TrackId hintTrackId);
 
@@ -777,13 +860,33 @@ public:
         MP4Timestamp* pStartTime = NULL,
         MP4Duration* pDuration = NULL);
 
+    bool GetNextEditSample(
+        MP4TrackId trackId,
+        MP4EditSampleCursor& cursor);
+
+    // limit on external (dref'd) media files kept open at a time
+    uint32_t GetMaxExternalFiles();
+    void     SetMaxExternalFiles( uint32_t max );
+
+    // write-combining buffer of files opened for writing
+    void SetWriteBufferSize( uint32_t size );
+    void Flush();
+
     /* "protected" interface to be used only by friends in library */
 
+    File* GetExternalFile( const string& path );
+    void  CloseExternalFiles();
+
+    recursive_mutex& GetSampleLock() { return m_sampleLock; }
+    bool CanReadUnlocked();
+    void ReadBytesUnlocked( uint64_t pos, uint8_t* buf, uint32_t bufsiz );
+
     uint64_t GetPosition( File* file = NULL );
     void SetPosition( uint64_t pos, File* file = NULL );
     uint64_t GetSize( File* file = NULL );
 
     void ReadBytes( uint8_t* buf, uint32_t bufsiz, File* file = NULL );
+    void ReadBytesAt( uint64_t pos, uint8_t* buf, uint32_t bufsiz, File* file = NULL );
     void PeekBytes( uint8_t* buf, uint32_t bufsiz, File* file = NULL );
 
     uint8_t ReadUInt8();
@@ -807,6 +910,7 @@ public:
     uint32_t ReadMpegLength();
 
     void WriteBytes( uint8_t* buf, uint32_t bufsiz, File* file = NULL );
+    void WriteBytesAt( uint64_t pos, uint8_t* buf, uint32_t bufsiz, File* file = NULL );
 
     void WriteUInt8(uint8_t value);
     void WriteUInt16(uint16_t value);
@@ -835,6 +939,12 @@ public:
     void DisableMemoryBuffer(
         uint8_t** ppBytes = NULL, uint64_t* pNumBytes = NULL);
 
+    // serialize atoms into memory at the current file position and
+    // emit them with a single write
+    void BeginBufferedWrite();
+    void FinishBufferedWrite();
+    void AbortBufferedWrite();
+
     bool IsWriteMode();
 
     MP4Track* GetTrack(MP4TrackId trackId);
@@ -881,9 +991,12 @@ protected:
     void ReadFromFile();
     void GenerateTracks();
     void BeginWrite();
+    void FinishMoov(uint32_t options);
     void FinishWrite(uint32_t options);
     void CacheProperties();
     void RewriteMdat( File& src, File& dst );
+    MP4TrackId CloneTrackAtoms( MP4File& srcFile, MP4TrackId srcTrackId );
+    void CopyAtom( MP4File& srcFile, MP4Atom& srcAtom, MP4Atom& parentAtom, uint32_t index );
     bool ShallHaveIods();
 
     void Rename(const char* existingFileName, const char* newFileName);
@@ -999,6 +1112,7 @@ protected:
     uint8_t*    m_memoryBuffer;
     uint64_t    m_memoryBufferPosition;
     uint64_t    m_memoryBufferSize;
+    uint64_t    m_memoryBufferBase;     // file offset of a buffered write
 
     // bit read/write buffering
     uint8_t m_numReadBits;
@@ -1009,6 +1123,22 @@ protected:
     char m_trakName[1024];
     char m_editName[1024];
 
+    // open external media files, most recently used first
+    struct ExternalFile {
+        string path;
+        File*  file;    // NULL if it could not be opened; not retried
+    };
+    list<ExternalFile> m_externalFiles;
+    uint32_t           m_maxExternalFiles;
+
+    uint32_t m_writeBufferSize;
+
+    // held by the sample access functions, so threads can share a handle
+    // opened for reading; guards the track lookup caches, the external
+    // files and the file position, but not positional reads of sample
+    // data, see CanReadUnlocked()
+    recursive_mutex m_sampleLock;
+
  private:
     MP4File ( const MP4File &src );
     MP4File &operator= ( const MP4File &src );
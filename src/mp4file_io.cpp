@@ -28,10 +28,51 @@ namespace impl {
 
 // MP4File low level IO support
 
+// Returns NULL if the file cannot be opened.
+File* MP4File::GetExternalFile( const string& path )
+{
+    list<ExternalFile>::iterator it;
+    for( it = m_externalFiles.begin(); it != m_externalFiles.end(); it++ ) {
+        if( it->path == path )
+            break;
+    }
+
+    if( it != m_externalFiles.end() ) {
+        if( it != m_externalFiles.begin() )
+            m_externalFiles.splice( m_externalFiles.begin(), m_externalFiles, it );
+        return m_externalFiles.front().file;
+    }
+
+    ExternalFile entry;
+    entry.path = path;
+    entry.file = new File( path, File::MODE_READ );
+    if( entry.file->open() ) {
+        delete entry.file;
+        entry.file = NULL;
+    }
+
+    // close the least recently used file to stay within the limit
+    if( m_externalFiles.size() >= m_maxExternalFiles ) {
+        delete m_externalFiles.back().file;
+        m_externalFiles.pop_back();
+    }
+
+    m_externalFiles.push_front( entry );
+    return entry.file;
+}
+
+void MP4File::CloseExternalFiles()
+{
+    list<ExternalFile>::iterator it;
+    for( it = m_externalFiles.begin(); it != m_externalFiles.end(); it++ )
+        delete it->file;
+    m_externalFiles.clear();
+}
+
 uint64_t MP4File::GetPosition( File* file )
 {
     if( m_memoryBuffer )
-        return m_memoryBufferPosition;
+        return m_memoryBufferBase + m_memoryBufferPosition;
 
     if( !file )
         file = m_file;
@@ -43,9 +84,10 @@ uint64_t MP4File::GetPosition( File* file )
 void MP4File::SetPosition( uint64_t pos, File* file )
 {
     if( m_memoryBuffer ) {
-        if( pos >= m_memoryBufferSize )
+        // the end of the buffer is a valid position, as for a file
+        if( pos < m_memoryBufferBase || pos - m_memoryBufferBase > m_memoryBufferSize )
             throw new EXCEPTION("position out of range");
-        m_memoryBufferPosition = pos;
+        m_memoryBufferPosition = pos - m_memoryBufferBase;
         return;
     }
 
@@ -98,11 +140,61 @@ void MP4File::ReadBytes( uint8_t* buf, uint32_t bufsiz, File* file )
         throw new EXCEPTION("not enough bytes, reached end-of-file");
 }
 
+// Reads at an absolute offset without moving the current position.
+void MP4File::ReadBytesAt( uint64_t pos, uint8_t* buf, uint32_t bufsiz, File* file )
+{
+    if( bufsiz == 0 )
+        return;
+
+    ASSERT( buf );
+
+    if( m_memoryBuffer ) {
+        if( pos < m_memoryBufferBase || pos - m_memoryBufferBase + bufsiz > m_memoryBufferSize )
+            throw new EXCEPTION("not enough bytes, reached end-of-memory");
+        memcpy( buf, &m_memoryBuffer[pos - m_memoryBufferBase], bufsiz );
+        return;
+    }
+
+    if( !file )
+        file = m_file;
+
+    ASSERT( file );
+    File::Size nin;
+    if( file->readAt( pos, buf, bufsiz, nin ))
+        throw new PLATFORM_EXCEPTION("read failed", sys::getLastError());
+    if( nin != bufsiz )
+        throw new EXCEPTION("not enough bytes, reached end-of-file");
+}
+
+// Whether sample data may be read without m_sampleLock: the file is only
+// read, and its provider reads at an offset without moving its position.
+bool MP4File::CanReadUnlocked()
+{
+    return m_file && !IsWriteMode() && m_file->isPositional();
+}
+
+// Reads from the file itself, never from a memory buffer another thread
+// may have enabled, see CanReadUnlocked().
+void MP4File::ReadBytesUnlocked( uint64_t pos, uint8_t* buf, uint32_t bufsiz )
+{
+    if( bufsiz == 0 )
+        return;
+
+    ASSERT( buf && m_file );
+    File::Size nin;
+    if( m_file->readAt( pos, buf, bufsiz, nin ))
+        throw new PLATFORM_EXCEPTION("read failed", sys::getLastError());
+    if( nin != bufsiz )
+        throw new EXCEPTION("not enough bytes, reached end-of-file");
+}
+
 void MP4File::PeekBytes( uint8_t* buf, uint32_t bufsiz, File* file )
 {
-    const uint64_t pos = GetPosition( file );
-    ReadBytes( buf, bufsiz, file );
-    SetPosition( pos, file );
+    if ( m_numReadBits > 0 ) {
+        WARNING( m_numReadBits > 0 );
+    }
+
+    ReadBytesAt( GetPosition( file ), buf, bufsiz, file );
 }
 
 void MP4File::EnableMemoryBuffer( uint8_t* pBytes, uint64_t numBytes )
@@ -137,6 +229,48 @@ void MP4File::DisableMemoryBuffer( uint8_t** ppBytes, uint64_t* pNumBytes )
     m_memoryBuffer = NULL;
     m_memoryBufferSize = 0;
     m_memoryBufferPosition = 0;
+    m_memoryBufferBase = 0;
+}
+
+// Atoms written between BeginBufferedWrite() and FinishBufferedWrite() go to
+// a memory buffer based at the current file position, so their recorded
+// offsets stay valid and size fix-ups are plain memory stores. The buffer
+// then reaches the file in one write instead of one per property value.
+void MP4File::BeginBufferedWrite()
+{
+    ASSERT( !m_memoryBuffer );
+
+    const uint64_t base = GetPosition();
+    EnableMemoryBuffer( NULL, 64 * 1024 );
+    m_memoryBufferBase = base;
+}
+
+void MP4File::FinishBufferedWrite()
+{
+    uint8_t* bytes;
+    uint64_t numBytes;
+    DisableMemoryBuffer( &bytes, &numBytes );
+
+    try {
+        for( uint64_t pos = 0; pos < numBytes; ) {
+            uint32_t size = (uint32_t)min( numBytes - pos, (uint64_t)0x40000000 );
+            WriteBytes( &bytes[pos], size );
+            pos += size;
+        }
+    }
+    catch( Exception* ) {
+        MP4Free( bytes );
+        throw;
+    }
+
+    MP4Free( bytes );
+}
+
+void MP4File::AbortBufferedWrite()
+{
+    uint8_t* bytes;
+    DisableMemoryBuffer( &bytes );
+    MP4Free( bytes );
 }
 
 void MP4File::WriteBytes( uint8_t* buf, uint32_t bufsiz, File* file )
@@ -167,6 +301,30 @@ void MP4File::WriteBytes( uint8_t* buf, uint32_t bufsiz, File* file )
         throw new EXCEPTION("not all bytes written");
 }
 
+// Writes at an absolute offset without moving the current position.
+void MP4File::WriteBytesAt( uint64_t pos, uint8_t* buf, uint32_t bufsiz, File* file )
+{
+    if( !buf || bufsiz == 0 )
+        return;
+
+    if( m_memoryBuffer ) {
+        if( pos < m_memoryBufferBase || pos - m_memoryBufferBase + bufsiz > m_memoryBufferPosition )
+            throw new EXCEPTION("position out of range");
+        memcpy( &m_memoryBuffer[pos - m_memoryBufferBase], buf, bufsiz );
+        return;
+    }
+
+    if( !file )
+        file = m_file;
+
+    ASSERT( file );
+    File::Size nout;
+    if( file->writeAt( pos, buf, bufsiz, nout ))
+        throw new PLATFORM_EXCEPTION("write failed", sys::getLastError());
+    if( nout != bufsiz )
+        throw new EXCEPTION("not all bytes written");
+}
+
 uint8_t MP4File::ReadUInt8()
 {
     uint8_t data;
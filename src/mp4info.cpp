@@ -567,6 +567,250 @@ static char* PrintTrackInfo(
 
 ///////////////////////////////////////////////////////////////////////////////
 
+// Lightweight header walker behind MP4Probe().
+//
+// Boxes are stepped over by their size fields and only the few header
+// boxes needed for MP4ProbeInfo are read.  Reads are served from a small
+// window so the headers of neighbouring boxes cost a single file read.
+
+class MP4Prober
+{
+public:
+    MP4Prober( File& file, MP4ProbeInfo& info )
+        : m_file(file)
+        , m_info(info)
+        , m_fileSize(file.size)
+        , m_windowPos(0)
+        , m_windowSize(0)
+    {
+    }
+
+    bool Probe()
+    {
+        bool foundMoov = false;
+        Box box;
+
+        for( uint64_t pos = 0; ReadBoxHeader( pos, m_fileSize, box ); pos = box.end ) {
+            if( box.type == ATOMID("ftyp") ) {
+                uint8_t buf[8];
+                if( ReadBytes( box.data, buf, sizeof(buf) ) ) {
+                    memcpy( m_info.majorBrand, buf, 4 );
+                    m_info.minorVersion = Get32( &buf[4] );
+                }
+            }
+            else if( box.type == ATOMID("moov") ) {
+                ProbeMoov( box );
+                foundMoov = true;
+                break;
+            }
+        }
+
+        return foundMoov;
+    }
+
+private:
+    struct Box {
+        uint32_t type;
+        uint64_t data;  // offset of box payload
+        uint64_t end;   // offset following the box
+    };
+
+    enum { WindowSize = 16 * 1024 };
+
+    static uint16_t Get16( const uint8_t* p ) {
+        return (p[0] << 8) | p[1];
+    }
+
+    static uint32_t Get32( const uint8_t* p ) {
+        return ((uint32_t)p[0] << 24) | (p[1] << 16) | (p[2] << 8) | p[3];
+    }
+
+    static uint64_t Get64( const uint8_t* p ) {
+        return ((uint64_t)Get32( p ) << 32) | Get32( &p[4] );
+    }
+
+    bool ReadBytes( uint64_t pos, uint8_t* buf, uint32_t size )
+    {
+        if( pos + size > m_fileSize )
+            return false;
+
+        if( pos < m_windowPos || pos + size > m_windowPos + m_windowSize ) {
+            File::Size nin;
+            if( size > WindowSize ) {
+                if( m_file.readAt( pos, buf, size, nin ) )
+                    return false;
+                return nin == size;
+            }
+
+            uint32_t windowSize = (uint32_t)min( (uint64_t)WindowSize, m_fileSize - pos );
+            if( m_file.readAt( pos, m_window, windowSize, nin ) || nin < size ) {
+                m_windowSize = 0;
+                return false;
+            }
+            m_windowPos  = pos;
+            m_windowSize = (uint32_t)nin;
+        }
+
+        memcpy( buf, &m_window[pos - m_windowPos], size );
+        return true;
+    }
+
+    bool ReadBoxHeader( uint64_t pos, uint64_t parentEnd, Box& box )
+    {
+        uint8_t buf[16];
+        if( pos + 8 > parentEnd || !ReadBytes( pos, buf, 8 ) )
+            return false;
+
+        uint64_t size = Get32( buf );
+        box.type = Get32( &buf[4] );
+        box.data = pos + 8;
+
+        if( size == 1 ) {
+            if( !ReadBytes( pos + 8, &buf[8], 8 ) )
+                return false;
+            size = Get64( &buf[8] );
+            box.data += 8;
+        }
+        else if( size == 0 ) {
+            size = parentEnd - pos;
+        }
+
+        if( size < box.data - pos || size > parentEnd - pos )
+            return false;
+
+        box.end = pos + size;
+        return true;
+    }
+
+    void ProbeMoov( const Box& moov )
+    {
+        Box box;
+        for( uint64_t pos = moov.data; ReadBoxHeader( pos, moov.end, box ); pos = box.end ) {
+            if( box.type == ATOMID("mvhd") ) {
+                uint8_t buf[32];
+                if( !ReadBytes( box.data, buf, 20 ) )
+                    continue;
+                if( buf[0] == 1 ) {
+                    if( !ReadBytes( box.data, buf, 32 ) )
+                        continue;
+                    m_info.timeScale = Get32( &buf[20] );
+                    m_info.duration  = Get64( &buf[24] );
+                }
+                else {
+                    m_info.timeScale = Get32( &buf[12] );
+                    m_info.duration  = Get32( &buf[16] );
+                }
+            }
+            else if( box.type == ATOMID("trak") ) {
+                if( m_info.numTracks < MP4_PROBE_MAX_TRACKS )
+                    ProbeTrak( box, m_info.tracks[m_info.numTracks] );
+                m_info.numTracks++;
+            }
+        }
+    }
+
+    void ProbeTrak( const Box& trak, MP4ProbeTrack& track )
+    {
+        Box box;
+        for( uint64_t pos = trak.data; ReadBoxHeader( pos, trak.end, box ); pos = box.end ) {
+            if( box.type == ATOMID("tkhd") ) {
+                uint8_t buf[16];
+                if( !ReadBytes( box.data, buf, 16 ) )
+                    continue;
+                if( buf[0] == 1 ) {
+                    uint8_t buf1[24];
+                    if( ReadBytes( box.data, buf1, 24 ) )
+                        track.trackId = Get32( &buf1[20] );
+                }
+                else {
+                    track.trackId = Get32( &buf[12] );
+                }
+            }
+            else if( box.type == ATOMID("mdia") ) {
+                ProbeMdia( box, track );
+            }
+        }
+    }
+
+    void ProbeMdia( const Box& mdia, MP4ProbeTrack& track )
+    {
+        Box box;
+        for( uint64_t pos = mdia.data; ReadBoxHeader( pos, mdia.end, box ); pos = box.end ) {
+            if( box.type == ATOMID("mdhd") ) {
+                uint8_t buf[32];
+                if( !ReadBytes( box.data, buf, 20 ) )
+                    continue;
+                if( buf[0] == 1 ) {
+                    if( !ReadBytes( box.data, buf, 32 ) )
+                        continue;
+                    track.timeScale = Get32( &buf[20] );
+                    track.duration  = Get64( &buf[24] );
+                }
+                else {
+                    track.timeScale = Get32( &buf[12] );
+                    track.duration  = Get32( &buf[16] );
+                }
+            }
+            else if( box.type == ATOMID("hdlr") ) {
+                uint8_t buf[12];
+                if( ReadBytes( box.data, buf, 12 ) )
+                    memcpy( track.type, &buf[8], 4 );
+            }
+            else if( box.type == ATOMID("minf") ) {
+                Box stbl, stsd;
+                if( FindChild( box, "stbl", stbl ) && FindChild( stbl, "stsd", stsd ) )
+                    ProbeStsd( stsd, track );
+            }
+        }
+
+        // audio sample descriptions can't express rates above 65535 Hz
+        if( track.channels && !track.sampleRate )
+            track.sampleRate = track.timeScale;
+    }
+
+    void ProbeStsd( const Box& stsd, MP4ProbeTrack& track )
+    {
+        // version/flags and entryCount precede the first sample description
+        Box entry;
+        if( !ReadBoxHeader( stsd.data + 8, stsd.end, entry ) )
+            return;
+
+        INT32TOSTR( entry.type, track.codec );
+
+        uint8_t buf[28];
+        if( entry.end - entry.data < sizeof(buf) || !ReadBytes( entry.data, buf, sizeof(buf) ) )
+            return;
+
+        if( strequal( track.type, MP4_VIDEO_TRACK_TYPE ) ) {
+            track.width  = Get16( &buf[24] );
+            track.height = Get16( &buf[26] );
+        }
+        else if( strequal( track.type, MP4_AUDIO_TRACK_TYPE ) ) {
+            track.channels   = Get16( &buf[16] );
+            track.sampleRate = Get32( &buf[24] ) >> 16;
+        }
+    }
+
+    bool FindChild( const Box& parent, const char* type, Box& child )
+    {
+        for( uint64_t pos = parent.data; ReadBoxHeader( pos, parent.end, child ); pos = child.end ) {
+            if( child.type == ATOMID(type) )
+                return true;
+        }
+        return false;
+    }
+
+private:
+    File&         m_file;
+    MP4ProbeInfo& m_info;
+    uint64_t      m_fileSize;
+    uint8_t       m_window[WindowSize];
+    uint64_t      m_windowPos;
+    uint32_t      m_windowSize;
+};
+
+///////////////////////////////////////////////////////////////////////////////
+
 }} // namespace mp4v2::impl
 
 ///////////////////////////////////////////////////////////////////////////////
@@ -630,3 +874,70 @@ char* MP4FileInfo(
 
     return info;    // caller should free this
 }
+
+static bool MP4ProbeFile( File& file, MP4ProbeInfo* info )
+{
+    memset( info, 0, sizeof(*info) );
+    if( file.open() )
+        return false;
+
+    MP4Prober prober( file, *info );
+    bool result = prober.Probe();
+
+    file.close();
+    return result;
+}
+
+extern "C"
+bool MP4Probe(
+    const char*   fileName,
+    MP4ProbeInfo* info )
+{
+    if( !fileName || !info )
+        return false;
+
+    // cleared up front so that failures before probing leave no garbage
+    memset( info, 0, sizeof(*info) );
+
+    try {
+        File file( fileName, File::MODE_READ );
+        return MP4ProbeFile( file, info );
+    }
+    catch( Exception* x ) {
+        mp4v2::impl::log.errorf(*x);
+        delete x;
+    }
+    catch( ... ) {
+        mp4v2::impl::log.errorf("%s: \"%s\": failed", __FUNCTION__,
+                                fileName );
+    }
+
+    return false;
+}
+
+extern "C"
+bool MP4ProbeCallbacks(
+    const MP4IOCallbacks* callbacks,
+    void*                 handle,
+    MP4ProbeInfo*         info )
+{
+    if( !callbacks || !info )
+        return false;
+
+    memset( info, 0, sizeof(*info) );
+
+    try {
+        File file( "<callbacks>", File::MODE_READ,
+                   new io::CallbacksFileProvider( *callbacks, handle ));
+        return MP4ProbeFile( file, info );
+    }
+    catch( Exception* x ) {
+        mp4v2::impl::log.errorf(*x);
+        delete x;
+    }
+    catch( ... ) {
+        mp4v2::impl::log.errorf("%s: failed", __FUNCTION__ );
+    }
+
+    return false;
+}
@@ -311,6 +311,11 @@ void MP4Float32Property::Dump(uint8_t indent,
                  m_name, m_values[index]);
 }
 
+void MP4Float32Property::DumpJson(MP4JsonWriter& json, uint32_t index)
+{
+    json.Float(m_values[index]);
+}
+
 // MP4Float64Property
 
 void MP4Float64Property::Read(MP4File& file, uint32_t index)
@@ -347,6 +352,11 @@ void MP4Float64Property::Dump(uint8_t indent,
                  m_name, m_values[index]);
 }
 
+void MP4Float64Property::DumpJson(MP4JsonWriter& json, uint32_t index)
+{
+    json.Float(m_values[index]);
+}
+
 // MP4StringProperty
 
 MP4StringProperty::MP4StringProperty(
@@ -525,6 +535,40 @@ void MP4StringProperty::Dump( uint8_t indent, bool dumpImplicits, uint32_t index
     }
 }
 
+void MP4StringProperty::DumpJson( MP4JsonWriter& json, uint32_t index )
+{
+    if( m_arrayMode ) {
+        const uint32_t max = GetCount();
+        json.BeginArray();
+        for( uint32_t i = 0; i < max; i++ )
+            DumpJsonValue( json, i );
+        json.EndArray();
+    }
+    else {
+        DumpJsonValue( json, index );
+    }
+}
+
+void MP4StringProperty::DumpJsonValue( MP4JsonWriter& json, uint32_t index )
+{
+    const char* const value = m_values[index];
+    if( !value ) {
+        json.Null();
+        return;
+    }
+
+    if( !m_useUnicode ) {
+        json.String( value );
+        return;
+    }
+
+    // wide strings are rare enough to narrow them; non-ASCII becomes '?'
+    string narrow;
+    for( const wchar_t* p = (const wchar_t*)value; *p; p++ )
+        narrow += (*p < 0x80) ? static_cast<char>(*p) : '?';
+    json.String( narrow.c_str() );
+}
+
 // MP4BytesProperty
 
 MP4BytesProperty::MP4BytesProperty(MP4Atom& parentAtom, const char* name, uint32_t valueSize,
@@ -709,6 +753,26 @@ void MP4BytesProperty::Dump(uint8_t indent,
     }
 }
 
+void MP4BytesProperty::DumpJson(MP4JsonWriter& json, uint32_t index)
+{
+    const uint32_t size = m_valueSizes[index];
+
+    // outside of full mode only a prefix is shown, as in Dump()
+    const uint32_t max = 128;
+    const bool truncated = !json.full && size > max;
+
+    json.BeginObject();
+    json.Key( "size" );
+    json.Integer( size );
+    json.Key( "hex" );
+    json.Hex( m_values[index], truncated ? max : size );
+    if( truncated ) {
+        json.Key( "truncated" );
+        json.Bool( true );
+    }
+    json.EndObject();
+}
+
 // MP4TableProperty
 
 MP4TableProperty::MP4TableProperty(MP4Atom& parentAtom, const char* name, MP4IntegerProperty* pCountProperty)
@@ -885,6 +949,87 @@ void MP4TableProperty::Dump(uint8_t indent,
     }
 }
 
+void MP4TableProperty::DumpJson(MP4JsonWriter& json, uint32_t index)
+{
+    ASSERT(index == 0);
+
+    const uint32_t numProperties = m_pProperties.Size();
+    const uint32_t numEntries = GetCount();
+
+    json.BeginObject();
+    json.Key( "count" );
+    json.Integer( numEntries );
+
+    // columns rather than rows keep the output compact
+    json.Key( "columns" );
+    json.BeginObject();
+    for( uint32_t j = 0; j < numProperties; j++ ) {
+        MP4Property* const column = m_pProperties[j];
+        if( column->IsImplicit() && !json.dumpImplicits )
+            continue;
+
+        json.Key( column->GetName() );
+        if( json.full ) {
+            json.BeginArray();
+            for( uint32_t i = 0; i < numEntries; i++ )
+                column->DumpJson( json, i );
+            json.EndArray();
+            continue;
+        }
+
+        // summary: range of integer columns and entries at either end
+        json.BeginObject();
+
+        switch( column->GetType() ) {
+            case Integer8Property:
+            case Integer16Property:
+            case Integer24Property:
+            case Integer32Property:
+            case Integer64Property:
+                if( numEntries ) {
+                    MP4IntegerProperty& ip = *static_cast<MP4IntegerProperty*>( column );
+                    uint64_t lo = ip.GetValue( 0 );
+                    uint64_t hi = lo;
+                    for( uint32_t i = 1; i < numEntries; i++ ) {
+                        const uint64_t value = ip.GetValue( i );
+                        if( value < lo )
+                            lo = value;
+                        else if( value > hi )
+                            hi = value;
+                    }
+                    json.Key( "min" );
+                    json.Integer( lo );
+                    json.Key( "max" );
+                    json.Integer( hi );
+                }
+                break;
+
+            default:
+                break;
+        }
+
+        const uint32_t first = min( numEntries, json.tableEntries );
+        const uint32_t last  = min( numEntries - first, json.tableEntries );
+
+        json.Key( "first" );
+        json.BeginArray();
+        for( uint32_t i = 0; i < first; i++ )
+            column->DumpJson( json, i );
+        json.EndArray();
+
+        json.Key( "last" );
+        json.BeginArray();
+        for( uint32_t i = numEntries - last; i < numEntries; i++ )
+            column->DumpJson( json, i );
+        json.EndArray();
+
+        json.EndObject();
+    }
+    json.EndObject();
+
+    json.EndObject();
+}
+
 // MP4DescriptorProperty
 
 MP4DescriptorProperty::MP4DescriptorProperty(MP4Atom& parentAtom, const char* name,
@@ -1078,6 +1223,17 @@ void MP4DescriptorProperty::Dump(uint8_t indent,
     }
 }
 
+void MP4DescriptorProperty::DumpJson(MP4JsonWriter& json, uint32_t index)
+{
+    ASSERT(index == 0);
+
+    json.BeginArray();
+    for (uint32_t i = 0; i < m_pDescriptors.Size(); i++) {
+        m_pDescriptors[i]->DumpJson(json);
+    }
+    json.EndArray();
+}
+
 ///////////////////////////////////////////////////////////////////////////////
 
 MP4LanguageCodeProperty::MP4LanguageCodeProperty( MP4Atom& parentAtom, const char* name, bmff::LanguageCode value )
@@ -1110,6 +1266,12 @@ MP4LanguageCodeProperty::Dump( uint8_t indent, bool dumpImplicits, uint32_t inde
              m_name, bmff::enumLanguageCode.toString( _value, true ).c_str(), data );
 }
 
+void
+MP4LanguageCodeProperty::DumpJson( MP4JsonWriter& json, uint32_t index )
+{
+    json.String( bmff::enumLanguageCode.toString( _value ).c_str() );
+}
+
 uint32_t
 MP4LanguageCodeProperty::GetCount()
 {
@@ -1185,6 +1347,12 @@ MP4BasicTypeProperty::Dump( uint8_t indent, bool dumpImplicits, uint32_t index )
              itmf::enumBasicType.toString( _value, true ).c_str(), _value );
 }
 
+void
+MP4BasicTypeProperty::DumpJson( MP4JsonWriter& json, uint32_t index )
+{
+    json.String( itmf::enumBasicType.toString( _value ).c_str() );
+}
+
 uint32_t
 MP4BasicTypeProperty::GetCount()
 {
@@ -90,6 +90,8 @@ public:
     virtual void Dump(uint8_t indent,
                       bool dumpImplicits, uint32_t index = 0) = 0;
 
+    virtual void DumpJson(MP4JsonWriter& json, uint32_t index = 0) = 0;
+
     virtual bool FindProperty(const char* name,
                               MP4Property** ppProperty, uint32_t* pIndex = NULL);
 
@@ -173,6 +175,10 @@ public:
         m_values.Add(value);
     }
 
+    void AddValues(const type* values, uint32_t count) {
+        m_values.Append(values, count);
+    }
+
     void InsertValue(type value, uint32_t index) {
         m_values.Insert(value, index);
     }
@@ -202,8 +208,12 @@ public:
     void Dump(uint8_t indent,
         bool dumpImplicits, uint32_t index = 0);
 
+    void DumpJson(MP4JsonWriter& json, uint32_t index = 0) {
+        json.Integer(m_values[index]);
+    }
+
 protected:
-    MP4Array<type> m_values;
+    MP4SegmentedArray<type> m_values;
 
 private:
     MP4SizedIntegerProperty();
@@ -309,6 +319,7 @@ public:
     void Write(MP4File& file, uint32_t index = 0);
     void Dump(uint8_t indent,
               bool dumpImplicits, uint32_t index = 0);
+    void DumpJson(MP4JsonWriter& json, uint32_t index = 0);
 
 protected:
     bool m_useFixed16Format;
@@ -365,6 +376,7 @@ public:
     void Write(MP4File& file, uint32_t index = 0);
     void Dump(uint8_t indent,
               bool dumpImplicits, uint32_t index = 0);
+    void DumpJson(MP4JsonWriter& json, uint32_t index = 0);
 
 protected:
     MP4Float64Array m_values;
@@ -400,7 +412,7 @@ public:
 
     void AddValue(const char* value) {
         uint32_t count = GetCount();
-        SetCount(count + 1);
+        m_values.Add(NULL);
         SetValue(value, count);
     }
 
@@ -440,8 +452,11 @@ public:
     void Write(MP4File& file, uint32_t index = 0);
     void Dump(uint8_t indent,
               bool dumpImplicits, uint32_t index = 0);
+    void DumpJson(MP4JsonWriter& json, uint32_t index = 0);
 
 protected:
+    void DumpJsonValue( MP4JsonWriter& json, uint32_t index );
+
     bool m_arrayMode; // during read/write ignore index and read/write full array
     bool m_useCountedFormat;
     bool m_useExpandedCount;
@@ -523,6 +538,7 @@ public:
     void Write(MP4File& file, uint32_t index = 0);
     void Dump(uint8_t indent,
               bool dumpImplicits, uint32_t index = 0);
+    void DumpJson(MP4JsonWriter& json, uint32_t index = 0);
 
 protected:
     uint32_t        m_fixedValueSize;
@@ -563,6 +579,7 @@ public:
     void Write(MP4File& file, uint32_t index = 0);
     void Dump(uint8_t indent,
               bool dumpImplicits, uint32_t index = 0);
+    void DumpJson(MP4JsonWriter& json, uint32_t index = 0);
 
     bool FindProperty(const char* name,
                       MP4Property** ppProperty, uint32_t* pIndex = NULL);
@@ -627,6 +644,7 @@ public:
     void Write(MP4File& file, uint32_t index = 0);
     void Dump(uint8_t indent,
               bool dumpImplicits, uint32_t index = 0);
+    void DumpJson(MP4JsonWriter& json, uint32_t index = 0);
 
     bool FindProperty(const char* name,
                       MP4Property** ppProperty, uint32_t* pIndex = NULL);
@@ -688,6 +706,7 @@ public:
     void            Read( MP4File&, uint32_t = 0 );
     void            Write( MP4File&, uint32_t = 0 );
     void            Dump( uint8_t, bool, uint32_t = 0 );
+    void            DumpJson( MP4JsonWriter&, uint32_t = 0 );
 
     bmff::LanguageCode GetValue();
     void               SetValue( bmff::LanguageCode );
@@ -713,6 +732,7 @@ public:
     void            Read( MP4File&, uint32_t = 0 );
     void            Write( MP4File&, uint32_t = 0 );
     void            Dump( uint8_t, bool, uint32_t = 0 );
+    void            DumpJson( MP4JsonWriter&, uint32_t = 0 );
     itmf::BasicType GetValue();
     void            SetValue( itmf::BasicType );
 
@@ -42,7 +42,7 @@ MP4Track::MP4Track(MP4File& file, MP4Atom& trakAtom)
     , m_trakAtom(trakAtom)
 {
     m_lastStsdIndex = 0;
-    m_lastSampleFile = NULL;
+    m_lastSampleFileRef = NULL;
 
     m_cachedReadSampleId = MP4_INVALID_SAMPLE_ID;
     m_pCachedReadSample = NULL;
@@ -55,6 +55,9 @@ MP4Track::MP4Track(MP4File& file, MP4Atom& trakAtom)
     m_sizeOfDataInChunkBuffer = 0;
     m_chunkSamples = 0;
     m_chunkDuration = 0;
+    m_refChunkSamples = 0;
+    m_refChunkEnd = 0;
+    m_externalDataRef = false;
 
     // m_bytesPerSample should be set to 1, except for the
     // quicktime audio constant bit rate samples, which have non-1 values
@@ -249,6 +252,13 @@ MP4Track::MP4Track(MP4File& file, MP4Atom& trakAtom)
         m_sdtpLog.assign( (char*)buffer, bufsize );
         free( buffer );
     }
+
+    // tracks of existing files may already refer to another file's data
+    // (a self-contained url entry has no location)
+    MP4StringProperty* pLocationProperty = NULL;
+    MP4Atom* pUrlAtom = m_trakAtom.FindAtom( "trak.mdia.minf.dinf.dref.url " );
+    if( pUrlAtom && pUrlAtom->FindProperty( "*.location", (MP4Property**)&pLocationProperty ) && pLocationProperty )
+        m_externalDataRef = pLocationProperty->GetValue() != NULL;
 }
 
 MP4Track::~MP4Track()
@@ -277,11 +287,50 @@ void MP4Track::ReadSample(
     MP4Duration*  pDuration,
     MP4Duration*  pRenderingOffset,
     bool*         pIsSyncSample,
-    bool*         hasDependencyFlags, 
+    bool*         hasDependencyFlags,
+    uint32_t*     dependencyFlags )
+{
+    MP4Error error = TryReadSample(
+        sampleId,
+        ppBytes,
+        pNumBytes,
+        pStartTime,
+        pDuration,
+        pRenderingOffset,
+        pIsSyncSample,
+        hasDependencyFlags,
+        dependencyFlags );
+
+    if( error != MP4_ERROR_NONE )
+        throw new EXCEPTION(ErrorString(error));
+}
+
+MP4Error MP4Track::CheckSampleId( MP4SampleId sampleId )
+{
+    if( sampleId == MP4_INVALID_SAMPLE_ID || sampleId > GetNumberOfSamples() )
+        return MP4_ERROR_INVALID_SAMPLE;
+
+    return MP4_ERROR_NONE;
+}
+
+MP4Error MP4Track::TryReadSample(
+    MP4SampleId   sampleId,
+    uint8_t**     ppBytes,
+    uint32_t*     pNumBytes,
+    MP4Timestamp* pStartTime,
+    MP4Duration*  pDuration,
+    MP4Duration*  pRenderingOffset,
+    bool*         pIsSyncSample,
+    bool*         hasDependencyFlags,
     uint32_t*     dependencyFlags )
 {
-    if( sampleId == MP4_INVALID_SAMPLE_ID )
-        throw new EXCEPTION("sample id can't be zero");
+    // the sample tables and their caches are shared; the sample data can
+    // often be read without the lock, see below
+    unique_lock<recursive_mutex> lock( m_File.GetSampleLock() );
+
+    MP4Error error = CheckSampleId( sampleId );
+    if( error != MP4_ERROR_NONE )
+        return error;
 
     if( hasDependencyFlags )
         *hasDependencyFlags = !m_sdtpLog.empty();
@@ -292,7 +341,7 @@ void MP4Track::ReadSample(
         }
         else {
             if( sampleId > m_sdtpLog.size() )
-                throw new EXCEPTION("sample id > sdtp logsize");
+                return MP4_ERROR_CORRUPT;
             *dependencyFlags = m_sdtpLog[sampleId-1]; // sampleId is 1-based
         }
     }
@@ -303,19 +352,28 @@ void MP4Track::ReadSample(
         WriteChunkBuffer();
     }
 
-    File* fin = GetSampleFile( sampleId );
-    if( fin == (File*)-1 )
-        throw new EXCEPTION("sample is located in an inaccessible file");
+    File* fin;
+    error = GetSampleFile( sampleId, fin );
+    if( error != MP4_ERROR_NONE )
+        return error;
 
-    uint64_t fileOffset = GetSampleFileOffset(sampleId);
+    uint64_t fileOffset;
+    error = TryGetSampleFileOffset( sampleId, fileOffset );
+    if( error != MP4_ERROR_NONE )
+        return error;
 
     uint32_t sampleSize = GetSampleSize(sampleId);
     if (*ppBytes != NULL && *pNumBytes < sampleSize) {
-        throw new EXCEPTION("sample buffer is too small");
+        return MP4_ERROR_BUFFER_TOO_SMALL;
     }
+
+    // a short read would otherwise only be noticed by the file layer
+    if( !m_File.IsWriteMode() && fileOffset + sampleSize > m_File.GetSize( fin ) )
+        return MP4_ERROR_TRUNCATED;
+
     *pNumBytes = sampleSize;
 
-    log.verbose3f("\"%s\": ReadSample: track %u id %u offset 0x%" PRIx64 " size %u (0x%x)",
+    LOG_VERBOSE3F("\"%s\": ReadSample: track %u id %u offset 0x%" PRIx64 " size %u (0x%x)",
                   GetFile().GetFilename().c_str(), m_trackId, sampleId, fileOffset, *pNumBytes, *pNumBytes);
 
     bool bufferMalloc = false;
@@ -324,30 +382,35 @@ void MP4Track::ReadSample(
         bufferMalloc = true;
     }
 
-    uint64_t oldPos = m_File.GetPosition( fin ); // only used in mode == 'w'
     try {
-        m_File.SetPosition( fileOffset, fin );
-        m_File.ReadBytes( *ppBytes, *pNumBytes, fin );
-
         if (pStartTime || pDuration) {
             GetSampleTimes(sampleId, pStartTime, pDuration);
 
-            log.verbose3f("\"%s\": ReadSample:  start %" PRIu64 " duration %" PRId64,
+            LOG_VERBOSE3F("\"%s\": ReadSample:  start %" PRIu64 " duration %" PRId64,
                           GetFile().GetFilename().c_str(), (pStartTime ? *pStartTime : 0),
                           (pDuration ? *pDuration : 0));
         }
         if (pRenderingOffset) {
             *pRenderingOffset = GetSampleRenderingOffset(sampleId);
 
-            log.verbose3f("\"%s\": ReadSample:  renderingOffset %" PRId64,
+            LOG_VERBOSE3F("\"%s\": ReadSample:  renderingOffset %" PRId64,
                           GetFile().GetFilename().c_str(), *pRenderingOffset);
         }
         if (pIsSyncSample) {
             *pIsSyncSample = IsSyncSample(sampleId);
 
-            log.verbose3f("\"%s\": ReadSample:  isSyncSample %u",
+            LOG_VERBOSE3F("\"%s\": ReadSample:  isSyncSample %u",
                           GetFile().GetFilename().c_str(), *pIsSyncSample);
         }
+
+        // external files may be closed by other readers, so only reads
+        // from this file can go ahead unlocked
+        if (fin == NULL && m_File.CanReadUnlocked()) {
+            lock.unlock();
+            m_File.ReadBytesUnlocked(fileOffset, *ppBytes, *pNumBytes);
+        } else {
+            m_File.ReadBytesAt(fileOffset, *ppBytes, *pNumBytes, fin);
+        }
     }
 
     catch (Exception*) {
@@ -356,14 +419,10 @@ void MP4Track::ReadSample(
             *ppBytes = NULL;
         }
 
-        if( m_File.IsWriteMode() )
-            m_File.SetPosition( oldPos, fin );
-
         throw;
     }
 
-    if( m_File.IsWriteMode() )
-        m_File.SetPosition( oldPos, fin );
+    return MP4_ERROR_NONE;
 }
 
 void MP4Track::ReadSampleFragment(
@@ -406,7 +465,7 @@ void MP4Track::WriteSample(
 {
     uint8_t curMode = 0;
 
-    log.verbose3f("\"%s\": WriteSample: track %u id %u size %u (0x%x) ",
+    LOG_VERBOSE3F("\"%s\": WriteSample: track %u id %u size %u (0x%x) ",
                   GetFile().GetFilename().c_str(),
                   m_trackId, m_writeSampleId, numBytes, numBytes);
 
@@ -414,17 +473,16 @@ void MP4Track::WriteSample(
         throw new EXCEPTION("no sample data");
     }
 
-    if (m_isAmr == AMR_UNINITIALIZED ) {
-        // figure out if this is an AMR audio track
-        if (m_trakAtom.FindAtom("trak.mdia.minf.stbl.stsd.samr") ||
-                m_trakAtom.FindAtom("trak.mdia.minf.stbl.stsd.sawb")) {
-            m_isAmr = AMR_TRUE;
-            m_curMode = (pBytes[0] >> 3) & 0x000F;
-        } else {
-            m_isAmr = AMR_FALSE;
-        }
+    // written samples go to this file, which the track's one data
+    // reference can't describe once it names another file
+    if (m_externalDataRef) {
+        throw new EXCEPTION("track refers to sample data in another file");
     }
 
+    FinishReferenceChunk();
+
+    InitAmrMode(pBytes);
+
     if (m_isAmr == AMR_TRUE) {
         curMode = (pBytes[0] >> 3) &0x000F; // The mode is in the first byte
     }
@@ -433,7 +491,7 @@ void MP4Track::WriteSample(
         duration = GetFixedSampleDuration();
     }
 
-    log.verbose3f("\"%s\": duration %" PRIu64, GetFile().GetFilename().c_str(), 
+    LOG_VERBOSE3F("\"%s\": duration %" PRIu64, GetFile().GetFilename().c_str(), 
                   duration);
 
     if ((m_isAmr == AMR_TRUE) &&
@@ -464,16 +522,139 @@ void MP4Track::WriteSample(
 
     UpdateSyncSamples(m_writeSampleId, isSyncSample);
 
-    if (IsChunkFull(m_writeSampleId)) {
-        WriteChunkBuffer();
-        m_curMode = curMode;
-    }
+    bool chunkFull = IsChunkFull(m_writeSampleId);
 
     UpdateDurations(duration);
 
     UpdateModificationTimes();
 
     m_writeSampleId++;
+
+    if (chunkFull) {
+        WriteChunkBuffer();
+        m_curMode = curMode;
+    }
+}
+
+void MP4Track::InitAmrMode(const uint8_t* pBytes)
+{
+    if (m_isAmr == AMR_UNINITIALIZED ) {
+        // figure out if this is an AMR audio track
+        if (m_trakAtom.FindAtom("trak.mdia.minf.stbl.stsd.samr") ||
+                m_trakAtom.FindAtom("trak.mdia.minf.stbl.stsd.sawb")) {
+            m_isAmr = AMR_TRUE;
+            m_curMode = (pBytes[0] >> 3) & 0x000F;
+        } else {
+            m_isAmr = AMR_FALSE;
+        }
+    }
+}
+
+// Appends numSamples sync samples stored back to back in pBytes. Chunks
+// and tables come out as if the samples were written one at a time with
+// WriteSample(), but stsz, ctts and stss are appended once, stts once per
+// run of equal durations, and the chunk buffer is sized up front.
+void MP4Track::WriteSamples(
+    const uint8_t*     pBytes,
+    uint32_t           numSamples,
+    const uint32_t*    pSizes,
+    const MP4Duration* pDurations )
+{
+    if (numSamples == 0) {
+        return;
+    }
+
+    LOG_VERBOSE3F("\"%s\": WriteSamples: track %u id %u count %u",
+                  GetFile().GetFilename().c_str(),
+                  m_trackId, m_writeSampleId, numSamples);
+
+    if (pBytes == NULL || pSizes == NULL || pDurations == NULL) {
+        throw new EXCEPTION("no sample data");
+    }
+
+    if (m_externalDataRef) {
+        throw new EXCEPTION("track refers to sample data in another file");
+    }
+
+    FinishReferenceChunk();
+
+    InitAmrMode(pBytes);
+
+    // AMR tracks start a new chunk on every mode change
+    if (m_isAmr == AMR_TRUE) {
+        for (uint32_t i = 0; i < numSamples; i++) {
+            WriteSample(pBytes, pSizes[i], pDurations[i]);
+            pBytes += pSizes[i];
+        }
+        return;
+    }
+
+    uint64_t totalBytes = 0;
+    for (uint32_t i = 0; i < numSamples; i++) {
+        totalBytes += pSizes[i];
+    }
+    if (m_sizeOfDataInChunkBuffer + totalBytes > 0xFFFFFFFF) {
+        throw new EXCEPTION("samples too large for one call");
+    }
+    if (m_sizeOfDataInChunkBuffer + totalBytes > m_chunkBufferSize) {
+        m_chunkBufferSize = (uint32_t)(m_sizeOfDataInChunkBuffer + totalBytes);
+        m_pChunkBuffer = (uint8_t*)MP4Realloc(m_pChunkBuffer, m_chunkBufferSize);
+    }
+
+    const MP4SampleId firstSampleId = m_writeSampleId;
+    MP4Duration totalDuration = 0;
+
+    // the run of equal durations not yet added to stts
+    MP4Duration runDuration = 0;
+    uint32_t runLength = 0;
+
+    for (uint32_t i = 0; i < numSamples; i++) {
+        uint32_t numBytes = pSizes[i];
+        MP4Duration duration = pDurations[i];
+
+        if (duration == MP4_INVALID_DURATION) {
+            // the fixed duration depends on stts as it stands so far
+            if (runLength) {
+                UpdateSampleTimes(runDuration, runLength);
+                runLength = 0;
+            }
+            duration = GetFixedSampleDuration();
+        }
+
+        if (runLength && duration != runDuration) {
+            UpdateSampleTimes(runDuration, runLength);
+            runLength = 0;
+        }
+        runDuration = duration;
+        runLength++;
+
+        memcpy(&m_pChunkBuffer[m_sizeOfDataInChunkBuffer], pBytes, numBytes);
+        m_sizeOfDataInChunkBuffer += numBytes;
+        m_chunkSamples++;
+        m_chunkDuration += duration;
+        pBytes += numBytes;
+
+        totalDuration += duration;
+        m_writeSampleId++;
+
+        if (IsChunkFull(m_writeSampleId - 1)) {
+            WriteChunkBuffer();
+        }
+    }
+
+    if (runLength) {
+        UpdateSampleTimes(runDuration, runLength);
+    }
+
+    UpdateSampleSizes(firstSampleId, pSizes, numSamples);
+
+    UpdateRenderingOffsets(firstSampleId, 0, numSamples);
+
+    UpdateSyncSamples(firstSampleId, true, numSamples);
+
+    UpdateDurations(totalDuration);
+
+    UpdateModificationTimes();
 }
 
 void MP4Track::WriteSampleDependency(
@@ -488,6 +669,105 @@ void MP4Track::WriteSampleDependency(
     WriteSample( pBytes, numBytes, duration, renderingOffset, isSyncSample );
 }
 
+void MP4Track::ReferenceSample(
+    const char*    url,
+    uint64_t       fileOffset,
+    uint32_t       numBytes,
+    MP4Duration    duration,
+    MP4Duration    renderingOffset,
+    bool           isSyncSample )
+{
+    LOG_VERBOSE3F("\"%s\": ReferenceSample: track %u id %u offset 0x%" PRIx64 " size %u (0x%x)",
+                  GetFile().GetFilename().c_str(),
+                  m_trackId, m_writeSampleId, fileOffset, numBytes, numBytes);
+
+    // all samples of the track share its one data reference
+    MP4StringProperty* pLocationProperty = GetDataReferenceLocation();
+    const char* location = pLocationProperty->GetValue();
+
+    if (GetNumberOfSamples() == 0) {
+        // the self-contained flag decides how samples are read back, so
+        // it has to match the location before the file is written
+        MP4Atom& urlAtom = pLocationProperty->GetParentAtom();
+        if (url) {
+            urlAtom.SetFlags(urlAtom.GetFlags() & 0xFFFFFE);
+        } else {
+            urlAtom.SetFlags(urlAtom.GetFlags() | 1);
+        }
+
+        pLocationProperty->SetValue(url);
+        m_externalDataRef = url != NULL;
+        InvalidateSampleFileRefs();
+    } else if ((url == NULL) != (location == NULL) ||
+               (url && strcmp(url, location))) {
+        throw new EXCEPTION("sample data reference differs from rest of track");
+    }
+
+    if (m_pChunkOffsetProperty->GetType() == Integer32Property &&
+            fileOffset + numBytes > 0xFFFFFFFF) {
+        throw new EXCEPTION("referenced sample offset requires 64-bit chunk offsets");
+    }
+
+    WriteChunkBuffer();
+
+    if (duration == MP4_INVALID_DURATION) {
+        duration = GetFixedSampleDuration();
+    }
+
+    // samples contiguous in the referenced file share a chunk
+    if (m_refChunkSamples == 0 || fileOffset != m_refChunkEnd) {
+        FinishReferenceChunk();
+        UpdateChunkOffsets(fileOffset);
+    }
+    m_refChunkSamples++;
+    m_refChunkEnd = fileOffset + numBytes;
+
+    UpdateSampleSizes(m_writeSampleId, numBytes);
+
+    UpdateSampleTimes(duration);
+
+    UpdateRenderingOffsets(m_writeSampleId, renderingOffset);
+
+    UpdateSyncSamples(m_writeSampleId, isSyncSample);
+
+    UpdateDurations(duration);
+
+    UpdateModificationTimes();
+
+    m_writeSampleId++;
+}
+
+void MP4Track::FinishReferenceChunk()
+{
+    if (m_refChunkSamples == 0) {
+        return;
+    }
+
+    // the chunk offset was recorded when the chunk was started
+    UpdateSampleToChunk(m_writeSampleId - 1,
+                        m_pChunkCountProperty->GetValue(),
+                        m_refChunkSamples);
+
+    m_refChunkSamples = 0;
+    m_refChunkEnd = 0;
+}
+
+MP4StringProperty* MP4Track::GetDataReferenceLocation()
+{
+    MP4Atom* pDrefAtom = m_trakAtom.FindAtom( "trak.mdia.minf.dinf.dref" );
+    MP4Atom* pUrlAtom = pDrefAtom ? pDrefAtom->GetChildAtom( 0 ) : NULL;
+
+    MP4StringProperty* pLocationProperty = NULL;
+    if( !pUrlAtom || !strequal( pUrlAtom->GetType(), "url " ) ||
+        !pUrlAtom->FindProperty( "*.location", (MP4Property**)&pLocationProperty ) ||
+        !pLocationProperty )
+    {
+        throw new EXCEPTION("track has no url data reference");
+    }
+
+    return pLocationProperty;
+}
+
 void MP4Track::WriteChunkBuffer()
 {
     if (m_sizeOfDataInChunkBuffer == 0) {
@@ -499,12 +779,13 @@ void MP4Track::WriteChunkBuffer()
     // write chunk buffer
     m_File.WriteBytes(m_pChunkBuffer, m_sizeOfDataInChunkBuffer);
 
-    log.verbose3f("\"%s\": WriteChunk: track %u offset 0x%" PRIx64 " size %u (0x%x) numSamples %u",
+    LOG_VERBOSE3F("\"%s\": WriteChunk: track %u offset 0x%" PRIx64 " size %u (0x%x) numSamples %u",
                   GetFile().GetFilename().c_str(), 
                   m_trackId, chunkOffset, m_sizeOfDataInChunkBuffer,
                   m_sizeOfDataInChunkBuffer, m_chunkSamples);
 
-    UpdateSampleToChunk(m_writeSampleId,
+    // the buffer holds the samples up to the last one written
+    UpdateSampleToChunk(m_writeSampleId - 1,
                         m_pChunkCountProperty->GetValue() + 1,
                         m_chunkSamples);
 
@@ -521,6 +802,8 @@ void MP4Track::FinishWrite(uint32_t options)
 {
     FinishSdtp();
 
+    FinishReferenceChunk();
+
     // write out any remaining samples in chunk buffer
     WriteChunkBuffer();
 
@@ -627,6 +910,13 @@ uint32_t MP4Track::GetNumberOfSamples()
     return m_pStszSampleCountProperty->GetValue();
 }
 
+// Samples whose chunk is recorded in the tables; the last samples written
+// may still wait in the chunk buffer or an open reference chunk.
+uint32_t MP4Track::GetNumberOfChunkedSamples()
+{
+    return GetNumberOfSamples() - m_chunkSamples - m_refChunkSamples;
+}
+
 uint32_t MP4Track::GetSampleSize(MP4SampleId sampleId)
 {
     if (m_pStszFixedSampleSizeProperty != NULL) {
@@ -790,6 +1080,57 @@ void MP4Track::UpdateSampleSizes(MP4SampleId sampleId, uint32_t numBytes)
     m_pStszSampleCountProperty->IncrementValue();
 }
 
+// Same as calling UpdateSampleSizes() for each of numSamples samples
+// starting at sampleId, but the stsz table grows in a single append.
+void MP4Track::UpdateSampleSizes(MP4SampleId sampleId,
+                                 const uint32_t* pSizes, uint32_t numSamples)
+{
+    if (numSamples == 0) {
+        return;
+    }
+
+    // scaled and compact sizes take the per-sample path
+    if (m_bytesPerSample > 1 ||
+            m_pStszSampleSizeProperty->GetType() != Integer32Property) {
+        for (uint32_t i = 0; i < numSamples; i++) {
+            UpdateSampleSizes(sampleId + i, pSizes[i]);
+        }
+        return;
+    }
+
+    uint32_t samples = GetNumberOfSamples();
+    uint32_t fixedSampleSize = 0;
+    if (m_pStszFixedSampleSizeProperty != NULL) {
+        fixedSampleSize = samples ?
+                          m_pStszFixedSampleSizeProperty->GetValue() : pSizes[0];
+    }
+
+    // the table stays implicit while every sample has the fixed size
+    uint32_t i = 0;
+    while (fixedSampleSize && i < numSamples && pSizes[i] == fixedSampleSize) {
+        i++;
+    }
+
+    if (i == numSamples) {
+        m_pStszFixedSampleSizeProperty->SetValue(fixedSampleSize);
+    } else {
+        if (m_pStszFixedSampleSizeProperty != NULL) {
+            m_pStszFixedSampleSizeProperty->SetValue(0);
+        }
+
+        // sizes of earlier samples of a fixed size track become explicit
+        if (samples && fixedSampleSize) {
+            vector<uint32_t> fixedSizes(samples, fixedSampleSize);
+            ((MP4Integer32Property*)m_pStszSampleSizeProperty)->
+            AddValues(&fixedSizes[0], samples);
+        }
+        ((MP4Integer32Property*)m_pStszSampleSizeProperty)->
+        AddValues(pSizes, numSamples);
+    }
+
+    m_pStszSampleCountProperty->IncrementValue(numSamples);
+}
+
 uint32_t MP4Track::GetAvgBitrate()
 {
     if (GetDuration() == 0) {
@@ -883,14 +1224,61 @@ uint32_t MP4Track::GetSampleStscIndex(MP4SampleId sampleId)
     return stscIndex;
 }
 
-File* MP4Track::GetSampleFile( MP4SampleId sampleId )
+const MP4Track::SampleFileRef& MP4Track::GetSampleFileRef( MP4SampleId sampleId )
+{
+    // an open reference chunk gets the first sample description when it
+    // is recorded, see UpdateSampleToChunk()
+    uint32_t stsdIndex = 1;
+    if( sampleId <= GetNumberOfChunkedSamples() ) {
+        uint32_t stscIndex = GetSampleStscIndex( sampleId );
+        stsdIndex = m_pStscSampleDescrIndexProperty->GetValue( stscIndex );
+    }
+
+    // the dref of each stsd entry is only resolved once
+    if( !m_lastStsdIndex || stsdIndex != m_lastStsdIndex ) {
+        map<uint32_t, SampleFileRef>::iterator it = m_sampleFileRefs.find( stsdIndex );
+        if( it == m_sampleFileRefs.end() )
+            it = m_sampleFileRefs.insert( make_pair( stsdIndex, ResolveSampleFile( stsdIndex ))).first;
+
+        m_lastStsdIndex = stsdIndex;
+        m_lastSampleFileRef = &it->second;
+    }
+
+    return *m_lastSampleFileRef;
+}
+
+// Sets file to NULL for samples in this file.
+MP4Error MP4Track::GetSampleFile( MP4SampleId sampleId, File*& file )
+{
+    const SampleFileRef& ref = GetSampleFileRef( sampleId );
+
+    file = NULL;
+    switch( ref.location ) {
+        case SampleFileRef::LOCAL:
+            return MP4_ERROR_NONE;
+
+        case SampleFileRef::EXTERNAL:
+            // open external files are shared, and limited, per MP4File
+            file = m_File.GetExternalFile( ref.path );
+            return file ? MP4_ERROR_NONE : MP4_ERROR_INACCESSIBLE_FILE;
+
+        default:
+            return MP4_ERROR_INACCESSIBLE_FILE;
+    }
+}
+
+// Forgets the resolved data references, after they have been changed.
+void MP4Track::InvalidateSampleFileRefs()
 {
-    uint32_t stscIndex = GetSampleStscIndex( sampleId );
-    uint32_t stsdIndex = m_pStscSampleDescrIndexProperty->GetValue( stscIndex );
+    m_sampleFileRefs.clear();
+    m_lastStsdIndex = 0;
+    m_lastSampleFileRef = NULL;
+}
 
-    // check if the answer will be the same as last time
-    if( m_lastStsdIndex && stsdIndex == m_lastStsdIndex )
-        return m_lastSampleFile;
+MP4Track::SampleFileRef MP4Track::ResolveSampleFile( uint32_t stsdIndex )
+{
+    SampleFileRef ref;
+    ref.location = SampleFileRef::LOCAL;
 
     MP4Atom* pStsdAtom = m_trakAtom.FindAtom( "trak.mdia.minf.stbl.stsd" );
     ASSERT( pStsdAtom );
@@ -910,11 +1298,11 @@ File* MP4Track::GetSampleFile( MP4SampleId sampleId )
 
         // MOV spec does not require "ftyp" atom...
         if ( pFtypAtom == NULL )
-            return NULL;
+            return ref;
 
         // ... but most often it is present with a "qt  " value
         if ( strequal( pFtypAtom->majorBrand.GetValue(), "qt  " ) )
-            return NULL;
+            return ref;
 
         throw new EXCEPTION("invalid stsd entry");
     }
@@ -927,55 +1315,71 @@ File* MP4Track::GetSampleFile( MP4SampleId sampleId )
     MP4Atom* pUrlAtom = pDrefAtom->GetChildAtom( drefIndex - 1 );
     ASSERT( pUrlAtom );
 
-    File* file;
-
     // make sure this is actually a url atom (somtimes it's "cios", like in iTunes videos)
     if( !strequal(pUrlAtom->GetType(), "url ") ||
         pUrlAtom->GetFlags() & 1 ) {
-        file = NULL; // self-contained
+        return ref; // self-contained
     }
-    else {
-        MP4StringProperty* pLocationProperty = NULL;
-        ASSERT( pUrlAtom->FindProperty( "*.location", (MP4Property**)&pLocationProperty) );
-        ASSERT( pLocationProperty );
 
-        const char* url = pLocationProperty->GetValue();
+    MP4StringProperty* pLocationProperty = NULL;
+    ASSERT( pUrlAtom->FindProperty( "*.location", (MP4Property**)&pLocationProperty) );
+    ASSERT( pLocationProperty );
 
-        log.verbose3f("\"%s\": dref url = %s", GetFile().GetFilename().c_str(), 
-                      url);
+    const char* url = pLocationProperty->GetValue();
 
-        file = (File*)-1;
+    LOG_VERBOSE3F("\"%s\": dref url = %s", GetFile().GetFilename().c_str(),
+                  url);
 
-        // attempt to open url if it's a file url
-        // currently this is the only thing we understand
-        if( strnequal( url, "file:", 5 )) {
-            const char* fileName = url + 5;
+    ref.location = SampleFileRef::UNSUPPORTED;
 
-            if( strnequal(fileName, "//", 2 ))
-                fileName = strchr( fileName + 2, '/' );
+    // file urls are currently the only thing we understand
+    if( strnequal( url, "file:", 5 )) {
+        const char* fileName = url + 5;
 
-            if( fileName ) {
-                file = new File( fileName, File::MODE_READ );
-                if( !file->open() ) {
-                    delete file;
-                    file = (File*)-1;
-                }
-            }
+        if( strnequal(fileName, "//", 2 ))
+            fileName = strchr( fileName + 2, '/' );
+
+        if( fileName ) {
+            ref.location = SampleFileRef::EXTERNAL;
+            ref.path = fileName;
         }
     }
 
-    if( m_lastSampleFile )
-        m_lastSampleFile->close();
-
-    // cache the answer
-    m_lastStsdIndex = stsdIndex;
-    m_lastSampleFile = file;
+    return ref;
+}
 
-    return file;
+bool MP4Track::IsSampleInFile(MP4SampleId sampleId)
+{
+    return GetSampleFileRef(sampleId).location == SampleFileRef::LOCAL;
 }
 
 uint64_t MP4Track::GetSampleFileOffset(MP4SampleId sampleId)
 {
+    uint64_t fileOffset;
+
+    MP4Error error = TryGetSampleFileOffset( sampleId, fileOffset );
+    if( error != MP4_ERROR_NONE )
+        throw new EXCEPTION(ErrorString(error));
+
+    return fileOffset;
+}
+
+MP4Error MP4Track::TryGetSampleFileOffset(MP4SampleId sampleId, uint64_t& fileOffset)
+{
+    // the samples of a reference chunk still being collected have no stsc
+    // entry yet, they follow each other from the chunk's recorded offset
+    MP4SampleId firstRefSampleId = GetNumberOfChunkedSamples() + 1;
+    if (m_refChunkSamples && sampleId >= firstRefSampleId) {
+        fileOffset = m_pChunkOffsetProperty->GetValue(m_pChunkCountProperty->GetValue() - 1);
+        for (MP4SampleId i = firstRefSampleId; i < sampleId; i++) {
+            fileOffset += GetSampleSize(i);
+        }
+        return MP4_ERROR_NONE;
+    }
+
+    if (m_pStscCountProperty->GetValue() == 0)
+        return MP4_ERROR_CORRUPT;
+
     uint32_t stscIndex =
         GetSampleStscIndex(sampleId);
 
@@ -992,13 +1396,16 @@ uint64_t MP4Track::GetSampleFileOffset(MP4SampleId sampleId)
         m_pStscSamplesPerChunkProperty->GetValue(stscIndex);
 
     if (samplesPerChunk == 0)
-        throw new EXCEPTION("Invalid number of samples in stsc entry");
+        return MP4_ERROR_CORRUPT;
 
     // chunkId tells which is the absolute chunk number that this sample
     // is stored in.
     MP4ChunkId chunkId = firstChunk +
                          ((sampleId - firstSample) / samplesPerChunk);
 
+    if (chunkId == 0 || chunkId > m_pChunkOffsetProperty->GetCount())
+        return MP4_ERROR_CORRUPT;
+
     // chunkOffset is the file offset (absolute) for the start of the chunk
     uint64_t chunkOffset = m_pChunkOffsetProperty->GetValue(chunkId - 1);
 
@@ -1022,7 +1429,8 @@ uint64_t MP4Track::GetSampleFileOffset(MP4SampleId sampleId)
     m_cachedSfoSampleId = sampleId;
     m_cachedSfoSampleOffset = sampleOffset;
 
-    return chunkOffset + sampleOffset;
+    fileOffset = chunkOffset + sampleOffset;
+    return MP4_ERROR_NONE;
 }
 
 void MP4Track::UpdateSampleToChunk(MP4SampleId sampleId,
@@ -1082,6 +1490,46 @@ void MP4Track::SetFixedSampleDuration(MP4Duration duration)
     return;
 }
 
+void MP4Track::InvalidateSttsIndex()
+{
+    m_sttsEnds.clear();
+    m_cachedSttsIndex = 0;
+    m_cachedSttsSid = MP4_INVALID_SAMPLE_ID;
+}
+
+// Writing samples only appends entries, and all but the last one are
+// final, so the index is extended rather than rebuilt. Entries changed in
+// place must be followed by InvalidateSttsIndex().
+void MP4Track::UpdateSttsIndex()
+{
+    uint32_t numStts = m_pSttsCountProperty->GetValue();
+
+    while (m_sttsEnds.size() + 1 < numStts) {
+        uint32_t sttsIndex = (uint32_t)m_sttsEnds.size();
+        MP4SampleId sampleCount =
+            m_pSttsSampleCountProperty->GetValue(sttsIndex);
+        MP4Duration sampleDelta =
+            m_pSttsSampleDeltaProperty->GetValue(sttsIndex);
+
+        if (sampleDelta == 0) {
+            log.warningf("%s: \"%s\": Zero sample duration, stts entry %u",
+                         __FUNCTION__, GetFile().GetFilename().c_str(), sttsIndex);
+        }
+
+        MP4Timestamp elapsed = sttsIndex ? m_sttsEnds.back().first : 0;
+        MP4SampleId sid = sttsIndex ? m_sttsEnds.back().second : 1;
+
+        m_sttsEnds.push_back(make_pair(elapsed + sampleCount * sampleDelta,
+                                       sid + sampleCount));
+    }
+}
+
+static bool SttsEndSampleIdLess(MP4SampleId sampleId,
+                                const pair<MP4Timestamp, MP4SampleId>& sttsEnd)
+{
+    return sampleId < sttsEnd.second;
+}
+
 void MP4Track::GetSampleTimes(MP4SampleId sampleId,
                               MP4Timestamp* pStartTime, MP4Duration* pDuration)
 {
@@ -1090,13 +1538,22 @@ void MP4Track::GetSampleTimes(MP4SampleId sampleId,
     MP4Duration elapsed;
 
 
-    if (m_cachedSttsSid != MP4_INVALID_SAMPLE_ID && sampleId >= m_cachedSttsSid) {
+    UpdateSttsIndex();
+
+    if (m_cachedSttsSid != MP4_INVALID_SAMPLE_ID && sampleId >= m_cachedSttsSid
+            && (m_cachedSttsIndex + 1 >= m_sttsEnds.size()
+                || sampleId < m_sttsEnds[m_cachedSttsIndex + 1].second)) {
         sid   = m_cachedSttsSid;
         elapsed   = m_cachedSttsElapsed;
     } else {
-        m_cachedSttsIndex = 0;
-        sid   = 1;
-        elapsed   = 0;
+        // not in or right after the cached entry, look it up
+        vector< pair<MP4Timestamp, MP4SampleId> >::iterator it =
+            upper_bound(m_sttsEnds.begin(), m_sttsEnds.end(), sampleId,
+                        SttsEndSampleIdLess);
+
+        m_cachedSttsIndex = (uint32_t)(it - m_sttsEnds.begin());
+        sid   = m_cachedSttsIndex ? (it - 1)->second : 1;
+        elapsed   = m_cachedSttsIndex ? (it - 1)->first : 0;
     }
 
     for (uint32_t sttsIndex = m_cachedSttsIndex; sttsIndex < numStts; sttsIndex++) {
@@ -1132,45 +1589,60 @@ MP4SampleId MP4Track::GetSampleIdFromTime(
     MP4Timestamp when,
     bool wantSyncSample)
 {
-    uint32_t numStts = m_pSttsCountProperty->GetValue();
-    MP4SampleId sid = 1;
-    MP4Duration elapsed = 0;
+    MP4SampleId sampleId;
 
-    for (uint32_t sttsIndex = 0; sttsIndex < numStts; sttsIndex++) {
-        MP4SampleId sampleCount =
-            m_pSttsSampleCountProperty->GetValue(sttsIndex);
-        MP4Duration sampleDelta =
-            m_pSttsSampleDeltaProperty->GetValue(sttsIndex);
+    MP4Error error = TryGetSampleIdFromTime( when, wantSyncSample, sampleId );
+    if( error != MP4_ERROR_NONE )
+        throw new EXCEPTION(ErrorString(error));
 
-        if (sampleDelta == 0 && sttsIndex < numStts - 1) {
-            log.warningf("%s: \"%s\": Zero sample duration, stts entry %u",
-                         __FUNCTION__, GetFile().GetFilename().c_str(), sttsIndex);
-        }
+    return sampleId;
+}
 
-        MP4Duration d = when - elapsed;
+MP4Error MP4Track::TryGetSampleIdFromTime(
+    MP4Timestamp when,
+    bool wantSyncSample,
+    MP4SampleId& sampleId)
+{
+    uint32_t numStts = m_pSttsCountProperty->GetValue();
 
-        if (d <= sampleCount * sampleDelta) {
-            MP4SampleId sampleId = sid;
-            if (sampleDelta) {
-                sampleId += (d / sampleDelta);
-            }
+    if (numStts == 0) {
+        return MP4_ERROR_TIME_OUT_OF_RANGE;
+    }
 
-            if (wantSyncSample) {
-                return GetNextSyncSample(sampleId);
-            }
-            return sampleId;
-        }
+    UpdateSttsIndex();
 
-        sid += sampleCount;
-        elapsed += sampleCount * sampleDelta;
-    }
+    // the first entry that ends at or after 'when'
+    uint32_t sttsIndex = (uint32_t)(lower_bound(m_sttsEnds.begin(), m_sttsEnds.end(),
+                                                make_pair(when, (MP4SampleId)0))
+                                    - m_sttsEnds.begin());
+
+    MP4Duration elapsed = sttsIndex ? m_sttsEnds[sttsIndex - 1].first : 0;
+    MP4SampleId sid = sttsIndex ? m_sttsEnds[sttsIndex - 1].second : 1;
+
+    MP4SampleId sampleCount =
+        m_pSttsSampleCountProperty->GetValue(sttsIndex);
+    MP4Duration sampleDelta =
+        m_pSttsSampleDeltaProperty->GetValue(sttsIndex);
+
+    MP4Duration d = when - elapsed;
 
-    throw new EXCEPTION("time out of range");
+    if (d <= sampleCount * sampleDelta) {
+        sampleId = sid;
+        if (sampleDelta) {
+            sampleId += (d / sampleDelta);
+        }
+
+        if (wantSyncSample) {
+            sampleId = GetNextSyncSample(sampleId);
+        }
+        return MP4_ERROR_NONE;
+    }
 
-    return 0; // satisfy MS compiler
+    return MP4_ERROR_TIME_OUT_OF_RANGE;
 }
 
-void MP4Track::UpdateSampleTimes(MP4Duration duration)
+// Records numSamples consecutive samples of the same duration
+void MP4Track::UpdateSampleTimes(MP4Duration duration, uint32_t numSamples)
 {
     uint32_t numStts = m_pSttsCountProperty->GetValue();
 
@@ -1178,11 +1650,11 @@ void MP4Track::UpdateSampleTimes(MP4Duration duration)
     if (numStts
             && duration == m_pSttsSampleDeltaProperty->GetValue(numStts-1)) {
         // increment last entry sampleCount
-        m_pSttsSampleCountProperty->IncrementValue(1, numStts-1);
+        m_pSttsSampleCountProperty->IncrementValue(numSamples, numStts-1);
 
     } else {
-        // add stts entry, sampleCount = 1, sampleDuration = duration
-        m_pSttsSampleCountProperty->AddValue(1);
+        // add stts entry, sampleCount = numSamples, sampleDuration = duration
+        m_pSttsSampleCountProperty->AddValue(numSamples);
         m_pSttsSampleDeltaProperty->AddValue(duration);
         m_pSttsCountProperty->IncrementValue();;
     }
@@ -1235,8 +1707,11 @@ MP4Duration MP4Track::GetSampleRenderingOffset(MP4SampleId sampleId)
     return m_pCttsSampleOffsetProperty->GetValue(cttsIndex);
 }
 
+// Records numSamples consecutive samples, starting at sampleId, of the
+// same rendering offset
 void MP4Track::UpdateRenderingOffsets(MP4SampleId sampleId,
-                                      MP4Duration renderingOffset)
+                                      MP4Duration renderingOffset,
+                                      uint32_t numSamples)
 {
     // if ctts atom doesn't exist
     if (m_pCttsCountProperty == NULL) {
@@ -1281,11 +1756,11 @@ void MP4Track::UpdateRenderingOffsets(MP4SampleId sampleId,
             == m_pCttsSampleOffsetProperty->GetValue(numCtts-1)) {
 
         // increment last entry sampleCount
-        m_pCttsSampleCountProperty->IncrementValue(1, numCtts-1);
+        m_pCttsSampleCountProperty->IncrementValue(numSamples, numCtts-1);
 
     } else {
-        // add ctts entry, sampleCount = 1, sampleOffset = renderingOffset
-        m_pCttsSampleCountProperty->AddValue(1);
+        // add ctts entry, sampleCount = numSamples, sampleOffset = renderingOffset
+        m_pCttsSampleCountProperty->AddValue(numSamples);
         m_pCttsSampleOffsetProperty->AddValue(renderingOffset);
         m_pCttsCountProperty->IncrementValue();
     }
@@ -1416,8 +1891,11 @@ bool MP4Track::IsSyncSample(MP4SampleId sampleId)
 
         if (sampleId > syncSampleId) {
             stssLIndex = stssIndex + 1;
-        } else {
+        } else if (stssIndex > stssLIndex) {
             stssRIndex = stssIndex - 1;
+        } else {
+            // before the first sync sample, don't wrap below index 0
+            break;
         }
     }
 
@@ -1448,13 +1926,46 @@ MP4SampleId MP4Track::GetNextSyncSample(MP4SampleId sampleId)
     return MP4_INVALID_SAMPLE_ID;
 }
 
-void MP4Track::UpdateSyncSamples(MP4SampleId sampleId, bool isSyncSample)
+// N.B. "prev" is inclusive of this sample id
+MP4SampleId MP4Track::GetPrevSyncSample(MP4SampleId sampleId)
+{
+    if (m_pStssCountProperty == NULL) {
+        return sampleId;
+    }
+
+    // stss is sorted, find the last entry not after sampleId
+    uint32_t stssLIndex = 0;
+    uint32_t stssRIndex = m_pStssCountProperty->GetValue();
+
+    while (stssLIndex < stssRIndex) {
+        uint32_t stssIndex = (stssLIndex + stssRIndex) >> 1;
+        if (m_pStssSampleProperty->GetValue(stssIndex) <= sampleId) {
+            stssLIndex = stssIndex + 1;
+        } else {
+            stssRIndex = stssIndex;
+        }
+    }
+
+    if (stssLIndex == 0) {
+        return MP4_INVALID_SAMPLE_ID;
+    }
+    return m_pStssSampleProperty->GetValue(stssLIndex - 1);
+}
+
+// Records numSamples consecutive samples, starting at sampleId, that are
+// all sync samples or all not
+void MP4Track::UpdateSyncSamples(MP4SampleId sampleId, bool isSyncSample,
+                                 uint32_t numSamples)
 {
     if (isSyncSample) {
-        // if stss atom exists, add entry
+        // if stss atom exists, add entries
         if (m_pStssCountProperty) {
-            m_pStssSampleProperty->AddValue(sampleId);
-            m_pStssCountProperty->IncrementValue();
+            vector<uint32_t> sampleIds(numSamples);
+            for (uint32_t i = 0; i < numSamples; i++) {
+                sampleIds[i] = sampleId + i;
+            }
+            m_pStssSampleProperty->AddValues(&sampleIds[0], numSamples);
+            m_pStssCountProperty->IncrementValue(numSamples);
         } // else nothing to do (yet)
 
     } else { // !isSyncSample
@@ -1472,8 +1983,7 @@ void MP4Track::UpdateSyncSamples(MP4SampleId sampleId, bool isSyncSample)
                        (MP4Property**)&m_pStssSampleProperty));
 
             // set values for all samples that came before this one
-            uint32_t samples = GetNumberOfSamples();
-            for (MP4SampleId sid = 1; sid < samples; sid++) {
+            for (MP4SampleId sid = 1; sid < sampleId; sid++) {
                 m_pStssSampleProperty->AddValue(sid);
                 m_pStssCountProperty->IncrementValue();
             }
@@ -1618,27 +2128,18 @@ void MP4Track::ReadChunk(MP4ChunkId chunkId,
     *pChunkSize = GetChunkSize(chunkId);
     *ppChunk = (uint8_t*)MP4Malloc(*pChunkSize);
 
-    log.verbose3f("\"%s\": ReadChunk: track %u id %u offset 0x%" PRIx64 " size %u (0x%x)",
+    LOG_VERBOSE3F("\"%s\": ReadChunk: track %u id %u offset 0x%" PRIx64 " size %u (0x%x)",
                   GetFile().GetFilename().c_str(),
                   m_trackId, chunkId, chunkOffset, *pChunkSize, *pChunkSize);
 
-    uint64_t oldPos = m_File.GetPosition(); // only used in mode == 'w'
     try {
-        m_File.SetPosition( chunkOffset );
-        m_File.ReadBytes( *ppChunk, *pChunkSize );
+        m_File.ReadBytesAt( chunkOffset, *ppChunk, *pChunkSize );
     }
     catch( Exception* ) {
         MP4Free( *ppChunk );
         *ppChunk = NULL;
-
-        if( m_File.IsWriteMode() )
-            m_File.SetPosition( oldPos );
-
         throw;
     }
-
-    if( m_File.IsWriteMode() )
-        m_File.SetPosition( oldPos );
 }
 
 void MP4Track::RewriteChunk(MP4ChunkId chunkId,
@@ -1650,11 +2151,508 @@ void MP4Track::RewriteChunk(MP4ChunkId chunkId,
 
     m_pChunkOffsetProperty->SetValue(chunkOffset, chunkId - 1);
 
-    log.verbose3f("\"%s\": RewriteChunk: track %u id %u offset 0x%" PRIx64 " size %u (0x%x)",
+    LOG_VERBOSE3F("\"%s\": RewriteChunk: track %u id %u offset 0x%" PRIx64 " size %u (0x%x)",
                   GetFile().GetFilename().c_str(),
                   m_trackId, chunkId, chunkOffset, chunkSize, chunkSize);
 }
 
+// The chunk copy below is the straight (no edits) MP4CopyTrack path. Whole
+// source chunks are moved as byte ranges and the sample tables are appended
+// a table entry at a time rather than a sample at a time.
+
+bool MP4Track::CanCopyChunksFrom(MP4Track& srcTrack)
+{
+    // tables are appended from scratch, and sizes are copied verbatim
+    if (GetNumberOfSamples() != 0 || m_writeSampleId != 1 ||
+            m_bytesPerSample != srcTrack.m_bytesPerSample ||
+            (srcTrack.m_pChunkBuffer && srcTrack.m_sizeOfDataInChunkBuffer)) {
+        return false;
+    }
+
+    uint32_t numStscs = srcTrack.m_pStscCountProperty->GetValue();
+    if (numStscs == 0 || srcTrack.GetNumberOfSamples() == 0) {
+        return false;
+    }
+
+    // all media must be in the source file itself
+    for (uint32_t stscIndex = 0; stscIndex < numStscs; stscIndex++) {
+        MP4SampleId firstSample =
+            srcTrack.m_pStscFirstSampleProperty->GetValue(stscIndex);
+        if (!srcTrack.IsSampleInFile(firstSample)) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+void MP4Track::CopyChunksFrom(MP4Track& srcTrack)
+{
+    uint32_t numStscs = srcTrack.m_pStscCountProperty->GetValue();
+    uint32_t numChunks = srcTrack.GetNumberOfChunks();
+    MP4SampleId numSamples = srcTrack.GetNumberOfSamples();
+
+    MP4File& srcFile = srcTrack.m_File;
+    uint8_t* pChunk = NULL;
+    uint32_t chunkBufferSize = 0;
+
+    // stsz, appended as one block
+    vector<uint32_t> sampleSizes(numSamples);
+    for (MP4SampleId sampleId = 1; sampleId <= numSamples; sampleId++) {
+        sampleSizes[sampleId - 1] = srcTrack.GetSampleSize(sampleId);
+    }
+    UpdateSampleSizes(m_writeSampleId, &sampleSizes[0], numSamples);
+
+    MP4SampleId srcSampleId = 1;
+
+    try {
+        for (uint32_t stscIndex = 0; stscIndex < numStscs; stscIndex++) {
+            MP4ChunkId firstChunk =
+                srcTrack.m_pStscFirstChunkProperty->GetValue(stscIndex);
+            MP4ChunkId lastChunk = (stscIndex + 1 < numStscs) ?
+                srcTrack.m_pStscFirstChunkProperty->GetValue(stscIndex + 1) - 1 :
+                numChunks;
+            uint32_t samplesPerChunk =
+                srcTrack.m_pStscSamplesPerChunkProperty->GetValue(stscIndex);
+
+            if (samplesPerChunk == 0 || lastChunk > numChunks) {
+                throw new EXCEPTION("Invalid stsc entry");
+            }
+
+            for (MP4ChunkId chunkId = firstChunk; chunkId <= lastChunk; chunkId++) {
+                if (srcSampleId + samplesPerChunk - 1 > numSamples) {
+                    throw new EXCEPTION("stsc describes more samples than stsz");
+                }
+
+                uint32_t chunkSize = 0;
+                for (uint32_t i = 0; i < samplesPerChunk; i++) {
+                    chunkSize += sampleSizes[srcSampleId - 1 + i];
+                }
+
+                if (chunkSize > chunkBufferSize) {
+                    pChunk = (uint8_t*)MP4Realloc(pChunk, chunkSize);
+                    chunkBufferSize = chunkSize;
+                }
+
+                // read the source chunk without disturbing the write
+                // position in case source and destination are the same file
+                srcFile.ReadBytesAt(srcTrack.m_pChunkOffsetProperty->GetValue(chunkId - 1),
+                                    pChunk, chunkSize);
+
+                uint64_t chunkOffset = m_File.GetPosition();
+                m_File.WriteBytes(pChunk, chunkSize);
+
+                LOG_VERBOSE3F("\"%s\": CopyChunk: track %u chunk %u offset 0x%" PRIx64 " size %u (0x%x) numSamples %u",
+                              GetFile().GetFilename().c_str(),
+                              m_trackId, chunkId, chunkOffset, chunkSize, chunkSize,
+                              samplesPerChunk);
+
+                m_writeSampleId += samplesPerChunk;
+                srcSampleId += samplesPerChunk;
+
+                UpdateSampleToChunk(m_writeSampleId - 1,
+                                    m_pChunkCountProperty->GetValue() + 1,
+                                    samplesPerChunk);
+                UpdateChunkOffsets(chunkOffset);
+            }
+        }
+    }
+    catch (Exception*) {
+        MP4Free(pChunk);
+        throw;
+    }
+    MP4Free(pChunk);
+
+    if (srcSampleId != numSamples + 1) {
+        throw new EXCEPTION("stsc describes fewer samples than stsz");
+    }
+
+    // stts, one update per run
+    MP4Duration duration = 0;
+    uint32_t numStts = srcTrack.m_pSttsCountProperty->GetValue();
+    for (uint32_t sttsIndex = 0; sttsIndex < numStts; sttsIndex++) {
+        uint32_t sampleCount =
+            srcTrack.m_pSttsSampleCountProperty->GetValue(sttsIndex);
+        uint32_t sampleDelta =
+            srcTrack.m_pSttsSampleDeltaProperty->GetValue(sttsIndex);
+        if (sampleCount == 0) {
+            continue;
+        }
+
+        UpdateSampleTimes(sampleDelta, sampleCount);
+        duration += (MP4Duration)sampleCount * sampleDelta;
+    }
+
+    // ctts, one update per run
+    if (srcTrack.m_pCttsCountProperty) {
+        uint32_t numCtts = srcTrack.m_pCttsCountProperty->GetValue();
+        MP4SampleId sampleId = 1;
+        for (uint32_t cttsIndex = 0; cttsIndex < numCtts; cttsIndex++) {
+            uint32_t sampleCount =
+                srcTrack.m_pCttsSampleCountProperty->GetValue(cttsIndex);
+            uint32_t sampleOffset =
+                srcTrack.m_pCttsSampleOffsetProperty->GetValue(cttsIndex);
+            if (sampleCount == 0) {
+                continue;
+            }
+
+            UpdateRenderingOffsets(sampleId, sampleOffset, sampleCount);
+            sampleId += sampleCount;
+        }
+    }
+
+    // stss, copied as a block; no stss means every sample is a sync sample
+    if (srcTrack.m_pStssCountProperty) {
+        if (m_pStssCountProperty == NULL) {
+            MP4Atom* pStssAtom = AddAtom("trak.mdia.minf.stbl", "stss");
+
+            ASSERT(pStssAtom->FindProperty(
+                       "stss.entryCount",
+                       (MP4Property**)&m_pStssCountProperty));
+
+            ASSERT(pStssAtom->FindProperty(
+                       "stss.entries.sampleNumber",
+                       (MP4Property**)&m_pStssSampleProperty));
+        }
+
+        uint32_t numStss = srcTrack.m_pStssCountProperty->GetValue();
+        if (numStss) {
+            vector<uint32_t> syncSamples(numStss);
+            for (uint32_t stssIndex = 0; stssIndex < numStss; stssIndex++) {
+                syncSamples[stssIndex] = srcTrack.m_pStssSampleProperty->GetValue(stssIndex);
+            }
+            m_pStssSampleProperty->AddValues(&syncSamples[0], numStss);
+            m_pStssCountProperty->IncrementValue(numStss);
+        }
+    }
+
+    m_sdtpLog = srcTrack.m_sdtpLog;
+
+    UpdateDurations(duration);
+
+    UpdateModificationTimes();
+}
+
+// MP4File::Remux builds the complete sample tables of a track first, with
+// placeholder chunk offsets, so that moov can be written ahead of the media.
+// The chunks are then filled in, in interleaved order, by WriteRemuxChunk.
+
+MP4ChunkId MP4Track::AddRemuxChunk(MP4Track& srcTrack,
+                                   MP4SampleId srcSampleId, uint32_t numSamples)
+{
+    ASSERT(numSamples);
+
+    if (m_bytesPerSample != srcTrack.m_bytesPerSample) {
+        throw new EXCEPTION("incompatible sample size layout");
+    }
+
+    MP4Duration chunkDuration = 0;
+
+    for (uint32_t i = 0; i < numSamples; i++, srcSampleId++) {
+        MP4Duration sampleDuration;
+        srcTrack.GetSampleTimes(srcSampleId, NULL, &sampleDuration);
+
+        UpdateSampleSizes(m_writeSampleId, srcTrack.GetSampleSize(srcSampleId));
+        UpdateSampleTimes(sampleDuration);
+        UpdateRenderingOffsets(m_writeSampleId,
+                               srcTrack.GetSampleRenderingOffset(srcSampleId));
+        UpdateSyncSamples(m_writeSampleId, srcTrack.IsSyncSample(srcSampleId));
+
+        if (srcSampleId <= srcTrack.m_sdtpLog.size()) {
+            m_sdtpLog.push_back(srcTrack.m_sdtpLog[srcSampleId - 1]);
+        }
+
+        chunkDuration += sampleDuration;
+        m_writeSampleId++;
+    }
+
+    MP4ChunkId chunkId = m_pChunkCountProperty->GetValue() + 1;
+
+    UpdateSampleToChunk(m_writeSampleId - 1, chunkId, numSamples);
+    UpdateChunkOffsets(0);
+
+    UpdateDurations(chunkDuration);
+
+    return chunkId;
+}
+
+void MP4Track::WriteRemuxChunk(MP4ChunkId chunkId, MP4Track& srcTrack,
+                               MP4SampleId srcFirstSampleId)
+{
+    uint32_t chunkSize = GetChunkSize(chunkId);
+    uint32_t stscIndex = GetChunkStscIndex(chunkId);
+    uint32_t numSamples = m_pStscSamplesPerChunkProperty->GetValue(stscIndex);
+
+    // srcFirstSampleId is the source sample that became sample 1 here
+    MP4SampleId srcSampleId = srcFirstSampleId - 1 +
+        m_pStscFirstSampleProperty->GetValue(stscIndex) +
+        (chunkId - m_pStscFirstChunkProperty->GetValue(stscIndex)) * numSamples;
+
+    uint8_t* pChunk = (uint8_t*)MP4Malloc(chunkSize);
+
+    try {
+        srcTrack.ReadSampleRun(srcSampleId, numSamples, pChunk, chunkSize);
+        RewriteChunk(chunkId, pChunk, chunkSize);
+    }
+    catch (Exception*) {
+        MP4Free(pChunk);
+        throw;
+    }
+
+    MP4Free(pChunk);
+}
+
+// Reads numSamples consecutive samples into pDest, back to back. Runs of
+// samples that are contiguous in the file are read with a single read each.
+void MP4Track::ReadSampleRun(MP4SampleId sampleId, uint32_t numSamples,
+                             uint8_t* pDest, uint32_t destSize)
+{
+    // samples still in the write chunk buffer go out first, see ReadSample()
+    if (m_pChunkBuffer && sampleId + numSamples > m_writeSampleId - m_chunkSamples) {
+        WriteChunkBuffer();
+    }
+
+    uint32_t pos = 0;
+    uint64_t runOffset = 0;
+    uint32_t runSize = 0;
+
+    for (uint32_t i = 0; i < numSamples; i++, sampleId++) {
+        uint32_t sampleSize = GetSampleSize(sampleId);
+        if (pos + runSize + sampleSize > destSize) {
+            throw new EXCEPTION("sample size mismatch");
+        }
+
+        if (!IsSampleInFile(sampleId)) {
+            if (runSize) {
+                m_File.ReadBytesAt(runOffset, &pDest[pos], runSize);
+                pos += runSize;
+                runSize = 0;
+            }
+
+            uint8_t* pSample = &pDest[pos];
+            ReadSample(sampleId, &pSample, &sampleSize);
+            pos += sampleSize;
+            continue;
+        }
+
+        uint64_t sampleOffset = GetSampleFileOffset(sampleId);
+        if (runSize && sampleOffset != runOffset + runSize) {
+            m_File.ReadBytesAt(runOffset, &pDest[pos], runSize);
+            pos += runSize;
+            runSize = 0;
+        }
+        if (runSize == 0) {
+            runOffset = sampleOffset;
+        }
+        runSize += sampleSize;
+    }
+
+    if (runSize) {
+        m_File.ReadBytesAt(runOffset, &pDest[pos], runSize);
+    }
+}
+
+// Text samples hold a 16-bit big endian text length followed by the text
+// and possibly modifier boxes, which are skipped. The samples are small
+// and usually stored back to back, so they are read in runs of about 1 MiB.
+void MP4Track::ReadTextSamples(string& texts, vector<uint32_t>& textOffsets,
+                               vector<uint32_t>& textLengths)
+{
+    uint32_t numSamples = GetNumberOfSamples();
+    vector<uint8_t> run;
+    vector<uint32_t> sampleSizes;
+    MP4SampleId sampleId = 1;
+
+    textOffsets.reserve(textOffsets.size() + numSamples);
+    textLengths.reserve(textLengths.size() + numSamples);
+
+    while (sampleId <= numSamples) {
+        MP4SampleId runStart = sampleId;
+        uint32_t runSize = 0;
+
+        sampleSizes.clear();
+        do {
+            sampleSizes.push_back(GetSampleSize(sampleId++));
+            runSize += sampleSizes.back();
+        } while (sampleId <= numSamples && runSize < 1024 * 1024);
+
+        run.resize(max(runSize, (uint32_t)1));
+        ReadSampleRun(runStart, (uint32_t)sampleSizes.size(), &run[0], runSize);
+
+        const uint8_t* sample = &run[0];
+        for (uint32_t k = 0; k < sampleSizes.size(); k++) {
+            uint32_t sampleSize = sampleSizes[k];
+            uint32_t length = 0;
+            if (sampleSize >= 2) {
+                length = min((uint32_t)((sample[0] << 8) | sample[1]), sampleSize - 2);
+            }
+
+            textOffsets.push_back((uint32_t)texts.size());
+            textLengths.push_back(length);
+            texts.append((const char*)sample + 2, length);
+            texts.push_back('\0');
+
+            sample += sampleSize;
+        }
+    }
+}
+
+void MP4Track::GetDecodableSamples(MP4Timestamp startTime, MP4Duration duration,
+                                   vector<MP4DecodableSample>& samples)
+{
+    samples.clear();
+
+    // samples not yet in a chunk have no offset and are left out rather
+    // than flushing them, which would change how the file is laid out
+    MP4SampleId numSamples = GetNumberOfChunkedSamples();
+
+    MP4SampleId sampleId;
+    if (TryGetSampleIdFromTime(startTime, false, sampleId) != MP4_ERROR_NONE
+            || sampleId > numSamples) {
+        return;
+    }
+
+    // decoding starts at the preceding sync sample, or at the first sample
+    // of a track whose leading samples aren't marked as sync samples
+    MP4SampleId firstSampleId = GetPrevSyncSample(sampleId);
+    if (firstSampleId == MP4_INVALID_SAMPLE_ID) {
+        firstSampleId = 1;
+    }
+
+    MP4Timestamp endTime = duration < MP4_INVALID_TIMESTAMP - startTime ?
+                           startTime + duration : MP4_INVALID_TIMESTAMP;
+
+    for (MP4SampleId sid = firstSampleId; sid <= numSamples; sid++) {
+        MP4DecodableSample sample;
+        GetSampleTimes(sid, &sample.startTime, &sample.duration);
+        if (sid > sampleId && sample.startTime >= endTime) {
+            break;
+        }
+
+        sample.isSyncSample = IsSyncSample(sid);
+        if (!sample.isSyncSample && sid <= m_sdtpLog.size() &&
+                ((uint8_t)m_sdtpLog[sid - 1] & (MP4_SDT_HAS_DEPENDENTS | MP4_SDT_HAS_NO_DEPENDENTS))
+                == MP4_SDT_HAS_NO_DEPENDENTS) {
+            continue;
+        }
+
+        sample.sampleId = sid;
+        sample.offset = GetSampleFileOffset(sid);
+        sample.size = GetSampleSize(sid);
+        sample.renderingOffset = GetSampleRenderingOffset(sid);
+        samples.push_back(sample);
+    }
+}
+
+void MP4Track::GetSyncSampleIndex(vector<MP4DecodableSample>& samples)
+{
+    samples.clear();
+
+    // samples not yet in a chunk are left out, see GetDecodableSamples()
+    uint32_t numSamples = GetNumberOfSamples();
+    uint32_t numChunkedSamples = GetNumberOfChunkedSamples();
+    if (numChunkedSamples == 0) {
+        return;
+    }
+
+    uint32_t numSync = m_pStssCountProperty ?
+                       m_pStssCountProperty->GetValue() : numSamples;
+    uint32_t numStts = m_pSttsCountProperty->GetValue();
+    uint32_t numCtts = m_pCttsCountProperty ?
+                       m_pCttsCountProperty->GetValue() : 0;
+    uint32_t numStsc = m_pStscCountProperty->GetValue();
+    if (numStsc == 0) {
+        throw new EXCEPTION("No data chunks exist");
+    }
+
+    // stss, stts, ctts and stsc are all in sample order, so a single cursor
+    // into each table is advanced instead of looking up every sync sample
+    uint32_t sttsIndex = 0;
+    MP4SampleId sttsSampleId = 1;
+    MP4Timestamp sttsElapsed = 0;
+    uint32_t cttsIndex = 0;
+    MP4SampleId cttsSampleId = 1;
+    uint32_t stscIndex = 0;
+    MP4SampleId prevSampleId = 0;
+
+    samples.reserve(numSync);
+
+    for (uint32_t i = 0; i < numSync; i++) {
+        MP4DecodableSample sample;
+        sample.isSyncSample = true;
+        sample.sampleId = m_pStssCountProperty ?
+                          m_pStssSampleProperty->GetValue(i) : i + 1;
+
+        if (sample.sampleId <= prevSampleId || sample.sampleId > numSamples) {
+            throw new EXCEPTION("invalid sync sample table");
+        }
+        if (sample.sampleId > numChunkedSamples) {
+            break;
+        }
+        prevSampleId = sample.sampleId;
+
+        for (;;) {
+            if (sttsIndex == numStts) {
+                throw new EXCEPTION("sample id out of range");
+            }
+            uint32_t sampleCount = m_pSttsSampleCountProperty->GetValue(sttsIndex);
+            MP4Duration sampleDelta = m_pSttsSampleDeltaProperty->GetValue(sttsIndex);
+
+            if (sample.sampleId < sttsSampleId + sampleCount) {
+                sample.startTime = sttsElapsed + (sample.sampleId - sttsSampleId) * sampleDelta;
+                sample.duration = sampleDelta;
+                break;
+            }
+            sttsSampleId += sampleCount;
+            sttsElapsed += sampleCount * sampleDelta;
+            sttsIndex++;
+        }
+
+        sample.renderingOffset = 0;
+        if (numCtts > 0) {
+            for (;;) {
+                if (cttsIndex == numCtts) {
+                    throw new EXCEPTION("sample id out of range");
+                }
+                uint32_t sampleCount = m_pCttsSampleCountProperty->GetValue(cttsIndex);
+
+                if (sample.sampleId < cttsSampleId + sampleCount) {
+                    sample.renderingOffset = m_pCttsSampleOffsetProperty->GetValue(cttsIndex);
+                    break;
+                }
+                cttsSampleId += sampleCount;
+                cttsIndex++;
+            }
+        }
+
+        while (stscIndex + 1 < numStsc &&
+                sample.sampleId >= m_pStscFirstSampleProperty->GetValue(stscIndex + 1)) {
+            stscIndex++;
+        }
+
+        uint32_t firstChunk = m_pStscFirstChunkProperty->GetValue(stscIndex);
+        MP4SampleId firstSample = m_pStscFirstSampleProperty->GetValue(stscIndex);
+        uint32_t samplesPerChunk = m_pStscSamplesPerChunkProperty->GetValue(stscIndex);
+        if (samplesPerChunk == 0 || sample.sampleId < firstSample) {
+            throw new EXCEPTION("invalid sample to chunk table");
+        }
+
+        MP4ChunkId chunkId = firstChunk + ((sample.sampleId - firstSample) / samplesPerChunk);
+        if (chunkId == 0 || chunkId > m_pChunkOffsetProperty->GetCount()) {
+            throw new EXCEPTION("invalid sample to chunk table");
+        }
+
+        sample.offset = m_pChunkOffsetProperty->GetValue(chunkId - 1);
+        for (MP4SampleId sid = sample.sampleId - ((sample.sampleId - firstSample) % samplesPerChunk);
+                sid < sample.sampleId; sid++) {
+            sample.offset += GetSampleSize(sid);
+        }
+
+        sample.size = GetSampleSize(sample.sampleId);
+        samples.push_back(sample);
+    }
+}
+
 // map track type name aliases to official names
 
 
@@ -1699,6 +2697,8 @@ bool MP4Track::InitEditListProperties()
 
 MP4EditId MP4Track::AddEdit(MP4EditId editId)
 {
+    InvalidateEditIndex();
+
     if (!m_pElstCountProperty) {
         (void)m_File.AddDescendantAtoms(&m_trakAtom, "edts.elst");
         if (InitEditListProperties() == false) return MP4_INVALID_EDIT_ID;
@@ -1729,6 +2729,8 @@ void MP4Track::DeleteEdit(MP4EditId editId)
         throw new EXCEPTION("no edits exist");
     }
 
+    InvalidateEditIndex();
+
     m_pElstMediaTimeProperty->DeleteValue(editId - 1);
     m_pElstDurationProperty->DeleteValue(editId - 1);
     m_pElstRateProperty->DeleteValue(editId - 1);
@@ -1752,7 +2754,13 @@ void MP4Track::DeleteEdit(MP4EditId editId)
 MP4Timestamp MP4Track::GetEditStart(
     MP4EditId editId)
 {
-    if (editId == MP4_INVALID_EDIT_ID) {
+    uint32_t numEdits = 0;
+
+    if (m_pElstCountProperty) {
+        numEdits = m_pElstCountProperty->GetValue();
+    }
+
+    if (editId == MP4_INVALID_EDIT_ID || editId > numEdits) {
         return MP4_INVALID_TIMESTAMP;
     } else if (editId == 1) {
         return 0;
@@ -1777,14 +2785,55 @@ MP4Duration MP4Track::GetEditTotalDuration(
         return MP4_INVALID_DURATION;
     }
 
-    MP4Duration totalDuration = 0;
+    UpdateEditIndex();
+
+    return m_editEnds[editId - 1];
+}
+
+void MP4Track::UpdateEditIndex()
+{
+    uint32_t numEdits = m_pElstCountProperty->GetValue();
+
+    if (m_editEnds.size() == numEdits) {
+        return;
+    }
+
+    m_editEnds.resize(numEdits);
+
+    MP4Duration editElapsedDuration = 0;
+    for (uint32_t i = 0; i < numEdits; i++) {
+        editElapsedDuration += m_pElstDurationProperty->GetValue(i);
+        m_editEnds[i] = editElapsedDuration;
+    }
+}
+
+// Returns the edit segment that 'editWhen' falls in, or MP4_INVALID_EDIT_ID
+// if it is past the end of the edit list. Walks in edit order check the
+// hinted edit and its successor before falling back to a binary search.
+MP4EditId MP4Track::FindEdit(
+    MP4Timestamp editWhen,
+    MP4EditId hint)
+{
+    UpdateEditIndex();
+
+    uint32_t numEdits = (uint32_t)m_editEnds.size();
+
+    // the first edit whose end lies after 'editWhen'; edits of zero
+    // duration are skipped that way
+    for (MP4EditId editId = hint; editId && editId <= numEdits && editId <= hint + 1; editId++) {
+        MP4Timestamp editStartTime = (editId > 1) ? m_editEnds[editId - 2] : 0;
+        if (editWhen >= editStartTime && editWhen < m_editEnds[editId - 1]) {
+            return editId;
+        }
+    }
 
-    for (MP4EditId eid = 1; eid <= editId; eid++) {
-        totalDuration +=
-            m_pElstDurationProperty->GetValue(eid - 1);
+    vector<MP4Duration>::iterator it =
+        upper_bound(m_editEnds.begin(), m_editEnds.end(), editWhen);
+    if (it == m_editEnds.end()) {
+        return MP4_INVALID_EDIT_ID;
     }
 
-    return totalDuration;
+    return (MP4EditId)(it - m_editEnds.begin()) + 1;
 }
 
 MP4SampleId MP4Track::GetSampleIdFromEditTime(
@@ -1800,111 +2849,154 @@ MP4SampleId MP4Track::GetSampleIdFromEditTime(
     }
 
     if (numEdits) {
-        MP4Duration editElapsedDuration = 0;
+        MP4EditId editId = FindEdit(editWhen);
 
-        for (MP4EditId editId = 1; editId <= numEdits; editId++) {
-            // remember edit segment's start time (in edit timeline)
-            MP4Timestamp editStartTime =
-                (MP4Timestamp)editElapsedDuration;
+        if (editId == MP4_INVALID_EDIT_ID) {
+            throw new EXCEPTION("time out of range");
+        }
 
-            // accumulate edit segment's duration
-            editElapsedDuration +=
-                m_pElstDurationProperty->GetValue(editId - 1);
+        sampleId = GetSampleIdFromEdit(editId, editWhen, pStartTime, pDuration);
 
-            // check whether the specified edit
-            // time is within this edit segment
-            if (editWhen >= editElapsedDuration) {
-                // the specified time has not yet been reached
-                continue;
-            }
+    } else { // no edit list
+        sampleId = GetSampleIdFromTime(editWhen, false);
 
-            // 'editWhen' is within this edit segment
+        if (pStartTime || pDuration) {
+            GetSampleTimes(sampleId, pStartTime, pDuration);
+        }
+    }
 
-            // calculate the specified edit time
-            // relative to just this edit segment
-            MP4Duration editOffset =
-                editWhen - editStartTime;
+    return sampleId;
+}
 
-            // calculate the media (track) time that corresponds
-            // to the specified edit time based on the edit list
-            MP4Timestamp mediaWhen =
-                m_pElstMediaTimeProperty->GetValue(editId - 1)
-                + editOffset;
+// 'editWhen' must be within edit segment 'editId'
+MP4SampleId MP4Track::GetSampleIdFromEdit(
+    MP4EditId editId,
+    MP4Timestamp editWhen,
+    MP4Timestamp* pStartTime,
+    MP4Duration* pDuration)
+{
+    // edit segment's start and end time (in edit timeline)
+    MP4Timestamp editStartTime =
+        (editId > 1) ? m_editEnds[editId - 2] : 0;
+    MP4Duration editElapsedDuration = m_editEnds[editId - 1];
 
-            // lookup the sample id for the media time
-            sampleId = GetSampleIdFromTime(mediaWhen, false);
+    // calculate the specified edit time
+    // relative to just this edit segment
+    MP4Duration editOffset =
+        editWhen - editStartTime;
 
-            // lookup the sample's media start time and duration
-            MP4Timestamp sampleStartTime;
-            MP4Duration sampleDuration;
+    // calculate the media (track) time that corresponds
+    // to the specified edit time based on the edit list
+    MP4Timestamp mediaWhen =
+        m_pElstMediaTimeProperty->GetValue(editId - 1)
+        + editOffset;
 
-            GetSampleTimes(sampleId, &sampleStartTime, &sampleDuration);
+    // lookup the sample id for the media time
+    MP4SampleId sampleId = GetSampleIdFromTime(mediaWhen, false);
 
-            // calculate the difference if any between when the sample
-            // would naturally start and when it starts in the edit timeline
-            MP4Duration sampleStartOffset =
-                mediaWhen - sampleStartTime;
+    // lookup the sample's media start time and duration
+    MP4Timestamp sampleStartTime;
+    MP4Duration sampleDuration;
 
-            // calculate the start time for the sample in the edit time line
-            MP4Timestamp editSampleStartTime =
-                editWhen - min(editOffset, sampleStartOffset);
+    GetSampleTimes(sampleId, &sampleStartTime, &sampleDuration);
 
-            MP4Duration editSampleDuration = 0;
+    // calculate the difference if any between when the sample
+    // would naturally start and when it starts in the edit timeline
+    MP4Duration sampleStartOffset =
+        mediaWhen - sampleStartTime;
 
-            // calculate how long this sample lasts in the edit list timeline
-            if (m_pElstRateProperty->GetValue(editId - 1) == 0) {
-                // edit segment is a "dwell"
-                // so sample duration is that of the edit segment
-                editSampleDuration =
-                    m_pElstDurationProperty->GetValue(editId - 1);
+    // calculate the start time for the sample in the edit time line
+    MP4Timestamp editSampleStartTime =
+        editWhen - min(editOffset, sampleStartOffset);
 
-            } else {
-                // begin with the natural sample duration
-                editSampleDuration = sampleDuration;
+    MP4Duration editSampleDuration = 0;
 
-                // now shorten that if the edit segment starts
-                // after the sample would naturally start
-                if (editOffset < sampleStartOffset) {
-                    editSampleDuration -= sampleStartOffset - editOffset;
-                }
+    // calculate how long this sample lasts in the edit list timeline
+    if (m_pElstRateProperty->GetValue(editId - 1) == 0) {
+        // edit segment is a "dwell"
+        // so sample duration is that of the edit segment
+        editSampleDuration =
+            m_pElstDurationProperty->GetValue(editId - 1);
 
-                // now shorten that if the edit segment ends
-                // before the sample would naturally end
-                if (editElapsedDuration
-                        < editSampleStartTime + sampleDuration) {
-                    editSampleDuration -= (editSampleStartTime + sampleDuration)
-                                          - editElapsedDuration;
-                }
-            }
+    } else {
+        // begin with the natural sample duration
+        editSampleDuration = sampleDuration;
 
-            if (pStartTime) {
-                *pStartTime = editSampleStartTime;
-            }
+        // now shorten that if the edit segment starts
+        // after the sample would naturally start
+        if (editOffset < sampleStartOffset) {
+            editSampleDuration -= sampleStartOffset - editOffset;
+        }
 
-            if (pDuration) {
-                *pDuration = editSampleDuration;
-            }
+        // now shorten that if the edit segment ends
+        // before the sample would naturally end
+        if (editElapsedDuration
+                < editSampleStartTime + editSampleDuration) {
+            editSampleDuration = editElapsedDuration - editSampleStartTime;
+        }
+    }
 
-            log.verbose2f("\"%s\": GetSampleIdFromEditTime: when %" PRIu64 " "
-                          "sampleId %u start %" PRIu64 " duration %" PRId64,
-                          GetFile().GetFilename().c_str(),
-                          editWhen, sampleId,
-                          editSampleStartTime, editSampleDuration);
+    if (pStartTime) {
+        *pStartTime = editSampleStartTime;
+    }
 
-            return sampleId;
-        }
+    if (pDuration) {
+        *pDuration = editSampleDuration;
+    }
 
-        throw new EXCEPTION("time out of range");
+    LOG_VERBOSE2F("\"%s\": GetSampleIdFromEditTime: when %" PRIu64 " "
+                  "sampleId %u start %" PRIu64 " duration %" PRId64,
+                  GetFile().GetFilename().c_str(),
+                  editWhen, sampleId,
+                  editSampleStartTime, editSampleDuration);
 
-    } else { // no edit list
-        sampleId = GetSampleIdFromTime(editWhen, false);
+    return sampleId;
+}
 
-        if (pStartTime || pDuration) {
-            GetSampleTimes(sampleId, pStartTime, pDuration);
+bool MP4Track::GetNextEditSample(MP4EditSampleCursor& cursor)
+{
+    uint32_t numEdits = 0;
+
+    if (m_pElstCountProperty) {
+        numEdits = m_pElstCountProperty->GetValue();
+    }
+
+    if (numEdits == 0) {
+        // no edit list, so the samples play in media order
+        if (cursor.sampleId >= GetNumberOfSamples()) {
+            return false;
         }
+        cursor.sampleId++;
+        GetSampleTimes(cursor.sampleId, &cursor.startTime, &cursor.duration);
+        return true;
     }
 
-    return sampleId;
+    // the next sample starts where the previous one ended
+    MP4Timestamp editWhen = 0;
+    if (cursor.editId != MP4_INVALID_EDIT_ID) {
+        editWhen = cursor.startTime + cursor.duration;
+    }
+
+    MP4EditId editId = FindEdit(editWhen, cursor.editId);
+    if (editId == MP4_INVALID_EDIT_ID) {
+        return false;
+    }
+
+    MP4Timestamp startTime;
+    MP4Duration duration;
+    MP4SampleId sampleId =
+        GetSampleIdFromEdit(editId, editWhen, &startTime, &duration);
+
+    // e.g. samples of zero duration
+    if (startTime + duration <= editWhen) {
+        throw new EXCEPTION("edit list walk does not advance");
+    }
+
+    cursor.sampleId = sampleId;
+    cursor.editId = editId;
+    cursor.startTime = startTime;
+    cursor.duration = duration;
+    return true;
 }
 
 void MP4Track::CalculateBytesPerSample ()
@@ -88,6 +88,21 @@ public:
         bool*         hasDependencyFlags = NULL,
         uint32_t*     dependencyFlags = NULL );
 
+    // Variant of ReadSample() which reports expected failures, such as an
+    // out of range sample id, as a status code instead of an exception.
+    MP4Error TryReadSample(
+        // input parameters
+        MP4SampleId sampleId,
+        // output parameters
+        uint8_t**     ppBytes,
+        uint32_t*     pNumBytes,
+        MP4Timestamp* pStartTime = NULL,
+        MP4Duration*  pDuration = NULL,
+        MP4Duration*  pRenderingOffset = NULL,
+        bool*         pIsSyncSample = NULL,
+        bool*         hasDependencyFlags = NULL,
+        uint32_t*     dependencyFlags = NULL );
+
     void WriteSample(
         const uint8_t* pBytes,
         uint32_t numBytes,
@@ -95,6 +110,14 @@ public:
         MP4Duration renderingOffset = 0,
         bool isSyncSample = true);
 
+    // append sync samples stored back to back, pSizes and pDurations
+    // holding numSamples entries each
+    void WriteSamples(
+        const uint8_t*     pBytes,
+        uint32_t           numSamples,
+        const uint32_t*    pSizes,
+        const MP4Duration* pDurations );
+
     void WriteSampleDependency(
         const uint8_t* pBytes,
         uint32_t       numBytes,
@@ -103,8 +126,21 @@ public:
         bool           isSyncSample,
         uint32_t       dependencyFlags );
 
+    // add a sample whose data already exists at fileOffset in the file
+    // named by url, or in this track's own file if url is NULL
+    void ReferenceSample(
+        const char*    url,
+        uint64_t       fileOffset,
+        uint32_t       numBytes,
+        MP4Duration    duration,
+        MP4Duration    renderingOffset,
+        bool           isSyncSample );
+
     virtual void FinishWrite(uint32_t options = 0);
 
+    // write out samples held in the chunk buffer as a (short) chunk
+    void WriteChunkBuffer();
+
     uint64_t    GetDuration();      // in track timeScale units
     uint32_t    GetTimeScale();
     uint32_t    GetNumberOfSamples();
@@ -126,7 +162,17 @@ public:
         MP4Timestamp when,
         bool wantSyncSample = false);
 
+    MP4Error    TryGetSampleIdFromTime(
+        MP4Timestamp when,
+        bool wantSyncSample,
+        MP4SampleId& sampleId);
+
+    MP4Error    CheckSampleId(MP4SampleId sampleId);
+
     MP4Duration GetSampleRenderingOffset(MP4SampleId sampleId);
+    uint64_t    GetSampleFileOffset(MP4SampleId sampleId);
+    bool        IsSampleInFile(MP4SampleId sampleId);  // not in a dref'd file
+    void        InvalidateSampleFileRefs();            // after dref changes
     void        SetSampleRenderingOffset(MP4SampleId sampleId,
                                          MP4Duration renderingOffset);
 
@@ -147,6 +193,15 @@ public:
         MP4Timestamp* pStartTime = NULL,
         MP4Duration* pDuration = NULL);
 
+    // advances cursor to the next sample in edit list order
+    bool        GetNextEditSample(MP4EditSampleCursor& cursor);
+
+    // must be called when elst entries are changed behind the track's back
+    void        InvalidateEditIndex() { m_editEnds.clear(); }
+
+    // likewise for stts entries changed in place
+    void        InvalidateSttsIndex();
+
     // special operation for use during hint track packet assembly
     void ReadSampleFragment(
         MP4SampleId sampleId,
@@ -166,32 +221,72 @@ public:
     void RewriteChunk(MP4ChunkId chunkId,
                       uint8_t* pChunk, uint32_t chunkSize);
 
+    // special operations for use during remuxing
+
+    bool CanCopyChunksFrom(MP4Track& srcTrack);
+    void CopyChunksFrom(MP4Track& srcTrack);
+
+    MP4ChunkId AddRemuxChunk(MP4Track& srcTrack,
+                             MP4SampleId srcSampleId, uint32_t numSamples);
+    void WriteRemuxChunk(MP4ChunkId chunkId, MP4Track& srcTrack,
+                         MP4SampleId srcFirstSampleId);
+
+    void ReadSampleRun(MP4SampleId sampleId, uint32_t numSamples,
+                       uint8_t* pDest, uint32_t destSize);
+
+    // the text of every sample of a text track, NUL terminated and back
+    // to back in texts, with each sample's offset into texts and length
+    void ReadTextSamples(string& texts, vector<uint32_t>& textOffsets,
+                         vector<uint32_t>& textLengths);
+
+    // the samples from the sync sample at or before startTime through the
+    // range, leaving out those sdtp marks as not referenced by others
+    void GetDecodableSamples(MP4Timestamp startTime, MP4Duration duration,
+                             vector<MP4DecodableSample>& samples);
+
+    // all sync samples, found in one pass over stss, stts and stsc
+    void GetSyncSampleIndex(vector<MP4DecodableSample>& samples);
+
     MP4Duration GetDurationPerChunk();
     void        SetDurationPerChunk( MP4Duration );
 
 protected:
     bool        InitEditListProperties();
 
-    File*       GetSampleFile( MP4SampleId sampleId );
-    uint64_t    GetSampleFileOffset(MP4SampleId sampleId);
+    void        UpdateSttsIndex();
+    void        UpdateEditIndex();
+    MP4EditId   FindEdit(MP4Timestamp editWhen,
+                         MP4EditId hint = MP4_INVALID_EDIT_ID);
+    MP4SampleId GetSampleIdFromEdit(MP4EditId editId, MP4Timestamp editWhen,
+                                    MP4Timestamp* pStartTime, MP4Duration* pDuration);
+
+    MP4Error    GetSampleFile( MP4SampleId sampleId, File*& file );
+    MP4Error    TryGetSampleFileOffset(MP4SampleId sampleId, uint64_t& fileOffset);
     uint32_t    GetSampleStscIndex(MP4SampleId sampleId);
     uint32_t    GetChunkStscIndex(MP4ChunkId chunkId);
     uint32_t    GetChunkSize(MP4ChunkId chunkId);
     uint32_t    GetSampleCttsIndex(MP4SampleId sampleId,
                                    MP4SampleId* pFirstSampleId = NULL);
     MP4SampleId GetNextSyncSample(MP4SampleId sampleId);
+    MP4SampleId GetPrevSyncSample(MP4SampleId sampleId);
 
     void UpdateSampleSizes(MP4SampleId sampleId,
                            uint32_t numBytes);
+    void UpdateSampleSizes(MP4SampleId sampleId,
+                           const uint32_t* pSizes, uint32_t numSamples);
     bool IsChunkFull(MP4SampleId sampleId);
+    uint32_t GetNumberOfChunkedSamples();
     void UpdateSampleToChunk(MP4SampleId sampleId,
                              MP4ChunkId chunkId, uint32_t samplesPerChunk);
     void UpdateChunkOffsets(uint64_t chunkOffset);
-    void UpdateSampleTimes(MP4Duration duration);
+    void UpdateSampleTimes(MP4Duration duration,
+                           uint32_t numSamples = 1);
     void UpdateRenderingOffsets(MP4SampleId sampleId,
-                                MP4Duration renderingOffset);
+                                MP4Duration renderingOffset,
+                                uint32_t numSamples = 1);
     void UpdateSyncSamples(MP4SampleId sampleId,
-                           bool isSyncSample);
+                           bool isSyncSample,
+                           uint32_t numSamples = 1);
 
     MP4Atom* AddAtom(const char* parentName, const char* childName);
 
@@ -200,7 +295,9 @@ protected:
 
     void UpdateModificationTimes();
 
-    void WriteChunkBuffer();
+    void FinishReferenceChunk();
+    void InitAmrMode(const uint8_t* pBytes);
+    MP4StringProperty* GetDataReferenceLocation();
 
     void CalculateBytesPerSample();
 
@@ -212,8 +309,22 @@ protected:
     MP4TrackId  m_trackId;          // moov.trak[].tkhd.trackId
     MP4StringProperty* m_pTypeProperty; // moov.trak[].mdia.hdlr.handlerType
 
-    uint32_t m_lastStsdIndex;
-    File*    m_lastSampleFile;
+    // dref resolution per stsd entry, see GetSampleFile()
+    struct SampleFileRef {
+        enum Location {
+            LOCAL,        // media is in this file
+            EXTERNAL,     // media is in the file at path
+            UNSUPPORTED,  // media is elsewhere, at a url we can't open
+        } location;
+        string path;
+    };
+    map<uint32_t, SampleFileRef> m_sampleFileRefs;
+
+    const SampleFileRef& GetSampleFileRef( MP4SampleId sampleId );
+    SampleFileRef        ResolveSampleFile( uint32_t stsdIndex );
+
+    uint32_t             m_lastStsdIndex;
+    const SampleFileRef* m_lastSampleFileRef;
 
     // for efficient construction of hint track packets
     MP4SampleId m_cachedReadSampleId;
@@ -229,6 +340,11 @@ protected:
     uint32_t    m_chunkSamples;
     MP4Duration m_chunkDuration;
 
+    // for referenced samples, see ReferenceSample()
+    uint32_t    m_refChunkSamples;
+    uint64_t    m_refChunkEnd;
+    bool        m_externalDataRef;  // sample data lives in another file
+
     // controls for chunking
     uint32_t    m_samplesPerChunk;
     MP4Duration m_durationPerChunk;
@@ -272,6 +388,10 @@ protected:
     MP4SampleId m_cachedSttsSid;
     MP4Timestamp    m_cachedSttsElapsed;
 
+    // end time and next sample id of each stts entry but the last one,
+    // for time to sample lookups; built on demand
+    vector< pair<MP4Timestamp, MP4SampleId> > m_sttsEnds;
+
     uint32_t    m_cachedCttsIndex;
     MP4SampleId m_cachedCttsSid;
 
@@ -288,6 +408,10 @@ protected:
     MP4Integer16Property* m_pElstRateProperty;
     MP4Integer16Property* m_pElstReservedProperty;
 
+    // running total of the edit segment durations, i.e. where each edit
+    // ends in the edit timeline; built on demand
+    vector<MP4Duration> m_editEnds;
+
     // for improved sample file offset query performance
     MP4ChunkId  m_cachedSfoChunkId;
     MP4SampleId m_cachedSfoSampleId;
@@ -304,4 +304,221 @@ void INT32TOSTR( uint32_t i, char* s )
 
 ///////////////////////////////////////////////////////////////////////////////
 
+namespace {
+    const size_t JSON_FLUSH_SIZE = 64 * 1024;
+}
+
+MP4JsonWriter::MP4JsonWriter( MP4DumpJsonWriteFunc write, void* handle, bool full_, uint32_t tableEntries_, bool dumpImplicits_ )
+    : full          ( full_ )
+    , tableEntries  ( tableEntries_ )
+    , dumpImplicits ( dumpImplicits_ )
+    , m_write       ( write )
+    , m_handle      ( handle )
+    , m_afterKey    ( false )
+{
+    m_buffer.reserve( JSON_FLUSH_SIZE + 256 );
+}
+
+MP4JsonWriter::~MP4JsonWriter()
+{
+    try {
+        Flush();
+    }
+    catch( Exception* x ) {
+        delete x;
+    }
+}
+
+void MP4JsonWriter::Flush()
+{
+    if( m_buffer.empty() )
+        return;
+
+    // dropped on failure too, so the destructor doesn't try again
+    const bool failed = m_write( m_handle, m_buffer.data(), (uint32_t)m_buffer.size() ) != 0;
+    m_buffer.clear();
+    if( failed )
+        throw new EXCEPTION("write failed");
+}
+
+void MP4JsonWriter::Append( const char* text, size_t size )
+{
+    m_buffer.append( text, size );
+    if( m_buffer.size() >= JSON_FLUSH_SIZE )
+        Flush();
+}
+
+void MP4JsonWriter::Separate()
+{
+    if( m_afterKey ) {
+        m_afterKey = false;
+        return;
+    }
+
+    if( m_first.empty() )
+        return;
+
+    if( m_first.back() )
+        m_first.back() = false;
+    else
+        m_buffer += ',';
+}
+
+void MP4JsonWriter::BeginObject()
+{
+    Separate();
+    m_buffer += '{';
+    m_first.push_back( true );
+}
+
+void MP4JsonWriter::EndObject()
+{
+    m_first.pop_back();
+    if( m_first.empty() )
+        Append( "}\n", 2 );
+    else
+        Append( "}", 1 );
+}
+
+void MP4JsonWriter::BeginArray()
+{
+    Separate();
+    m_buffer += '[';
+    m_first.push_back( true );
+}
+
+void MP4JsonWriter::EndArray()
+{
+    m_first.pop_back();
+    if( m_first.empty() )
+        Append( "]\n", 2 );
+    else
+        Append( "]", 1 );
+}
+
+void MP4JsonWriter::Key( const char* key )
+{
+    String( key );
+    m_buffer += ':';
+    m_afterKey = true;
+}
+
+void MP4JsonWriter::String( const char* value )
+{
+    String( value, value ? (uint32_t)strlen( value ) : 0 );
+}
+
+void MP4JsonWriter::String( const char* value, uint32_t size )
+{
+    static const char digits[] = "0123456789abcdef";
+
+    Separate();
+    m_buffer += '"';
+    for( uint32_t i = 0; i < size; i++ ) {
+        const unsigned char c = value[i];
+        switch( c ) {
+            case '"':  m_buffer += "\\\""; break;
+            case '\\': m_buffer += "\\\\"; break;
+            case '\n': m_buffer += "\\n";  break;
+            case '\r': m_buffer += "\\r";  break;
+            case '\t': m_buffer += "\\t";  break;
+
+            default:
+            {
+                // pass well-formed UTF-8 through, escape anything else
+                uint32_t n = 0;
+                if( c >= 0x20 && c < 0x7f )
+                    n = 1;
+                else if( c >= 0xc2 && c <= 0xdf )
+                    n = 2;
+                else if( c >= 0xe0 && c <= 0xef )
+                    n = 3;
+                else if( c >= 0xf0 && c <= 0xf4 )
+                    n = 4;
+
+                if( n > size - i )
+                    n = 0;
+                for( uint32_t k = 1; k < n; k++ ) {
+                    if( (value[i+k] & 0xc0) != 0x80 ) {
+                        n = 0;
+                        break;
+                    }
+                }
+
+                // reject overlong forms, surrogates and code points past U+10FFFF
+                if( n > 2 ) {
+                    const unsigned char c1 = value[i+1];
+                    if( (c == 0xe0 && c1 < 0xa0) || (c == 0xed && c1 > 0x9f)
+                        || (c == 0xf0 && c1 < 0x90) || (c == 0xf4 && c1 > 0x8f) )
+                        n = 0;
+                }
+
+                if( n ) {
+                    m_buffer.append( value + i, n );
+                    i += n - 1;
+                }
+                else {
+                    m_buffer += "\\u00";
+                    m_buffer += digits[c >> 4];
+                    m_buffer += digits[c & 0xf];
+                }
+                break;
+            }
+        }
+    }
+    Append( "\"", 1 );
+}
+
+void MP4JsonWriter::Hex( const uint8_t* value, uint32_t size )
+{
+    static const char digits[] = "0123456789abcdef";
+
+    Separate();
+    m_buffer += '"';
+    for( uint32_t i = 0; i < size; i++ ) {
+        m_buffer += digits[value[i] >> 4];
+        m_buffer += digits[value[i] & 0xf];
+        if( m_buffer.size() >= JSON_FLUSH_SIZE )
+            Flush();
+    }
+    Append( "\"", 1 );
+}
+
+void MP4JsonWriter::Integer( uint64_t value )
+{
+    char text[24];
+    Separate();
+    Append( text, snprintf( text, sizeof(text), "%" PRIu64, value ));
+}
+
+void MP4JsonWriter::Float( double value )
+{
+    // JSON has no representation for NaN or infinity
+    if( value != value || value - value != 0 ) {
+        Null();
+        return;
+    }
+
+    char text[32];
+    Separate();
+    Append( text, snprintf( text, sizeof(text), "%.9g", value ));
+}
+
+void MP4JsonWriter::Bool( bool value )
+{
+    Separate();
+    if( value )
+        Append( "true", 4 );
+    else
+        Append( "false", 5 );
+}
+
+void MP4JsonWriter::Null()
+{
+    Separate();
+    Append( "null", 4 );
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
 }} // namespace mp4v2::impl
@@ -115,6 +115,54 @@ const char* MP4NormalizeTrackType(const char* type);
 
 ///////////////////////////////////////////////////////////////////////////////
 
+/// Streaming writer for compact JSON output.
+/// Text is collected in a buffer and passed to <b>write</b> in large blocks.
+/// Commas between members and elements are inserted automatically.
+///
+class MP4JsonWriter
+{
+public:
+    MP4JsonWriter( MP4DumpJsonWriteFunc write, void* handle, bool full, uint32_t tableEntries, bool dumpImplicits );
+    ~MP4JsonWriter();
+
+    void BeginObject();
+    void EndObject();
+    void BeginArray();
+    void EndArray();
+
+    void Key( const char* key );
+    void String( const char* value );
+    void String( const char* value, uint32_t size );
+    void Hex( const uint8_t* value, uint32_t size );
+    void Integer( uint64_t value );
+    void Float( double value );
+    void Bool( bool value );
+    void Null();
+
+    void Flush();
+
+    const bool     full;          ///< write tables and byte values in full.
+    const uint32_t tableEntries;  ///< entries kept at each end of a summarized table.
+    const bool     dumpImplicits; ///< include implicit properties.
+
+private:
+    void Separate();
+    void Append( const char* text, size_t size );
+
+    MP4DumpJsonWriteFunc m_write;
+    void*                m_handle;
+    string               m_buffer;
+    vector<bool>         m_first;    // per open container: no member written yet
+    bool                 m_afterKey; // next value belongs to the key just written
+
+private:
+    MP4JsonWriter();
+    MP4JsonWriter ( const MP4JsonWriter &src );
+    MP4JsonWriter &operator= ( const MP4JsonWriter &src );
+};
+
+///////////////////////////////////////////////////////////////////////////////
+
 }} // namespace mp4v2::impl
 
 #endif // MP4V2_IMPL_MP4UTIL_H
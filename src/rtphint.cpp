@@ -145,6 +145,91 @@ void MP4RtpHintTrack::ReadHint(
     }
 }
 
+MP4RtpSchedule* MP4RtpHintTrack::CompileSchedule()
+{
+    if (m_pRefTrack == NULL) {
+        InitRefTrack();
+        InitRtpStart();
+    }
+
+    vector<MP4RtpSchedulePacket> packets;
+    vector<MP4RtpScheduleSegment> segments;
+    vector<uint8_t> pool;
+
+    MP4SampleId numHints = GetNumberOfSamples();
+
+    for (MP4SampleId hintSampleId = 1; hintSampleId <= numHints; hintSampleId++) {
+        uint16_t numPackets;
+        ReadHint(hintSampleId, &numPackets);
+
+        for (uint16_t packetIndex = 0; packetIndex < numPackets; packetIndex++) {
+            MP4RtpPacket* pPacket = m_pReadHint->GetPacket(packetIndex);
+
+            MP4RtpSchedulePacket packet;
+            memset(&packet, 0, sizeof(packet));
+
+            packet.timestamp = m_readHintTimestamp;
+            packet.hintSampleId = hintSampleId;
+            packet.transmitOffset = pPacket->GetTransmitOffset();
+            packet.sequenceNumber = pPacket->GetSequenceNumber();
+            packet.header[0] =
+                0x80 | (pPacket->GetPBit() << 5) | (pPacket->GetXBit() << 4);
+            packet.header[1] =
+                (pPacket->GetMBit() << 7) | pPacket->GetPayload();
+            packet.isBFrame = pPacket->IsBFrame();
+            packet.payloadSize = pPacket->GetDataSize();
+
+            packet.firstSegment = segments.size();
+            pPacket->CompileData(segments, pool);
+            packet.numSegments = segments.size() - packet.firstSegment;
+
+            packets.push_back(packet);
+        }
+    }
+
+    // lay out header, packets, segments and pool in one block
+    uint64_t packetsOffset = sizeof(MP4RtpSchedule);
+    uint64_t segmentsOffset =
+        packetsOffset + packets.size() * sizeof(MP4RtpSchedulePacket);
+    uint64_t poolOffset =
+        segmentsOffset + segments.size() * sizeof(MP4RtpScheduleSegment);
+    uint64_t size = poolOffset + pool.size();
+
+    if (size != (size_t)size) {
+        throw new EXCEPTION("packet schedule too large");
+    }
+
+    uint8_t* pBlock = (uint8_t*)MP4Malloc((size_t)size);
+
+    MP4RtpSchedule* pSchedule = (MP4RtpSchedule*)pBlock;
+    memset(pSchedule, 0, sizeof(*pSchedule));
+    pSchedule->magic = MP4_RTP_SCHEDULE_MAGIC;
+    pSchedule->version = MP4_RTP_SCHEDULE_VERSION;
+    pSchedule->size = size;
+    pSchedule->timeScale = GetTimeScale();
+    pSchedule->numPackets = packets.size();
+    pSchedule->numSegments = segments.size();
+    pSchedule->sequenceStart = m_rtpSequenceStart;
+    pSchedule->timestampStart = m_rtpTimestampStart;
+    pSchedule->packetsOffset = packetsOffset;
+    pSchedule->segmentsOffset = segmentsOffset;
+    pSchedule->poolOffset = poolOffset;
+
+    if (!packets.empty()) {
+        memcpy(pBlock + packetsOffset, &packets[0],
+               packets.size() * sizeof(MP4RtpSchedulePacket));
+    }
+    if (!segments.empty()) {
+        memcpy(pBlock + segmentsOffset, &segments[0],
+               segments.size() * sizeof(MP4RtpScheduleSegment));
+    }
+    if (!pool.empty()) {
+        memcpy(pBlock + poolOffset, &pool[0], pool.size());
+    }
+
+    return pSchedule;
+}
+
 uint16_t MP4RtpHintTrack::GetHintNumberOfPackets()
 {
     if (m_pReadHint == NULL) {
@@ -164,7 +249,7 @@ bool MP4RtpHintTrack::GetPacketBFrame(uint16_t packetIndex)
     return pPacket->IsBFrame();
 }
 
-uint16_t MP4RtpHintTrack::GetPacketTransmitOffset(uint16_t packetIndex)
+int32_t MP4RtpHintTrack::GetPacketTransmitOffset(uint16_t packetIndex)
 {
     if (m_pReadHint == NULL) {
         throw new EXCEPTION("no hint has been read");
@@ -642,6 +727,284 @@ void MP4RtpHintTrack::WriteHint(MP4Duration duration, bool isSyncSample)
     m_pWriteHint = NULL;
 }
 
+// RFC 6184 packetization of avc1 samples. NAL units that fit a packet go
+// out as single NAL unit packets, or aggregated into STAP-A packets with
+// their neighbours; larger ones are split into FU-A fragments. Payload
+// headers are immediate data and the NAL unit bytes are references into the
+// media samples, which are read in runs rather than one at a time.
+
+void MP4RtpHintTrack::HintH264(uint16_t maxPayloadSize, uint32_t lengthSize)
+{
+    if (lengthSize < 1 || lengthSize > 4) {
+        throw new EXCEPTION("invalid NAL unit length size");
+    }
+    if (maxPayloadSize < 3) {
+        throw new EXCEPTION("max payload size is too small");
+    }
+
+    InitRefTrack();
+
+    uint32_t numSamples = m_pRefTrack->GetNumberOfSamples();
+    uint32_t mediaTimeScale = m_pRefTrack->GetTimeScale();
+    uint32_t hintTimeScale = GetTimeScale();
+    MP4Timestamp hintTime = 0;
+    vector<uint8_t> buffer;
+
+    for (MP4SampleId sampleId = 1; sampleId <= numSamples; ) {
+        uint32_t runSamples = 0;
+        uint32_t runSize = 0;
+        while (sampleId + runSamples <= numSamples) {
+            uint32_t sampleSize = m_pRefTrack->GetSampleSize(sampleId + runSamples);
+            if (runSamples && runSize + sampleSize > 1024 * 1024) {
+                break;
+            }
+            runSize += sampleSize;
+            runSamples++;
+        }
+
+        buffer.resize(runSize + 1);
+        m_pRefTrack->ReadSampleRun(sampleId, runSamples, &buffer[0], runSize);
+
+        uint32_t pos = 0;
+        for (uint32_t i = 0; i < runSamples; i++, sampleId++) {
+            uint32_t sampleSize = m_pRefTrack->GetSampleSize(sampleId);
+            MP4Timestamp startTime;
+            MP4Duration duration;
+
+            m_pRefTrack->GetSampleTimes(sampleId, &startTime, &duration);
+            MP4Duration renderingOffset =
+                m_pRefTrack->GetSampleRenderingOffset(sampleId);
+
+            AddHint(false, (uint32_t)MP4ConvertTime(renderingOffset,
+                                                    mediaTimeScale, hintTimeScale));
+
+            HintH264Sample(sampleId, &buffer[pos], sampleSize,
+                           maxPayloadSize, lengthSize);
+
+            // convert the end time so rounding doesn't accumulate
+            MP4Timestamp hintEnd = MP4ConvertTime(startTime + duration,
+                                                  mediaTimeScale, hintTimeScale);
+            WriteHint(hintEnd - hintTime, m_pRefTrack->IsSyncSample(sampleId));
+            hintTime = hintEnd;
+
+            pos += sampleSize;
+        }
+    }
+}
+
+void MP4RtpHintTrack::HintH264Sample(MP4SampleId sampleId,
+                                     const uint8_t* pSample, uint32_t sampleSize,
+                                     uint16_t maxPayloadSize, uint32_t lengthSize)
+{
+    // offset and size of each NAL unit in the sample
+    vector<pair<uint32_t, uint32_t> > nals;
+
+    uint32_t pos = 0;
+    while (pos < sampleSize) {
+        if (sampleSize - pos < lengthSize) {
+            throw new EXCEPTION("truncated NAL unit length");
+        }
+        uint32_t nalSize = 0;
+        for (uint32_t i = 0; i < lengthSize; i++) {
+            nalSize = (nalSize << 8) | pSample[pos++];
+        }
+        if (nalSize > sampleSize - pos) {
+            throw new EXCEPTION("NAL unit extends past end of sample");
+        }
+        if (nalSize) {
+            nals.push_back(make_pair(pos, nalSize));
+        }
+        pos += nalSize;
+    }
+
+    // NAL units pending aggregation
+    size_t stapFirst = 0;
+    size_t stapCount = 0;
+    uint32_t stapSize = 1;
+
+    for (size_t n = 0; n < nals.size(); n++) {
+        uint32_t nalOffset = nals[n].first;
+        uint32_t nalSize = nals[n].second;
+        bool lastNal = (n + 1 == nals.size());
+
+        if (nalSize <= maxPayloadSize) {
+            if (stapCount && stapSize + 2 + nalSize > maxPayloadSize) {
+                AddH264Packet(sampleId, pSample, nals, stapFirst, stapCount, false);
+                stapCount = 0;
+            }
+            if (stapCount == 0) {
+                stapFirst = n;
+                stapSize = 1;
+            }
+            stapCount++;
+            stapSize += 2 + nalSize;
+            continue;
+        }
+
+        if (stapCount) {
+            AddH264Packet(sampleId, pSample, nals, stapFirst, stapCount, false);
+            stapCount = 0;
+        }
+
+        // FU-A, the NAL unit header is folded into the FU indicator and header
+        uint8_t nalHeader = pSample[nalOffset];
+        uint8_t fu[2];
+        fu[0] = (nalHeader & 0xE0) | 28;
+        fu[1] = 0x80 | (nalHeader & 0x1F);
+
+        uint32_t offset = nalOffset + 1;
+        uint32_t remaining = nalSize - 1;
+        while (remaining) {
+            uint32_t fragSize = min(remaining, (uint32_t)(maxPayloadSize - 2));
+            bool lastFrag = (fragSize == remaining);
+            if (lastFrag) {
+                fu[1] |= 0x40;
+            }
+
+            AddPacket(lastNal && lastFrag);
+            AddImmediateData(fu, 2);
+            AddSampleData(sampleId, offset, fragSize);
+
+            fu[1] &= ~0x80;
+            offset += fragSize;
+            remaining -= fragSize;
+        }
+    }
+
+    if (stapCount) {
+        AddH264Packet(sampleId, pSample, nals, stapFirst, stapCount, true);
+    }
+}
+
+void MP4RtpHintTrack::AddH264Packet(MP4SampleId sampleId, const uint8_t* pSample,
+                                    const vector<pair<uint32_t, uint32_t> >& nals,
+                                    size_t first, size_t count, bool setMbit)
+{
+    AddPacket(setMbit);
+
+    if (count == 1) {
+        AddSampleData(sampleId, nals[first].first, nals[first].second);
+        return;
+    }
+
+    // STAP-A, F is the OR and NRI the maximum over the aggregated units
+    uint8_t stapHeader = 24;
+    for (size_t n = first; n < first + count; n++) {
+        uint8_t nalHeader = pSample[nals[n].first];
+        stapHeader |= nalHeader & 0x80;
+        if ((nalHeader & 0x60) > (stapHeader & 0x60)) {
+            stapHeader = (stapHeader & ~0x60) | (nalHeader & 0x60);
+        }
+    }
+
+    for (size_t n = first; n < first + count; n++) {
+        uint8_t header[3];
+        header[0] = stapHeader;
+        header[1] = (uint8_t)(nals[n].second >> 8);
+        header[2] = (uint8_t)nals[n].second;
+
+        if (n == first) {
+            AddImmediateData(header, 3);
+        } else {
+            AddImmediateData(&header[1], 2);
+        }
+        AddSampleData(sampleId, nals[n].first, nals[n].second);
+    }
+}
+
+// RFC 3640 AAC-hbr packetization with 13 bit AU sizes and 3 bit AU indices.
+// Consecutive access units are aggregated into a packet while they fit, and
+// an access unit larger than a packet is fragmented over the packets of one
+// hint. Only the sample sizes are needed, the media data isn't read.
+
+void MP4RtpHintTrack::HintAac(uint16_t maxPayloadSize)
+{
+    // AU-headers-length, one AU header and at least a byte of data
+    if (maxPayloadSize < 5) {
+        throw new EXCEPTION("max payload size is too small");
+    }
+
+    InitRefTrack();
+
+    uint32_t numSamples = m_pRefTrack->GetNumberOfSamples();
+    uint32_t mediaTimeScale = m_pRefTrack->GetTimeScale();
+    uint32_t hintTimeScale = GetTimeScale();
+    MP4Timestamp hintTime = 0;
+    vector<uint8_t> headers;
+
+    for (MP4SampleId sampleId = 1; sampleId <= numSamples; ) {
+        uint32_t sampleSize = m_pRefTrack->GetSampleSize(sampleId);
+        uint32_t numAus = 1;
+
+        if (sampleSize >= (1 << 13)) {
+            throw new EXCEPTION("access unit is too large for AAC-hbr");
+        }
+
+        AddHint(false, 0);
+
+        if (4 + sampleSize > maxPayloadSize) {
+            // every fragment carries the header of the whole access unit
+            uint8_t header[4];
+            header[0] = 0;
+            header[1] = 16;
+            header[2] = (uint8_t)(sampleSize >> 5);
+            header[3] = (uint8_t)(sampleSize << 3);
+
+            uint32_t offset = 0;
+            while (offset < sampleSize) {
+                uint32_t fragSize = min(sampleSize - offset,
+                                        (uint32_t)(maxPayloadSize - 4));
+                AddPacket(offset + fragSize == sampleSize);
+                AddImmediateData(header, 4);
+                AddSampleData(sampleId, offset, fragSize);
+                offset += fragSize;
+            }
+        } else {
+            uint32_t payloadSize = 4 + sampleSize;
+            while (sampleId + numAus <= numSamples) {
+                uint32_t nextSize = m_pRefTrack->GetSampleSize(sampleId + numAus);
+                if (nextSize >= (1 << 13) ||
+                        payloadSize + 2 + nextSize > maxPayloadSize) {
+                    break;
+                }
+                payloadSize += 2 + nextSize;
+                numAus++;
+            }
+
+            // AU-headers-length in bits, then the AU headers with an index
+            // (delta) of zero as the access units are consecutive
+            headers.resize(2 + 2 * numAus);
+            headers[0] = (uint8_t)((16 * numAus) >> 8);
+            headers[1] = (uint8_t)(16 * numAus);
+            for (uint32_t i = 0; i < numAus; i++) {
+                uint32_t auSize = m_pRefTrack->GetSampleSize(sampleId + i);
+                headers[2 + 2 * i] = (uint8_t)(auSize >> 5);
+                headers[3 + 2 * i] = (uint8_t)(auSize << 3);
+            }
+
+            AddPacket(true);
+            for (uint32_t i = 0; i < headers.size(); i += 14) {
+                AddImmediateData(&headers[i], min((uint32_t)headers.size() - i, 14U));
+            }
+            for (uint32_t i = 0; i < numAus; i++) {
+                AddSampleData(sampleId + i, 0,
+                              m_pRefTrack->GetSampleSize(sampleId + i));
+            }
+        }
+
+        MP4Timestamp startTime;
+        MP4Duration duration;
+        m_pRefTrack->GetSampleTimes(sampleId + numAus - 1, &startTime, &duration);
+
+        MP4Timestamp hintEnd = MP4ConvertTime(startTime + duration,
+                                              mediaTimeScale, hintTimeScale);
+        WriteHint(hintEnd - hintTime, true);
+        hintTime = hintEnd;
+
+        sampleId += numAus;
+    }
+}
+
 void MP4RtpHintTrack::FinishWrite(uint32_t option)
 {
     if (m_writeHintId != MP4_INVALID_SAMPLE_ID) {
@@ -1030,6 +1393,45 @@ void MP4RtpPacket::GetData(uint8_t* pDest)
     }
 }
 
+void MP4RtpPacket::CompileData(
+    vector<MP4RtpScheduleSegment>& segments,
+    vector<uint8_t>& pool)
+{
+    size_t firstSegment = segments.size();
+
+    for (uint32_t i = 0; i < m_rtpData.Size(); i++) {
+        uint32_t length = m_rtpData[i]->GetDataSize();
+        if (length == 0) {
+            continue;
+        }
+
+        MP4RtpScheduleSegment segment;
+        segment.length = length;
+
+        if (m_rtpData[i]->GetDataFileOffset(segment.offset)) {
+            segment.flags = 0;
+        } else {
+            // copy whatever isn't in the file as is into the pool
+            segment.offset = pool.size();
+            segment.flags = MP4_RTP_SEGMENT_POOL;
+            pool.resize(pool.size() + length);
+            m_rtpData[i]->GetData(&pool[segment.offset]);
+        }
+
+        // merge with the previous piece of this packet where possible
+        if (segments.size() > firstSegment) {
+            MP4RtpScheduleSegment& last = segments.back();
+            if (last.flags == segment.flags &&
+                    last.offset + last.length == segment.offset) {
+                last.length += segment.length;
+                continue;
+            }
+        }
+
+        segments.push_back(segment);
+    }
+}
+
 void MP4RtpPacket::Write(MP4File& file)
 {
     MP4Container::Write(file);
@@ -1223,6 +1625,29 @@ void MP4RtpSampleData::GetData(uint8_t* pDest)
         pDest);
 }
 
+bool MP4RtpSampleData::GetDataFileOffset(uint64_t& fileOffset)
+{
+    MP4Track* pSampleTrack = FindTrackFromRefIndex(
+        ((MP4Integer8Property*)m_pProperties[1])->GetValue());
+
+    MP4SampleId sampleId =
+        ((MP4Integer32Property*)m_pProperties[3])->GetValue();
+    uint32_t sampleOffset =
+        ((MP4Integer32Property*)m_pProperties[4])->GetValue();
+
+    if (!pSampleTrack->IsSampleInFile(sampleId)) {
+        return false;
+    }
+
+    if ((uint64_t)sampleOffset + GetDataSize() >
+            pSampleTrack->GetSampleSize(sampleId)) {
+        throw new EXCEPTION("offset and/or length are too large");
+    }
+
+    fileOffset = pSampleTrack->GetSampleFileOffset(sampleId) + sampleOffset;
+    return true;
+}
+
 void MP4RtpSampleData::WriteEmbeddedData(MP4File& file, uint64_t startPos)
 {
     // if not using embedded data, nothing to do
@@ -1288,7 +1713,7 @@ uint16_t MP4RtpSampleDescriptionData::GetDataSize()
     return ((MP4Integer16Property*)m_pProperties[2])->GetValue();
 }
 
-void MP4RtpSampleDescriptionData::GetData(uint8_t* pDest)
+uint64_t MP4RtpSampleDescriptionData::GetDataPosition()
 {
     // we start with the index into our track references
     uint8_t trackRefIndex =
@@ -1326,12 +1751,6 @@ void MP4RtpSampleDescriptionData::GetData(uint8_t* pDest)
         throw new EXCEPTION("offset and/or length are too large");
     }
 
-    // now we use the raw file to get the desired bytes
-
-    MP4File& file = GetPacket().GetHint().GetTrack().GetFile();
-
-    uint64_t orgPos = file.GetPosition();
-
     // It's not entirely clear from the spec whether the offset is from
     // the start of the sample descirption atom, or the start of the atom's
     // data. I believe it is the former, but the commented out code will
@@ -1339,11 +1758,24 @@ void MP4RtpSampleDescriptionData::GetData(uint8_t* pDest)
     uint64_t dataPos = pSdAtom->GetStart();
     //uint64_t dataPos = pSdAtom->GetEnd() - pSdAtom->GetSize();
 
-    file.SetPosition(dataPos + offset);
+    return dataPos + offset;
+}
 
-    file.ReadBytes(pDest, length);
+void MP4RtpSampleDescriptionData::GetData(uint8_t* pDest)
+{
+    uint64_t dataPos = GetDataPosition();
 
-    file.SetPosition(orgPos);
+    // now we use the raw file to get the desired bytes
+
+    MP4File& file = GetPacket().GetHint().GetTrack().GetFile();
+
+    file.ReadBytesAt(dataPos, pDest, GetDataSize());
+}
+
+bool MP4RtpSampleDescriptionData::GetDataFileOffset(uint64_t& fileOffset)
+{
+    fileOffset = GetDataPosition();
+    return true;
 }
 
 ///////////////////////////////////////////////////////////////////////////////
@@ -43,6 +43,11 @@ public:
     virtual uint16_t GetDataSize() = 0;
     virtual void GetData(uint8_t* pDest) = 0;
 
+    // location of the data in the file, if it can be sent from there as is
+    virtual bool GetDataFileOffset(uint64_t& /* fileOffset */) {
+        return false;
+    }
+
     MP4Track* FindTrackFromRefIndex(uint8_t refIndex);
 
     virtual void WriteEmbeddedData(MP4File& file, uint64_t startPos) {
@@ -104,6 +109,8 @@ public:
 
     void GetData(uint8_t* pDest);
 
+    bool GetDataFileOffset(uint64_t& fileOffset);
+
     void WriteEmbeddedData(MP4File& file, uint64_t startPos);
 
 protected:
@@ -124,6 +131,11 @@ public:
     uint16_t GetDataSize();
 
     void GetData(uint8_t* pDest);
+
+    bool GetDataFileOffset(uint64_t& fileOffset);
+
+protected:
+    uint64_t GetDataPosition();
 };
 
 class MP4RtpPacket : public MP4Container {
@@ -166,6 +178,10 @@ public:
 
     void GetData(uint8_t* pDest);
 
+    // append the payload pieces of this packet to a packet schedule
+    void CompileData(vector<MP4RtpScheduleSegment>& segments,
+                     vector<uint8_t>& pool);
+
     void Read(MP4File& file);
 
     void ReadExtra(MP4File& file);
@@ -280,7 +296,9 @@ public:
 
     bool GetPacketBFrame(uint16_t packetIndex);
 
-    uint16_t GetPacketTransmitOffset(uint16_t packetIndex);
+    int32_t GetPacketTransmitOffset(uint16_t packetIndex);
+
+    MP4RtpSchedule* CompileSchedule();
 
     void ReadPacket(
         uint16_t packetIndex,
@@ -307,9 +325,21 @@ public:
 
     void WriteHint(MP4Duration duration, bool isSyncSample);
 
+    void HintH264(uint16_t maxPayloadSize, uint32_t lengthSize);
+
+    void HintAac(uint16_t maxPayloadSize);
+
     void FinishWrite(uint32_t options = 0);
 
 protected:
+    void HintH264Sample(MP4SampleId sampleId,
+                        const uint8_t* pSample, uint32_t sampleSize,
+                        uint16_t maxPayloadSize, uint32_t lengthSize);
+
+    void AddH264Packet(MP4SampleId sampleId, const uint8_t* pSample,
+                       const vector<pair<uint32_t, uint32_t> >& nals,
+                       size_t first, size_t count, bool setMbit);
+
     MP4Track*   m_pRefTrack;
 
     MP4StringProperty*      m_pRtpMapProperty;
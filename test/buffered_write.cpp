@@ -0,0 +1,170 @@
+///////////////////////////////////////////////////////////////////////////////
+//
+//  The contents of this file are subject to the Mozilla Public License
+//  Version 1.1 (the "License"); you may not use this file except in
+//  compliance with the License. You may obtain a copy of the License at
+//  http://www.mozilla.org/MPL/
+//
+//  Software distributed under the License is distributed on an "AS IS"
+//  basis, WITHOUT WARRANTY OF ANY KIND, either express or implied. See the
+//  License for the specific language governing rights and limitations
+//  under the License.
+//
+//  The Original Code is MP4v2.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+// Writes the moov atom of a file opened for modification straight to the
+// file, then again through MP4File::BeginBufferedWrite() and
+// FinishBufferedWrite() over a scribbled copy, and checks the bytes,
+// positions and atom sizes match. Then checks that AbortBufferedWrite()
+// leaves the file untouched. Uses library internals, so it includes
+// src/impl.h.
+
+#include "src/impl.h"
+#include <cstdio>
+#include <cstring>
+#include <vector>
+
+using namespace mp4v2::impl;
+
+#define CHECK(cond) \
+    do { \
+        if( !(cond) ) { \
+            fprintf( stderr, "%s:%d: check failed: %s\n", __FILE__, __LINE__, #cond ); \
+            return false; \
+        } \
+    } while( 0 )
+
+static const char* const FILE_NAME = "buffered-write.mp4";
+
+static const uint32_t NUM_SAMPLES = 300;
+
+static bool
+createFile()
+{
+    MP4FileHandle file = MP4Create( FILE_NAME );
+    CHECK( file != MP4_INVALID_FILE_HANDLE );
+
+    bool ok = MP4AddVideoTrack( file, 90000, 3000, 320, 240, MP4_MPEG4_VIDEO_TYPE ) == 1
+        && MP4AddAudioTrack( file, 48000, 1024, MP4_MPEG4_AUDIO_TYPE ) == 2;
+
+    uint8_t sample[64];
+    for( MP4SampleId sampleId = 1; ok && sampleId <= NUM_SAMPLES; sampleId++ ) {
+        memset( sample, (int)sampleId, sizeof(sample) );
+        ok = MP4WriteSample( file, 1, sample, 8 + sampleId % 56, MP4_INVALID_DURATION, 0, sampleId % 30 == 1 )
+            && MP4WriteSample( file, 2, sample, 4 + sampleId % 13 );
+    }
+    MP4Close( file );
+    CHECK( ok );
+    return true;
+}
+
+static void
+readBytes( MP4File& file, uint64_t pos, std::vector<uint8_t>& bytes )
+{
+    file.ReadBytesAt( pos, &bytes[0], (uint32_t)bytes.size() );
+}
+
+static bool
+writeMoov( MP4File& file )
+{
+    MP4Atom* moov = file.FindAtom( "moov" );
+    CHECK( moov );
+    const uint64_t start = moov->GetStart();
+
+    // write moov past the end of the file the usual way, atom by atom
+    const uint64_t base = file.GetSize();
+    file.SetPosition( base );
+    moov->Write();
+    const uint64_t end = file.GetPosition();
+    const uint64_t size = moov->GetSize();
+    CHECK( moov->GetStart() == base );
+    CHECK( moov->GetEnd() == end );
+    CHECK( end - base == size + 8 );
+
+    std::vector<uint8_t> direct( (size_t)(end - base) );
+    readBytes( file, base, direct );
+
+    // scribble over it, then write it to memory and out in one piece
+    std::vector<uint8_t> scribble( direct.size(), 0xA5 );
+    file.SetPosition( base );
+    file.WriteBytes( &scribble[0], (uint32_t)scribble.size() );
+
+    file.SetPosition( base );
+    file.BeginBufferedWrite();
+    moov->Write();
+    CHECK( file.GetPosition() == end );
+    file.FinishBufferedWrite();
+    CHECK( file.GetPosition() == end );
+    CHECK( moov->GetStart() == base );
+    CHECK( moov->GetSize() == size );
+
+    std::vector<uint8_t> buffered( direct.size() );
+    readBytes( file, base, buffered );
+    CHECK( buffered == direct );
+
+    // an aborted write past the end must not reach the file
+    file.SetPosition( end );
+    file.WriteBytes( &scribble[0], (uint32_t)scribble.size() );
+    const uint64_t fileSize = file.GetSize();
+
+    file.SetPosition( end );
+    file.BeginBufferedWrite();
+    moov->Write();
+    file.AbortBufferedWrite();
+    CHECK( file.GetPosition() == end );
+    CHECK( file.GetSize() == fileSize );
+
+    std::vector<uint8_t> aborted( scribble.size() );
+    readBytes( file, end, aborted );
+    CHECK( aborted == scribble );
+    readBytes( file, base, buffered );
+    CHECK( buffered == direct );
+
+    // put the atom back where it was read from
+    moov->SetStart( start );
+    return true;
+}
+
+static bool
+checkBufferedWrite()
+{
+    MP4FileHandle handle = MP4Modify( FILE_NAME );
+    CHECK( handle != MP4_INVALID_FILE_HANDLE );
+
+    bool ok;
+    try {
+        ok = writeMoov( *(MP4File*)handle );
+    }
+    catch( Exception* x ) {
+        fprintf( stderr, "%s\n", x->msg().c_str() );
+        delete x;
+        ok = false;
+    }
+    MP4Close( handle );
+    CHECK( ok );
+
+    // the file is still readable
+    handle = MP4Read( FILE_NAME );
+    CHECK( handle != MP4_INVALID_FILE_HANDLE );
+    ok = MP4GetTrackNumberOfSamples( handle, 1 ) == NUM_SAMPLES
+        && MP4GetTrackNumberOfSamples( handle, 2 ) == NUM_SAMPLES;
+    MP4Close( handle );
+    CHECK( ok );
+    return true;
+}
+
+int
+main( int, char** )
+{
+    MP4LogSetLevel( MP4_LOG_ERROR );
+
+    bool ok = createFile()
+        && checkBufferedWrite();
+
+    remove( FILE_NAME );
+
+    printf( "%s\n", ok ? "PASS" : "FAIL" );
+    return ok ? 0 : 1;
+}
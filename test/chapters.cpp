@@ -0,0 +1,225 @@
+///////////////////////////////////////////////////////////////////////////////
+//
+//  The contents of this file are subject to the Mozilla Public License
+//  Version 1.1 (the "License"); you may not use this file except in
+//  compliance with the License. You may obtain a copy of the License at
+//  http://www.mozilla.org/MPL/
+//
+//  Software distributed under the License is distributed on an "AS IS"
+//  basis, WITHOUT WARRANTY OF ANY KIND, either express or implied. See the
+//  License for the specific language governing rights and limitations
+//  under the License.
+//
+//  The Original Code is MP4v2.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+// Writes QuickTime and Nero chapter lists with MP4SetChapters() and reads
+// them back with MP4GetChapters() before and after closing the file. The
+// lists hold empty, default, long and over-long titles, and the QuickTime
+// one has enough long titles to be read in more than one sample run. Also
+// converts QuickTime chapters to Nero chapters.
+
+#include <mp4v2/mp4v2.h>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#define CHECK(cond) \
+    do { \
+        if( !(cond) ) { \
+            fprintf( stderr, "%s:%d: check failed: %s\n", __FILE__, __LINE__, #cond ); \
+            return false; \
+        } \
+    } while( 0 )
+
+static const char* const FILE_NAME = "chapters.mp4";
+
+static const uint32_t NUM_SAMPLES       = 500;
+static const uint32_t NUM_QT_CHAPTERS   = 3000;
+static const uint32_t NUM_NERO_CHAPTERS = 300;
+
+// Nero titles have a one byte length
+static const uint32_t NERO_TITLE_MAX = 255;
+
+static std::string
+makeTitle( uint32_t i )
+{
+    char name[32];
+    snprintf( name, sizeof(name), "chapter %u ", i );
+    switch( i % 10 ) {
+    case 3:
+        return "";
+    case 4:
+    case 5:
+        return std::string( MP4V2_CHAPTER_TITLE_MAX + 10, (char)('a' + i % 26) );
+    case 6:
+    case 7:
+    case 8:
+        return name + std::string( 600 + i % 400, (char)('A' + i % 26) );
+    default:
+        return name + std::string( i % 50, '-' );
+    }
+}
+
+static void
+makeChapters( std::vector<MP4Chapter_t>& chapters, uint32_t count )
+{
+    chapters.resize( count );
+    for( uint32_t i = 0; i < count; i++ ) {
+        std::string title = makeTitle( i );
+        strncpy( chapters[i].title, title.c_str(), MP4V2_CHAPTER_TITLE_MAX );
+        chapters[i].title[MP4V2_CHAPTER_TITLE_MAX] = 0;
+        chapters[i].duration = 5 + i % 7;
+    }
+}
+
+static bool
+checkChapters( MP4FileHandle file, MP4ChapterType type, const std::vector<MP4Chapter_t>& expected, uint32_t titleMax )
+{
+    MP4Chapter_t* chapters = NULL;
+    uint32_t count = 0;
+    CHECK( MP4GetChapters( file, &chapters, &count, type ) == type );
+    CHECK( chapters != NULL );
+
+    bool ok = count == expected.size();
+    for( uint32_t i = 0; ok && i < count; i++ ) {
+        std::string title( expected[i].title, strnlen( expected[i].title, titleMax ));
+        ok = title == chapters[i].title;
+
+        // the last Nero chapter lasts until the end of the movie
+        if( type == MP4ChapterTypeNero && i == count - 1 ) {
+            MP4Duration end = MP4ConvertFromMovieDuration( file, MP4GetDuration( file ), MP4_MSECS_TIME_SCALE );
+            MP4Duration start = 0;
+            for( uint32_t j = 0; j < i; j++ )
+                start += expected[j].duration;
+            ok = ok && chapters[i].duration == end - start;
+        }
+        else {
+            ok = ok && chapters[i].duration == expected[i].duration;
+        }
+
+        if( !ok )
+            fprintf( stderr, "chapter %u of %u differs\n", i, count );
+    }
+    MP4Free( chapters );
+    CHECK( ok );
+    return true;
+}
+
+static bool
+checkNone( MP4FileHandle file, MP4ChapterType type )
+{
+    MP4Chapter_t* chapters = NULL;
+    uint32_t count = 0;
+    CHECK( MP4GetChapters( file, &chapters, &count, type ) == MP4ChapterTypeNone );
+    CHECK( chapters == NULL && count == 0 );
+    return true;
+}
+
+static bool
+createFile()
+{
+    MP4FileHandle file = MP4Create( FILE_NAME );
+    CHECK( file != MP4_INVALID_FILE_HANDLE );
+
+    bool ok = MP4AddAudioTrack( file, 48000, 1024, MP4_MPEG4_AUDIO_TYPE ) == 1;
+    uint8_t sample[16] = { 0 };
+    for( MP4SampleId sampleId = 1; ok && sampleId <= NUM_SAMPLES; sampleId++ )
+        ok = MP4WriteSample( file, 1, sample, sizeof(sample) );
+
+    ok = ok && checkNone( file, MP4ChapterTypeAny );
+    MP4Close( file );
+    CHECK( ok );
+    return true;
+}
+
+static bool
+checkQtAndNero()
+{
+    std::vector<MP4Chapter_t> qt;
+    std::vector<MP4Chapter_t> nero;
+    makeChapters( qt, NUM_QT_CHAPTERS );
+    makeChapters( nero, NUM_NERO_CHAPTERS );
+
+    MP4FileHandle file = MP4Modify( FILE_NAME );
+    CHECK( file != MP4_INVALID_FILE_HANDLE );
+
+    bool ok = MP4SetChapters( file, &qt[0], (uint32_t)qt.size(), MP4ChapterTypeQt ) == MP4ChapterTypeQt
+        && MP4SetChapters( file, &nero[0], (uint32_t)nero.size(), MP4ChapterTypeNero ) == MP4ChapterTypeNero
+        && checkChapters( file, MP4ChapterTypeQt, qt, MP4V2_CHAPTER_TITLE_MAX )
+        && checkChapters( file, MP4ChapterTypeNero, nero, NERO_TITLE_MAX );
+    MP4Close( file );
+    CHECK( ok );
+
+    file = MP4Read( FILE_NAME );
+    CHECK( file != MP4_INVALID_FILE_HANDLE );
+
+    // Any prefers QuickTime chapters
+    ok = checkChapters( file, MP4ChapterTypeQt, qt, MP4V2_CHAPTER_TITLE_MAX )
+        && checkChapters( file, MP4ChapterTypeNero, nero, NERO_TITLE_MAX );
+    MP4Chapter_t* chapters = NULL;
+    uint32_t count = 0;
+    ok = ok && MP4GetChapters( file, &chapters, &count, MP4ChapterTypeAny ) == MP4ChapterTypeQt
+        && count == NUM_QT_CHAPTERS;
+    MP4Free( chapters );
+    MP4Close( file );
+    CHECK( ok );
+    return true;
+}
+
+static bool
+checkAddAndConvert()
+{
+    MP4FileHandle file = MP4Modify( FILE_NAME );
+    CHECK( file != MP4_INVALID_FILE_HANDLE );
+
+    // chapters added one at a time, with default and empty titles
+    std::vector<MP4Chapter_t> expected( 4 );
+    static const char* const TITLES[] = { "first", NULL, "", "last" };
+    for( uint32_t i = 0; i < expected.size(); i++ ) {
+        if( TITLES[i] )
+            strcpy( expected[i].title, TITLES[i] );
+        else
+            snprintf( expected[i].title, sizeof(expected[i].title), "Chapter %03u", i + 1 );
+        expected[i].duration = 1000 * (i + 1);
+    }
+
+    bool ok = MP4DeleteChapters( file, MP4ChapterTypeAny ) == MP4ChapterTypeAny
+        && checkNone( file, MP4ChapterTypeAny );
+
+    MP4TrackId trackId = ok ? MP4AddChapterTextTrack( file, 1, 1000 ) : MP4_INVALID_TRACK_ID;
+    ok = trackId != MP4_INVALID_TRACK_ID;
+    for( uint32_t i = 0; ok && i < expected.size(); i++ )
+        MP4AddChapter( file, trackId, expected[i].duration, TITLES[i] );
+
+    ok = ok && checkChapters( file, MP4ChapterTypeQt, expected, MP4V2_CHAPTER_TITLE_MAX )
+        && checkNone( file, MP4ChapterTypeNero )
+        && MP4ConvertChapters( file, MP4ChapterTypeNero ) == MP4ChapterTypeNero;
+    MP4Close( file );
+    CHECK( ok );
+
+    file = MP4Read( FILE_NAME );
+    CHECK( file != MP4_INVALID_FILE_HANDLE );
+    ok = checkChapters( file, MP4ChapterTypeQt, expected, MP4V2_CHAPTER_TITLE_MAX )
+        && checkChapters( file, MP4ChapterTypeNero, expected, NERO_TITLE_MAX );
+    MP4Close( file );
+    CHECK( ok );
+    return true;
+}
+
+int
+main( int, char** )
+{
+    MP4LogSetLevel( MP4_LOG_ERROR );
+
+    bool ok = createFile()
+        && checkQtAndNero()
+        && checkAddAndConvert();
+
+    remove( FILE_NAME );
+
+    printf( "%s\n", ok ? "PASS" : "FAIL" );
+    return ok ? 0 : 1;
+}
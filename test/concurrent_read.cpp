@@ -0,0 +1,175 @@
+///////////////////////////////////////////////////////////////////////////////
+//
+//  The contents of this file are subject to the Mozilla Public License
+//  Version 1.1 (the "License"); you may not use this file except in
+//  compliance with the License. You may obtain a copy of the License at
+//  http://www.mozilla.org/MPL/
+//
+//  Software distributed under the License is distributed on an "AS IS"
+//  basis, WITHOUT WARRANTY OF ANY KIND, either express or implied. See the
+//  License for the specific language governing rights and limitations
+//  under the License.
+//
+//  The Original Code is MP4v2.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+// Reads the samples of one MP4Read() handle from several threads at once,
+// from a track stored in the file and from a track that refers to the data
+// of another file, and checks every sample's data, time and sync flag.
+// Referenced samples are also read while the file is still being written.
+
+#include <mp4v2/mp4v2.h>
+#include <atomic>
+#include <cstdio>
+#include <cstring>
+#include <thread>
+#include <vector>
+
+using namespace std;
+
+#define CHECK(cond) \
+    do { \
+        if( !(cond) ) { \
+            fprintf( stderr, "%s:%d: check failed: %s\n", __FILE__, __LINE__, #cond ); \
+            return false; \
+        } \
+    } while( 0 )
+
+static const char* const MEDIA_NAME = "concurrent-media.mp4";
+static const char* const FILE_NAME  = "concurrent.mp4";
+
+static const uint32_t NUM_SAMPLES = 2000;
+static const uint32_t NUM_THREADS = 8;
+static const uint32_t NUM_PASSES  = 4;
+
+// sample sizes and contents differ per track and sample
+static uint32_t
+sampleSize( MP4TrackId trackId, MP4SampleId sampleId )
+{
+    return 16 + (sampleId * 7 + trackId * 13) % 200;
+}
+
+static uint8_t
+sampleByte( MP4TrackId trackId, MP4SampleId sampleId, uint32_t offset )
+{
+    return (uint8_t)(sampleId * 31 + trackId * 17 + offset);
+}
+
+static bool
+writeSamples( MP4FileHandle file, MP4TrackId trackId, MP4TrackId contentId )
+{
+    uint8_t sample[256];
+    for( MP4SampleId sampleId = 1; sampleId <= NUM_SAMPLES; sampleId++ ) {
+        uint32_t size = sampleSize( contentId, sampleId );
+        for( uint32_t i = 0; i < size; i++ )
+            sample[i] = sampleByte( contentId, sampleId, i );
+        CHECK( MP4WriteSample( file, trackId, sample, size, MP4_INVALID_DURATION, 0, sampleId % 25 == 1 ));
+    }
+    return true;
+}
+
+static bool
+checkSample( MP4FileHandle file, MP4TrackId trackId, MP4SampleId sampleId )
+{
+    uint8_t* sample = NULL;
+    uint32_t size = 0;
+    MP4Timestamp startTime = 0;
+    bool sync = false;
+    CHECK( MP4ReadSample( file, trackId, sampleId, &sample, &size, &startTime, NULL, NULL, &sync ));
+
+    bool ok = size == sampleSize( trackId, sampleId )
+        && startTime == (MP4Timestamp)(sampleId - 1) * 3600
+        && sync == (sampleId % 25 == 1);
+    for( uint32_t i = 0; ok && i < size; i++ )
+        ok = sample[i] == sampleByte( trackId, sampleId, i );
+    MP4Free( sample );
+    CHECK( ok );
+
+    CHECK( MP4GetSampleSize( file, trackId, sampleId ) == size );
+    return true;
+}
+
+// track 1 holds its samples, track 2 refers to the samples of MEDIA_NAME
+static bool
+createFiles()
+{
+    MP4FileHandle media = MP4Create( MEDIA_NAME );
+    CHECK( media != MP4_INVALID_FILE_HANDLE );
+    MP4TrackId mediaId = MP4AddVideoTrack( media, 90000, 3600, 320, 240, MP4_MPEG4_VIDEO_TYPE );
+    CHECK( mediaId != MP4_INVALID_TRACK_ID );
+    CHECK( writeSamples( media, mediaId, 2 ));
+    MP4Close( media );
+
+    media = MP4Read( MEDIA_NAME );
+    CHECK( media != MP4_INVALID_FILE_HANDLE );
+
+    MP4FileHandle file = MP4Create( FILE_NAME );
+    CHECK( file != MP4_INVALID_FILE_HANDLE );
+    MP4TrackId trackId = MP4AddVideoTrack( file, 90000, 3600, 320, 240, MP4_MPEG4_VIDEO_TYPE );
+    CHECK( trackId == 1 );
+    CHECK( writeSamples( file, trackId, 1 ));
+
+    MP4TrackId refId = MP4CloneTrack( media, mediaId, file );
+    CHECK( refId == 2 );
+    for( MP4SampleId sampleId = 1; sampleId <= NUM_SAMPLES; sampleId++ )
+        CHECK( MP4ReferenceSample( media, mediaId, sampleId, file, refId ));
+
+    // referenced samples are read from the other file before it is closed
+    bool ok = true;
+    for( MP4SampleId sampleId = 1; ok && sampleId <= NUM_SAMPLES; sampleId += 37 )
+        ok = checkSample( file, refId, sampleId );
+
+    MP4Close( file );
+    MP4Close( media );
+    return ok;
+}
+
+// each thread walks the samples with its own stride, so threads hit
+// different parts of the tables and of the file at the same time
+static void
+readAll( MP4FileHandle file, uint32_t index, atomic<uint32_t>* failures )
+{
+    uint32_t stride = 2 * index + 1;
+    for( uint32_t pass = 0; pass < NUM_PASSES; pass++ ) {
+        for( uint32_t n = 0; n < NUM_SAMPLES; n++ ) {
+            MP4SampleId sampleId = (MP4SampleId)((n * stride + index * 97 + pass) % NUM_SAMPLES) + 1;
+            MP4TrackId trackId = (MP4TrackId)((n + index) % 2) + 1;
+            if( !checkSample( file, trackId, sampleId ))
+                (*failures)++;
+        }
+    }
+}
+
+static bool
+checkConcurrentReads()
+{
+    MP4FileHandle file = MP4Read( FILE_NAME );
+    CHECK( file != MP4_INVALID_FILE_HANDLE );
+
+    atomic<uint32_t> failures( 0 );
+    vector<thread> threads;
+    for( uint32_t i = 0; i < NUM_THREADS; i++ )
+        threads.push_back( thread( readAll, file, i, &failures ));
+    for( uint32_t i = 0; i < NUM_THREADS; i++ )
+        threads[i].join();
+
+    MP4Close( file );
+    CHECK( failures == 0 );
+    return true;
+}
+
+int
+main( int, char** )
+{
+    MP4LogSetLevel( MP4_LOG_ERROR );
+
+    bool ok = createFiles()
+        && checkConcurrentReads();
+
+    remove( FILE_NAME );
+    remove( MEDIA_NAME );
+
+    printf( "%s\n", ok ? "PASS" : "FAIL" );
+    return ok ? 0 : 1;
+}
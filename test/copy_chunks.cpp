@@ -0,0 +1,151 @@
+///////////////////////////////////////////////////////////////////////////////
+//
+//  The contents of this file are subject to the Mozilla Public License
+//  Version 1.1 (the "License"); you may not use this file except in
+//  compliance with the License. You may obtain a copy of the License at
+//  http://www.mozilla.org/MPL/
+//
+//  Software distributed under the License is distributed on an "AS IS"
+//  basis, WITHOUT WARRANTY OF ANY KIND, either express or implied. See the
+//  License for the specific language governing rights and limitations
+//  under the License.
+//
+//  The Original Code is MP4v2.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+// Copies a track with sync samples and one without with MP4CopyTrack(),
+// which copies whole chunks when no edits are applied, and checks the
+// sample tables and data of the copies.
+
+#include <mp4v2/mp4v2.h>
+#include <cstdio>
+#include <cstring>
+
+#define CHECK(cond) \
+    do { \
+        if( !(cond) ) { \
+            fprintf( stderr, "%s:%d: check failed: %s\n", __FILE__, __LINE__, #cond ); \
+            return false; \
+        } \
+    } while( 0 )
+
+static const char* const SRC_NAME = "copy-chunks-src.mp4";
+static const char* const DST_NAME = "copy-chunks-dst.mp4";
+
+static const uint32_t NUM_SAMPLES = 90;
+
+// track 1 has a sync sample every 12 samples, track 2 only sync samples
+static bool
+isSync( MP4TrackId trackId, MP4SampleId sampleId )
+{
+    return trackId == 2 || sampleId % 12 == 5;
+}
+
+static bool
+createSource()
+{
+    MP4FileHandle file = MP4Create( SRC_NAME );
+    CHECK( file != MP4_INVALID_FILE_HANDLE );
+
+    uint8_t sample[40];
+    for( MP4TrackId trackId = 1; trackId <= 2; trackId++ ) {
+        CHECK( MP4AddVideoTrack( file, 90000, 3000, 320, 240, MP4_MPEG4_VIDEO_TYPE ) == trackId );
+        CHECK( MP4SetTrackDurationPerChunk( file, trackId, 7 * 3000 ));
+
+        for( MP4SampleId sampleId = 1; sampleId <= NUM_SAMPLES; sampleId++ ) {
+            memset( sample, (int)(sampleId + trackId * 100), sizeof(sample) );
+            CHECK( MP4WriteSample( file, trackId, sample, 8 + sampleId % 32, MP4_INVALID_DURATION,
+                                   0, isSync( trackId, sampleId )));
+        }
+    }
+
+    MP4Close( file );
+    return true;
+}
+
+static bool
+checkCopy( MP4FileHandle src, MP4FileHandle dst, MP4TrackId trackId )
+{
+    uint64_t srcCount = 0;
+    uint64_t dstCount = 0;
+    bool srcHasStss = MP4GetTrackIntegerProperty( src, trackId, "mdia.minf.stbl.stss.entryCount", &srcCount );
+    bool dstHasStss = MP4GetTrackIntegerProperty( dst, trackId, "mdia.minf.stbl.stss.entryCount", &dstCount );
+    CHECK( srcHasStss == (trackId == 1) );
+    CHECK( dstHasStss == srcHasStss );
+    CHECK( dstCount == srcCount );
+
+    // stss entries are copied in order
+    char name[64];
+    for( uint32_t i = 0; i < dstCount; i++ ) {
+        snprintf( name, sizeof(name), "mdia.minf.stbl.stss.entries[%u].sampleNumber", i );
+        uint64_t sampleNumber = 0;
+        CHECK( MP4GetTrackIntegerProperty( dst, trackId, name, &sampleNumber ));
+        CHECK( sampleNumber == 12 * i + 5 );
+    }
+
+    // copied sample by sample the chunks would hold a second each, not 7
+    // samples as in the source
+    uint64_t numChunks = 0;
+    CHECK( MP4GetTrackIntegerProperty( dst, trackId, "mdia.minf.stbl.stco.entryCount", &numChunks ));
+    CHECK( numChunks == (NUM_SAMPLES + 6) / 7 );
+
+    CHECK( MP4GetTrackNumberOfSamples( dst, trackId ) == NUM_SAMPLES );
+    for( MP4SampleId sampleId = 1; sampleId <= NUM_SAMPLES; sampleId++ ) {
+        uint8_t* sample = NULL;
+        uint32_t sampleSize = 0;
+        MP4Timestamp startTime = 0;
+        bool sync = false;
+        CHECK( MP4ReadSample( dst, trackId, sampleId, &sample, &sampleSize, &startTime, NULL, NULL, &sync ));
+        bool ok = sampleSize == 8 + sampleId % 32
+            && sample[0] == (uint8_t)(sampleId + trackId * 100)
+            && startTime == (MP4Timestamp)(sampleId - 1) * 3000
+            && sync == isSync( trackId, sampleId );
+        MP4Free( sample );
+        CHECK( ok );
+    }
+    return true;
+}
+
+static bool
+checkCopies()
+{
+    MP4FileHandle src = MP4Read( SRC_NAME );
+    CHECK( src != MP4_INVALID_FILE_HANDLE );
+
+    MP4FileHandle dst = MP4Create( DST_NAME );
+    bool ok = dst != MP4_INVALID_FILE_HANDLE
+        && MP4CopyTrack( src, 1, dst ) == 1
+        && MP4CopyTrack( src, 2, dst ) == 2;
+    if( dst != MP4_INVALID_FILE_HANDLE )
+        MP4Close( dst );
+    if( !ok ) {
+        MP4Close( src );
+        CHECK( ok );
+    }
+
+    dst = MP4Read( DST_NAME );
+    ok = dst != MP4_INVALID_FILE_HANDLE
+        && checkCopy( src, dst, 1 )
+        && checkCopy( src, dst, 2 );
+    if( dst != MP4_INVALID_FILE_HANDLE )
+        MP4Close( dst );
+
+    MP4Close( src );
+    return ok;
+}
+
+int
+main( int, char** )
+{
+    MP4LogSetLevel( MP4_LOG_ERROR );
+
+    bool ok = createSource()
+        && checkCopies();
+
+    remove( SRC_NAME );
+    remove( DST_NAME );
+
+    printf( "%s\n", ok ? "PASS" : "FAIL" );
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,203 @@
+///////////////////////////////////////////////////////////////////////////////
+//
+//  The contents of this file are subject to the Mozilla Public License
+//  Version 1.1 (the "License"); you may not use this file except in
+//  compliance with the License. You may obtain a copy of the License at
+//  http://www.mozilla.org/MPL/
+//
+//  Software distributed under the License is distributed on an "AS IS"
+//  basis, WITHOUT WARRANTY OF ANY KIND, either express or implied. See the
+//  License for the specific language governing rights and limitations
+//  under the License.
+//
+//  The Original Code is MP4v2.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+// Lists the samples needed to decode time ranges of a track with sample
+// dependency flags and of a track without, while the file is written and
+// after it is read back, and checks each listed sample's data.
+
+#include <mp4v2/mp4v2.h>
+#include <cstdio>
+#include <cstring>
+
+#define CHECK(cond) \
+    do { \
+        if( !(cond) ) { \
+            fprintf( stderr, "%s:%d: check failed: %s\n", __FILE__, __LINE__, #cond ); \
+            return false; \
+        } \
+    } while( 0 )
+
+static const char* const FILE_NAME = "decodable-samples.mp4";
+
+static const uint32_t    NUM_SAMPLES     = 35;
+static const MP4Duration SAMPLE_DURATION = 3000;
+static const uint32_t    GOP_SIZE        = 10;
+
+// track 1 has sdtp, track 2 the same samples without
+static const MP4TrackId SDTP_TRACK  = 1;
+static const MP4TrackId PLAIN_TRACK = 2;
+
+// each GOP is a sync sample followed by alternating P and B frames, of
+// which only the B frames are not referenced by other samples
+static bool
+isSync( MP4SampleId sampleId )
+{
+    return sampleId % GOP_SIZE == 1;
+}
+
+static bool
+isDisposable( MP4SampleId sampleId )
+{
+    return sampleId % 2 == 0;
+}
+
+static uint32_t
+sampleSize( MP4SampleId sampleId )
+{
+    return 20 + sampleId % 7;
+}
+
+static uint64_t
+chunkCount( MP4FileHandle file, MP4TrackId trackId )
+{
+    uint64_t count = 0;
+    MP4GetTrackIntegerProperty( file, trackId, "mdia.minf.stbl.stco.entryCount", &count );
+    return count;
+}
+
+// the listed samples must be those from firstId to lastId, less the
+// disposable ones if the track has sdtp
+static bool
+checkList( MP4TrackId trackId, const MP4DecodableSample* samples, uint32_t numSamples,
+           MP4SampleId firstId, MP4SampleId lastId )
+{
+    FILE* in = fopen( FILE_NAME, "rb" );
+    CHECK( in );
+
+    uint32_t n = 0;
+    bool ok = true;
+    for( MP4SampleId sampleId = firstId; ok && sampleId <= lastId; sampleId++ ) {
+        if( trackId == SDTP_TRACK && !isSync( sampleId ) && isDisposable( sampleId ))
+            continue;
+
+        const MP4DecodableSample& sample = samples[n++];
+        uint8_t data = 0;
+        ok = n <= numSamples
+            && sample.sampleId == sampleId
+            && sample.size == sampleSize( sampleId )
+            && sample.startTime == (sampleId - 1) * SAMPLE_DURATION
+            && sample.duration == SAMPLE_DURATION
+            && sample.renderingOffset == 0
+            && sample.isSyncSample == isSync( sampleId )
+            && fseek( in, (long)sample.offset, SEEK_SET ) == 0
+            && fread( &data, 1, 1, in ) == 1
+            && data == (uint8_t)(sampleId * trackId);
+    }
+    fclose( in );
+
+    CHECK( ok );
+    CHECK( n == numSamples );
+    return true;
+}
+
+static bool
+checkRange( MP4FileHandle file, MP4TrackId trackId, MP4Timestamp startTime, MP4Duration duration,
+            MP4SampleId firstId, MP4SampleId lastId )
+{
+    MP4DecodableSample* samples = NULL;
+    uint32_t numSamples = 0;
+    CHECK( MP4GetDecodableSamples( file, trackId, startTime, duration, &samples, &numSamples ));
+
+    bool ok = checkList( trackId, samples, numSamples, firstId, lastId );
+    MP4Free( samples );
+    return ok;
+}
+
+static bool
+createFile()
+{
+    MP4FileHandle file = MP4Create( FILE_NAME );
+    CHECK( file != MP4_INVALID_FILE_HANDLE );
+
+    uint8_t sample[32];
+    for( MP4TrackId trackId = SDTP_TRACK; trackId <= PLAIN_TRACK; trackId++ ) {
+        CHECK( MP4AddVideoTrack( file, 90000, SAMPLE_DURATION, 320, 240, MP4_MPEG4_VIDEO_TYPE ) == trackId );
+        CHECK( MP4SetTrackDurationPerChunk( file, trackId, GOP_SIZE * SAMPLE_DURATION ));
+
+        for( MP4SampleId sampleId = 1; sampleId <= NUM_SAMPLES; sampleId++ ) {
+            memset( sample, (int)(sampleId * trackId), sizeof(sample) );
+            if( trackId == SDTP_TRACK ) {
+                uint32_t flags = isDisposable( sampleId ) ? MP4_SDT_HAS_NO_DEPENDENTS : MP4_SDT_HAS_DEPENDENTS;
+                CHECK( MP4WriteSampleDependency( file, trackId, sample, sampleSize( sampleId ),
+                                                 SAMPLE_DURATION, 0, isSync( sampleId ), flags ));
+            }
+            else {
+                CHECK( MP4WriteSample( file, trackId, sample, sampleSize( sampleId ),
+                                       SAMPLE_DURATION, 0, isSync( sampleId )));
+            }
+        }
+    }
+
+    // the last 5 samples wait in the chunk buffer, are not listed and are
+    // not written out by the query
+    bool ok = true;
+    for( MP4TrackId trackId = SDTP_TRACK; ok && trackId <= PLAIN_TRACK; trackId++ ) {
+        MP4DecodableSample* samples = NULL;
+        uint32_t numSamples = 0;
+        ok = chunkCount( file, trackId ) == 3
+            && MP4GetDecodableSamples( file, trackId, 0, MP4_INVALID_DURATION, &samples, &numSamples )
+            && chunkCount( file, trackId ) == 3
+            && numSamples > 0
+            && samples[numSamples - 1].sampleId <= 3 * GOP_SIZE;
+        MP4Free( samples );
+    }
+
+    MP4Close( file );
+    CHECK( ok );
+    return true;
+}
+
+static bool
+checkFile()
+{
+    MP4FileHandle file = MP4Read( FILE_NAME );
+    CHECK( file != MP4_INVALID_FILE_HANDLE );
+
+    bool ok = true;
+    for( MP4TrackId trackId = SDTP_TRACK; ok && trackId <= PLAIN_TRACK; trackId++ ) {
+        // from sample 15 for 4 samples: decoding starts at sync sample 11
+        ok = checkRange( file, trackId, 14 * SAMPLE_DURATION, 4 * SAMPLE_DURATION, 11, 18 )
+            // on a sync sample for one tick
+            && checkRange( file, trackId, 20 * SAMPLE_DURATION, 1, 21, 21 )
+            // the end of the range must not wrap around
+            && checkRange( file, trackId, 14 * SAMPLE_DURATION, MP4_INVALID_DURATION, 11, NUM_SAMPLES )
+            && checkRange( file, trackId, 0, MP4_INVALID_DURATION - 1, 1, NUM_SAMPLES );
+    }
+
+    // past the end of the track nothing is listed
+    MP4DecodableSample* samples = NULL;
+    uint32_t numSamples = 1;
+    ok = ok && MP4GetDecodableSamples( file, PLAIN_TRACK, NUM_SAMPLES * SAMPLE_DURATION, 1, &samples, &numSamples )
+        && samples == NULL && numSamples == 0;
+
+    MP4Close( file );
+    CHECK( ok );
+    return true;
+}
+
+int
+main( int, char** )
+{
+    MP4LogSetLevel( MP4_LOG_ERROR );
+
+    bool ok = createFile()
+        && checkFile();
+
+    remove( FILE_NAME );
+
+    printf( "%s\n", ok ? "PASS" : "FAIL" );
+    return ok ? 0 : 1;
+}
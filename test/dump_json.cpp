@@ -0,0 +1,582 @@
+///////////////////////////////////////////////////////////////////////////////
+//
+//  The contents of this file are subject to the Mozilla Public License
+//  Version 1.1 (the "License"); you may not use this file except in
+//  compliance with the License. You may obtain a copy of the License at
+//  http://www.mozilla.org/MPL/
+//
+//  Software distributed under the License is distributed on an "AS IS"
+//  basis, WITHOUT WARRANTY OF ANY KIND, either express or implied. See the
+//  License for the specific language governing rights and limitations
+//  under the License.
+//
+//  The Original Code is MP4v2.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+// Dumps a file with MP4DumpJson() and MP4DumpJsonCallback(), summarized
+// and in full, and parses the output. Checks the atom sizes, a summarized
+// and a full sample size table, chapter titles that need escaping or hold
+// invalid UTF-8, and a byte property longer than the summary keeps. Also
+// checks that a failing write function ends the dump and that mp4file
+// --dump-json writes the same text.
+//
+// The path of mp4file is the first argument, ./mp4file by default.
+
+#include <mp4v2/mp4v2.h>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <algorithm>
+#include <string>
+#include <vector>
+
+#ifndef _WIN32
+#   include <sys/wait.h>
+#endif
+
+using namespace std;
+
+#define CHECK(cond) \
+    do { \
+        if( !(cond) ) { \
+            fprintf( stderr, "%s:%d: check failed: %s\n", __FILE__, __LINE__, #cond ); \
+            return false; \
+        } \
+    } while( 0 )
+
+static const char* const FILE_NAME = "dump-json.mp4";
+static const char* const JSON_NAME = "dump-json.json";
+static const char* const OUT_NAME  = "dump-json.txt";
+
+// enough sample sizes for the full dump to take several blocks
+static const uint32_t NUM_SAMPLES = 20000;
+static const uint32_t CONFIG_SIZE = 200;
+
+static string tool = "./mp4file";
+
+// titles as written, and as they read back from JSON
+struct Title {
+    const char* raw;
+    const char* decoded;
+};
+
+static const Title TITLES[] = {
+    { "plain", "plain" },
+    { "quote \" backslash \\ slash /", "quote \" backslash \\ slash /" },
+    { "newline \n return \r tab \t", "newline \n return \r tab \t" },
+    { "control \x01\x1f delete \x7f", "control \x01\x1f delete \x7f" },
+    { "utf-8 \xc3\xa9 \xe2\x82\xac \xf0\x9f\x8e\xb5", "utf-8 \xc3\xa9 \xe2\x82\xac \xf0\x9f\x8e\xb5" },
+    // each byte of invalid UTF-8 is escaped as the code point of that value
+    { "invalid \xff \xc3 \xed\xa0\x80 \xc0\xaf", "invalid \xc3\xbf \xc3\x83 \xc3\xad\xc2\xa0\xc2\x80 \xc3\x80\xc2\xaf" },
+    { "", "" },
+};
+static const uint32_t NUM_TITLES = sizeof(TITLES) / sizeof(TITLES[0]);
+
+static uint32_t
+sampleSize( MP4SampleId sampleId )
+{
+    return 10 + sampleId * 7 % 90;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+// just enough JSON to check the dump
+struct Value {
+    enum Type { NUL, BOOL, NUMBER, STRING, ARRAY, OBJECT };
+
+    Type                         type;
+    bool                         boolean;
+    uint64_t                     number;
+    string                       text;
+    vector<Value>                items;
+    vector<pair<string, Value> > members;
+
+    Value() : type( NUL ), boolean( false ), number( 0 ) { }
+
+    const Value* member( const char* key ) const
+    {
+        for( size_t i = 0; i < members.size(); i++ ) {
+            if( members[i].first == key )
+                return &members[i].second;
+        }
+        return NULL;
+    }
+};
+
+class Parser
+{
+public:
+    Parser( const string& text ) : _text( text ), _pos( 0 ) { }
+
+    bool parse( Value& value )
+    {
+        return parseValue( value ) && (skip(), _pos == _text.size());
+    }
+
+private:
+    void skip()
+    {
+        while( _pos < _text.size() && strchr( " \t\r\n", _text[_pos] ))
+            _pos++;
+    }
+
+    bool expect( char c )
+    {
+        skip();
+        if( _pos >= _text.size() || _text[_pos] != c )
+            return false;
+        _pos++;
+        return true;
+    }
+
+    bool literal( const char* word )
+    {
+        size_t len = strlen( word );
+        if( _text.compare( _pos, len, word ))
+            return false;
+        _pos += len;
+        return true;
+    }
+
+    static void
+    appendUtf8( string& out, uint32_t cp )
+    {
+        if( cp < 0x80 ) {
+            out += (char)cp;
+        }
+        else if( cp < 0x800 ) {
+            out += (char)(0xc0 | cp >> 6);
+            out += (char)(0x80 | (cp & 0x3f));
+        }
+        else {
+            out += (char)(0xe0 | cp >> 12);
+            out += (char)(0x80 | (cp >> 6 & 0x3f));
+            out += (char)(0x80 | (cp & 0x3f));
+        }
+    }
+
+    bool parseString( string& out )
+    {
+        if( !expect( '"' ))
+            return false;
+        for( ;; ) {
+            if( _pos >= _text.size() )
+                return false;
+            unsigned char c = _text[_pos++];
+            if( c == '"' )
+                return true;
+            if( c < 0x20 )
+                return false;
+            if( c != '\\' ) {
+                out += (char)c;
+                continue;
+            }
+            if( _pos >= _text.size() )
+                return false;
+            switch( _text[_pos++] ) {
+                case '"':  out += '"';  break;
+                case '\\': out += '\\'; break;
+                case '/':  out += '/';  break;
+                case 'b':  out += '\b'; break;
+                case 'f':  out += '\f'; break;
+                case 'n':  out += '\n'; break;
+                case 'r':  out += '\r'; break;
+                case 't':  out += '\t'; break;
+                case 'u':
+                {
+                    if( _pos + 4 > _text.size() )
+                        return false;
+                    char* end;
+                    string hex = _text.substr( _pos, 4 );
+                    uint32_t cp = (uint32_t)strtoul( hex.c_str(), &end, 16 );
+                    if( *end )
+                        return false;
+                    appendUtf8( out, cp );
+                    _pos += 4;
+                    break;
+                }
+                default:
+                    return false;
+            }
+        }
+    }
+
+    bool parseValue( Value& value )
+    {
+        skip();
+        if( _pos >= _text.size() )
+            return false;
+
+        char c = _text[_pos];
+        if( c == '{' ) {
+            _pos++;
+            value.type = Value::OBJECT;
+            if( expect( '}' ))
+                return true;
+            do {
+                value.members.push_back( pair<string, Value>() );
+                if( !parseString( value.members.back().first ) || !expect( ':' )
+                    || !parseValue( value.members.back().second ))
+                    return false;
+            } while( expect( ',' ));
+            return expect( '}' );
+        }
+        if( c == '[' ) {
+            _pos++;
+            value.type = Value::ARRAY;
+            if( expect( ']' ))
+                return true;
+            do {
+                value.items.push_back( Value() );
+                if( !parseValue( value.items.back() ))
+                    return false;
+            } while( expect( ',' ));
+            return expect( ']' );
+        }
+        if( c == '"' ) {
+            value.type = Value::STRING;
+            return parseString( value.text );
+        }
+        if( c >= '0' && c <= '9' ) {
+            value.type = Value::NUMBER;
+            while( _pos < _text.size() && _text[_pos] >= '0' && _text[_pos] <= '9' )
+                value.number = value.number * 10 + (_text[_pos++] - '0');
+            return true;
+        }
+        if( literal( "true" )) {
+            value.type = Value::BOOL;
+            value.boolean = true;
+            return true;
+        }
+        if( literal( "false" )) {
+            value.type = Value::BOOL;
+            return true;
+        }
+        return literal( "null" );
+    }
+
+    const string& _text;
+    size_t        _pos;
+};
+
+///////////////////////////////////////////////////////////////////////////////
+
+// depth first search for an atom of a type
+static const Value*
+findAtom( const Value& atoms, const char* type )
+{
+    for( size_t i = 0; i < atoms.items.size(); i++ ) {
+        const Value& atom = atoms.items[i];
+        const Value* t = atom.member( "type" );
+        if( t && t->text == type )
+            return &atom;
+        const Value* children = atom.member( "children" );
+        if( children ) {
+            const Value* found = findAtom( *children, type );
+            if( found )
+                return found;
+        }
+    }
+    return NULL;
+}
+
+// depth first search for a bytes value of a size
+static const Value*
+findBytes( const Value& value, uint64_t size )
+{
+    const Value* s = value.member( "size" );
+    if( s && s->number == size && value.member( "hex" ))
+        return &value;
+    for( size_t i = 0; i < value.members.size(); i++ ) {
+        const Value* found = findBytes( value.members[i].second, size );
+        if( found )
+            return found;
+    }
+    for( size_t i = 0; i < value.items.size(); i++ ) {
+        const Value* found = findBytes( value.items[i], size );
+        if( found )
+            return found;
+    }
+    return NULL;
+}
+
+static string
+toHex( const uint8_t* bytes, uint32_t size )
+{
+    static const char digits[] = "0123456789abcdef";
+    string hex;
+    for( uint32_t i = 0; i < size; i++ ) {
+        hex += digits[bytes[i] >> 4];
+        hex += digits[bytes[i] & 0xf];
+    }
+    return hex;
+}
+
+static void
+makeConfig( uint8_t* config )
+{
+    for( uint32_t i = 0; i < CONFIG_SIZE; i++ )
+        config[i] = (uint8_t)(i * 13);
+}
+
+static bool
+createFile()
+{
+    MP4FileHandle file = MP4Create( FILE_NAME );
+    CHECK( file != MP4_INVALID_FILE_HANDLE );
+
+    uint8_t config[CONFIG_SIZE];
+    makeConfig( config );
+    bool ok = MP4AddVideoTrack( file, 90000, 3000, 320, 240, MP4_MPEG4_VIDEO_TYPE ) == 1
+        && MP4SetTrackESConfiguration( file, 1, config, CONFIG_SIZE );
+
+    uint8_t sample[100];
+    memset( sample, 0, sizeof(sample) );
+    for( MP4SampleId sampleId = 1; ok && sampleId <= NUM_SAMPLES; sampleId++ )
+        ok = MP4WriteSample( file, 1, sample, sampleSize( sampleId ));
+
+    for( uint32_t i = 0; ok && i < NUM_TITLES; i++ )
+        MP4AddNeroChapter( file, i * 10000000, TITLES[i].raw );
+
+    MP4Close( file );
+    CHECK( ok );
+    return true;
+}
+
+static bool
+readFile( const char* name, string& text )
+{
+    text.clear();
+    FILE* in = fopen( name, "rb" );
+    CHECK( in );
+    char buffer[4096];
+    size_t n;
+    while( (n = fread( buffer, 1, sizeof(buffer), in )) > 0 )
+        text.append( buffer, n );
+    fclose( in );
+    return true;
+}
+
+struct Output {
+    string   text;
+    uint32_t numCalls;
+    uint32_t failAt;   // call that fails, 0 for none
+
+    Output( uint32_t failAt_ = 0 ) : numCalls( 0 ), failAt( failAt_ ) { }
+};
+
+static int
+writeOutput( void* handle, const char* text, uint32_t size )
+{
+    Output& out = *(Output*)handle;
+    if( ++out.numCalls == out.failAt )
+        return 1;
+    out.text.append( text, size );
+    return 0;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+static bool
+checkTable( const Value& table, bool full, uint32_t tableEntries )
+{
+    CHECK( table.member( "count" ) && table.member( "count" )->number == NUM_SAMPLES );
+    const Value* columns = table.member( "columns" );
+    CHECK( columns );
+    const Value* sizes = columns->member( "entrySize" );
+    CHECK( sizes );
+
+    if( full ) {
+        CHECK( sizes->type == Value::ARRAY && sizes->items.size() == NUM_SAMPLES );
+        for( uint32_t i = 0; i < NUM_SAMPLES; i++ )
+            CHECK( sizes->items[i].number == sampleSize( i + 1 ));
+        return true;
+    }
+
+    const Value* first = sizes->member( "first" );
+    const Value* last = sizes->member( "last" );
+    CHECK( first && first->items.size() == tableEntries );
+    CHECK( last && last->items.size() == tableEntries );
+    for( uint32_t i = 0; i < tableEntries; i++ ) {
+        CHECK( first->items[i].number == sampleSize( i + 1 ));
+        CHECK( last->items[i].number == sampleSize( NUM_SAMPLES - tableEntries + i + 1 ));
+    }
+    CHECK( sizes->member( "min" ) && sizes->member( "min" )->number == 10 );
+    CHECK( sizes->member( "max" ) && sizes->member( "max" )->number == 99 );
+    return true;
+}
+
+static bool
+checkTitle( const Value& value, uint32_t index )
+{
+    CHECK( value.type == Value::STRING );
+    if( value.text != TITLES[index].decoded ) {
+        fprintf( stderr, "title %u differs\n", index );
+        return false;
+    }
+    return true;
+}
+
+static bool
+checkTitles( const Value& chapters, bool full, uint32_t tableEntries )
+{
+    const Value* columns = chapters.member( "columns" );
+    CHECK( columns );
+    const Value* titles = columns->member( "title" );
+    CHECK( titles );
+
+    if( full ) {
+        CHECK( titles->items.size() == NUM_TITLES );
+        for( uint32_t i = 0; i < NUM_TITLES; i++ )
+            CHECK( checkTitle( titles->items[i], i ));
+        return true;
+    }
+
+    const Value* first = titles->member( "first" );
+    const Value* last = titles->member( "last" );
+    CHECK( first && first->items.size() == tableEntries );
+    CHECK( last && last->items.size() == min( NUM_TITLES - tableEntries, tableEntries ));
+    for( uint32_t i = 0; i < first->items.size(); i++ )
+        CHECK( checkTitle( first->items[i], i ));
+    for( uint32_t i = 0; i < last->items.size(); i++ )
+        CHECK( checkTitle( last->items[i], NUM_TITLES - (uint32_t)last->items.size() + i ));
+    return true;
+}
+
+static bool
+checkDump( const string& text, uint32_t flags, uint32_t tableEntries )
+{
+    Value root;
+    Parser parser( text );
+    CHECK( parser.parse( root ));
+    CHECK( root.type == Value::OBJECT );
+
+    CHECK( root.member( "file" ) && root.member( "file" )->text == FILE_NAME );
+    const Value* size = root.member( "size" );
+    const Value* atoms = root.member( "atoms" );
+    CHECK( size && atoms && atoms->type == Value::ARRAY );
+
+    // the top level atoms cover the file
+    uint64_t end = 0;
+    for( size_t i = 0; i < atoms->items.size(); i++ ) {
+        const Value& atom = atoms->items[i];
+        CHECK( atom.member( "offset" ) && atom.member( "offset" )->number == end );
+        end += atom.member( "size" )->number;
+    }
+    CHECK( end == size->number );
+
+    const bool full = (flags & MP4_DUMP_JSON_FULL) != 0;
+
+    const Value* stsz = findAtom( *atoms, "stsz" );
+    CHECK( stsz && stsz->member( "properties" ));
+    const Value* entries = stsz->member( "properties" )->member( "entries" );
+    CHECK( entries && checkTable( *entries, full, tableEntries ));
+
+    const Value* chpl = findAtom( *atoms, "chpl" );
+    CHECK( chpl && chpl->member( "properties" ));
+    const Value* chapters = chpl->member( "properties" )->member( "chapters" );
+    CHECK( chapters && checkTitles( *chapters, full, tableEntries ));
+
+    // the decoder configuration is cut unless dumping in full
+    uint8_t config[CONFIG_SIZE];
+    makeConfig( config );
+    const Value* info = findBytes( *findAtom( *atoms, "esds" ), CONFIG_SIZE );
+    CHECK( info );
+    const Value* truncated = info->member( "truncated" );
+    if( full ) {
+        CHECK( info->member( "hex" )->text == toHex( config, CONFIG_SIZE ));
+        CHECK( !truncated );
+    }
+    else {
+        CHECK( info->member( "hex" )->text == toHex( config, 128 ));
+        CHECK( truncated && truncated->type == Value::BOOL && truncated->boolean );
+    }
+    return true;
+}
+
+static bool
+checkLibrary( uint32_t flags, uint32_t tableEntries )
+{
+    MP4FileHandle file = MP4Read( FILE_NAME );
+    CHECK( file != MP4_INVALID_FILE_HANDLE );
+
+    Output out;
+    string text;
+    bool ok = MP4DumpJsonCallback( file, writeOutput, &out, flags, tableEntries )
+        && MP4DumpJson( file, JSON_NAME, flags, tableEntries )
+        && readFile( JSON_NAME, text );
+
+    // a failing write function gets no more output
+    Output failed( 1 );
+    MP4LogSetLevel( MP4_LOG_NONE );
+    ok = ok && !MP4DumpJsonCallback( file, writeOutput, &failed, flags, tableEntries )
+        && failed.numCalls == 1;
+    MP4LogSetLevel( MP4_LOG_ERROR );
+    MP4Close( file );
+    CHECK( ok );
+
+    CHECK( out.text == text );
+    if( flags & MP4_DUMP_JSON_FULL )
+        CHECK( out.numCalls > 1 );
+    CHECK( checkDump( text, flags, tableEntries ));
+    return true;
+}
+
+// runs mp4file with options, returns its exit code, the output goes to
+// OUT_NAME
+static int
+runTool( const string& options )
+{
+    string command = "\"" + tool + "\" " + options + " " + FILE_NAME + " > " + OUT_NAME;
+
+    int status = system( command.c_str() );
+#ifndef _WIN32
+    status = WIFEXITED( status ) ? WEXITSTATUS( status ) : -1;
+#endif
+    return status;
+}
+
+static bool
+checkTool( const string& options, uint32_t flags, uint32_t tableEntries )
+{
+    CHECK( runTool( "--dump-json " + options ) == 0 );
+
+    MP4FileHandle file = MP4Read( FILE_NAME );
+    CHECK( file != MP4_INVALID_FILE_HANDLE );
+    bool ok = MP4DumpJson( file, JSON_NAME, flags, tableEntries );
+    MP4Close( file );
+    CHECK( ok );
+
+    string text;
+    string expected;
+    CHECK( readFile( OUT_NAME, text ));
+    CHECK( readFile( JSON_NAME, expected ));
+    CHECK( text == expected );
+    return true;
+}
+
+int
+main( int argc, char** argv )
+{
+    MP4LogSetLevel( MP4_LOG_ERROR );
+
+    if( argc > 1 )
+        tool = argv[1];
+
+    bool ok = createFile()
+        && checkLibrary( 0, 3 )
+        && checkLibrary( 0, 5 )
+        && checkLibrary( MP4_DUMP_JSON_FULL, 3 )
+        && checkLibrary( MP4_DUMP_JSON_FULL | MP4_DUMP_JSON_IMPLICITS, 3 )
+        && checkTool( "", 0, 3 )
+        && checkTool( "--table-entries 4", 0, 4 )
+        && checkTool( "--full-tables", MP4_DUMP_JSON_FULL, 3 );
+
+    remove( FILE_NAME );
+    remove( JSON_NAME );
+    remove( OUT_NAME );
+
+    printf( "%s\n", ok ? "PASS" : "FAIL" );
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,206 @@
+///////////////////////////////////////////////////////////////////////////////
+//
+//  The contents of this file are subject to the Mozilla Public License
+//  Version 1.1 (the "License"); you may not use this file except in
+//  compliance with the License. You may obtain a copy of the License at
+//  http://www.mozilla.org/MPL/
+//
+//  Software distributed under the License is distributed on an "AS IS"
+//  basis, WITHOUT WARRANTY OF ANY KIND, either express or implied. See the
+//  License for the specific language governing rights and limitations
+//  under the License.
+//
+//  The Original Code is MP4v2.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+// Walks tracks with and without an edit list with MP4GetNextEditSample()
+// and checks every step against MP4GetSampleIdFromEditTime(), and the
+// edit start times reported by MP4GetTrackEditStart(), also after an stts
+// entry has been changed.
+
+#include <mp4v2/mp4v2.h>
+#include <cstdio>
+#include <cstring>
+
+#define CHECK(cond) \
+    do { \
+        if( !(cond) ) { \
+            fprintf( stderr, "%s:%d: check failed: %s\n", __FILE__, __LINE__, #cond ); \
+            return false; \
+        } \
+    } while( 0 )
+
+static const char* const FILE_NAME = "edit-samples.mp4";
+
+static const uint32_t NUM_SAMPLES = 60;
+
+// media and movie time scale are both 1000, so edit times need no scaling
+struct Edit {
+    MP4Timestamp mediaStart;
+    MP4Duration  duration;
+};
+
+// cuts into samples at both ends, repeats media and plays out of order
+static const Edit EDITS[] = {
+    { 205, 500 },
+    { 1000, 333 },
+    { 205, 95 },
+    { 40, 1 },
+};
+static const uint32_t NUM_EDITS = sizeof(EDITS) / sizeof(EDITS[0]);
+
+// stts gets runs of different durations
+static MP4Duration
+sampleDuration( MP4SampleId sampleId )
+{
+    return 20 + ((sampleId - 1) / 4 % 3) * 10;
+}
+
+static bool
+createFile()
+{
+    MP4FileHandle file = MP4Create( FILE_NAME );
+    CHECK( file != MP4_INVALID_FILE_HANDLE );
+    MP4SetTimeScale( file, 1000 );
+
+    uint8_t sample[8];
+    for( MP4TrackId trackId = 1; trackId <= 2; trackId++ ) {
+        CHECK( MP4AddTrack( file, "data", 1000 ) == trackId );
+        for( MP4SampleId sampleId = 1; sampleId <= NUM_SAMPLES; sampleId++ ) {
+            memset( sample, (int)sampleId, sizeof(sample) );
+            CHECK( MP4WriteSample( file, trackId, sample, sizeof(sample), sampleDuration( sampleId )));
+        }
+    }
+
+    // track 1 keeps its media timeline, track 2 gets the edit list
+    for( uint32_t i = 0; i < NUM_EDITS; i++ )
+        CHECK( MP4AddTrackEdit( file, 2, MP4_INVALID_EDIT_ID, EDITS[i].mediaStart, EDITS[i].duration ) == i + 1 );
+
+    MP4Close( file );
+    return true;
+}
+
+static bool
+checkEditStart( MP4FileHandle file )
+{
+    MP4Timestamp start = 0;
+    for( MP4EditId editId = 1; editId <= NUM_EDITS; editId++ ) {
+        CHECK( MP4GetTrackEditStart( file, 2, editId ) == start );
+        start += EDITS[editId - 1].duration;
+    }
+
+    CHECK( MP4GetTrackEditTotalDuration( file, 2 ) == start );
+    CHECK( MP4GetTrackEditStart( file, 2, MP4_INVALID_EDIT_ID ) == MP4_INVALID_TIMESTAMP );
+    CHECK( MP4GetTrackEditStart( file, 2, NUM_EDITS + 1 ) == MP4_INVALID_TIMESTAMP );
+    CHECK( MP4GetTrackEditStart( file, 1, 1 ) == MP4_INVALID_TIMESTAMP );
+    return true;
+}
+
+// steps must tile the timeline and agree with the random access lookup
+static bool
+checkWalk( MP4FileHandle file, MP4TrackId trackId, MP4Duration totalDuration, uint32_t* pNumSteps )
+{
+    MP4EditSampleCursor cursor;
+    memset( &cursor, 0, sizeof(cursor) );
+
+    MP4Timestamp expectedStart = 0;
+    uint32_t numSteps = 0;
+    while( MP4GetNextEditSample( file, trackId, &cursor )) {
+        CHECK( cursor.startTime == expectedStart );
+        CHECK( cursor.duration > 0 );
+
+        MP4Timestamp startTime = 0;
+        MP4Duration duration = 0;
+        MP4SampleId sampleId = MP4GetSampleIdFromEditTime( file, trackId, cursor.startTime, &startTime, &duration );
+        CHECK( sampleId == cursor.sampleId );
+        CHECK( startTime == cursor.startTime );
+        CHECK( duration == cursor.duration );
+
+        expectedStart += cursor.duration;
+        numSteps++;
+    }
+
+    CHECK( expectedStart == totalDuration );
+    *pNumSteps = numSteps;
+    return true;
+}
+
+static bool
+checkFile()
+{
+    MP4FileHandle file = MP4Read( FILE_NAME );
+    CHECK( file != MP4_INVALID_FILE_HANDLE );
+
+    bool ok = checkEditStart( file );
+
+    // without an edit list every sample is visited once, in media order
+    MP4Duration mediaDuration = 0;
+    for( MP4SampleId sampleId = 1; sampleId <= NUM_SAMPLES; sampleId++ )
+        mediaDuration += sampleDuration( sampleId );
+
+    uint32_t numSteps = 0;
+    ok = ok && checkWalk( file, 1, mediaDuration, &numSteps );
+    if( ok && numSteps != NUM_SAMPLES ) {
+        fprintf( stderr, "%u steps without edits\n", numSteps );
+        ok = false;
+    }
+
+    // edit 1 cuts into samples 9 and 24, edit 2 starts on sample 35 and
+    // ends in 46, edit 3 replays samples 9 to 11, edit 4 is one tick of 3
+    ok = ok && checkWalk( file, 2, MP4GetTrackEditTotalDuration( file, 2 ), &numSteps );
+    if( ok && numSteps != 16 + 12 + 3 + 1 ) {
+        fprintf( stderr, "%u steps with edits\n", numSteps );
+        ok = false;
+    }
+
+    MP4Close( file );
+    return ok;
+}
+
+// stts entries changed in place must not leave stale times behind
+static bool
+checkSttsChange()
+{
+    MP4FileHandle file = MP4Modify( FILE_NAME );
+    CHECK( file != MP4_INVALID_FILE_HANDLE );
+
+    MP4Timestamp endTime = MP4GetSampleTime( file, 1, NUM_SAMPLES );
+    CHECK( MP4GetSampleIdFromTime( file, 1, endTime ) == NUM_SAMPLES );
+
+    // samples 1 to 4 make up the first entry
+    CHECK( MP4SetTrackIntegerProperty( file, 1, "mdia.minf.stbl.stts.entries[0].sampleDelta", 25 ));
+
+    bool ok = MP4GetSampleTime( file, 1, 2 ) == 25
+        && MP4GetSampleTime( file, 1, NUM_SAMPLES ) == endTime + 4 * 5
+        && MP4GetSampleIdFromTime( file, 1, endTime + 4 * 5 ) == NUM_SAMPLES
+        && MP4GetSampleIdFromTime( file, 1, endTime ) == NUM_SAMPLES - 1;
+
+    MP4EditSampleCursor cursor;
+    memset( &cursor, 0, sizeof(cursor) );
+    for( MP4SampleId sampleId = 1; ok && sampleId <= 5; sampleId++ ) {
+        ok = MP4GetNextEditSample( file, 1, &cursor )
+            && cursor.sampleId == sampleId
+            && cursor.startTime == (sampleId - 1) * 25
+            && cursor.duration == (sampleId < 5 ? 25u : 30u);
+    }
+
+    MP4Close( file );
+    CHECK( ok );
+    return true;
+}
+
+int
+main( int, char** )
+{
+    MP4LogSetLevel( MP4_LOG_ERROR );
+
+    bool ok = createFile()
+        && checkFile()
+        && checkSttsChange();
+
+    remove( FILE_NAME );
+
+    printf( "%s\n", ok ? "PASS" : "FAIL" );
+    return ok ? 0 : 1;
+}
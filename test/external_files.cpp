@@ -0,0 +1,257 @@
+///////////////////////////////////////////////////////////////////////////////
+//
+//  The contents of this file are subject to the Mozilla Public License
+//  Version 1.1 (the "License"); you may not use this file except in
+//  compliance with the License. You may obtain a copy of the License at
+//  http://www.mozilla.org/MPL/
+//
+//  Software distributed under the License is distributed on an "AS IS"
+//  basis, WITHOUT WARRANTY OF ANY KIND, either express or implied. See the
+//  License for the specific language governing rights and limitations
+//  under the License.
+//
+//  The Original Code is MP4v2.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+// Reads a file whose tracks refer to the media of several other files,
+// interleaving the tracks under different MP4SetMaxExternalFiles() limits.
+// Then removes source files while the reader has them open to see which
+// files the cache keeps open: the most recently used ones, shared by all
+// tracks, with a file that could not be opened remembered until evicted.
+// That part relies on removed files staying readable while open, so it
+// is skipped on Windows.
+
+#include <mp4v2/mp4v2.h>
+#include <cstdio>
+#include <cstring>
+#include <string>
+
+#define CHECK(cond) \
+    do { \
+        if( !(cond) ) { \
+            fprintf( stderr, "%s:%d: check failed: %s\n", __FILE__, __LINE__, #cond ); \
+            return false; \
+        } \
+    } while( 0 )
+
+static const char* const FILE_NAME = "external-files.mp4";
+
+static const uint32_t NUM_SOURCES = 4;
+static const uint32_t NUM_SAMPLES = 50;
+
+// tracks 1 to NUM_SOURCES refer to one source file each, the last track
+// refers to the first source file again
+static const MP4TrackId SHARED_TRACK = NUM_SOURCES + 1;
+
+static std::string
+sourceName( uint32_t source )
+{
+    char name[64];
+    snprintf( name, sizeof(name), "external-files-src%u.mp4", source );
+    return name;
+}
+
+static uint32_t
+sampleSize( MP4SampleId sampleId )
+{
+    return 20 + sampleId % 10;
+}
+
+static uint8_t
+sampleByte( uint32_t source, MP4SampleId sampleId )
+{
+    return (uint8_t)(source * 64 + sampleId);
+}
+
+static bool
+writeSource( uint32_t source )
+{
+    MP4FileHandle file = MP4Create( sourceName( source ).c_str() );
+    CHECK( file != MP4_INVALID_FILE_HANDLE );
+
+    bool ok = MP4AddAudioTrack( file, 48000, 1024, MP4_MPEG4_AUDIO_TYPE ) == 1;
+    uint8_t sample[32];
+    for( MP4SampleId sampleId = 1; ok && sampleId <= NUM_SAMPLES; sampleId++ ) {
+        memset( sample, sampleByte( source, sampleId ), sizeof(sample) );
+        ok = MP4WriteSample( file, 1, sample, sampleSize( sampleId ));
+    }
+    MP4Close( file );
+    CHECK( ok );
+    return true;
+}
+
+static bool
+createFiles()
+{
+    for( uint32_t source = 1; source <= NUM_SOURCES; source++ )
+        CHECK( writeSource( source ));
+
+    MP4FileHandle file = MP4Create( FILE_NAME );
+    CHECK( file != MP4_INVALID_FILE_HANDLE );
+
+    bool ok = true;
+    for( uint32_t source = 1; ok && source <= NUM_SOURCES + 1; source++ ) {
+        const uint32_t from = source <= NUM_SOURCES ? source : 1;
+        MP4FileHandle src = MP4Read( sourceName( from ).c_str() );
+        ok = src != MP4_INVALID_FILE_HANDLE
+            && MP4ReferenceTrack( src, 1, file ) == source;
+        MP4Close( src );
+    }
+    MP4Close( file );
+    CHECK( ok );
+    return true;
+}
+
+static uint32_t
+trackSource( MP4TrackId trackId )
+{
+    return trackId == SHARED_TRACK ? 1 : trackId;
+}
+
+// reads a sample and checks it holds the data of its source file
+static bool
+readSample( MP4FileHandle file, MP4TrackId trackId, MP4SampleId sampleId )
+{
+    uint8_t sample[32];
+    uint8_t* bytes = sample;
+    uint32_t numBytes = sizeof(sample);
+    CHECK( MP4ReadSample( file, trackId, sampleId, &bytes, &numBytes ));
+    CHECK( numBytes == sampleSize( sampleId ));
+
+    const uint8_t expected = sampleByte( trackSource( trackId ), sampleId );
+    for( uint32_t i = 0; i < numBytes; i++ )
+        CHECK( sample[i] == expected );
+    return true;
+}
+
+static bool
+isInaccessible( MP4FileHandle file, MP4TrackId trackId )
+{
+    uint8_t* bytes = NULL;
+    uint32_t numBytes = 0;
+    CHECK( !MP4ReadSample( file, trackId, 1, &bytes, &numBytes ));
+    CHECK( MP4GetLastError() == MP4_ERROR_INACCESSIBLE_FILE );
+    return true;
+}
+
+static bool
+checkInterleaved()
+{
+    static const uint32_t LIMITS[] = { 8, 2, 1 };
+
+    for( uint32_t i = 0; i < sizeof(LIMITS) / sizeof(LIMITS[0]); i++ ) {
+        MP4FileHandle file = MP4Read( FILE_NAME );
+        CHECK( file != MP4_INVALID_FILE_HANDLE );
+
+        bool ok = MP4SetMaxExternalFiles( file, LIMITS[i] );
+        for( MP4SampleId sampleId = 1; ok && sampleId <= NUM_SAMPLES; sampleId++ ) {
+            for( MP4TrackId trackId = 1; ok && trackId <= SHARED_TRACK; trackId++ )
+                ok = readSample( file, trackId, sampleId );
+        }
+
+        // and backwards, one track at a time
+        for( MP4TrackId trackId = SHARED_TRACK; ok && trackId >= 1; trackId-- ) {
+            for( MP4SampleId sampleId = NUM_SAMPLES; ok && sampleId >= 1; sampleId-- )
+                ok = readSample( file, trackId, sampleId );
+        }
+        MP4Close( file );
+        CHECK( ok );
+    }
+    return true;
+}
+
+#ifndef _WIN32
+
+static bool
+checkCachedFiles( MP4FileHandle file )
+{
+    const std::string src1 = sourceName( 1 );
+    const std::string src2 = sourceName( 2 );
+
+    CHECK( !MP4SetMaxExternalFiles( file, 0 ));
+    CHECK( MP4SetMaxExternalFiles( file, 2 ));
+
+    // source 1 stays open after its removal, also for the other track
+    // referring to it
+    CHECK( readSample( file, 1, 1 ));
+    CHECK( readSample( file, 2, 1 ));
+    CHECK( remove( src1.c_str() ) == 0 );
+    CHECK( readSample( file, 1, 2 ));
+    CHECK( readSample( file, SHARED_TRACK, 2 ));
+
+    // 1 was used last, so opening 3 closes 2 rather than 1
+    CHECK( readSample( file, 3, 1 ));
+    CHECK( readSample( file, 1, 3 ));
+
+    // opening 2 again closes 3, opening 4 closes 1, which can't be reopened
+    CHECK( readSample( file, 2, 2 ));
+    CHECK( readSample( file, 4, 1 ));
+    CHECK( isInaccessible( file, 1 ));
+    CHECK( isInaccessible( file, SHARED_TRACK ));
+
+    // the failed open is remembered, until it is evicted
+    CHECK( writeSource( 1 ));
+    CHECK( isInaccessible( file, 1 ));
+    CHECK( readSample( file, 2, 3 ));
+    CHECK( readSample( file, 3, 3 ));
+    CHECK( readSample( file, 1, 5 ));
+    CHECK( readSample( file, SHARED_TRACK, 5 ));
+
+    // lowering the limit closes the least recently used files at once
+    CHECK( MP4SetMaxExternalFiles( file, 3 ));
+    CHECK( readSample( file, 2, 4 ));
+    CHECK( readSample( file, 1, 6 ));
+    CHECK( remove( src2.c_str() ) == 0 );
+    CHECK( MP4SetMaxExternalFiles( file, 1 ));
+    CHECK( readSample( file, 1, 7 ));
+    CHECK( isInaccessible( file, 2 ));
+    CHECK( writeSource( 2 ));
+    return true;
+}
+
+static bool
+checkCache()
+{
+    MP4FileHandle file = MP4Read( FILE_NAME );
+    CHECK( file != MP4_INVALID_FILE_HANDLE );
+    bool ok = checkCachedFiles( file );
+    MP4Close( file );
+    CHECK( ok );
+
+    // files are looked up afresh by a new handle
+    file = MP4Read( FILE_NAME );
+    CHECK( file != MP4_INVALID_FILE_HANDLE );
+    for( MP4TrackId trackId = 1; ok && trackId <= SHARED_TRACK; trackId++ )
+        ok = readSample( file, trackId, NUM_SAMPLES );
+    MP4Close( file );
+    CHECK( ok );
+    return true;
+}
+
+#else
+
+static bool
+checkCache()
+{
+    return true;
+}
+
+#endif
+
+int
+main( int, char** )
+{
+    MP4LogSetLevel( MP4_LOG_NONE );
+
+    bool ok = createFiles()
+        && checkInterleaved()
+        && checkCache();
+
+    remove( FILE_NAME );
+    for( uint32_t source = 1; source <= NUM_SOURCES; source++ )
+        remove( sourceName( source ).c_str() );
+
+    printf( "%s\n", ok ? "PASS" : "FAIL" );
+    return ok ? 0 : 1;
+}
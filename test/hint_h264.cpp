@@ -0,0 +1,383 @@
+///////////////////////////////////////////////////////////////////////////////
+//
+//  The contents of this file are subject to the Mozilla Public License
+//  Version 1.1 (the "License"); you may not use this file except in
+//  compliance with the License. You may obtain a copy of the License at
+//  http://www.mozilla.org/MPL/
+//
+//  Software distributed under the License is distributed on an "AS IS"
+//  basis, WITHOUT WARRANTY OF ANY KIND, either express or implied. See the
+//  License for the specific language governing rights and limitations
+//  under the License.
+//
+//  The Original Code is MP4v2.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+// Hints H.264 tracks with MP4HintTrack() for several NAL unit length sizes
+// and payload sizes, then depacketizes the RTP packets returned by
+// MP4ReadRtpPacket() as a RFC 6184 receiver would. The single NAL unit,
+// STAP-A and FU-A packets of each hint must give back the NAL units of its
+// sample in order. Also checks the RTP headers, the payload size limit,
+// that small NAL units are aggregated as far as they fit, and the SDP.
+
+#include <mp4v2/mp4v2.h>
+#include <cstdio>
+#include <cstring>
+#include <vector>
+
+#define CHECK(cond) \
+    do { \
+        if( !(cond) ) { \
+            fprintf( stderr, "%s:%d: check failed: %s\n", __FILE__, __LINE__, #cond ); \
+            return false; \
+        } \
+    } while( 0 )
+
+typedef std::vector<uint8_t> Nal;
+
+struct Config {
+    uint32_t lengthSize;
+    uint16_t maxPayloadSize;
+};
+
+// the last one only leaves room for single byte FU-A fragments
+static const Config CONFIGS[] = {
+    { 4, 100 },
+    { 2, 600 },
+    { 1, 3 },
+};
+
+static const uint32_t NUM_CONFIGS = sizeof(CONFIGS) / sizeof(CONFIGS[0]);
+
+static const char* const FILE_NAME = "hint-h264.mp4";
+
+static const uint32_t NUM_SAMPLES = 40;
+static const uint32_t TIME_SCALE  = 11025;
+static const uint32_t RTP_CLOCK   = 90000;
+
+static const uint8_t SPS[] = { 0x67, 0x42, 0xc0, 0x1e };
+static const uint8_t PPS[] = { 0x68, 0xce, 0x38, 0x80 };
+
+// packet kinds seen over all tracks
+static uint32_t numSingle = 0;
+static uint32_t numStapA  = 0;
+static uint32_t numFuA    = 0;
+
+// deterministic, so a failure can be reproduced
+static uint32_t
+nextRandom( uint32_t& state )
+{
+    state = state * 1103515245 + 12345;
+    return state >> 8;
+}
+
+static MP4Duration
+sampleDuration( MP4SampleId sampleId )
+{
+    return 300 + sampleId % 7 * 50;
+}
+
+// the NAL units of a sample, including empty ones, which aren't sent
+static void
+makeNals( const Config& config, MP4SampleId sampleId, std::vector<Nal>& nals )
+{
+    const uint32_t maxSize = config.lengthSize < 4 ? (1u << (8 * config.lengthSize)) - 1 : 4000;
+    const uint32_t max = config.maxPayloadSize;
+
+    // the last sample has two NAL units exactly filling a STAP-A packet,
+    // one exactly filling a packet and one just too large for a packet
+    const uint32_t exact[] = { (max - 5) / 2, max - 5 - (max - 5) / 2, max, max + 1 };
+    const bool useExact = sampleId == NUM_SAMPLES && max >= 7;
+
+    uint32_t state = config.lengthSize * 1000 + sampleId;
+    nals.resize( useExact ? sizeof(exact) / sizeof(exact[0]) : 1 + nextRandom( state ) % 8 );
+
+    for( uint32_t n = 0; n < nals.size(); n++ ) {
+        const uint32_t r = nextRandom( state );
+        uint32_t size;
+        switch( useExact ? 7 : r % 7 ) {
+            case 7:  size = exact[n]; break;
+            case 0:  size = 0; break;
+            case 1:
+            case 2:  size = 1 + r / 7 % 8; break;
+            case 3:  size = 1 + r / 7 % (max / 3 + 1); break;
+            case 4:  size = max - 1 + r / 7 % 3; break;
+            case 5:  size = max + 1 + r / 7 % (2 * max + 1); break;
+            default: size = 1 + r / 7 % maxSize; break;
+        }
+        if( size > maxSize )
+            size = maxSize;
+
+        Nal& nal = nals[n];
+        nal.resize( size );
+        if( size == 0 )
+            continue;
+
+        // forbidden_zero_bit now and then, any NRI, any single NAL unit type
+        const uint32_t h = nextRandom( state );
+        nal[0] = (h % 16 == 0 ? 0x80 : 0) | (h / 16 % 4) << 5 | (1 + h / 64 % 23);
+        for( uint32_t i = 1; i < size; i++ )
+            nal[i] = (uint8_t)nextRandom( state );
+    }
+}
+
+static bool
+addTrack( MP4FileHandle file, const Config& config, MP4TrackId& trackId )
+{
+    trackId = MP4AddH264VideoTrack( file, TIME_SCALE, MP4_INVALID_DURATION, 320, 240,
+                                    SPS[1], SPS[2], SPS[3], config.lengthSize - 1 );
+    CHECK( trackId != MP4_INVALID_TRACK_ID );
+    MP4AddH264SequenceParameterSet( file, trackId, SPS, sizeof(SPS) );
+    MP4AddH264PictureParameterSet( file, trackId, PPS, sizeof(PPS) );
+
+    std::vector<Nal> nals;
+    std::vector<uint8_t> sample;
+    for( MP4SampleId sampleId = 1; sampleId <= NUM_SAMPLES; sampleId++ ) {
+        makeNals( config, sampleId, nals );
+        sample.clear();
+        for( uint32_t n = 0; n < nals.size(); n++ ) {
+            const uint32_t size = (uint32_t)nals[n].size();
+            for( uint32_t i = config.lengthSize; i > 0; i-- )
+                sample.push_back( (uint8_t)(size >> (8 * (i - 1))) );
+            sample.insert( sample.end(), nals[n].begin(), nals[n].end() );
+        }
+        CHECK( MP4WriteSample( file, trackId, &sample[0], (uint32_t)sample.size(),
+                               sampleDuration( sampleId ), 0, sampleId % 10 == 1 ));
+    }
+    return true;
+}
+
+static bool
+createFile( MP4TrackId* hintTrackIds )
+{
+    MP4FileHandle file = MP4Create( FILE_NAME );
+    CHECK( file != MP4_INVALID_FILE_HANDLE );
+
+    bool ok = true;
+    MP4TrackId trackIds[NUM_CONFIGS];
+    for( uint32_t c = 0; ok && c < NUM_CONFIGS; c++ )
+        ok = addTrack( file, CONFIGS[c], trackIds[c] );
+    for( uint32_t c = 0; ok && c < NUM_CONFIGS; c++ ) {
+        hintTrackIds[c] = MP4HintTrack( file, trackIds[c], CONFIGS[c].maxPayloadSize );
+        ok = hintTrackIds[c] != MP4_INVALID_TRACK_ID;
+    }
+    MP4Close( file );
+    CHECK( ok );
+    return true;
+}
+
+static uint16_t
+get16( const uint8_t* p )
+{
+    return (uint16_t)(p[0] << 8 | p[1]);
+}
+
+static uint32_t
+get32( const uint8_t* p )
+{
+    return (uint32_t)p[0] << 24 | (uint32_t)p[1] << 16 | (uint32_t)p[2] << 8 | p[3];
+}
+
+// depacketizes one payload, appending completed NAL units to nals; fu
+// collects the fragments of a FU-A NAL unit across packets
+static bool
+depacketize( const Config& config, const uint8_t* payload, uint32_t size,
+             std::vector<Nal>& nals, Nal& fu, bool& inFu )
+{
+    CHECK( size >= 1 );
+    const uint8_t type = payload[0] & 0x1f;
+
+    if( type == 28 ) {
+        CHECK( size >= 3 );
+        const uint8_t indicator = payload[0];
+        const uint8_t header = payload[1];
+        const bool start = (header & 0x80) != 0;
+        const bool end = (header & 0x40) != 0;
+        CHECK( (header & 0x20) == 0 );
+        CHECK( !(start && end) );
+        CHECK( start != inFu );
+
+        const uint8_t nalHeader = (indicator & 0xe0) | (header & 0x1f);
+        if( start ) {
+            fu.assign( 1, nalHeader );
+            inFu = true;
+        }
+        CHECK( fu[0] == nalHeader );
+        fu.insert( fu.end(), payload + 2, payload + size );
+
+        if( end ) {
+            // NAL units that fit a packet aren't fragmented
+            CHECK( fu.size() > config.maxPayloadSize );
+            nals.push_back( fu );
+            inFu = false;
+        }
+        numFuA++;
+        return true;
+    }
+
+    CHECK( !inFu );
+
+    if( type == 24 ) {
+        uint8_t f = 0;
+        uint8_t nri = 0;
+        uint32_t count = 0;
+        uint32_t pos = 1;
+        while( pos < size ) {
+            CHECK( size - pos >= 2 );
+            const uint32_t nalSize = get16( payload + pos );
+            pos += 2;
+            CHECK( nalSize >= 1 && nalSize <= size - pos );
+            nals.push_back( Nal( payload + pos, payload + pos + nalSize ));
+            f |= payload[pos] & 0x80;
+            if( (payload[pos] & 0x60) > nri )
+                nri = payload[pos] & 0x60;
+            pos += nalSize;
+            count++;
+        }
+        CHECK( count >= 2 );
+        CHECK( (payload[0] & 0x80) == f );
+        CHECK( (payload[0] & 0x60) == nri );
+        numStapA++;
+        return true;
+    }
+
+    CHECK( type >= 1 && type <= 23 );
+    nals.push_back( Nal( payload, payload + size ));
+    numSingle++;
+    return true;
+}
+
+static bool
+checkHintTrack( MP4FileHandle file, const Config& config, MP4TrackId hintTrackId )
+{
+    CHECK( MP4GetTrackTimeScale( file, hintTrackId ) == RTP_CLOCK );
+    CHECK( MP4GetTrackNumberOfSamples( file, hintTrackId ) == NUM_SAMPLES );
+
+    const uint32_t fuBefore = numFuA;
+    const uint32_t timestampStart = (uint32_t)MP4GetRtpTimestampStart( file, hintTrackId );
+
+    std::vector<Nal> expected;
+    std::vector<Nal> nals;
+    Nal fu;
+    bool inFu = false;
+    uint64_t mediaTime = 0;
+    uint8_t payloadType = 0;
+    uint16_t sequence = 0;
+
+    for( MP4SampleId hintId = 1; hintId <= NUM_SAMPLES; hintId++ ) {
+        uint16_t numPackets = 0;
+        CHECK( MP4ReadRtpHint( file, hintTrackId, hintId, &numPackets ));
+
+        nals.clear();
+
+        // what the payload of the previous packet could grow to by
+        // aggregating another NAL unit, zero for a FU-A packet
+        uint32_t aggregated = 0;
+
+        for( uint16_t i = 0; i < numPackets; i++ ) {
+            uint8_t* packet = NULL;
+            uint32_t packetSize = 0;
+            CHECK( MP4ReadRtpPacket( file, hintTrackId, i, &packet, &packetSize ));
+
+            bool ok = packetSize > 12 && packetSize - 12 <= config.maxPayloadSize;
+            if( ok ) {
+                // version 2 without padding, extension or CSRCs, marker bit
+                // on the last packet of an access unit only
+                const uint8_t* payload = packet + 12;
+                const uint32_t payloadSize = packetSize - 12;
+                const bool marker = (packet[1] & 0x80) != 0;
+
+                if( hintId == 1 && i == 0 ) {
+                    payloadType = packet[1] & 0x7f;
+                    sequence = get16( packet + 2 );
+                }
+                ok = packet[0] == 0x80
+                    && marker == (i + 1 == numPackets)
+                    && (packet[1] & 0x7f) == payloadType
+                    && get16( packet + 2 ) == sequence++
+                    && get32( packet + 4 ) == timestampStart + (uint32_t)(mediaTime * RTP_CLOCK / TIME_SCALE);
+
+                // a packet is only started when the next NAL unit didn't fit
+                const uint8_t type = payload[0] & 0x1f;
+                if( ok && aggregated && type != 28 ) {
+                    const uint32_t first = type == 24 ? get16( payload + 1 ) : payloadSize;
+                    ok = aggregated + 2 + first > config.maxPayloadSize;
+                }
+                aggregated = type == 28 ? 0 : type == 24 ? payloadSize : 1 + 2 + payloadSize;
+
+                ok = ok && depacketize( config, payload, payloadSize, nals, fu, inFu );
+            }
+            MP4Free( packet );
+            if( !ok ) {
+                fprintf( stderr, "packet %u of hint %u of track %u is wrong\n", i, hintId, hintTrackId );
+                return false;
+            }
+        }
+        CHECK( !inFu );
+
+        makeNals( config, hintId, expected );
+        uint32_t n = 0;
+        for( uint32_t e = 0; e < expected.size(); e++ ) {
+            if( expected[e].empty() )
+                continue;
+            if( n >= nals.size() || nals[n] != expected[e] ) {
+                fprintf( stderr, "NAL unit %u of hint %u of track %u differs\n", e, hintId, hintTrackId );
+                return false;
+            }
+            n++;
+        }
+        CHECK( n == nals.size() );
+
+        mediaTime += sampleDuration( hintId );
+    }
+
+    CHECK( numFuA > fuBefore );
+    return true;
+}
+
+static bool
+checkSdp( MP4FileHandle file, MP4TrackId hintTrackId )
+{
+    const char* sdp = MP4GetHintTrackSdp( file, hintTrackId );
+    CHECK( sdp != NULL );
+    CHECK( strstr( sdp, " H264/90000\r\n" ) != NULL );
+    CHECK( strstr( sdp, " packetization-mode=1" ) != NULL );
+    CHECK( strstr( sdp, "; profile-level-id=42c01e" ) != NULL );
+    CHECK( strstr( sdp, "; sprop-parameter-sets=Z0LAHg==,aM44gA==\r\n" ) != NULL );
+    return true;
+}
+
+static bool
+checkFile( const MP4TrackId* hintTrackIds )
+{
+    MP4FileHandle file = MP4Read( FILE_NAME );
+    CHECK( file != MP4_INVALID_FILE_HANDLE );
+
+    bool ok = true;
+    for( uint32_t c = 0; ok && c < NUM_CONFIGS; c++ ) {
+        ok = checkHintTrack( file, CONFIGS[c], hintTrackIds[c] )
+            && checkSdp( file, hintTrackIds[c] );
+    }
+    MP4Close( file );
+    CHECK( ok );
+
+    CHECK( numSingle > 0 );
+    CHECK( numStapA > 0 );
+    return true;
+}
+
+int
+main( int, char** )
+{
+    MP4LogSetLevel( MP4_LOG_ERROR );
+
+    MP4TrackId hintTrackIds[NUM_CONFIGS];
+    bool ok = createFile( hintTrackIds )
+        && checkFile( hintTrackIds );
+
+    remove( FILE_NAME );
+
+    printf( "%s\n", ok ? "PASS" : "FAIL" );
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,229 @@
+///////////////////////////////////////////////////////////////////////////////
+//
+//  The contents of this file are subject to the Mozilla Public License
+//  Version 1.1 (the "License"); you may not use this file except in
+//  compliance with the License. You may obtain a copy of the License at
+//  http://www.mozilla.org/MPL/
+//
+//  Software distributed under the License is distributed on an "AS IS"
+//  basis, WITHOUT WARRANTY OF ANY KIND, either express or implied. See the
+//  License for the specific language governing rights and limitations
+//  under the License.
+//
+//  The Original Code is MP4v2.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+// Runs mp4tags on several files at once with -jobs, with and without
+// -keepgoing, where some of the files can't be opened. Checks the exit
+// code, the tags written and that the output is in argument order.
+//
+// The path of mp4tags is the first argument, ./mp4tags by default.
+
+#include <mp4v2/mp4v2.h>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#ifndef _WIN32
+#   include <sys/wait.h>
+#endif
+
+using namespace std;
+
+#define CHECK(cond) \
+    do { \
+        if( !(cond) ) { \
+            fprintf( stderr, "%s:%d: check failed: %s\n", __FILE__, __LINE__, #cond ); \
+            return false; \
+        } \
+    } while( 0 )
+
+static const char* const OUT_NAME = "mp4tags-batch.txt";
+
+static const uint32_t NUM_FILES = 8;
+
+static string tool = "./mp4tags";
+
+// files with an odd index are never created
+static string
+fileName( uint32_t index )
+{
+    char name[32];
+    snprintf( name, sizeof(name), "mp4tags-batch-%u.mp4", index );
+    return name;
+}
+
+static bool
+exists( uint32_t index )
+{
+    return index % 2 == 0;
+}
+
+static bool
+createFiles()
+{
+    uint8_t sample[64];
+    memset( sample, 0, sizeof(sample) );
+
+    for( uint32_t i = 0; i < NUM_FILES; i++ ) {
+        remove( fileName( i ).c_str() );
+        if( !exists( i ))
+            continue;
+
+        MP4FileHandle file = MP4Create( fileName( i ).c_str() );
+        CHECK( file != MP4_INVALID_FILE_HANDLE );
+        MP4TrackId trackId = MP4AddAudioTrack( file, 44100, 1024, MP4_MPEG4_AUDIO_TYPE );
+        bool ok = trackId != MP4_INVALID_TRACK_ID;
+        for( uint32_t n = 0; ok && n < 200; n++ )
+            ok = MP4WriteSample( file, trackId, sample, sizeof(sample) );
+        MP4Close( file );
+        CHECK( ok );
+    }
+    return true;
+}
+
+// runs mp4tags with options on files, returns its exit code and output
+static int
+runTool( const string& options, const vector<uint32_t>& files, string& output )
+{
+    string command = "\"" + tool + "\" " + options;
+    for( size_t i = 0; i < files.size(); i++ )
+        command += " " + fileName( files[i] );
+    command += string( " > " ) + OUT_NAME + " 2>&1";
+
+    int status = system( command.c_str() );
+#ifndef _WIN32
+    status = WIFEXITED( status ) ? WEXITSTATUS( status ) : -1;
+#endif
+
+    output.clear();
+    FILE* in = fopen( OUT_NAME, "r" );
+    if( in ) {
+        char line[512];
+        while( fgets( line, sizeof(line), in ))
+            output += line;
+        fclose( in );
+    }
+    return status;
+}
+
+static bool
+checkName( uint32_t index, const char* name )
+{
+    MP4FileHandle file = MP4Read( fileName( index ).c_str() );
+    CHECK( file != MP4_INVALID_FILE_HANDLE );
+
+    const MP4Tags* tags = MP4TagsAlloc();
+    bool ok = MP4TagsFetch( tags, file )
+        && tags->name
+        && !strcmp( tags->name, name );
+    MP4TagsFree( tags );
+    MP4Close( file );
+
+    if( !ok )
+        fprintf( stderr, "%s: name is not %s\n", fileName( index ).c_str(), name );
+    return ok;
+}
+
+// each missing file is mentioned, and no line mentions a file before one
+// that came earlier on the command line
+static bool
+checkOrder( const string& output, const vector<uint32_t>& files )
+{
+    size_t last = 0;
+    for( size_t i = 0; i < files.size(); i++ ) {
+        if( exists( files[i] ))
+            continue;
+
+        const string name = fileName( files[i] );
+        size_t first = output.find( name );
+        CHECK( first != string::npos );
+        CHECK( first >= last );
+        last = output.rfind( name );
+
+        for( size_t k = 0; k < i; k++ )
+            CHECK( output.find( fileName( files[k] ), last ) == string::npos );
+    }
+    return true;
+}
+
+static bool
+checkKeepGoing()
+{
+    vector<uint32_t> files;
+    for( uint32_t i = 0; i < NUM_FILES; i++ )
+        files.push_back( i );
+
+    // every file which exists is tagged, and the failures make it fail
+    string output;
+    CHECK( runTool( "-jobs 4 -keepgoing -song Keep", files, output ) == 5 );
+    CHECK( checkOrder( output, files ));
+    for( uint32_t i = 0; i < NUM_FILES; i += 2 )
+        CHECK( checkName( i, "Keep" ));
+
+    return true;
+}
+
+static bool
+checkStop()
+{
+    // serially no file after the failure is touched
+    vector<uint32_t> files;
+    files.push_back( 0 );
+    files.push_back( 1 );
+    files.push_back( 2 );
+
+    string output;
+    CHECK( runTool( "-jobs 1 -song Stop", files, output ) == 5 );
+    CHECK( checkOrder( output, files ));
+    CHECK( checkName( 0, "Stop" ));
+    CHECK( checkName( 2, "Keep" ));
+
+    // in parallel jobs already running may finish, the result is the same
+    files.push_back( 4 );
+    files.push_back( 6 );
+    CHECK( runTool( "-jobs 4 -song Stop", files, output ) == 5 );
+    CHECK( checkOrder( output, files ));
+
+    return true;
+}
+
+static bool
+checkSuccess()
+{
+    vector<uint32_t> files;
+    for( uint32_t i = 0; i < NUM_FILES; i += 2 )
+        files.push_back( i );
+
+    string output;
+    CHECK( runTool( "-jobs 3 -song Done", files, output ) == 0 );
+    CHECK( output.empty() );
+    for( uint32_t i = 0; i < NUM_FILES; i += 2 )
+        CHECK( checkName( i, "Done" ));
+
+    return true;
+}
+
+int
+main( int argc, char** argv )
+{
+    MP4LogSetLevel( MP4_LOG_ERROR );
+
+    if( argc > 1 )
+        tool = argv[1];
+
+    bool ok = createFiles()
+        && checkKeepGoing()
+        && checkStop()
+        && checkSuccess();
+
+    for( uint32_t i = 0; i < NUM_FILES; i++ )
+        remove( fileName( i ).c_str() );
+    remove( OUT_NAME );
+
+    printf( "%s\n", ok ? "PASS" : "FAIL" );
+    return ok ? 0 : 1;
+}
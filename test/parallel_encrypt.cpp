@@ -0,0 +1,319 @@
+///////////////////////////////////////////////////////////////////////////////
+//
+//  The contents of this file are subject to the Mozilla Public License
+//  Version 1.1 (the "License"); you may not use this file except in
+//  compliance with the License. You may obtain a copy of the License at
+//  http://www.mozilla.org/MPL/
+//
+//  Software distributed under the License is distributed on an "AS IS"
+//  basis, WITHOUT WARRANTY OF ANY KIND, either express or implied. See the
+//  License for the specific language governing rights and limitations
+//  under the License.
+//
+//  The Original Code is MP4v2.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+// Encrypts a track with MP4EncAndCopyTrackParallel() on several thread
+// counts, with and without its edit list applied, and checks every sample
+// against a copy made one sample at a time with MP4EncAndCopySample().
+// The encryption function takes longer on some samples, so the workers
+// finish out of order. Also checks an encryption function that fails on
+// one sample: a failure without output is logged and the sample written
+// empty, and one that leaves the track inconsistent deletes the copy.
+
+#include <mp4v2/mp4v2.h>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <chrono>
+#include <thread>
+
+#define CHECK(cond) \
+    do { \
+        if( !(cond) ) { \
+            fprintf( stderr, "%s:%d: check failed: %s\n", __FILE__, __LINE__, #cond ); \
+            return false; \
+        } \
+    } while( 0 )
+
+static const char* const SRC_NAME = "parallel-encrypt-src.mp4";
+static const char* const DST_NAME = "parallel-encrypt-dst.mp4";
+
+static const uint32_t NUM_SAMPLES = 400;
+static const uint32_t FAIL_SAMPLE = 123;
+static const uint32_t KEY         = 0x5A;
+
+// the track and movie time scale are both 1000
+static const MP4Duration SAMPLE_DURATION = 40;
+
+///////////////////////////////////////////////////////////////////////////////
+
+// the first two bytes of every source sample hold its sample id
+static uint32_t
+sampleIdOf( const uint8_t* bytes )
+{
+    return bytes[0] << 8 | bytes[1];
+}
+
+// prepends the sample size and xors the rest with the key
+static uint32_t
+encryptSample( uint32_t key, uint32_t numBytes, uint8_t* pBytes, uint32_t* encNumBytes, uint8_t** encBytes )
+{
+    uint32_t sampleId = sampleIdOf( pBytes );
+    if( sampleId % 7 == 0 )
+        std::this_thread::sleep_for( std::chrono::microseconds( 300 ));
+
+    uint8_t* out = (uint8_t*)malloc( numBytes + 4 );
+    out[0] = (uint8_t)(numBytes >> 24);
+    out[1] = (uint8_t)(numBytes >> 16);
+    out[2] = (uint8_t)(numBytes >> 8);
+    out[3] = (uint8_t)numBytes;
+    for( uint32_t i = 0; i < numBytes; i++ )
+        out[4 + i] = pBytes[i] ^ (uint8_t)(key + i);
+
+    *encBytes = out;
+    *encNumBytes = numBytes + 4;
+    return 0;
+}
+
+// fails on one sample without producing any output
+static uint32_t
+encryptSampleOrFail( uint32_t key, uint32_t numBytes, uint8_t* pBytes, uint32_t* encNumBytes, uint8_t** encBytes )
+{
+    if( sampleIdOf( pBytes ) == FAIL_SAMPLE ) {
+        *encBytes = NULL;
+        *encNumBytes = 0;
+        return 1;
+    }
+    return encryptSample( key, numBytes, pBytes, encNumBytes, encBytes );
+}
+
+// fails on one sample with a size but no data, which can't be written
+static uint32_t
+encryptSampleOrBreak( uint32_t key, uint32_t numBytes, uint8_t* pBytes, uint32_t* encNumBytes, uint8_t** encBytes )
+{
+    if( sampleIdOf( pBytes ) == FAIL_SAMPLE ) {
+        *encBytes = NULL;
+        *encNumBytes = numBytes;
+        return 1;
+    }
+    return encryptSample( key, numBytes, pBytes, encNumBytes, encBytes );
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+static bool
+createSource()
+{
+    MP4FileHandle file = MP4Create( SRC_NAME );
+    CHECK( file != MP4_INVALID_FILE_HANDLE );
+    MP4SetTimeScale( file, 1000 );
+
+    static const uint8_t config[] = { 0x00, 0x00, 0x01, 0xb0, 0x01 };
+    bool ok = MP4AddVideoTrack( file, 1000, SAMPLE_DURATION, 320, 240, MP4_MPEG4_VIDEO_TYPE ) == 1
+        && MP4SetTrackESConfiguration( file, 1, config, sizeof(config) );
+
+    uint8_t sample[300];
+    for( MP4SampleId sampleId = 1; ok && sampleId <= NUM_SAMPLES; sampleId++ ) {
+        memset( sample, (int)sampleId, sizeof(sample) );
+        sample[0] = (uint8_t)(sampleId >> 8);
+        sample[1] = (uint8_t)sampleId;
+        ok = MP4WriteSample( file, 1, sample, 2 + sampleId * 37 % 298, SAMPLE_DURATION,
+                             sampleId % 3 * SAMPLE_DURATION, sampleId % 12 == 1 );
+    }
+
+    // samples 51 to 150, then 1 to 30
+    ok = ok && MP4AddTrackEdit( file, 1, MP4_INVALID_EDIT_ID, 50 * SAMPLE_DURATION, 100 * SAMPLE_DURATION ) == 1
+        && MP4AddTrackEdit( file, 1, MP4_INVALID_EDIT_ID, 0, 30 * SAMPLE_DURATION ) == 2;
+
+    MP4Close( file );
+    CHECK( ok );
+    return true;
+}
+
+// the reference copy, one sample at a time
+static MP4TrackId
+copySamples( MP4FileHandle src, MP4FileHandle dst, encryptFunc_t encfcnp )
+{
+    mp4v2_ismacrypParams icPp;
+    MP4DefaultISMACrypParams( &icPp );
+
+    MP4TrackId trackId = MP4EncAndCloneTrack( src, 1, &icPp, dst );
+    for( MP4SampleId sampleId = 1; trackId != MP4_INVALID_TRACK_ID && sampleId <= NUM_SAMPLES; sampleId++ ) {
+        if( !MP4EncAndCopySample( src, 1, sampleId, encfcnp, KEY, dst, trackId ))
+            trackId = MP4_INVALID_TRACK_ID;
+    }
+    return trackId;
+}
+
+static MP4TrackId
+copyTrack( MP4FileHandle src, MP4FileHandle dst, encryptFunc_t encfcnp, uint32_t numThreads, bool applyEdits )
+{
+    mp4v2_ismacrypParams icPp;
+    MP4DefaultISMACrypParams( &icPp );
+
+    if( numThreads == 1 )
+        return MP4EncAndCopyTrack( src, 1, &icPp, encfcnp, KEY, dst, applyEdits );
+    return MP4EncAndCopyTrackParallel( src, 1, &icPp, encfcnp, KEY, numThreads, dst, applyEdits );
+}
+
+static bool
+compareSample( MP4FileHandle file, MP4TrackId trackId, MP4TrackId expectedId, MP4SampleId sampleId )
+{
+    uint8_t* bytes = NULL;
+    uint8_t* expected = NULL;
+    uint32_t numBytes = 0;
+    uint32_t expectedNumBytes = 0;
+    MP4Duration duration = 0;
+    MP4Duration expectedDuration = 0;
+    MP4Duration renderingOffset = 0;
+    MP4Duration expectedRenderingOffset = 0;
+    bool isSyncSample = false;
+    bool expectedIsSyncSample = false;
+
+    bool ok = MP4ReadSample( file, trackId, sampleId, &bytes, &numBytes, NULL,
+                             &duration, &renderingOffset, &isSyncSample )
+        && MP4ReadSample( file, expectedId, sampleId, &expected, &expectedNumBytes, NULL,
+                          &expectedDuration, &expectedRenderingOffset, &expectedIsSyncSample )
+        && numBytes == expectedNumBytes
+        && (numBytes == 0 || !memcmp( bytes, expected, numBytes ))
+        && duration == expectedDuration
+        && renderingOffset == expectedRenderingOffset
+        && isSyncSample == expectedIsSyncSample;
+
+    MP4Free( bytes );
+    MP4Free( expected );
+    if( !ok )
+        fprintf( stderr, "track %u differs from track %u at sample %u\n", trackId, expectedId, sampleId );
+    return ok;
+}
+
+static bool
+compareTracks( MP4FileHandle file, MP4TrackId trackId, MP4TrackId expectedId )
+{
+    MP4SampleId numSamples = MP4GetTrackNumberOfSamples( file, expectedId );
+    CHECK( numSamples > 0 );
+    CHECK( MP4GetTrackNumberOfSamples( file, trackId ) == numSamples );
+    for( MP4SampleId sampleId = 1; sampleId <= numSamples; sampleId++ )
+        CHECK( compareSample( file, trackId, expectedId, sampleId ));
+    return true;
+}
+
+// the reference copy holds the encrypted source samples
+static bool
+checkReference( MP4FileHandle src, MP4FileHandle dst, MP4TrackId trackId )
+{
+    CHECK( MP4GetTrackNumberOfSamples( dst, trackId ) == NUM_SAMPLES );
+    for( MP4SampleId sampleId = 1; sampleId <= NUM_SAMPLES; sampleId++ ) {
+        uint8_t* bytes = NULL;
+        uint8_t* enc = NULL;
+        uint32_t numBytes = 0;
+        uint32_t encNumBytes = 0;
+        bool ok = MP4ReadSample( src, 1, sampleId, &bytes, &numBytes )
+            && MP4ReadSample( dst, trackId, sampleId, &enc, &encNumBytes )
+            && encNumBytes == numBytes + 4
+            && (enc[0] << 24 | enc[1] << 16 | enc[2] << 8 | enc[3]) == (int)numBytes
+            && (enc[4] ^ (uint8_t)KEY) == bytes[0]
+            && (enc[3 + numBytes] ^ (uint8_t)(KEY + numBytes - 1)) == bytes[numBytes - 1];
+        MP4Free( bytes );
+        MP4Free( enc );
+        CHECK( ok );
+    }
+    return true;
+}
+
+static bool
+checkParallel()
+{
+    MP4FileHandle src = MP4Read( SRC_NAME );
+    CHECK( src != MP4_INVALID_FILE_HANDLE );
+    MP4FileHandle dst = MP4Create( DST_NAME );
+    if( dst == MP4_INVALID_FILE_HANDLE ) {
+        MP4Close( src );
+        CHECK( dst != MP4_INVALID_FILE_HANDLE );
+    }
+
+    // 3 threads keep fewer samples in flight than there are samples up to
+    // the failing one, 0 is one thread per processor
+    static const uint32_t THREADS[] = { 1, 2, 3, 8, 0 };
+    static const uint32_t NUM_THREADS = sizeof(THREADS) / sizeof(THREADS[0]);
+
+    MP4TrackId reference = copySamples( src, dst, encryptSample );
+    bool ok = reference != MP4_INVALID_TRACK_ID
+        && checkReference( src, dst, reference );
+
+    // the whole track
+    for( uint32_t i = 0; ok && i < NUM_THREADS; i++ ) {
+        MP4TrackId trackId = copyTrack( src, dst, encryptSample, THREADS[i], false );
+        ok = trackId != MP4_INVALID_TRACK_ID
+            && compareTracks( dst, trackId, reference );
+    }
+
+    // through the edit list, compared with a single thread; the copy has
+    // always stopped short of the sample that reaches the end of the edits.
+    // It starts with samples before the first sync sample
+    MP4TrackId edited = MP4_INVALID_TRACK_ID;
+    if( ok ) {
+        edited = copyTrack( src, dst, encryptSample, 1, true );
+        ok = edited != MP4_INVALID_TRACK_ID
+            && MP4GetTrackNumberOfSamples( dst, edited ) == 129;
+    }
+    for( uint32_t i = 1; ok && i < NUM_THREADS; i++ ) {
+        MP4TrackId trackId = copyTrack( src, dst, encryptSample, THREADS[i], true );
+        ok = trackId != MP4_INVALID_TRACK_ID
+            && compareTracks( dst, trackId, edited );
+    }
+
+    // a failed sample is written empty and the copy goes on
+    MP4TrackId failed = MP4_INVALID_TRACK_ID;
+    if( ok ) {
+        failed = copySamples( src, dst, encryptSampleOrFail );
+        ok = failed != MP4_INVALID_TRACK_ID
+            && MP4GetSampleSize( dst, failed, FAIL_SAMPLE ) == 0
+            && MP4GetSampleSize( dst, failed, FAIL_SAMPLE + 1 ) > 0;
+    }
+    for( uint32_t i = 0; ok && i < NUM_THREADS; i++ ) {
+        MP4TrackId trackId = copyTrack( src, dst, encryptSampleOrFail, THREADS[i], false );
+        ok = trackId != MP4_INVALID_TRACK_ID
+            && compareTracks( dst, trackId, failed );
+    }
+
+    // a sample that can't be written stops the copy and removes the track,
+    // while the workers may still be encrypting the samples after it
+    for( uint32_t i = 0; ok && i < NUM_THREADS; i++ ) {
+        uint32_t numTracks = MP4GetNumberOfTracks( dst );
+        ok = copyTrack( src, dst, encryptSampleOrBreak, THREADS[i], false ) == MP4_INVALID_TRACK_ID
+            && MP4GetNumberOfTracks( dst ) == numTracks;
+    }
+
+    MP4Close( dst );
+    MP4Close( src );
+    CHECK( ok );
+
+    // and the copies survive writing
+    dst = MP4Read( DST_NAME );
+    CHECK( dst != MP4_INVALID_FILE_HANDLE );
+    ok = MP4GetNumberOfTracks( dst ) == 3 * NUM_THREADS + 2
+        && compareTracks( dst, 2, reference )
+        && compareTracks( dst, 2 * NUM_THREADS + 2, failed );
+    MP4Close( dst );
+    CHECK( ok );
+    return true;
+}
+
+int
+main( int, char** )
+{
+    // the failing encryption functions log errors
+    MP4LogSetLevel( MP4_LOG_NONE );
+
+    bool ok = createSource()
+        && checkParallel();
+
+    remove( SRC_NAME );
+    remove( DST_NAME );
+
+    printf( "%s\n", ok ? "PASS" : "FAIL" );
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,255 @@
+///////////////////////////////////////////////////////////////////////////////
+//
+//  The contents of this file are subject to the Mozilla Public License
+//  Version 1.1 (the "License"); you may not use this file except in
+//  compliance with the License. You may obtain a copy of the License at
+//  http://www.mozilla.org/MPL/
+//
+//  Software distributed under the License is distributed on an "AS IS"
+//  basis, WITHOUT WARRANTY OF ANY KIND, either express or implied. See the
+//  License for the specific language governing rights and limitations
+//  under the License.
+//
+//  The Original Code is MP4v2.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+// Mixes positional readAt()/writeAt() with seeks and stream reads and
+// writes on a file opened with the standard provider, with and without
+// the write buffer, and checks every read and the final contents against
+// an in-memory copy. Then writes a track in chunks of different sizes,
+// flushing and reading samples back while writing, and checks the stsc
+// first-sample values before and after closing.
+
+#include "libplatform/platform.h"
+#include <cstdio>
+#include <cstring>
+#include <vector>
+
+using namespace mp4v2::platform::io;
+
+#define CHECK(cond) \
+    do { \
+        if( !(cond) ) { \
+            fprintf( stderr, "%s:%d: check failed: %s\n", __FILE__, __LINE__, #cond ); \
+            return false; \
+        } \
+    } while( 0 )
+
+static const char* const DATA_NAME = "positional-io.bin";
+static const char* const MP4_NAME  = "positional-io.mp4";
+
+static const uint32_t NUM_OPS     = 3000;
+static const uint32_t MAX_OP_SIZE = 3000;
+
+static const uint32_t NUM_SAMPLES       = 60;
+static const uint32_t SAMPLES_PER_CHUNK = 4;
+
+static uint32_t seed = 1;
+
+static uint32_t
+nextRandom( uint32_t range )
+{
+    seed = seed * 1103515245 + 12345;
+    return (seed >> 8) % range;
+}
+
+static bool
+checkRead( const std::vector<uint8_t>& model, File::Size pos, const uint8_t* bytes, File::Size nin, uint32_t size )
+{
+    File::Size expected = (File::Size)model.size() - pos;
+    if( expected > size )
+        expected = size;
+    CHECK( nin == expected );
+    CHECK( !memcmp( bytes, &model[pos], (size_t)nin ));
+    return true;
+}
+
+static bool
+mixOperations( uint32_t bufferSize )
+{
+    std::vector<uint8_t> model;
+    std::vector<uint8_t> bytes( MAX_OP_SIZE );
+
+    File file( DATA_NAME, File::MODE_CREATE );
+    CHECK( !file.open() );
+    CHECK( !file.setBufferSize( bufferSize ));
+
+    File::Size pos = 0;
+    File::Size n;
+    for( uint32_t i = 0; i < NUM_OPS; i++ ) {
+        uint32_t size = 1 + nextRandom( MAX_OP_SIZE );
+        File::Size at = nextRandom( (uint32_t)model.size() + 1 );
+        uint8_t fill = (uint8_t)i;
+
+        switch( nextRandom( 6 )) {
+        case 0:
+        case 1:
+            // stream write, mostly appending
+            memset( &bytes[0], fill, size );
+            CHECK( !file.write( &bytes[0], size, n ) && n == size );
+            if( model.size() < (size_t)(pos + size) )
+                model.resize( (size_t)(pos + size) );
+            memcpy( &model[pos], &bytes[0], size );
+            pos += size;
+            break;
+
+        case 2:
+            // stream read from wherever the last operation left off
+            CHECK( !file.read( &bytes[0], size, n ));
+            CHECK( checkRead( model, pos, &bytes[0], n, size ));
+            pos += n;
+            break;
+
+        case 3:
+            CHECK( !file.seek( at ));
+            pos = at;
+            break;
+
+        case 4:
+            // may overwrite data a stream read has already buffered
+            memset( &bytes[0], fill, size );
+            CHECK( !file.writeAt( at, &bytes[0], size, n ) && n == size );
+            if( model.size() < (size_t)(at + size) )
+                model.resize( (size_t)(at + size) );
+            memcpy( &model[at], &bytes[0], size );
+            break;
+
+        case 5:
+            // may cover data a stream write has not written out yet
+            CHECK( !file.readAt( at, &bytes[0], size, n ));
+            CHECK( checkRead( model, at, &bytes[0], n, size ));
+            break;
+        }
+
+        // positional operations leave the stream position alone
+        CHECK( file.position == pos );
+    }
+    CHECK( !file.close() );
+
+    // reopen and compare everything
+    File check( DATA_NAME, File::MODE_READ );
+    CHECK( !check.open() );
+    std::vector<uint8_t> contents( model.size() + 1 );
+    bool ok = !check.read( &contents[0], contents.size(), n )
+        && n == (File::Size)model.size()
+        && !memcmp( &contents[0], &model[0], model.size() );
+    check.close();
+    CHECK( ok );
+    return true;
+}
+
+static bool
+checkStsc( MP4FileHandle file, uint32_t numSamples )
+{
+    uint64_t numEntries = 0;
+    uint64_t numChunks = 0;
+    CHECK( MP4GetTrackIntegerProperty( file, 1, "mdia.minf.stbl.stsc.entryCount", &numEntries ));
+    CHECK( MP4GetTrackIntegerProperty( file, 1, "mdia.minf.stbl.stco.entryCount", &numChunks ));
+    CHECK( numEntries > 1 );
+
+    char name[64];
+    uint64_t expected = 1;
+    uint64_t prevFirstChunk = 0;
+    uint64_t prevSamplesPerChunk = 0;
+    for( uint32_t i = 0; i < numEntries; i++ ) {
+        uint64_t firstChunk = 0;
+        uint64_t samplesPerChunk = 0;
+        uint64_t firstSample = 0;
+        snprintf( name, sizeof(name), "mdia.minf.stbl.stsc.entries[%u].firstChunk", i );
+        CHECK( MP4GetTrackIntegerProperty( file, 1, name, &firstChunk ));
+        snprintf( name, sizeof(name), "mdia.minf.stbl.stsc.entries[%u].samplesPerChunk", i );
+        CHECK( MP4GetTrackIntegerProperty( file, 1, name, &samplesPerChunk ));
+        snprintf( name, sizeof(name), "mdia.minf.stbl.stsc.entries[%u].firstSample", i );
+        CHECK( MP4GetTrackIntegerProperty( file, 1, name, &firstSample ));
+
+        if( i > 0 )
+            expected += (firstChunk - prevFirstChunk) * prevSamplesPerChunk;
+        CHECK( firstSample == expected );
+
+        prevFirstChunk = firstChunk;
+        prevSamplesPerChunk = samplesPerChunk;
+    }
+
+    // the last entry runs to the last chunk
+    expected += (numChunks - prevFirstChunk + 1) * prevSamplesPerChunk;
+    CHECK( expected == numSamples + 1 );
+    return true;
+}
+
+static bool
+checkSample( MP4FileHandle file, MP4SampleId sampleId )
+{
+    uint8_t* sample = NULL;
+    uint32_t sampleSize = 0;
+    CHECK( MP4ReadSample( file, 1, sampleId, &sample, &sampleSize ));
+    bool ok = sampleSize == 10 + sampleId % 50
+        && sample[0] == (uint8_t)sampleId
+        && sample[sampleSize - 1] == (uint8_t)sampleId;
+    MP4Free( sample );
+    CHECK( ok );
+    return true;
+}
+
+// flushing ends the open chunk, so these make chunks of other sizes
+static bool
+isFlushPoint( MP4SampleId sampleId )
+{
+    return sampleId == 10 || sampleId == 23 || sampleId == 25 || sampleId == 41;
+}
+
+static bool
+writeChunks( MP4FileHandle file )
+{
+    CHECK( MP4AddVideoTrack( file, 90000, 3000, 320, 240, MP4_MPEG4_VIDEO_TYPE ) == 1 );
+    CHECK( MP4SetTrackDurationPerChunk( file, 1, SAMPLES_PER_CHUNK * 3000 ));
+
+    uint8_t sample[64];
+    for( MP4SampleId sampleId = 1; sampleId <= NUM_SAMPLES; sampleId++ ) {
+        memset( sample, (int)sampleId, sizeof(sample) );
+        CHECK( MP4WriteSample( file, 1, sample, 10 + sampleId % 50 ));
+
+        if( isFlushPoint( sampleId )) {
+            CHECK( MP4Flush( file ));
+            CHECK( checkStsc( file, sampleId ));
+            for( MP4SampleId readId = 1; readId <= sampleId; readId++ )
+                CHECK( checkSample( file, readId ));
+        }
+    }
+    return true;
+}
+
+static bool
+checkChunks()
+{
+    MP4FileHandle file = MP4Create( MP4_NAME );
+    CHECK( file != MP4_INVALID_FILE_HANDLE );
+    bool ok = writeChunks( file );
+    MP4Close( file );
+    CHECK( ok );
+
+    file = MP4Read( MP4_NAME );
+    CHECK( file != MP4_INVALID_FILE_HANDLE );
+    ok = checkStsc( file, NUM_SAMPLES );
+    for( MP4SampleId sampleId = 1; ok && sampleId <= NUM_SAMPLES; sampleId++ )
+        ok = checkSample( file, sampleId );
+    MP4Close( file );
+    CHECK( ok );
+    return true;
+}
+
+int
+main( int, char** )
+{
+    MP4LogSetLevel( MP4_LOG_ERROR );
+
+    bool ok = mixOperations( 0 )
+        && mixOperations( 4096 )
+        && checkChunks();
+
+    remove( DATA_NAME );
+    remove( MP4_NAME );
+
+    printf( "%s\n", ok ? "PASS" : "FAIL" );
+    return ok ? 0 : 1;
+}
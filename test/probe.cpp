@@ -0,0 +1,348 @@
+///////////////////////////////////////////////////////////////////////////////
+//
+//  The contents of this file are subject to the Mozilla Public License
+//  Version 1.1 (the "License"); you may not use this file except in
+//  compliance with the License. You may obtain a copy of the License at
+//  http://www.mozilla.org/MPL/
+//
+//  Software distributed under the License is distributed on an "AS IS"
+//  basis, WITHOUT WARRANTY OF ANY KIND, either express or implied. See the
+//  License for the specific language governing rights and limitations
+//  under the License.
+//
+//  The Original Code is MP4v2.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+// Checks the summary MP4Probe() gives against what MP4Read() reports, then
+// probes every prefix of the file through MP4ProbeCallbacks(): a prefix
+// holding the whole moov box gives the full summary, a shorter one gives
+// false and no track information. Also probes files that are not mp4 files
+// at all, which must give false and a cleared summary.
+
+#include <mp4v2/mp4v2.h>
+#include <cstdio>
+#include <cstring>
+#include <vector>
+
+#define CHECK(cond) \
+    do { \
+        if( !(cond) ) { \
+            fprintf( stderr, "%s:%d: check failed: %s\n", __FILE__, __LINE__, #cond ); \
+            return false; \
+        } \
+    } while( 0 )
+
+static const char* const FILE_NAME      = "probe.mp4";
+static const char* const OPTIMIZED_NAME = "probe-optimized.mp4";
+static const char* const OTHER_NAME     = "probe-other.bin";
+
+static const uint32_t NUM_SAMPLES = 200;
+
+// more than MP4ProbeInfo can describe
+static const uint32_t NUM_AUDIO_TRACKS = MP4_PROBE_MAX_TRACKS + 2;
+
+struct MemFile {
+    std::vector<uint8_t> data;
+    int64_t              pos;
+};
+
+static int64_t
+memSize( void* handle )
+{
+    return (int64_t)((MemFile*)handle)->data.size();
+}
+
+static int
+memSeek( void* handle, int64_t pos )
+{
+    ((MemFile*)handle)->pos = pos;
+    return 0;
+}
+
+static int
+memRead( void* handle, void* buffer, int64_t size, int64_t* nin )
+{
+    MemFile& file = *(MemFile*)handle;
+    int64_t avail = (int64_t)file.data.size() - file.pos;
+    if( avail < size )
+        return 1;
+    memcpy( buffer, &file.data[file.pos], size );
+    file.pos += size;
+    *nin = size;
+    return 0;
+}
+
+// probing only reads
+static const MP4IOCallbacks MEM_CALLBACKS = {
+    memSize, memSeek, memRead, NULL, NULL
+};
+
+static bool
+readFile( const char* name, std::vector<uint8_t>& data )
+{
+    FILE* in = fopen( name, "rb" );
+    CHECK( in );
+    data.clear();
+    uint8_t buf[4096];
+    size_t n;
+    while( (n = fread( buf, 1, sizeof(buf), in )) > 0 )
+        data.insert( data.end(), buf, buf + n );
+    fclose( in );
+    return true;
+}
+
+static bool
+writeFile( const char* name, const std::vector<uint8_t>& data )
+{
+    FILE* out = fopen( name, "wb" );
+    CHECK( out );
+    bool ok = data.empty() || fwrite( &data[0], 1, data.size(), out ) == data.size();
+    fclose( out );
+    CHECK( ok );
+    return true;
+}
+
+static bool
+isCleared( const MP4ProbeInfo& info )
+{
+    MP4ProbeInfo zero;
+    memset( &zero, 0, sizeof(zero) );
+    return memcmp( &info, &zero, sizeof(info) ) == 0;
+}
+
+static bool
+createFile()
+{
+    MP4FileHandle file = MP4Create( FILE_NAME );
+    CHECK( file != MP4_INVALID_FILE_HANDLE );
+    MP4SetTimeScale( file, 600 );
+
+    bool ok = MP4AddVideoTrack( file, 90000, 3000, 320, 240, MP4_MPEG4_VIDEO_TYPE ) == 1;
+    for( uint32_t i = 0; ok && i < NUM_AUDIO_TRACKS; i++ )
+        ok = MP4AddAudioTrack( file, 44100 + i * 1000, 1024, MP4_MPEG4_AUDIO_TYPE ) == 2 + i;
+
+    uint8_t sample[100] = { 0 };
+    for( MP4SampleId sampleId = 1; ok && sampleId <= NUM_SAMPLES; sampleId++ ) {
+        for( MP4TrackId trackId = 1; ok && trackId <= 1 + NUM_AUDIO_TRACKS; trackId++ )
+            ok = MP4WriteSample( file, trackId, sample, sizeof(sample), MP4_INVALID_DURATION, 0, sampleId % 30 == 1 );
+    }
+    MP4Close( file );
+    CHECK( ok );
+
+    // the same file with moov ahead of mdat
+    CHECK( MP4Optimize( FILE_NAME, OPTIMIZED_NAME ));
+    return true;
+}
+
+static bool
+checkTrack( MP4FileHandle file, const MP4ProbeTrack& track, MP4TrackId trackId )
+{
+    CHECK( track.trackId == trackId );
+    CHECK( !strcmp( track.type, MP4GetTrackType( file, trackId )));
+    CHECK( !strcmp( track.codec, MP4GetTrackMediaDataName( file, trackId )));
+    CHECK( track.timeScale == MP4GetTrackTimeScale( file, trackId ));
+    CHECK( track.duration == MP4GetTrackDuration( file, trackId ));
+
+    if( MP4_IS_VIDEO_TRACK_TYPE( track.type )) {
+        CHECK( track.width == MP4GetTrackVideoWidth( file, trackId ));
+        CHECK( track.height == MP4GetTrackVideoHeight( file, trackId ));
+        CHECK( track.width == 320 && track.height == 240 );
+        CHECK( track.sampleRate == 0 && track.channels == 0 );
+    }
+    else {
+        CHECK( MP4_IS_AUDIO_TRACK_TYPE( track.type ));
+        CHECK( track.sampleRate == MP4GetTrackTimeScale( file, trackId ));
+        CHECK( (int)track.channels == MP4GetTrackAudioChannels( file, trackId ));
+        CHECK( track.width == 0 && track.height == 0 );
+    }
+    return true;
+}
+
+static bool
+checkProbe( const char* name )
+{
+    MP4ProbeInfo info;
+    CHECK( MP4Probe( name, &info ));
+
+    MP4FileHandle file = MP4Read( name );
+    CHECK( file != MP4_INVALID_FILE_HANDLE );
+
+    const char* brand = NULL;
+    uint64_t minorVersion = 0;
+    bool ok = MP4GetStringProperty( file, "ftyp.majorBrand", &brand )
+        && MP4GetIntegerProperty( file, "ftyp.minorVersion", &minorVersion )
+        && !strcmp( info.majorBrand, brand )
+        && info.minorVersion == minorVersion
+        && info.timeScale == MP4GetTimeScale( file )
+        && info.duration == MP4GetDuration( file )
+        && info.numTracks == MP4GetNumberOfTracks( file );
+
+    for( uint32_t i = 0; ok && i < MP4_PROBE_MAX_TRACKS; i++ )
+        ok = checkTrack( file, info.tracks[i], MP4FindTrackId( file, (uint16_t)i ));
+    MP4Close( file );
+    CHECK( ok );
+    CHECK( info.numTracks == 1 + NUM_AUDIO_TRACKS );
+    return true;
+}
+
+// returns the offset following the moov box, or 0
+static uint64_t
+findMoovEnd( const std::vector<uint8_t>& data )
+{
+    uint64_t pos = 0;
+    while( pos + 8 <= data.size() ) {
+        const uint8_t* p = &data[pos];
+        uint32_t size = ((uint32_t)p[0] << 24) | (p[1] << 16) | (p[2] << 8) | p[3];
+        if( size < 8 )
+            return 0;
+        if( !memcmp( &p[4], "moov", 4 ))
+            return pos + size;
+        pos += size;
+    }
+    return 0;
+}
+
+static bool
+checkTruncated( const char* name )
+{
+    std::vector<uint8_t> data;
+    CHECK( readFile( name, data ));
+    const uint64_t moovEnd = findMoovEnd( data );
+    CHECK( moovEnd > 0 );
+
+    MemFile whole;
+    whole.data = data;
+    MP4ProbeInfo full;
+    CHECK( MP4ProbeCallbacks( &MEM_CALLBACKS, &whole, &full ));
+    CHECK( full.numTracks == 1 + NUM_AUDIO_TRACKS );
+
+    // every prefix up to a little past the moov box, then coarser steps
+    for( uint64_t size = 0; size <= data.size(); size += (size < moovEnd + 64) ? 1 : 997 ) {
+        MemFile prefix;
+        prefix.data.assign( data.begin(), data.begin() + (size_t)size );
+
+        MP4ProbeInfo info;
+        memset( &info, 0xA5, sizeof(info) );
+        bool found = MP4ProbeCallbacks( &MEM_CALLBACKS, &prefix, &info );
+
+        bool ok;
+        if( size >= moovEnd ) {
+            ok = found && !memcmp( &info, &full, sizeof(info) );
+        }
+        else {
+            // the ftyp box may have been read, nothing else
+            memset( info.majorBrand, 0, sizeof(info.majorBrand) );
+            info.minorVersion = 0;
+            ok = !found && isCleared( info );
+        }
+
+        if( !ok ) {
+            fprintf( stderr, "%s: prefix of %u bytes, moov ends at %u\n",
+                     name, (uint32_t)size, (uint32_t)moovEnd );
+            return false;
+        }
+    }
+    return true;
+}
+
+static bool
+probeOther( const std::vector<uint8_t>& data, bool expectMoov = false )
+{
+    CHECK( writeFile( OTHER_NAME, data ));
+
+    MP4ProbeInfo info;
+    memset( &info, 0xA5, sizeof(info) );
+    CHECK( MP4Probe( OTHER_NAME, &info ) == expectMoov );
+    CHECK( isCleared( info ));
+    return true;
+}
+
+static void
+appendBox( std::vector<uint8_t>& data, uint32_t size, const char* type )
+{
+    const uint8_t header[8] = {
+        (uint8_t)(size >> 24), (uint8_t)(size >> 16), (uint8_t)(size >> 8), (uint8_t)size,
+        (uint8_t)type[0], (uint8_t)type[1], (uint8_t)type[2], (uint8_t)type[3]
+    };
+    data.insert( data.end(), header, header + sizeof(header) );
+}
+
+static bool
+checkNotMp4()
+{
+    MP4ProbeInfo info;
+    memset( &info, 0xA5, sizeof(info) );
+    CHECK( !MP4Probe( "probe-does-not-exist.mp4", &info ));
+    CHECK( isCleared( info ));
+    CHECK( !MP4Probe( NULL, &info ));
+    CHECK( !MP4Probe( OPTIMIZED_NAME, NULL ));
+
+    // empty
+    std::vector<uint8_t> data;
+    CHECK( probeOther( data ));
+
+    // text
+    const char* text = "This is not an mp4 file, just some text.\n";
+    for( uint32_t i = 0; i < 100; i++ )
+        data.insert( data.end(), text, text + strlen( text ));
+    CHECK( probeOther( data ));
+
+    // noise
+    uint32_t state = 1;
+    data.resize( 100000 );
+    for( uint32_t i = 0; i < data.size(); i++ ) {
+        state = state * 1103515245 + 12345;
+        data[i] = (uint8_t)(state >> 16);
+    }
+    CHECK( probeOther( data ));
+
+    // well formed boxes, none of them moov
+    data.clear();
+    for( uint32_t i = 0; i < 1000; i++ )
+        appendBox( data, 8, "free" );
+    CHECK( probeOther( data ));
+
+    // a box smaller than its own header
+    data.clear();
+    appendBox( data, 4, "free" );
+    appendBox( data, 8, "moov" );
+    CHECK( probeOther( data ));
+
+    // a box larger than the file, and a 64-bit one
+    data.clear();
+    appendBox( data, 1000, "moov" );
+    CHECK( probeOther( data ));
+    data.clear();
+    appendBox( data, 1, "moov" );
+    const uint8_t largeSize[8] = { 0, 0, 0, 1, 0, 0, 0, 0 };
+    data.insert( data.end(), largeSize, largeSize + sizeof(largeSize) );
+    CHECK( probeOther( data ));
+
+    // a moov box reaching to the end of the file, holding nothing useful
+    data.clear();
+    appendBox( data, 0, "moov" );
+    data.resize( data.size() + 100, 0 );
+    CHECK( probeOther( data, true ));
+    return true;
+}
+
+int
+main( int, char** )
+{
+    MP4LogSetLevel( MP4_LOG_NONE );
+
+    bool ok = createFile()
+        && checkProbe( FILE_NAME )
+        && checkProbe( OPTIMIZED_NAME )
+        && checkTruncated( FILE_NAME )
+        && checkTruncated( OPTIMIZED_NAME )
+        && checkNotMp4();
+
+    remove( FILE_NAME );
+    remove( OPTIMIZED_NAME );
+    remove( OTHER_NAME );
+
+    printf( "%s\n", ok ? "PASS" : "FAIL" );
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,183 @@
+///////////////////////////////////////////////////////////////////////////////
+//
+//  The contents of this file are subject to the Mozilla Public License
+//  Version 1.1 (the "License"); you may not use this file except in
+//  compliance with the License. You may obtain a copy of the License at
+//  http://www.mozilla.org/MPL/
+//
+//  Software distributed under the License is distributed on an "AS IS"
+//  basis, WITHOUT WARRANTY OF ANY KIND, either express or implied. See the
+//  License for the specific language governing rights and limitations
+//  under the License.
+//
+//  The Original Code is MP4v2.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+// Remuxes a file with a video track and QuickTime chapters, whole and in
+// part, and checks the tracks, samples and chapters of the copies.
+
+#include <mp4v2/mp4v2.h>
+#include <cstdio>
+#include <cstring>
+
+#define CHECK(cond) \
+    do { \
+        if( !(cond) ) { \
+            fprintf( stderr, "%s:%d: check failed: %s\n", __FILE__, __LINE__, #cond ); \
+            return false; \
+        } \
+    } while( 0 )
+
+static const char* const SRC_NAME = "remux-src.mp4";
+static const char* const DST_NAME = "remux-dst.mp4";
+
+static const uint32_t NUM_SAMPLES = 100;  // 4 seconds at 25 fps
+static const uint32_t SYNC_PERIOD = 10;
+
+static bool
+createSource()
+{
+    MP4FileHandle file = MP4Create( SRC_NAME );
+    CHECK( file != MP4_INVALID_FILE_HANDLE );
+
+    MP4SetTimeScale( file, 1000 );
+    MP4TrackId trackId = MP4AddVideoTrack( file, 90000, 3600, 320, 240, MP4_MPEG4_VIDEO_TYPE );
+    CHECK( trackId != MP4_INVALID_TRACK_ID );
+
+    uint8_t sample[64];
+    for( uint32_t i = 0; i < NUM_SAMPLES; i++ ) {
+        memset( sample, (int)i, sizeof(sample) );
+        CHECK( MP4WriteSample( file, trackId, sample, sizeof(sample), MP4_INVALID_DURATION, 0, i % SYNC_PERIOD == 0 ));
+    }
+
+    MP4Chapter_t chapters[2];
+    memset( chapters, 0, sizeof(chapters) );
+    chapters[0].duration = 1500;
+    strcpy( chapters[0].title, "Opening" );
+    chapters[1].duration = 2500;
+    strcpy( chapters[1].title, "Closing" );
+    CHECK( MP4SetChapters( file, chapters, 2, MP4ChapterTypeQt ) == MP4ChapterTypeQt );
+
+    MP4Close( file );
+    return true;
+}
+
+static bool
+checkChapters( MP4FileHandle file )
+{
+    MP4Chapter_t* chapters = NULL;
+    uint32_t numChapters = 0;
+    CHECK( MP4GetChapters( file, &chapters, &numChapters, MP4ChapterTypeQt ) == MP4ChapterTypeQt );
+
+    bool ok = numChapters == 2
+        && !strcmp( chapters[0].title, "Opening" )
+        && !strcmp( chapters[1].title, "Closing" );
+    MP4Free( chapters );
+    CHECK( ok );
+    return true;
+}
+
+static bool
+checkWhole()
+{
+    MP4FileHandle src = MP4Read( SRC_NAME );
+    CHECK( src != MP4_INVALID_FILE_HANDLE );
+    bool remuxed = MP4Remux( src, DST_NAME );
+    MP4Close( src );
+    CHECK( remuxed );
+
+    MP4FileHandle dst = MP4Read( DST_NAME );
+    CHECK( dst != MP4_INVALID_FILE_HANDLE );
+    CHECK( MP4GetNumberOfTracks( dst ) == 2 );
+
+    MP4TrackId videoId = MP4FindTrackId( dst, 0, MP4_VIDEO_TRACK_TYPE );
+    MP4TrackId textId = MP4FindTrackId( dst, 0, MP4_TEXT_TRACK_TYPE );
+    CHECK( videoId != MP4_INVALID_TRACK_ID );
+    CHECK( textId != MP4_INVALID_TRACK_ID );
+    CHECK( MP4GetTrackNumberOfSamples( dst, videoId ) == NUM_SAMPLES );
+    CHECK( MP4GetTrackNumberOfSamples( dst, textId ) == 2 );
+
+    const char* dataName = MP4GetTrackMediaDataName( dst, textId );
+    CHECK( dataName && !strcmp( dataName, "text" ));
+
+    for( MP4SampleId sampleId = 1; sampleId <= NUM_SAMPLES; sampleId++ ) {
+        uint8_t* sample = NULL;
+        uint32_t sampleSize = 0;
+        bool sync = false;
+        CHECK( MP4ReadSample( dst, videoId, sampleId, &sample, &sampleSize, NULL, NULL, NULL, &sync ));
+        bool ok = sampleSize == 64 && sample[0] == (uint8_t)(sampleId - 1)
+            && sync == ((sampleId - 1) % SYNC_PERIOD == 0);
+        MP4Free( sample );
+        CHECK( ok );
+    }
+
+    bool ok = checkChapters( dst );
+    MP4Close( dst );
+    return ok;
+}
+
+static bool
+checkRange()
+{
+    // from 1.5s for 2s: starts at the sync sample at 1.2s, ends at 3.52s
+    MP4FileHandle src = MP4Read( SRC_NAME );
+    CHECK( src != MP4_INVALID_FILE_HANDLE );
+    bool remuxed = MP4Remux( src, DST_NAME, NULL, 0, 1500, 2000 );
+    MP4Close( src );
+    CHECK( remuxed );
+
+    MP4FileHandle dst = MP4Read( DST_NAME );
+    CHECK( dst != MP4_INVALID_FILE_HANDLE );
+    CHECK( MP4GetNumberOfTracks( dst ) == 2 );
+
+    MP4TrackId videoId = MP4FindTrackId( dst, 0, MP4_VIDEO_TRACK_TYPE );
+    CHECK( videoId != MP4_INVALID_TRACK_ID );
+    CHECK( MP4GetTrackNumberOfSamples( dst, videoId ) == 88 - 30 );
+    CHECK( MP4GetTrackNumberOfEdits( dst, videoId ) == 1 );
+
+    uint8_t* sample = NULL;
+    uint32_t sampleSize = 0;
+    CHECK( MP4ReadSample( dst, videoId, 1, &sample, &sampleSize ));
+    bool ok = sampleSize == 64 && sample[0] == 30;
+    MP4Free( sample );
+    CHECK( ok );
+
+    MP4Close( dst );
+    return true;
+}
+
+static bool
+checkSelf()
+{
+    MP4FileHandle src = MP4Read( SRC_NAME );
+    CHECK( src != MP4_INVALID_FILE_HANDLE );
+    bool remuxed = MP4Remux( src, "./remux-src.mp4" );
+    MP4Close( src );
+    CHECK( !remuxed );
+
+    // the source must be intact
+    src = MP4Read( SRC_NAME );
+    CHECK( src != MP4_INVALID_FILE_HANDLE );
+    bool ok = MP4GetNumberOfTracks( src ) == 2;
+    MP4Close( src );
+    CHECK( ok );
+    return true;
+}
+
+int
+main( int, char** )
+{
+    MP4LogSetLevel( MP4_LOG_ERROR );
+
+    bool ok = createSource()
+        && checkWhole()
+        && checkRange()
+        && checkSelf();
+
+    remove( SRC_NAME );
+    remove( DST_NAME );
+
+    printf( "%s\n", ok ? "PASS" : "FAIL" );
+    return ok ? 0 : 1;
+}
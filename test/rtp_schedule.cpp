@@ -0,0 +1,372 @@
+///////////////////////////////////////////////////////////////////////////////
+//
+//  The contents of this file are subject to the Mozilla Public License
+//  Version 1.1 (the "License"); you may not use this file except in
+//  compliance with the License. You may obtain a copy of the License at
+//  http://www.mozilla.org/MPL/
+//
+//  Software distributed under the License is distributed on an "AS IS"
+//  basis, WITHOUT WARRANTY OF ANY KIND, either express or implied. See the
+//  License for the specific language governing rights and limitations
+//  under the License.
+//
+//  The Original Code is MP4v2.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+// Compiles hint tracks with MP4CompileRtpSchedule() and checks that every
+// packet MP4BuildRtpSchedulePacket() gives, from a copy of the schedule and
+// of the file contents, matches MP4ReadRtpPacket() byte for byte. The hints
+// mix immediate data, sample data split into adjacent pieces, references to
+// earlier samples and ES configuration packets; a second file hints a
+// track whose media is in the first file. Also checks that
+// MP4CheckRtpSchedule() rejects damaged schedules.
+
+#include <mp4v2/mp4v2.h>
+#include <cstdio>
+#include <cstring>
+#include <vector>
+
+#define CHECK(cond) \
+    do { \
+        if( !(cond) ) { \
+            fprintf( stderr, "%s:%d: check failed: %s\n", __FILE__, __LINE__, #cond ); \
+            return false; \
+        } \
+    } while( 0 )
+
+static const char* const FILE_NAME     = "rtp-schedule.mp4";
+static const char* const REF_FILE_NAME = "rtp-schedule-ref.mp4";
+
+static const uint32_t    NUM_SAMPLES      = 120;
+static const MP4Duration SAMPLE_DURATION  = 3000;
+static const uint16_t    MAX_PAYLOAD_SIZE = 300;
+static const uint32_t    SSRC             = 0x12345678;
+
+static const MP4TrackId VIDEO_TRACK = 1;
+static const MP4TrackId HINT_TRACK  = 2;
+
+static const uint8_t ES_CONFIG[] = { 0x00, 0x00, 0x01, 0xb0, 0x01, 0x00, 0x00, 0x01, 0xb5, 0x09 };
+
+static uint32_t
+sampleSize( MP4SampleId sampleId )
+{
+    return 40 + sampleId * 37 % 900;
+}
+
+static bool
+isSyncSample( MP4SampleId sampleId )
+{
+    return sampleId % 10 == 1;
+}
+
+// one hint per media sample, with the number of payload segments each of
+// its packets should compile to
+static bool
+addHint( MP4FileHandle file, MP4TrackId hintTrackId, MP4SampleId sampleId,
+         bool sampleDataInFile, std::vector<uint16_t>& segmentCounts )
+{
+    CHECK( MP4AddRtpVideoHint( file, hintTrackId, sampleId % 4 == 2, sampleId % 3 * 100 ));
+
+    // the configuration is read from the sample description, which is
+    // always in the hinted file
+    if( isSyncSample( sampleId )) {
+        CHECK( MP4AddRtpESConfigurationPacket( file, hintTrackId ));
+        segmentCounts.push_back( 1 );
+    }
+
+    // a payload header, then the sample data in two adjacent pieces
+    const uint32_t size = sampleSize( sampleId );
+    const uint32_t chunk = MAX_PAYLOAD_SIZE - 2;
+    for( uint32_t offset = 0, k = 0; offset < size; offset += chunk, k++ ) {
+        const uint32_t length = size - offset < chunk ? size - offset : chunk;
+        const uint8_t header[2] = { (uint8_t)sampleId, (uint8_t)k };
+        CHECK( MP4AddRtpPacket( file, hintTrackId, offset + length == size, (int32_t)k * 7 - 3 ));
+        CHECK( MP4AddRtpImmediateData( file, hintTrackId, header, sizeof(header) ));
+        CHECK( MP4AddRtpSampleData( file, hintTrackId, sampleId, offset, length / 2 ));
+        CHECK( MP4AddRtpSampleData( file, hintTrackId, sampleId, offset + length / 2, length - length / 2 ));
+
+        // the pieces merge into one file segment, or, when the media is in
+        // another file, into the pool segment holding the header
+        segmentCounts.push_back( sampleDataInFile ? 2 : 1 );
+    }
+
+    // data of an earlier sample, between immediate data
+    if( sampleId % 5 == 0 ) {
+        const uint8_t before[3] = { 1, 2, 3 };
+        const uint8_t after[1] = { 4 };
+        CHECK( MP4AddRtpPacket( file, hintTrackId ));
+        CHECK( MP4AddRtpImmediateData( file, hintTrackId, before, sizeof(before) ));
+        CHECK( MP4AddRtpSampleData( file, hintTrackId, sampleId - 1, 5, 20 ));
+        CHECK( MP4AddRtpImmediateData( file, hintTrackId, after, sizeof(after) ));
+        segmentCounts.push_back( sampleDataInFile ? 3 : 1 );
+    }
+
+    CHECK( MP4WriteRtpHint( file, hintTrackId, SAMPLE_DURATION, isSyncSample( sampleId )));
+    return true;
+}
+
+static bool
+addHintTrack( MP4FileHandle file, MP4TrackId mediaTrackId, bool sampleDataInFile,
+              std::vector<uint16_t>& segmentCounts )
+{
+    MP4TrackId hintTrackId = MP4AddHintTrack( file, mediaTrackId );
+    CHECK( hintTrackId != MP4_INVALID_TRACK_ID );
+
+    uint8_t payloadNumber = MP4_SET_DYNAMIC_PAYLOAD;
+    CHECK( MP4SetHintTrackRtpPayload( file, hintTrackId, "MP4V-ES", &payloadNumber, MAX_PAYLOAD_SIZE ));
+
+    for( MP4SampleId sampleId = 1; sampleId <= NUM_SAMPLES; sampleId++ )
+        CHECK( addHint( file, hintTrackId, sampleId, sampleDataInFile, segmentCounts ));
+    return true;
+}
+
+static bool
+createFiles( std::vector<uint16_t>& segmentCounts, std::vector<uint16_t>& refSegmentCounts )
+{
+    MP4FileHandle file = MP4Create( FILE_NAME );
+    CHECK( file != MP4_INVALID_FILE_HANDLE );
+
+    bool ok = MP4AddVideoTrack( file, 90000, SAMPLE_DURATION, 320, 240, MP4_MPEG4_VIDEO_TYPE ) == VIDEO_TRACK
+        && MP4SetTrackESConfiguration( file, VIDEO_TRACK, ES_CONFIG, sizeof(ES_CONFIG) );
+
+    std::vector<uint8_t> sample( 1000 );
+    for( MP4SampleId sampleId = 1; ok && sampleId <= NUM_SAMPLES; sampleId++ ) {
+        for( uint32_t i = 0; i < sample.size(); i++ )
+            sample[i] = (uint8_t)(sampleId * 7 + i);
+        ok = MP4WriteSample( file, VIDEO_TRACK, &sample[0], sampleSize( sampleId ),
+                             MP4_INVALID_DURATION, 0, isSyncSample( sampleId ));
+    }
+
+    ok = ok && addHintTrack( file, VIDEO_TRACK, true, segmentCounts );
+
+    // a write handle can't be compiled
+    ok = ok && MP4CompileRtpSchedule( file, HINT_TRACK ) == NULL;
+    MP4Close( file );
+    CHECK( ok );
+
+    // hint a track whose media is in the first file
+    MP4FileHandle src = MP4Read( FILE_NAME );
+    CHECK( src != MP4_INVALID_FILE_HANDLE );
+    file = MP4Create( REF_FILE_NAME );
+    ok = file != MP4_INVALID_FILE_HANDLE
+        && MP4ReferenceTrack( src, VIDEO_TRACK, file ) == VIDEO_TRACK
+        && addHintTrack( file, VIDEO_TRACK, false, refSegmentCounts );
+    MP4Close( file );
+    MP4Close( src );
+    CHECK( ok );
+    return true;
+}
+
+static bool
+readFile( const char* name, std::vector<uint8_t>& data )
+{
+    FILE* in = fopen( name, "rb" );
+    CHECK( in );
+    data.clear();
+    uint8_t buf[4096];
+    size_t n;
+    while( (n = fread( buf, 1, sizeof(buf), in )) > 0 )
+        data.insert( data.end(), buf, buf + n );
+    fclose( in );
+    return true;
+}
+
+static const MP4RtpSchedulePacket*
+getPackets( const MP4RtpSchedule* schedule )
+{
+    return (const MP4RtpSchedulePacket*)((const uint8_t*)schedule + schedule->packetsOffset);
+}
+
+static MP4RtpScheduleSegment*
+getSegments( MP4RtpSchedule* schedule )
+{
+    return (MP4RtpScheduleSegment*)((uint8_t*)schedule + schedule->segmentsOffset);
+}
+
+static bool
+checkPackets( MP4FileHandle file, const MP4RtpSchedule* schedule,
+              const std::vector<uint8_t>& fileData, const std::vector<uint16_t>& segmentCounts )
+{
+    const MP4RtpSchedulePacket* packets = getPackets( schedule );
+    CHECK( schedule->numPackets == segmentCounts.size() );
+    CHECK( schedule->timeScale == MP4GetTrackTimeScale( file, HINT_TRACK ));
+    CHECK( schedule->timestampStart == MP4GetRtpTimestampStart( file, HINT_TRACK ));
+
+    std::vector<MP4RtpIoVec> iov( 8 );
+    uint8_t header[12];
+    uint32_t index = 0;
+
+    for( MP4SampleId hintId = 1; hintId <= NUM_SAMPLES; hintId++ ) {
+        uint16_t numPackets = 0;
+        CHECK( MP4ReadRtpHint( file, HINT_TRACK, hintId, &numPackets ));
+
+        for( uint16_t i = 0; i < numPackets; i++, index++ ) {
+            CHECK( index < schedule->numPackets );
+            const MP4RtpSchedulePacket& packet = packets[index];
+            CHECK( packet.hintSampleId == hintId );
+            CHECK( packet.timestamp == MP4GetSampleTime( file, HINT_TRACK, hintId ));
+            CHECK( packet.transmitOffset == MP4GetRtpPacketTransmitOffset( file, HINT_TRACK, i ));
+            CHECK( packet.isBFrame == MP4GetRtpPacketBFrame( file, HINT_TRACK, i ));
+            CHECK( packet.numSegments == segmentCounts[index] );
+
+            uint8_t* expected = NULL;
+            uint32_t expectedSize = 0;
+            CHECK( MP4ReadRtpPacket( file, HINT_TRACK, i, &expected, &expectedSize, SSRC ));
+
+            uint32_t n = MP4BuildRtpSchedulePacket( schedule, index, &fileData[0], SSRC,
+                                                    schedule->sequenceStart, schedule->timestampStart,
+                                                    header, &iov[0], (uint32_t)iov.size() );
+            std::vector<uint8_t> built;
+            for( uint32_t j = 0; j < n; j++ ) {
+                const uint8_t* base = (const uint8_t*)iov[j].base;
+                built.insert( built.end(), base, base + iov[j].length );
+            }
+
+            bool same = n == packet.numSegments + 1u
+                && packet.payloadSize + 12 == expectedSize
+                && built.size() == expectedSize
+                && !memcmp( &built[0], expected, expectedSize );
+            MP4Free( expected );
+            if( !same ) {
+                fprintf( stderr, "packet %u of hint %u differs\n", i, hintId );
+                return false;
+            }
+        }
+    }
+    CHECK( index == schedule->numPackets );
+
+    // other session parameters only change the header
+    CHECK( MP4BuildRtpSchedulePacket( schedule, 0, &fileData[0], 7, 0xfffe, 0x10,
+                                      header, &iov[0], (uint32_t)iov.size() ) > 0 );
+    const uint16_t sequenceNumber = (uint16_t)(0xfffe + packets[0].sequenceNumber);
+    const uint32_t timestamp = 0x10 + (uint32_t)packets[0].timestamp;
+    CHECK( header[2] == (uint8_t)(sequenceNumber >> 8) && header[3] == (uint8_t)sequenceNumber );
+    CHECK( header[4] == (uint8_t)(timestamp >> 24) && header[7] == (uint8_t)timestamp );
+    CHECK( header[8] == 0 && header[11] == 7 );
+    return true;
+}
+
+static bool
+checkBuildErrors( const MP4RtpSchedule* schedule, const std::vector<uint8_t>& fileData )
+{
+    std::vector<MP4RtpIoVec> iov( 8 );
+    uint8_t header[12];
+    const MP4RtpSchedulePacket* packets = getPackets( schedule );
+
+    CHECK( MP4BuildRtpSchedulePacket( schedule, schedule->numPackets, &fileData[0], SSRC, 0, 0,
+                                      header, &iov[0], (uint32_t)iov.size() ) == 0 );
+    CHECK( MP4BuildRtpSchedulePacket( schedule, 0, &fileData[0], SSRC, 0, 0,
+                                      header, &iov[0], packets[0].numSegments ) == 0 );
+    CHECK( MP4BuildRtpSchedulePacket( schedule, 0, &fileData[0], SSRC, 0, 0,
+                                      NULL, &iov[0], (uint32_t)iov.size() ) == 0 );
+    CHECK( MP4BuildRtpSchedulePacket( NULL, 0, &fileData[0], SSRC, 0, 0,
+                                      header, &iov[0], (uint32_t)iov.size() ) == 0 );
+
+    // payload from the file needs the file contents
+    CHECK( MP4BuildRtpSchedulePacket( schedule, 0, NULL, SSRC, 0, 0,
+                                      header, &iov[0], (uint32_t)iov.size() ) == 0 );
+    return true;
+}
+
+// damages a copy of the schedule, expecting MP4CheckRtpSchedule() to notice
+static bool
+checkDamaged( const MP4RtpSchedule* schedule )
+{
+    const size_t size = (size_t)schedule->size;
+    std::vector<uint8_t> copy( size );
+
+    for( uint32_t damage = 0; damage < 8; damage++ ) {
+        memcpy( &copy[0], schedule, size );
+        MP4RtpSchedule* s = (MP4RtpSchedule*)&copy[0];
+        MP4RtpSchedulePacket* packets = (MP4RtpSchedulePacket*)getPackets( s );
+        MP4RtpScheduleSegment* segments = getSegments( s );
+        uint64_t available = size;
+
+        switch( damage ) {
+        case 0: s->magic ^= 1; break;
+        case 1: s->version++; break;
+        case 2: available = size - 1; break;
+        case 3: s->numPackets++; break;
+        case 4: s->segmentsOffset = s->poolOffset + 8; break;
+        case 5: packets[s->numPackets - 1].firstSegment = s->numSegments; break;
+        case 6: {
+            uint32_t i = 0;
+            while( !(segments[i].flags & MP4_RTP_SEGMENT_POOL) )
+                i++;
+            segments[i].offset = s->size - s->poolOffset - segments[i].length + 1;
+            break;
+        }
+        case 7: {
+            uint32_t i = 0;
+            while( segments[i].flags & MP4_RTP_SEGMENT_POOL )
+                i++;
+            segments[i].offset = (uint64_t)-1 - segments[i].length + 1;
+            break;
+        }
+        }
+
+        if( MP4CheckRtpSchedule( s, available )) {
+            fprintf( stderr, "damage %u not noticed\n", damage );
+            return false;
+        }
+    }
+    return true;
+}
+
+static bool
+checkSchedule( const char* name, const std::vector<uint16_t>& segmentCounts, bool sampleDataInFile )
+{
+    std::vector<uint8_t> fileData;
+    CHECK( readFile( name, fileData ));
+
+    MP4FileHandle file = MP4Read( name );
+    CHECK( file != MP4_INVALID_FILE_HANDLE );
+
+    // use a copy, as if loaded from disk, so nothing points into the original
+    MP4RtpSchedule* compiled = MP4CompileRtpSchedule( file, HINT_TRACK );
+    bool ok = compiled && MP4CheckRtpSchedule( compiled, compiled->size );
+    std::vector<uint64_t> copy;
+    if( ok ) {
+        copy.resize( (size_t)(compiled->size + 7) / 8 );
+        memcpy( &copy[0], compiled, (size_t)compiled->size );
+        memset( compiled, 0xA5, (size_t)compiled->size );
+    }
+    MP4Free( compiled );
+
+    const MP4RtpSchedule* schedule = (const MP4RtpSchedule*)&copy[0];
+    ok = ok && checkPackets( file, schedule, fileData, segmentCounts );
+    MP4Close( file );
+    CHECK( ok );
+
+    MP4RtpScheduleSegment* segments = getSegments( (MP4RtpSchedule*)schedule );
+    for( uint32_t i = 0; i < schedule->numSegments; i++ ) {
+        if( !(segments[i].flags & MP4_RTP_SEGMENT_POOL) )
+            CHECK( segments[i].offset + segments[i].length <= fileData.size() );
+    }
+
+    if( sampleDataInFile ) {
+        CHECK( checkBuildErrors( schedule, fileData ));
+        CHECK( checkDamaged( schedule ));
+    }
+    return true;
+}
+
+int
+main( int, char** )
+{
+    MP4LogSetLevel( MP4_LOG_NONE );
+
+    std::vector<uint16_t> segmentCounts;
+    std::vector<uint16_t> refSegmentCounts;
+
+    bool ok = createFiles( segmentCounts, refSegmentCounts )
+        && checkSchedule( FILE_NAME, segmentCounts, true )
+        && checkSchedule( REF_FILE_NAME, refSegmentCounts, false );
+
+    remove( FILE_NAME );
+    remove( REF_FILE_NAME );
+
+    printf( "%s\n", ok ? "PASS" : "FAIL" );
+    return ok ? 0 : 1;
+}
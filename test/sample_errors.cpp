@@ -0,0 +1,306 @@
+///////////////////////////////////////////////////////////////////////////////
+//
+//  The contents of this file are subject to the Mozilla Public License
+//  Version 1.1 (the "License"); you may not use this file except in
+//  compliance with the License. You may obtain a copy of the License at
+//  http://www.mozilla.org/MPL/
+//
+//  Software distributed under the License is distributed on an "AS IS"
+//  basis, WITHOUT WARRANTY OF ANY KIND, either express or implied. See the
+//  License for the specific language governing rights and limitations
+//  under the License.
+//
+//  The Original Code is MP4v2.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+// Makes each expected failure of the sample access functions happen: bad
+// handle, track, sample id and time, a short buffer, a missing external
+// file, broken sample tables and a truncated file. Checks the status
+// MP4GetLastError() reports, that success resets it, that it is kept per
+// thread, and that none of these failures reach the log handler.
+
+#include <mp4v2/mp4v2.h>
+#include <cstdio>
+#include <cstring>
+#include <thread>
+#include <vector>
+
+#define CHECK(cond) \
+    do { \
+        if( !(cond) ) { \
+            fprintf( stderr, "%s:%d: check failed: %s\n", __FILE__, __LINE__, #cond ); \
+            return false; \
+        } \
+    } while( 0 )
+
+static const char* const FILE_NAME      = "sample-errors.mp4";
+static const char* const REF_NAME       = "sample-errors-ref.mp4";
+static const char* const REF_SRC_NAME   = "sample-errors-ref-src.mp4";
+static const char* const TRUNCATED_NAME = "sample-errors-truncated.mp4";
+
+static const uint32_t    NUM_SAMPLES     = 100;
+static const MP4Duration SAMPLE_DURATION = 3000;
+static const MP4TrackId  NO_TRACK        = 99;
+
+static uint32_t numLogMessages = 0;
+
+static void
+countLogMessage( MP4LogLevel, const char*, va_list )
+{
+    numLogMessages++;
+}
+
+static uint32_t
+sampleSize( MP4SampleId sampleId )
+{
+    return 50 + sampleId % 40;
+}
+
+static bool
+writeSamples( const char* name )
+{
+    MP4FileHandle file = MP4Create( name );
+    CHECK( file != MP4_INVALID_FILE_HANDLE );
+
+    bool ok = MP4AddVideoTrack( file, 90000, SAMPLE_DURATION, 320, 240, MP4_MPEG4_VIDEO_TYPE ) == 1;
+    uint8_t sample[100];
+    for( MP4SampleId sampleId = 1; ok && sampleId <= NUM_SAMPLES; sampleId++ ) {
+        memset( sample, (int)sampleId, sizeof(sample) );
+        ok = MP4WriteSample( file, 1, sample, sampleSize( sampleId ), MP4_INVALID_DURATION, 0, sampleId % 10 == 1 );
+    }
+    MP4Close( file );
+    CHECK( ok );
+    return true;
+}
+
+// every sample access function, expecting the same status from each
+static bool
+checkAll( MP4FileHandle file, MP4TrackId trackId, MP4SampleId sampleId, MP4Error expected )
+{
+    numLogMessages = 0;
+
+    uint8_t* bytes = NULL;
+    uint32_t numBytes = 1234;
+    CHECK( !MP4ReadSample( file, trackId, sampleId, &bytes, &numBytes ));
+    CHECK( MP4GetLastError() == expected );
+    CHECK( bytes == NULL && numBytes == 0 );
+
+    CHECK( MP4GetSampleSize( file, trackId, sampleId ) == 0 );
+    CHECK( MP4GetLastError() == expected );
+    CHECK( MP4GetSampleTime( file, trackId, sampleId ) == MP4_INVALID_TIMESTAMP );
+    CHECK( MP4GetLastError() == expected );
+    CHECK( MP4GetSampleDuration( file, trackId, sampleId ) == MP4_INVALID_DURATION );
+    CHECK( MP4GetLastError() == expected );
+    CHECK( MP4GetSampleRenderingOffset( file, trackId, sampleId ) == MP4_INVALID_DURATION );
+    CHECK( MP4GetLastError() == expected );
+    CHECK( MP4GetSampleSync( file, trackId, sampleId ) == -1 );
+    CHECK( MP4GetLastError() == expected );
+
+    CHECK( numLogMessages == 0 );
+    return true;
+}
+
+static bool
+checkReadSample( MP4FileHandle file, MP4SampleId sampleId, MP4Error expected )
+{
+    numLogMessages = 0;
+    uint8_t* bytes = NULL;
+    uint32_t numBytes = 0;
+    bool read = MP4ReadSample( file, 1, sampleId, &bytes, &numBytes );
+    MP4Free( bytes );
+    CHECK( read == (expected == MP4_ERROR_NONE) );
+    CHECK( MP4GetLastError() == expected );
+    CHECK( numLogMessages == 0 );
+    return true;
+}
+
+// the status of a thread that hasn't accessed any samples
+static void
+lastErrorOfNewThread( MP4Error* error )
+{
+    *error = MP4GetLastError();
+}
+
+static bool
+checkLookups()
+{
+    MP4FileHandle file = MP4Read( FILE_NAME );
+    CHECK( file != MP4_INVALID_FILE_HANDLE );
+
+    bool ok = checkAll( MP4_INVALID_FILE_HANDLE, 1, 1, MP4_ERROR_INVALID_HANDLE )
+        && checkAll( file, NO_TRACK, 1, MP4_ERROR_INVALID_TRACK )
+        && checkAll( file, MP4_INVALID_TRACK_ID, 1, MP4_ERROR_INVALID_TRACK )
+        && checkAll( file, 1, MP4_INVALID_SAMPLE_ID, MP4_ERROR_INVALID_SAMPLE )
+        && checkAll( file, 1, NUM_SAMPLES + 1, MP4_ERROR_INVALID_SAMPLE );
+
+    // success resets the status
+    ok = ok && MP4GetSampleSize( file, 1, NUM_SAMPLES ) == sampleSize( NUM_SAMPLES )
+        && MP4GetLastError() == MP4_ERROR_NONE;
+
+    // times past the end of the track
+    const MP4Timestamp end = NUM_SAMPLES * SAMPLE_DURATION;
+    static const MP4Timestamp PAST_END[] = { end + 1, end + SAMPLE_DURATION, end * 1000 };
+    numLogMessages = 0;
+    for( uint32_t i = 0; ok && i < sizeof(PAST_END) / sizeof(PAST_END[0]); i++ ) {
+        uint8_t* bytes = NULL;
+        uint32_t numBytes = 1234;
+        ok = MP4GetSampleIdFromTime( file, 1, PAST_END[i] ) == MP4_INVALID_SAMPLE_ID
+            && MP4GetLastError() == MP4_ERROR_TIME_OUT_OF_RANGE
+            && !MP4ReadSampleFromTime( file, 1, PAST_END[i], &bytes, &numBytes )
+            && MP4GetLastError() == MP4_ERROR_TIME_OUT_OF_RANGE
+            && bytes == NULL && numBytes == 0
+            && MP4GetSampleIdFromTime( file, NO_TRACK, 0 ) == MP4_INVALID_SAMPLE_ID
+            && MP4GetLastError() == MP4_ERROR_INVALID_TRACK;
+    }
+    ok = ok && numLogMessages == 0
+        && MP4GetSampleIdFromTime( file, 1, end - 1 ) == NUM_SAMPLES
+        && MP4GetLastError() == MP4_ERROR_NONE;
+
+    // a caller supplied buffer one byte short, then one that fits
+    uint8_t buffer[100];
+    uint8_t* bytes = buffer;
+    uint32_t numBytes = sampleSize( 7 ) - 1;
+    ok = ok && !MP4ReadSample( file, 1, 7, &bytes, &numBytes )
+        && MP4GetLastError() == MP4_ERROR_BUFFER_TOO_SMALL
+        && bytes == buffer && numBytes == 0;
+    numBytes = sampleSize( 7 );
+    ok = ok && MP4ReadSample( file, 1, 7, &bytes, &numBytes )
+        && MP4GetLastError() == MP4_ERROR_NONE
+        && numBytes == sampleSize( 7 ) && buffer[0] == 7;
+    ok = ok && numLogMessages == 0;
+
+    // the status is kept per thread
+    ok = ok && MP4GetSampleSync( file, 1, 0 ) == -1
+        && MP4GetLastError() == MP4_ERROR_INVALID_SAMPLE;
+    MP4Error otherError = MP4_ERROR_FAILED;
+    std::thread other( lastErrorOfNewThread, &otherError );
+    other.join();
+    ok = ok && otherError == MP4_ERROR_NONE
+        && MP4GetLastError() == MP4_ERROR_INVALID_SAMPLE;
+
+    MP4Close( file );
+    CHECK( ok );
+    return true;
+}
+
+static bool
+checkExternalFile()
+{
+    CHECK( writeSamples( REF_SRC_NAME ));
+
+    MP4FileHandle src = MP4Read( REF_SRC_NAME );
+    CHECK( src != MP4_INVALID_FILE_HANDLE );
+    MP4FileHandle dst = MP4Create( REF_NAME );
+    bool ok = dst != MP4_INVALID_FILE_HANDLE
+        && MP4ReferenceTrack( src, 1, dst ) == 1;
+    MP4Close( dst );
+    MP4Close( src );
+    CHECK( ok );
+
+    MP4FileHandle file = MP4Read( REF_NAME );
+    CHECK( file != MP4_INVALID_FILE_HANDLE );
+    ok = checkReadSample( file, 5, MP4_ERROR_NONE );
+    MP4Close( file );
+    CHECK( ok );
+
+    // the referenced file is gone
+    remove( REF_SRC_NAME );
+    file = MP4Read( REF_NAME );
+    CHECK( file != MP4_INVALID_FILE_HANDLE );
+    ok = checkReadSample( file, 5, MP4_ERROR_INACCESSIBLE_FILE )
+        && checkReadSample( file, 6, MP4_ERROR_INACCESSIBLE_FILE )
+        && MP4GetSampleSize( file, 1, 5 ) == sampleSize( 5 );
+    MP4Close( file );
+    CHECK( ok );
+    return true;
+}
+
+static bool
+checkCorrupt()
+{
+    // a chunk past the end of the chunk offset table
+    MP4FileHandle file = MP4Modify( FILE_NAME );
+    CHECK( file != MP4_INVALID_FILE_HANDLE );
+    uint64_t numChunks = 0;
+    bool ok = MP4GetTrackIntegerProperty( file, 1, "mdia.minf.stbl.stco.entryCount", &numChunks )
+        && numChunks > 0
+        && MP4SetTrackIntegerProperty( file, 1, "mdia.minf.stbl.stsc.entries[0].firstChunk", numChunks + 1 );
+    MP4Close( file );
+    CHECK( ok );
+
+    file = MP4Read( FILE_NAME );
+    CHECK( file != MP4_INVALID_FILE_HANDLE );
+    ok = checkReadSample( file, 1, MP4_ERROR_CORRUPT )
+        && checkReadSample( file, NUM_SAMPLES, MP4_ERROR_CORRUPT );
+    MP4Close( file );
+    CHECK( ok );
+    return true;
+}
+
+static bool
+checkTruncated()
+{
+    // moov ahead of mdat, then cut off the last samples
+    CHECK( MP4Optimize( FILE_NAME, TRUNCATED_NAME ));
+
+    FILE* f = fopen( TRUNCATED_NAME, "rb" );
+    CHECK( f );
+    std::vector<uint8_t> data;
+    uint8_t buf[4096];
+    size_t n;
+    while( (n = fread( buf, 1, sizeof(buf), f )) > 0 )
+        data.insert( data.end(), buf, buf + n );
+    fclose( f );
+
+    const size_t cut = sampleSize( NUM_SAMPLES ) + sampleSize( NUM_SAMPLES - 1 ) / 2;
+    CHECK( data.size() > cut );
+    f = fopen( TRUNCATED_NAME, "wb" );
+    CHECK( f );
+    bool ok = fwrite( &data[0], 1, data.size() - cut, f ) == data.size() - cut;
+    fclose( f );
+    CHECK( ok );
+
+    MP4FileHandle file = MP4Read( TRUNCATED_NAME );
+    CHECK( file != MP4_INVALID_FILE_HANDLE );
+    ok = checkReadSample( file, NUM_SAMPLES - 2, MP4_ERROR_NONE )
+        && checkReadSample( file, NUM_SAMPLES - 1, MP4_ERROR_TRUNCATED )
+        && checkReadSample( file, NUM_SAMPLES, MP4_ERROR_TRUNCATED );
+    MP4Close( file );
+    CHECK( ok );
+    return true;
+}
+
+static bool
+checkErrorStrings()
+{
+    for( int error = MP4_ERROR_NONE; error <= MP4_ERROR_TRUNCATED; error++ ) {
+        const char* s = MP4GetErrorString( (MP4Error)error );
+        CHECK( s && *s );
+        for( int other = MP4_ERROR_NONE; other < error; other++ )
+            CHECK( strcmp( s, MP4GetErrorString( (MP4Error)other )));
+    }
+    return true;
+}
+
+int
+main( int, char** )
+{
+    MP4LogSetLevel( MP4_LOG_ERROR );
+    MP4SetLogCallback( countLogMessage );
+
+    bool ok = writeSamples( FILE_NAME )
+        && checkLookups()
+        && checkExternalFile()
+        && checkTruncated()
+        && checkCorrupt()
+        && checkErrorStrings();
+
+    remove( FILE_NAME );
+    remove( REF_NAME );
+    remove( REF_SRC_NAME );
+    remove( TRUNCATED_NAME );
+
+    printf( "%s\n", ok ? "PASS" : "FAIL" );
+    return ok ? 0 : 1;
+}
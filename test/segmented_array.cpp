@@ -0,0 +1,212 @@
+///////////////////////////////////////////////////////////////////////////////
+//
+//  The contents of this file are subject to the Mozilla Public License
+//  Version 1.1 (the "License"); you may not use this file except in
+//  compliance with the License. You may obtain a copy of the License at
+//  http://www.mozilla.org/MPL/
+//
+//  Software distributed under the License is distributed on an "AS IS"
+//  basis, WITHOUT WARRANTY OF ANY KIND, either express or implied. See the
+//  License for the specific language governing rights and limitations
+//  under the License.
+//
+//  The Original Code is MP4v2.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+// Grows MP4SegmentedArray across several segments with Add(), Append() and
+// Resize(), then mixes in Insert() and Delete() so segments are split and
+// removed, and checks every index against a std::vector doing the same.
+// Also checks that indexes past the end throw. Uses library internals, so
+// it includes src/impl.h.
+
+#include "src/impl.h"
+#include <cstdio>
+#include <vector>
+
+using namespace mp4v2::impl;
+
+#define CHECK(cond) \
+    do { \
+        if( !(cond) ) { \
+            fprintf( stderr, "%s:%d: check failed: %s\n", __FILE__, __LINE__, #cond ); \
+            return false; \
+        } \
+    } while( 0 )
+
+typedef MP4SegmentedArray<uint64_t> Array;
+
+static const uint32_t SEGMENT_SIZE = Array::SegmentSize;
+
+// deterministic, so a failure can be reproduced
+static uint32_t
+nextRandom( uint32_t& state )
+{
+    state = state * 1103515245 + 12345;
+    return state >> 8;
+}
+
+static bool
+sameElements( Array& array, const std::vector<uint64_t>& expected )
+{
+    CHECK( array.Size() == expected.size() );
+    for( uint32_t i = 0; i < expected.size(); i++ ) {
+        if( array[i] != expected[i] ) {
+            fprintf( stderr, "element %u of %u differs\n", i, (uint32_t)expected.size() );
+            return false;
+        }
+    }
+    return true;
+}
+
+static bool
+throwsOutOfRange( Array& array, MP4ArrayIndex index )
+{
+    try {
+        array[index];
+    }
+    catch( Exception* x ) {
+        delete x;
+        return true;
+    }
+    return false;
+}
+
+static bool
+checkGrowth()
+{
+    Array array;
+    std::vector<uint64_t> expected;
+    CHECK( array.Size() == 0 );
+    CHECK( !array.ValidIndex( 0 ));
+    CHECK( throwsOutOfRange( array, 0 ));
+
+    // a single element lives inside the array
+    array.Add( 7 );
+    expected.push_back( 7 );
+    CHECK( sameElements( array, expected ));
+
+    // grow the first segment one element at a time, past its end
+    for( uint64_t i = 1; i < SEGMENT_SIZE + 10; i++ ) {
+        array.Add( i * 3 );
+        expected.push_back( i * 3 );
+    }
+    CHECK( sameElements( array, expected ));
+
+    // append in pieces that straddle segment boundaries
+    std::vector<uint64_t> block( SEGMENT_SIZE + 123 );
+    for( uint32_t n = 0; n < 4; n++ ) {
+        for( uint32_t i = 0; i < block.size(); i++ )
+            block[i] = ((uint64_t)n << 40) | i;
+        array.Append( &block[0], (MP4ArrayIndex)block.size() );
+        expected.insert( expected.end(), block.begin(), block.end() );
+    }
+    CHECK( sameElements( array, expected ));
+    CHECK( array.ValidIndex( (MP4ArrayIndex)expected.size() - 1 ));
+    CHECK( !array.ValidIndex( (MP4ArrayIndex)expected.size() ));
+    CHECK( throwsOutOfRange( array, (MP4ArrayIndex)expected.size() ));
+
+    // shrink into the middle of a segment, then grow and fill the new tail
+    const uint32_t shrunk = 2 * SEGMENT_SIZE + 5;
+    array.Resize( shrunk );
+    expected.resize( shrunk );
+    CHECK( sameElements( array, expected ));
+
+    const uint32_t grown = 5 * SEGMENT_SIZE - 1;
+    array.Resize( grown );
+    CHECK( array.Size() == grown );
+    for( uint32_t i = shrunk; i < grown; i++ )
+        array[i] = i;
+    for( uint32_t i = shrunk; i < grown; i++ )
+        expected.push_back( i );
+    CHECK( sameElements( array, expected ));
+
+    array.Resize( 0 );
+    CHECK( array.Size() == 0 );
+    CHECK( throwsOutOfRange( array, 0 ));
+
+    // still usable after being emptied
+    array.Add( 42 );
+    CHECK( array.Size() == 1 && array[0] == 42 );
+    return true;
+}
+
+static bool
+checkInsertDelete()
+{
+    Array array;
+    std::vector<uint64_t> expected;
+
+    std::vector<uint64_t> block( 3 * SEGMENT_SIZE );
+    for( uint32_t i = 0; i < block.size(); i++ )
+        block[i] = i;
+    array.Append( &block[0], (MP4ArrayIndex)block.size() );
+    expected = block;
+
+    // inserts into full segments split them, deletes can empty them
+    uint32_t state = 1;
+    uint64_t value = 1000000;
+    for( uint32_t step = 0; step < 20000; step++ ) {
+        const uint32_t r = nextRandom( state );
+        if( r % 5 < 3 || expected.empty() ) {
+            const uint32_t index = nextRandom( state ) % (expected.size() + 1);
+            array.Insert( value, index );
+            expected.insert( expected.begin() + index, value );
+            value++;
+        }
+        else {
+            // delete runs, so whole segments go away
+            uint32_t index = nextRandom( state ) % expected.size();
+            uint32_t count = 1 + (r % 7 == 0 ? nextRandom( state ) % 3000 : 0);
+            while( count-- && index < expected.size() ) {
+                array.Delete( index );
+                expected.erase( expected.begin() + index );
+            }
+        }
+
+        if( step % 1000 == 0 )
+            CHECK( sameElements( array, expected ));
+    }
+    CHECK( sameElements( array, expected ));
+
+    // lookups out of order, after walking the array in order above
+    for( uint32_t i = 0; i < 5000; i++ ) {
+        const uint32_t index = nextRandom( state ) % expected.size();
+        CHECK( array[index] == expected[index] );
+    }
+
+    // appending keeps working after splits
+    for( uint32_t i = 0; i < SEGMENT_SIZE + 1; i++ ) {
+        array.Add( i );
+        expected.push_back( i );
+    }
+    CHECK( sameElements( array, expected ));
+    CHECK( throwsOutOfRange( array, (MP4ArrayIndex)expected.size() ));
+
+    try {
+        array.Insert( 0, (MP4ArrayIndex)expected.size() + 1 );
+        CHECK( false );
+    }
+    catch( Exception* x ) {
+        delete x;
+    }
+    try {
+        array.Delete( (MP4ArrayIndex)expected.size() );
+        CHECK( false );
+    }
+    catch( Exception* x ) {
+        delete x;
+    }
+    CHECK( sameElements( array, expected ));
+    return true;
+}
+
+int
+main( int, char** )
+{
+    bool ok = checkGrowth()
+        && checkInsertDelete();
+
+    printf( "%s\n", ok ? "PASS" : "FAIL" );
+    return ok ? 0 : 1;
+}
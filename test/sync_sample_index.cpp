@@ -0,0 +1,174 @@
+///////////////////////////////////////////////////////////////////////////////
+//
+//  The contents of this file are subject to the Mozilla Public License
+//  Version 1.1 (the "License"); you may not use this file except in
+//  compliance with the License. You may obtain a copy of the License at
+//  http://www.mozilla.org/MPL/
+//
+//  Software distributed under the License is distributed on an "AS IS"
+//  basis, WITHOUT WARRANTY OF ANY KIND, either express or implied. See the
+//  License for the specific language governing rights and limitations
+//  under the License.
+//
+//  The Original Code is MP4v2.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+// Indexes the sync samples of a track without a sync sample table, of one
+// whose table is empty and of one with rendering offsets, and checks each
+// entry against the per sample lookups and the sample data.
+
+#include <mp4v2/mp4v2.h>
+#include <cstdio>
+#include <cstring>
+
+#define CHECK(cond) \
+    do { \
+        if( !(cond) ) { \
+            fprintf( stderr, "%s:%d: check failed: %s\n", __FILE__, __LINE__, #cond ); \
+            return false; \
+        } \
+    } while( 0 )
+
+static const char* const FILE_NAME = "sync-sample-index.mp4";
+
+static const uint32_t NUM_SAMPLES = 50;
+
+// track 1 has only sync samples, so no stss, track 2 none, so an empty
+// stss, and track 3 a sync sample every 7 samples and ctts
+static const MP4TrackId ALL_SYNC_TRACK = 1;
+static const MP4TrackId NO_SYNC_TRACK  = 2;
+static const MP4TrackId CTTS_TRACK     = 3;
+
+static bool
+isSync( MP4TrackId trackId, MP4SampleId sampleId )
+{
+    switch( trackId ) {
+    case ALL_SYNC_TRACK:
+        return true;
+    case NO_SYNC_TRACK:
+        return false;
+    default:
+        return sampleId % 7 == 1;
+    }
+}
+
+// stts, ctts and stsc get runs of different lengths
+static MP4Duration
+sampleDuration( MP4SampleId sampleId )
+{
+    return 1000 + ((sampleId - 1) / 4 % 3) * 500;
+}
+
+static MP4Duration
+renderingOffset( MP4TrackId trackId, MP4SampleId sampleId )
+{
+    return trackId == CTTS_TRACK ? ((sampleId - 1) / 3 % 4) * 1000 : 0;
+}
+
+static uint32_t
+sampleSize( MP4SampleId sampleId )
+{
+    return 10 + sampleId % 11;
+}
+
+static bool
+createFile()
+{
+    MP4FileHandle file = MP4Create( FILE_NAME );
+    CHECK( file != MP4_INVALID_FILE_HANDLE );
+
+    uint8_t sample[32];
+    for( MP4TrackId trackId = ALL_SYNC_TRACK; trackId <= CTTS_TRACK; trackId++ ) {
+        CHECK( MP4AddVideoTrack( file, 90000, MP4_INVALID_DURATION, 320, 240, MP4_MPEG4_VIDEO_TYPE ) == trackId );
+        CHECK( MP4SetTrackDurationPerChunk( file, trackId, 9000 ));
+
+        for( MP4SampleId sampleId = 1; sampleId <= NUM_SAMPLES; sampleId++ ) {
+            memset( sample, (int)(sampleId + trackId * 64), sizeof(sample) );
+            CHECK( MP4WriteSample( file, trackId, sample, sampleSize( sampleId ), sampleDuration( sampleId ),
+                                   renderingOffset( trackId, sampleId ), isSync( trackId, sampleId )));
+        }
+    }
+
+    MP4Close( file );
+    return true;
+}
+
+static bool
+checkIndex( MP4FileHandle file, MP4TrackId trackId )
+{
+    MP4DecodableSample* samples = NULL;
+    uint32_t numSamples = 0;
+    CHECK( MP4GetSyncSampleIndex( file, trackId, &samples, &numSamples ));
+    CHECK( (samples == NULL) == (numSamples == 0) );
+
+    FILE* in = fopen( FILE_NAME, "rb" );
+    bool ok = in != NULL;
+
+    uint32_t n = 0;
+    for( MP4SampleId sampleId = 1; ok && sampleId <= NUM_SAMPLES; sampleId++ ) {
+        if( !isSync( trackId, sampleId ))
+            continue;
+
+        const MP4DecodableSample& sample = samples[n++];
+        uint8_t data = 0;
+        ok = n <= numSamples
+            && sample.sampleId == sampleId
+            && sample.isSyncSample
+            && sample.startTime == MP4GetSampleTime( file, trackId, sampleId )
+            && sample.duration == sampleDuration( sampleId )
+            && sample.renderingOffset == renderingOffset( trackId, sampleId )
+            && sample.renderingOffset == MP4GetSampleRenderingOffset( file, trackId, sampleId )
+            && sample.size == sampleSize( sampleId )
+            && fseek( in, (long)sample.offset, SEEK_SET ) == 0
+            && fread( &data, 1, 1, in ) == 1
+            && data == (uint8_t)(sampleId + trackId * 64);
+    }
+    if( in )
+        fclose( in );
+
+    MP4Free( samples );
+    CHECK( ok );
+    CHECK( n == numSamples );
+    return true;
+}
+
+static bool
+checkFile()
+{
+    MP4FileHandle file = MP4Read( FILE_NAME );
+    CHECK( file != MP4_INVALID_FILE_HANDLE );
+
+    // the tracks must cover each shape of the sync sample table
+    uint64_t allSyncCount = 0;
+    uint64_t noSyncCount = 1;
+    uint64_t cttsCount = 0;
+    bool ok = !MP4GetTrackIntegerProperty( file, ALL_SYNC_TRACK, "mdia.minf.stbl.stss.entryCount", &allSyncCount )
+        && MP4GetTrackIntegerProperty( file, NO_SYNC_TRACK, "mdia.minf.stbl.stss.entryCount", &noSyncCount )
+        && noSyncCount == 0
+        && MP4GetTrackIntegerProperty( file, CTTS_TRACK, "mdia.minf.stbl.ctts.entryCount", &cttsCount )
+        && cttsCount > 1;
+    if( !ok )
+        fprintf( stderr, "unexpected sample tables\n" );
+
+    ok = ok && checkIndex( file, ALL_SYNC_TRACK )
+        && checkIndex( file, NO_SYNC_TRACK )
+        && checkIndex( file, CTTS_TRACK );
+
+    MP4Close( file );
+    return ok;
+}
+
+int
+main( int, char** )
+{
+    MP4LogSetLevel( MP4_LOG_ERROR );
+
+    bool ok = createFile()
+        && checkFile();
+
+    remove( FILE_NAME );
+
+    printf( "%s\n", ok ? "PASS" : "FAIL" );
+    return ok ? 0 : 1;
+}
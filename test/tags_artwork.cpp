@@ -0,0 +1,138 @@
+///////////////////////////////////////////////////////////////////////////////
+//
+//  The contents of this file are subject to the Mozilla Public License
+//  Version 1.1 (the "License"); you may not use this file except in
+//  compliance with the License. You may obtain a copy of the License at
+//  http://www.mozilla.org/MPL/
+//
+//  Software distributed under the License is distributed on an "AS IS"
+//  basis, WITHOUT WARRANTY OF ANY KIND, either express or implied. See the
+//  License for the specific language governing rights and limitations
+//  under the License.
+//
+//  The Original Code is MP4v2.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+// Stores cover-art after fetching tags with and without artwork and checks
+// that a fetch without artwork only ever appends to the file's cover-art.
+
+#include <mp4v2/mp4v2.h>
+#include <cstdio>
+#include <cstring>
+
+#define CHECK(cond) \
+    do { \
+        if( !(cond) ) { \
+            fprintf( stderr, "%s:%d: check failed: %s\n", __FILE__, __LINE__, #cond ); \
+            return false; \
+        } \
+    } while( 0 )
+
+static const char* const FILE_NAME = "tags-artwork.mp4";
+
+static bool
+addArtwork( const MP4Tags* tags, uint8_t fill )
+{
+    uint8_t data[32];
+    memset( data, fill, sizeof(data) );
+
+    MP4TagArtwork art;
+    art.data = data;
+    art.size = sizeof(data);
+    art.type = MP4_ART_PNG;
+    return MP4TagsAddArtwork( tags, &art );
+}
+
+// stores with tags fetched by flags, after adding one piece of artwork
+static bool
+store( uint32_t flags, uint8_t fill, uint32_t* pNumFetched )
+{
+    MP4FileHandle file = MP4Modify( FILE_NAME );
+    CHECK( file != MP4_INVALID_FILE_HANDLE );
+
+    const MP4Tags* tags = MP4TagsAlloc();
+    bool ok = MP4TagsFetchFlags( tags, file, flags );
+    *pNumFetched = tags->artworkCount;
+    ok = ok && addArtwork( tags, fill ) && MP4TagsStore( tags, file );
+
+    // what was appended is not stored twice
+    ok = ok && MP4TagsStore( tags, file );
+
+    MP4TagsFree( tags );
+    MP4Close( file );
+    CHECK( ok );
+    return true;
+}
+
+// the file's cover-art must be fills, in order
+static bool
+checkArtwork( const uint8_t* fills, uint32_t numFills )
+{
+    MP4FileHandle file = MP4Read( FILE_NAME );
+    CHECK( file != MP4_INVALID_FILE_HANDLE );
+
+    const MP4Tags* tags = MP4TagsAlloc();
+    bool ok = MP4TagsFetch( tags, file ) && tags->artworkCount == numFills;
+    for( uint32_t i = 0; ok && i < numFills; i++ ) {
+        const MP4TagArtwork& art = tags->artwork[i];
+        ok = art.size == 32 && ((const uint8_t*)art.data)[0] == fills[i];
+    }
+
+    MP4TagsFree( tags );
+    MP4Close( file );
+    CHECK( ok );
+    return true;
+}
+
+static bool
+checkStore()
+{
+    MP4FileHandle file = MP4Create( FILE_NAME );
+    CHECK( file != MP4_INVALID_FILE_HANDLE );
+    MP4Close( file );
+
+    uint32_t numFetched = 0;
+    CHECK( store( 0, 1, &numFetched ));
+    CHECK( numFetched == 0 );
+    const uint8_t one[] = { 1 };
+    CHECK( checkArtwork( one, 1 ));
+
+    CHECK( store( 0, 2, &numFetched ));
+    CHECK( numFetched == 1 );
+    const uint8_t two[] = { 1, 2 };
+    CHECK( checkArtwork( two, 2 ));
+
+    // the existing artwork is neither fetched nor removed
+    CHECK( store( MP4_TAGS_FETCH_NO_ARTWORK, 3, &numFetched ));
+    CHECK( numFetched == 0 );
+    const uint8_t three[] = { 1, 2, 3 };
+    CHECK( checkArtwork( three, 3 ));
+
+    // a full fetch replaces the file's artwork with the structure's
+    file = MP4Modify( FILE_NAME );
+    CHECK( file != MP4_INVALID_FILE_HANDLE );
+    const MP4Tags* tags = MP4TagsAlloc();
+    bool ok = MP4TagsFetch( tags, file )
+        && MP4TagsRemoveArtwork( tags, 0 )
+        && MP4TagsStore( tags, file );
+    MP4TagsFree( tags );
+    MP4Close( file );
+    CHECK( ok );
+    const uint8_t removed[] = { 2, 3 };
+    CHECK( checkArtwork( removed, 2 ));
+    return true;
+}
+
+int
+main( int, char** )
+{
+    MP4LogSetLevel( MP4_LOG_ERROR );
+
+    bool ok = checkStore();
+
+    remove( FILE_NAME );
+
+    printf( "%s\n", ok ? "PASS" : "FAIL" );
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,179 @@
+///////////////////////////////////////////////////////////////////////////////
+//
+//  The contents of this file are subject to the Mozilla Public License
+//  Version 1.1 (the "License"); you may not use this file except in
+//  compliance with the License. You may obtain a copy of the License at
+//  http://www.mozilla.org/MPL/
+//
+//  Software distributed under the License is distributed on an "AS IS"
+//  basis, WITHOUT WARRANTY OF ANY KIND, either express or implied. See the
+//  License for the specific language governing rights and limitations
+//  under the License.
+//
+//  The Original Code is MP4v2.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+// Writes subtitle cues with MP4WriteTextCues() in two calls and reads them
+// back with MP4ReadTextCues(). The same samples are written one at a time
+// to a second track with MP4WriteSample(), and both tracks must agree.
+
+#include <mp4v2/mp4v2.h>
+#include <cstdio>
+#include <cstring>
+#include <string>
+
+using namespace std;
+
+#define CHECK(cond) \
+    do { \
+        if( !(cond) ) { \
+            fprintf( stderr, "%s:%d: check failed: %s\n", __FILE__, __LINE__, #cond ); \
+            return false; \
+        } \
+    } while( 0 )
+
+static const char* const FILE_NAME = "text-cues.mp4";
+
+// gaps before the third and fifth cue, runs of equal durations
+static const MP4TextCue CUES[] = {
+    { "One",                       0, 1000 },
+    { "Two",                    1000, 1000 },
+    { "Three",                  2500,  500 },
+    { "Four\nhas two lines",    3000,  500 },
+    { "Cinq \xc3\xa0 la suite", 5000, 1000 },
+    { "Six",                    6000, 1000 },
+};
+static const uint32_t NUM_CUES  = sizeof(CUES) / sizeof(CUES[0]);
+static const uint32_t NUM_FIRST = 3; // cues written by the first call
+
+// what MP4WriteTextCues() is documented to write, one sample at a time
+static bool
+writeSamples( MP4FileHandle file, MP4TrackId trackId )
+{
+    MP4Timestamp end = 0;
+    for( uint32_t i = 0; i < NUM_CUES; i++ ) {
+        const MP4TextCue& cue = CUES[i];
+        if( cue.start > end ) {
+            const uint8_t gap[2] = { 0, 0 };
+            CHECK( MP4WriteSample( file, trackId, gap, 2, cue.start - end ));
+        }
+
+        string sample( 2, '\0' );
+        const size_t length = strlen( cue.text );
+        sample[0] = (char)(length >> 8);
+        sample[1] = (char)length;
+        sample += cue.text;
+        CHECK( MP4WriteSample( file, trackId, (const uint8_t*)sample.data(), (uint32_t)sample.size(), cue.duration ));
+        end = cue.start + cue.duration;
+    }
+    return true;
+}
+
+static bool
+createFile()
+{
+    MP4FileHandle file = MP4Create( FILE_NAME );
+    CHECK( file != MP4_INVALID_FILE_HANDLE );
+    MP4SetTimeScale( file, 1000 );
+
+    MP4TrackId cuesId = MP4AddSubtitleTrack( file, 1000, 320, 60 );
+    MP4TrackId samplesId = MP4AddSubtitleTrack( file, 1000, 320, 60 );
+    CHECK( cuesId == 1 && samplesId == 2 );
+
+    CHECK( MP4WriteTextCues( file, cuesId, CUES, NUM_FIRST ));
+    CHECK( MP4WriteTextCues( file, cuesId, CUES + NUM_FIRST, NUM_CUES - NUM_FIRST ));
+
+    // cues may not go back in time
+    CHECK( !MP4WriteTextCues( file, cuesId, CUES, 1 ));
+
+    CHECK( writeSamples( file, samplesId ));
+
+    MP4Close( file );
+    return true;
+}
+
+static bool
+checkCues( MP4FileHandle file, MP4TrackId trackId )
+{
+    MP4TextCue* cues = NULL;
+    uint32_t numCues = 0;
+    CHECK( MP4ReadTextCues( file, trackId, &cues, &numCues ));
+
+    bool ok = numCues == NUM_CUES;
+    for( uint32_t i = 0; ok && i < numCues; i++ ) {
+        ok = !strcmp( cues[i].text, CUES[i].text )
+            && cues[i].start == CUES[i].start
+            && cues[i].duration == CUES[i].duration;
+        if( !ok )
+            fprintf( stderr, "cue %u: \"%s\" %llu %llu\n", i, cues[i].text,
+                     (unsigned long long)cues[i].start, (unsigned long long)cues[i].duration );
+    }
+    MP4Free( cues );
+    CHECK( ok );
+    return true;
+}
+
+static bool
+checkTables( MP4FileHandle file )
+{
+    // one stts entry per run of equal durations: 1000 twice, 500 three
+    // times across both calls, the 1500 gap and 1000 twice
+    uint64_t numStts = 0;
+    CHECK( MP4GetTrackIntegerProperty( file, 1, "mdia.minf.stbl.stts.entryCount", &numStts ));
+    CHECK( numStts == 4 );
+
+    static const char* const PROPERTIES[] = {
+        "mdia.minf.stbl.stts.entryCount",
+        "mdia.minf.stbl.stsz.sampleCount",
+        "mdia.minf.stbl.stsz.sampleSize",
+        "mdia.mdhd.duration",
+    };
+    for( uint32_t i = 0; i < sizeof(PROPERTIES) / sizeof(PROPERTIES[0]); i++ ) {
+        uint64_t cuesValue = 0;
+        uint64_t samplesValue = 0;
+        CHECK( MP4GetTrackIntegerProperty( file, 1, PROPERTIES[i], &cuesValue ));
+        CHECK( MP4GetTrackIntegerProperty( file, 2, PROPERTIES[i], &samplesValue ));
+        CHECK( cuesValue == samplesValue );
+    }
+
+    const uint32_t numSamples = MP4GetTrackNumberOfSamples( file, 1 );
+    CHECK( numSamples == NUM_CUES + 2 );
+    CHECK( MP4GetTrackNumberOfSamples( file, 2 ) == numSamples );
+    for( MP4SampleId sampleId = 1; sampleId <= numSamples; sampleId++ ) {
+        CHECK( MP4GetSampleTime( file, 1, sampleId ) == MP4GetSampleTime( file, 2, sampleId ));
+        CHECK( MP4GetSampleDuration( file, 1, sampleId ) == MP4GetSampleDuration( file, 2, sampleId ));
+        CHECK( MP4GetSampleSize( file, 1, sampleId ) == MP4GetSampleSize( file, 2, sampleId ));
+        CHECK( MP4GetSampleSync( file, 1, sampleId ) == 1 );
+    }
+    return true;
+}
+
+static bool
+checkFile()
+{
+    MP4FileHandle file = MP4Read( FILE_NAME );
+    CHECK( file != MP4_INVALID_FILE_HANDLE );
+
+    bool ok = checkCues( file, 1 )
+        && checkCues( file, 2 )
+        && checkTables( file );
+
+    MP4Close( file );
+    return ok;
+}
+
+int
+main( int, char** )
+{
+    // quiet, as the rejected MP4WriteTextCues() call logs an error
+    MP4LogSetLevel( MP4_LOG_NONE );
+
+    bool ok = createFile()
+        && checkFile();
+
+    remove( FILE_NAME );
+
+    printf( "%s\n", ok ? "PASS" : "FAIL" );
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,322 @@
+///////////////////////////////////////////////////////////////////////////////
+//
+//  The contents of this file are subject to the Mozilla Public License
+//  Version 1.1 (the "License"); you may not use this file except in
+//  compliance with the License. You may obtain a copy of the License at
+//  http://www.mozilla.org/MPL/
+//
+//  Software distributed under the License is distributed on an "AS IS"
+//  basis, WITHOUT WARRANTY OF ANY KIND, either express or implied. See the
+//  License for the specific language governing rights and limitations
+//  under the License.
+//
+//  The Original Code is MP4v2.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+// Writes the same movie into memory through MP4CreateCallbacks() with the
+// write buffer disabled, at the default size and at many small sizes, and
+// checks that the bytes are identical apart from time stamps. Drives
+// io::File directly with sequential writes and back-patches that land in
+// the buffer, before it and across its start, and compares the result
+// with unbuffered writes. Also checks that MP4Flush() hands all sample
+// data written so far to the provider.
+
+#include "libplatform/platform.h"
+#include <cstdio>
+#include <cstring>
+#include <vector>
+
+using namespace mp4v2::platform::io;
+
+#define CHECK(cond) \
+    do { \
+        if( !(cond) ) { \
+            fprintf( stderr, "%s:%d: check failed: %s\n", __FILE__, __LINE__, #cond ); \
+            return false; \
+        } \
+    } while( 0 )
+
+static const uint32_t NUM_SAMPLES = 200;
+
+// in-memory file that records how the library writes to it
+struct MemFile {
+    std::vector<uint8_t> data;
+    int64_t  pos;
+    uint32_t numWrites;
+    uint32_t numStraddles;  // writes reaching from before into the previous write
+    int64_t  lastWriteStart;
+
+    MemFile() : pos( 0 ), numWrites( 0 ), numStraddles( 0 ), lastWriteStart( -1 ) {}
+};
+
+static int64_t
+memSize( void* handle )
+{
+    return (int64_t)((MemFile*)handle)->data.size();
+}
+
+static int
+memSeek( void* handle, int64_t pos )
+{
+    ((MemFile*)handle)->pos = pos;
+    return 0;
+}
+
+static int
+memRead( void* handle, void* buffer, int64_t size, int64_t* nin )
+{
+    MemFile& file = *(MemFile*)handle;
+    int64_t avail = (int64_t)file.data.size() - file.pos;
+    if( avail < size )
+        return 1;
+    memcpy( buffer, &file.data[file.pos], size );
+    file.pos += size;
+    *nin = size;
+    return 0;
+}
+
+static int
+memWrite( void* handle, const void* buffer, int64_t size, int64_t* nout )
+{
+    MemFile& file = *(MemFile*)handle;
+    if( file.pos < file.lastWriteStart && file.pos + size > file.lastWriteStart )
+        file.numStraddles++;
+    file.lastWriteStart = file.pos;
+    file.numWrites++;
+
+    if( file.data.size() < (size_t)(file.pos + size) )
+        file.data.resize( file.pos + size );
+    memcpy( &file.data[file.pos], buffer, size );
+    file.pos += size;
+    *nout = size;
+    return 0;
+}
+
+static int
+memTruncate( void* handle, int64_t size )
+{
+    ((MemFile*)handle)->data.resize( size );
+    return 0;
+}
+
+static const MP4IOCallbacks MEM_CALLBACKS = {
+    memSize, memSeek, memRead, memWrite, memTruncate
+};
+
+// the same for io::File
+class MemProvider : public FileProvider
+{
+public:
+    MemProvider( MemFile& file ) : _file( file ) { }
+
+    bool open( const std::string&, Mode ) { return memSeek( &_file, 0 ) != 0; }
+    bool seek( Size pos ) { return memSeek( &_file, pos ) != 0; }
+    bool read( void* buffer, Size size, Size& nin ) { return memRead( &_file, buffer, size, &nin ) != 0; }
+    bool write( const void* buffer, Size size, Size& nout ) { return memWrite( &_file, buffer, size, &nout ) != 0; }
+    bool truncate( Size size ) { return memTruncate( &_file, size ) != 0; }
+    bool close() { return false; }
+    bool getSize( Size& nout ) { nout = memSize( &_file ); return false; }
+
+private:
+    MemFile& _file;
+};
+
+// small audio samples and larger video samples, interleaved
+static uint32_t
+sampleSize( MP4TrackId trackId, MP4SampleId sampleId )
+{
+    return trackId == 1 ? 5 + sampleId % 23 : 100 + sampleId * 7 % 300;
+}
+
+static bool
+writeSamples( MP4FileHandle file, MP4SampleId first, MP4SampleId last )
+{
+    uint8_t sample[400];
+    for( MP4SampleId sampleId = first; sampleId <= last; sampleId++ ) {
+        for( MP4TrackId trackId = 1; trackId <= 2; trackId++ ) {
+            memset( sample, (int)(sampleId + trackId * 100), sizeof(sample) );
+            CHECK( MP4WriteSample( file, trackId, sample, sampleSize( trackId, sampleId )));
+        }
+    }
+    return true;
+}
+
+static bool
+addTracks( MP4FileHandle file )
+{
+    CHECK( MP4AddAudioTrack( file, 48000, 1024, MP4_MPEG4_AUDIO_TYPE ) == 1 );
+    CHECK( MP4AddVideoTrack( file, 90000, 3000, 320, 240, MP4_MPEG4_VIDEO_TYPE ) == 2 );
+    return true;
+}
+
+// bufferSize < 0 keeps the default size
+static bool
+writeMovie( MemFile& mem, int bufferSize )
+{
+    MP4FileHandle file = MP4CreateCallbacks( &MEM_CALLBACKS, &mem );
+    CHECK( file != MP4_INVALID_FILE_HANDLE );
+
+    bool ok = (bufferSize < 0 || MP4SetWriteBufferSize( file, bufferSize ))
+        && addTracks( file )
+        && writeSamples( file, 1, NUM_SAMPLES );
+    MP4Close( file );
+    return ok;
+}
+
+// clear the creation and modification times of mvhd, tkhd and mdhd
+static void
+clearTimes( std::vector<uint8_t>& data, size_t start, size_t end )
+{
+    while( start + 8 <= end ) {
+        const uint8_t* p = &data[start];
+        size_t size = (size_t)p[0] << 24 | p[1] << 16 | p[2] << 8 | p[3];
+        if( size < 8 || start + size > end )
+            return;
+
+        if( !memcmp( p + 4, "moov", 4 ) || !memcmp( p + 4, "trak", 4 ) || !memcmp( p + 4, "mdia", 4 )) {
+            clearTimes( data, start + 8, start + size );
+        }
+        else if( !memcmp( p + 4, "mvhd", 4 ) || !memcmp( p + 4, "tkhd", 4 ) || !memcmp( p + 4, "mdhd", 4 )) {
+            size_t timesSize = p[8] == 1 ? 16 : 8;
+            if( 12 + timesSize <= size )
+                memset( &data[start + 12], 0, timesSize );
+        }
+        start += size;
+    }
+}
+
+static bool
+checkSizes()
+{
+    MemFile unbuffered;
+    CHECK( writeMovie( unbuffered, 0 ));
+    clearTimes( unbuffered.data, 0, unbuffered.data.size() );
+
+    MemFile defaultSize;
+    CHECK( writeMovie( defaultSize, -1 ));
+    clearTimes( defaultSize.data, 0, defaultSize.data.size() );
+    CHECK( defaultSize.data == unbuffered.data );
+    CHECK( defaultSize.numWrites < unbuffered.numWrites );
+
+    for( int bufferSize = 2; bufferSize <= 128; bufferSize++ ) {
+        MemFile buffered;
+        CHECK( writeMovie( buffered, bufferSize ));
+        clearTimes( buffered.data, 0, buffered.data.size() );
+        if( buffered.data != unbuffered.data ) {
+            fprintf( stderr, "output differs with a %d byte buffer\n", bufferSize );
+            return false;
+        }
+    }
+    return true;
+}
+
+// appends runs of bytes and patches the last few dozen bytes written,
+// the way atom sizes are back-patched
+static bool
+writePatches( MemFile& mem, uint32_t bufferSize )
+{
+    File file( "mem", File::MODE_CREATE, new MemProvider( mem ));
+    CHECK( !file.open() );
+    CHECK( !file.setBufferSize( bufferSize ));
+
+    uint32_t seed = 1;
+    uint8_t bytes[64];
+    File::Size n;
+    for( uint32_t i = 0; i < 2000; i++ ) {
+        seed = seed * 1103515245 + 12345;
+        uint32_t size = 1 + (seed >> 16) % 40;
+        memset( bytes, (int)i, size );
+        CHECK( !file.write( bytes, size, n ) && n == size );
+
+        seed = seed * 1103515245 + 12345;
+        if( (seed >> 16) % 3 == 0 ) {
+            uint32_t patchSize = 1 + (seed >> 20) % 12;
+            File::Size end = file.position;
+            File::Size back = patchSize + (seed >> 24) % 48;
+            File::Size pos = back < end ? end - back : 0;
+            memset( bytes, 0x80 | (int)i, patchSize );
+            CHECK( !file.writeAt( pos, bytes, patchSize, n ) && n == patchSize );
+            CHECK( file.position == end );
+        }
+    }
+    CHECK( !file.close() );
+    return true;
+}
+
+static bool
+checkBackPatches()
+{
+    MemFile unbuffered;
+    CHECK( writePatches( unbuffered, 0 ));
+
+    uint32_t numStraddles = 0;
+    for( uint32_t bufferSize = 8; bufferSize <= 256; bufferSize *= 2 ) {
+        MemFile buffered;
+        CHECK( writePatches( buffered, bufferSize ));
+        if( buffered.data != unbuffered.data ) {
+            fprintf( stderr, "patched output differs with a %u byte buffer\n", bufferSize );
+            return false;
+        }
+        CHECK( buffered.numWrites < unbuffered.numWrites );
+        numStraddles += buffered.numStraddles;
+    }
+
+    // a patch across the start of the buffer flushes the buffer first,
+    // so some writes must reach back into the one before them
+    CHECK( numStraddles > 0 );
+    return true;
+}
+
+static bool
+checkFlush()
+{
+    MemFile mem;
+    MP4FileHandle file = MP4CreateCallbacks( &MEM_CALLBACKS, &mem );
+    CHECK( file != MP4_INVALID_FILE_HANDLE );
+
+    bool ok = addTracks( file ) && writeSamples( file, 1, NUM_SAMPLES / 2 );
+
+    // all sample data so far must have reached the provider
+    uint64_t total = 0;
+    for( MP4SampleId sampleId = 1; sampleId <= NUM_SAMPLES / 2; sampleId++ )
+        total += sampleSize( 1, sampleId ) + sampleSize( 2, sampleId );
+    ok = ok && MP4Flush( file ) && mem.data.size() >= total;
+
+    ok = ok && writeSamples( file, NUM_SAMPLES / 2 + 1, NUM_SAMPLES );
+    MP4Close( file );
+    CHECK( ok );
+
+    // the flushed file reads back like any other
+    mem.pos = 0;
+    file = MP4ReadCallbacks( &MEM_CALLBACKS, &mem );
+    CHECK( file != MP4_INVALID_FILE_HANDLE );
+    for( MP4TrackId trackId = 1; ok && trackId <= 2; trackId++ ) {
+        ok = MP4GetTrackNumberOfSamples( file, trackId ) == NUM_SAMPLES;
+        for( MP4SampleId sampleId = 1; ok && sampleId <= NUM_SAMPLES; sampleId++ ) {
+            uint8_t* sample = NULL;
+            uint32_t size = 0;
+            ok = MP4ReadSample( file, trackId, sampleId, &sample, &size )
+                && size == sampleSize( trackId, sampleId )
+                && sample[0] == (uint8_t)(sampleId + trackId * 100)
+                && sample[size - 1] == sample[0];
+            MP4Free( sample );
+        }
+    }
+    MP4Close( file );
+    CHECK( ok );
+    return true;
+}
+
+int
+main( int, char** )
+{
+    MP4LogSetLevel( MP4_LOG_ERROR );
+
+    bool ok = checkSizes()
+        && checkBackPatches()
+        && checkFlush();
+
+    printf( "%s\n", ok ? "PASS" : "FAIL" );
+    return ok ? 0 : 1;
+}
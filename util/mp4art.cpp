@@ -90,6 +90,7 @@ ArtUtility::ArtUtility( int argc, char** argv )
     _group.add( STD_OPTIMIZE );
     _group.add( STD_DRYRUN );
     _group.add( STD_KEEPGOING );
+    _group.add( STD_JOBS );
     _group.add( STD_OVERWRITE );
     _group.add( STD_FORCE );
     _group.add( STD_QUIET );
@@ -204,7 +205,7 @@ ArtUtility::actionList( JobContext& job )
     const int wtype = 9;
     const string sep = "  ";
 
-    if( _jobCount == 0 ) {
+    if( job.index == 0 ) {
         report << setw(widx) << right << "IDX" << left
                << sep << setw(wsize) << right << "BYTES" << left
                << sep << setw(8) << "CRC32"
@@ -219,18 +220,39 @@ ArtUtility::actionList( JobContext& job )
     if( job.fileHandle == MP4_INVALID_FILE_HANDLE )
         return herrf( "unable to open for read: %s\n", job.file.c_str() );
 
-    CoverArtBox::ItemList items;
+    // only sizes and offsets; each image is streamed from the file below
+    CoverArtBox::InfoList items;
     if( CoverArtBox::list( job.fileHandle, items ))
         return herrf( "unable to get list of covr-box: %s\n", job.file.c_str() );
 
+    File in( job.file, File::MODE_READ );
+    if( in.open() )
+        return herrf( "unable to open %s for read: %s\n", job.file.c_str(), sys::getLastErrorStr() );
+
+    vector<uint8_t> block( 64 * 1024 );
+
     int line = 0;
-    const CoverArtBox::ItemList::size_type max = items.size();
-    for( CoverArtBox::ItemList::size_type i = 0; i < max; i++ ) {
+    const CoverArtBox::InfoList::size_type max = items.size();
+    for( CoverArtBox::InfoList::size_type i = 0; i < max; i++ ) {
         if( _artFilter != numeric_limits<uint32_t>::max() && _artFilter != i )
             continue;
 
-        CoverArtBox::Item& item = items[i];
-        const uint32_t crc = crc32( item.buffer, item.size );
+        const CoverArtBox::ItemInfo& item = items[i];
+
+        uint32_t crc = 0;
+        for( uint32_t done = 0; done < item.size; ) {
+            uint32_t want = item.size - done;
+            if( want > block.size() )
+                want = (uint32_t)block.size();
+
+            File::Size nin;
+            if( in.readAt( item.offset + done, &block[0], want, nin ) || nin != want )
+                return herrf( "read failed: %s\n", job.file.c_str() );
+
+            crc = crc32Update( crc, &block[0], want );
+            done += want;
+        }
+        crc = crc32Finish( crc, item.size );
 
         report << setw(widx) << right << i
                << sep << setw(wsize) << item.size
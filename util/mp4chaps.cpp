@@ -126,6 +126,7 @@ ChapterUtility::ChapterUtility( int argc, char** argv )
     _group.add( STD_OPTIMIZE );
     _group.add( STD_DRYRUN );
     _group.add( STD_KEEPGOING );
+    _group.add( STD_JOBS );
     _group.add( STD_OVERWRITE );
     _group.add( STD_FORCE );
     _group.add( STD_QUIET );
@@ -408,7 +409,7 @@ ChapterUtility::actionExport( JobContext& job )
         ostringstream oss;
         // write metadata
         const MP4Tags* tags = MP4TagsAlloc();
-        MP4TagsFetch( tags, job.fileHandle );
+        MP4TagsFetchFlags( tags, job.fileHandle, MP4_TAGS_FETCH_NO_ARTWORK );
 
         if( tags->albumArtist && (!tags->artist || !strequal(tags->albumArtist, tags->artist)) )
             oss << "## album-artist: " << tags->albumArtist << LINEND;
@@ -35,7 +35,10 @@ private:
     enum FileLongCode {
         LC_LIST = _LC_MAX,
         LC_OPTIMIZE,
-        LC_DUMP
+        LC_DUMP,
+        LC_DUMP_JSON,
+        LC_FULL_TABLES,
+        LC_TABLE_ENTRIES
     };
 
 public:
@@ -50,9 +53,16 @@ private:
     bool actionList     ( JobContext& );
     bool actionOptimize ( JobContext& );
     bool actionDump     ( JobContext& );
+    bool actionDumpJson ( JobContext& );
+
+    static int writeJson( void*, const char*, uint32_t ); //!< JSON dump output through outf
 
 private:
     Group _actionGroup;
+    Group _parmGroup;
+
+    bool     _fullTables;
+    uint32_t _tableEntries;
 
     bool (FileUtility::*_action)( JobContext& );
 };
@@ -60,13 +70,17 @@ private:
 ///////////////////////////////////////////////////////////////////////////////
 
 FileUtility::FileUtility( int argc, char** argv )
-    : Utility      ( "mp4file", argc, argv )
-    , _actionGroup ( "ACTIONS" )
-    , _action      ( NULL )
+    : Utility       ( "mp4file", argc, argv )
+    , _actionGroup  ( "ACTIONS" )
+    , _parmGroup    ( "ACTION PARAMETERS" )
+    , _fullTables   ( false )
+    , _tableEntries ( 3 )
+    , _action       ( NULL )
 {
     // add standard options which make sense for this utility
     _group.add( STD_DRYRUN );
     _group.add( STD_KEEPGOING );
+    _group.add( STD_JOBS );
     _group.add( STD_QUIET );
     _group.add( STD_DEBUG );
     _group.add( STD_VERBOSE );
@@ -74,9 +88,14 @@ FileUtility::FileUtility( int argc, char** argv )
     _group.add( STD_VERSION );
     _group.add( STD_VERSIONX );
 
-    _actionGroup.add( "list",     false, LC_LIST,     "list (summary information)" );
-    _actionGroup.add( "optimize", false, LC_OPTIMIZE, "optimize mp4 structure" );
-    _actionGroup.add( "dump",     false, LC_DUMP,     "dump mp4 structure in human-readable format" );
+    _parmGroup.add( "full-tables",   false, LC_FULL_TABLES,   "dump-json: write every table entry" );
+    _parmGroup.add( "table-entries", true,  LC_TABLE_ENTRIES, "dump-json: show N entries at each end of a table (default 3)", "N" );
+    _groups.push_back( &_parmGroup );
+
+    _actionGroup.add( "list",      false, LC_LIST,      "list (summary information)" );
+    _actionGroup.add( "optimize",  false, LC_OPTIMIZE,  "optimize mp4 structure" );
+    _actionGroup.add( "dump",      false, LC_DUMP,      "dump mp4 structure in human-readable format" );
+    _actionGroup.add( "dump-json", false, LC_DUMP_JSON, "dump mp4 structure as JSON to stdout" );
     _groups.push_back( &_actionGroup );
 
     _usage = "[OPTION]... ACTION file...";
@@ -104,6 +123,36 @@ FileUtility::actionDump( JobContext& job )
 
 ///////////////////////////////////////////////////////////////////////////////
 
+bool
+FileUtility::actionDumpJson( JobContext& job )
+{
+    job.fileHandle = MP4Read( job.file.c_str() );
+    if( job.fileHandle == MP4_INVALID_FILE_HANDLE )
+        return herrf( "unable to open for read: %s\n", job.file.c_str() );
+
+    uint32_t flags = 0;
+    if( _fullTables )
+        flags |= MP4_DUMP_JSON_FULL;
+    if( _debugImplicits )
+        flags |= MP4_DUMP_JSON_IMPLICITS;
+
+    if( !MP4DumpJsonCallback( job.fileHandle, writeJson, this, flags, _tableEntries ))
+        return herrf( "dump failed: %s\n", job.file.c_str() );
+
+    return SUCCESS;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+int
+FileUtility::writeJson( void* handle, const char* text, uint32_t size )
+{
+    static_cast<FileUtility*>(handle)->outf( "%.*s", (int)size, text );
+    return 0;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
 bool
 FileUtility::actionList( JobContext& job )
 {
@@ -114,7 +163,7 @@ FileUtility::actionList( JobContext& job )
     const int wsizing = 6;
     const string sep = "  ";
 
-    if( _jobCount == 0 ) {
+    if( job.index == 0 ) {
         report << setw(wbrand) << left << "BRAND" 
                << sep << setw(wcompat) << left << "COMPAT" 
                << sep << setw(wsizing) << left << "SIZING" 
@@ -202,6 +251,23 @@ FileUtility::utility_option( int code, bool& handled )
             _action = &FileUtility::actionDump;
             break;
 
+        case LC_DUMP_JSON:
+            _action = &FileUtility::actionDumpJson;
+            break;
+
+        case LC_FULL_TABLES:
+            _fullTables = true;
+            break;
+
+        case LC_TABLE_ENTRIES:
+        {
+            istringstream iss( prog::optarg );
+            iss >> _tableEntries;
+            if( iss.rdstate() != ios::eofbit )
+                return herrf( "invalid table entry count: %s\n", prog::optarg );
+            break;
+        }
+
         default:
             handled = false;
             break;
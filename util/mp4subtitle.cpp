@@ -28,6 +28,22 @@ namespace mp4v2 { namespace util {
 
 ///////////////////////////////////////////////////////////////////////////////
 
+namespace {
+
+// HH:MM:SS followed by fracSep and milliseconds
+string
+formatTime( MP4Timestamp msecs, char fracSep )
+{
+    char buf[32];
+    snprintf( buf, sizeof(buf), "%02" PRIu64 ":%02" PRIu64 ":%02" PRIu64 "%c%03" PRIu64,
+              msecs / 3600000, msecs / 60000 % 60, msecs / 1000 % 60, fracSep, msecs % 1000 );
+    return buf;
+}
+
+} // namespace
+
+///////////////////////////////////////////////////////////////////////////////
+
 class SubtitleUtility : public Utility
 {
 private:
@@ -52,6 +68,9 @@ private:
     bool actionImport ( JobContext& );
     bool actionRemove ( JobContext& );
 
+    MP4TrackId findSubtitleTrack ( MP4FileHandle );
+    bool       parseSubtitleFile ( const string&, vector<MP4TextCue>&, vector<string>& );
+
 private:
     Group  _actionGroup;
 
@@ -71,6 +90,7 @@ SubtitleUtility::SubtitleUtility( int argc, char** argv )
     _group.add( STD_OPTIMIZE );
     _group.add( STD_DRYRUN );
     _group.add( STD_KEEPGOING );
+    _group.add( STD_JOBS );
     _group.add( STD_OVERWRITE );
     _group.add( STD_FORCE );
     _group.add( STD_QUIET );
@@ -91,7 +111,10 @@ SubtitleUtility::SubtitleUtility( int argc, char** argv )
         // 79-cols, inclusive, max desired width
         // |----------------------------------------------------------------------------|
         "\nFor each mp4 file specified, perform the specified ACTION. An action must be"
-        "\nspecified. Some options are not applicable to some actions.";
+        "\nspecified. Some options are not applicable to some actions."
+        "\n"
+        "\nSubtitles are exported and imported as SubRip text (UTF-8). Import replaces"
+        "\nall subtitle tracks of the file with a new one.";
 }
 
 ///////////////////////////////////////////////////////////////////////////////
@@ -103,8 +126,65 @@ SubtitleUtility::actionExport( JobContext& job )
     if( job.fileHandle == MP4_INVALID_FILE_HANDLE )
         return herrf( "unable to open for read: %s\n", job.file.c_str() );
 
-    verbose1f( "NOT IMPLEMENTED\n" );
-    return FAILURE;
+    MP4TrackId trackId = findSubtitleTrack( job.fileHandle );
+    if( trackId == MP4_INVALID_TRACK_ID )
+        return herrf( "no subtitle track in file: %s\n", job.file.c_str() );
+
+    MP4TextCue* cues = NULL;
+    uint32_t numCues = 0;
+    if( !MP4ReadTextCues( job.fileHandle, trackId, &cues, &numCues ))
+        return herrf( "unable to read subtitles: %s\n", job.file.c_str() );
+
+    verbose1f( "Exporting %u subtitles from file \"%s\" into \"%s\"\n",
+               numCues, job.file.c_str(), _stTextFile.c_str() );
+    if( dryrunAbort() ) {
+        MP4Free( cues );
+        return SUCCESS;
+    }
+
+    File out( _stTextFile, File::MODE_CREATE );
+    if( openFileForWriting( out )) {
+        MP4Free( cues );
+        return FAILURE;
+    }
+
+#if defined( _WIN32 )
+    static const char* LINEND = "\r\n";
+#else
+    static const char* LINEND = "\n";
+#endif
+
+    // SubRip: index, "start --> end" in milliseconds, text, blank line
+    ostringstream oss;
+    for( uint32_t i = 0; i < numCues; i++ ) {
+        const MP4Timestamp times[2] = {
+            MP4ConvertFromTrackTimestamp( job.fileHandle, trackId, cues[i].start, MP4_MSECS_TIME_SCALE ),
+            MP4ConvertFromTrackTimestamp( job.fileHandle, trackId, cues[i].start + cues[i].duration, MP4_MSECS_TIME_SCALE )
+        };
+
+        oss << i + 1 << LINEND;
+        oss << formatTime( times[0], ',' ) << " --> " << formatTime( times[1], ',' ) << LINEND;
+
+        for( const char* text = cues[i].text; *text; text++ ) {
+            if( *text == '\n' )
+                oss << LINEND;
+            else if( *text != '\r' )
+                oss << *text;
+        }
+        oss << LINEND << LINEND;
+    }
+    MP4Free( cues );
+
+    const string str = oss.str();
+    File::Size nout;
+    if( out.write( str.c_str(), str.size(), nout )) {
+        out.close();
+        ::remove( _stTextFile.c_str() );
+        return herrf( "write to %s failed: %s\n", _stTextFile.c_str(), sys::getLastErrorStr() );
+    }
+    out.close();
+
+    return SUCCESS;
 }
 
 ///////////////////////////////////////////////////////////////////////////////
@@ -112,12 +192,46 @@ SubtitleUtility::actionExport( JobContext& job )
 bool
 SubtitleUtility::actionImport( JobContext& job )
 {
+    vector<MP4TextCue> cues;
+    vector<string> texts;
+    if( parseSubtitleFile( _stTextFile, cues, texts ))
+        return FAILURE;
+
+    verbose1f( "Importing %u subtitles from \"%s\" into file \"%s\"\n",
+               (uint32_t)cues.size(), _stTextFile.c_str(), job.file.c_str() );
+    if( dryrunAbort() )
+        return SUCCESS;
+
+    if( cues.empty() )
+        return herrf( "no subtitles found in file %s\n", _stTextFile.c_str() );
+
     job.fileHandle = MP4Modify( job.file.c_str() );
     if( job.fileHandle == MP4_INVALID_FILE_HANDLE )
         return herrf( "unable to open for write: %s\n", job.file.c_str() );
 
-    verbose1f( "NOT IMPLEMENTED\n" );
-    return FAILURE;
+    // the text box covers the first video track, if there is one
+    uint16_t width = 0;
+    uint16_t height = 0;
+    MP4TrackId videoTrackId = MP4FindTrackId( job.fileHandle, 0, MP4_VIDEO_TRACK_TYPE );
+    if( videoTrackId != MP4_INVALID_TRACK_ID ) {
+        width = MP4GetTrackVideoWidth( job.fileHandle, videoTrackId );
+        height = MP4GetTrackVideoHeight( job.fileHandle, videoTrackId );
+    }
+
+    for( MP4TrackId trackId; (trackId = findSubtitleTrack( job.fileHandle )) != MP4_INVALID_TRACK_ID; ) {
+        if( !MP4DeleteTrack( job.fileHandle, trackId ))
+            return herrf( "unable to remove track %u: %s\n", trackId, job.file.c_str() );
+    }
+
+    MP4TrackId trackId = MP4AddSubtitleTrack( job.fileHandle, MP4_MSECS_TIME_SCALE, width, height );
+    if( trackId == MP4_INVALID_TRACK_ID )
+        return herrf( "unable to add subtitle track: %s\n", job.file.c_str() );
+
+    if( !MP4WriteTextCues( job.fileHandle, trackId, &cues[0], (uint32_t)cues.size() ))
+        return herrf( "unable to write subtitles: %s\n", job.file.c_str() );
+
+    job.optimizeApplicable = true;
+    return SUCCESS;
 }
 
 ///////////////////////////////////////////////////////////////////////////////
@@ -125,12 +239,53 @@ SubtitleUtility::actionImport( JobContext& job )
 bool
 SubtitleUtility::actionList( JobContext& job )
 {
+    ostringstream report;
+
+    const int wid = 3;
+    const int wcues = 8;
+    const int wdur = 12;
+    const string sep = "  ";
+
+    if( job.index == 0 ) {
+        report << setw(wid) << right << "ID" << left
+               << sep << setw(wcues) << right << "CUES" << left
+               << sep << setw(wdur) << right << "DURATION" << left
+               << sep << setw(0) << "FILE"
+               << '\n';
+
+        report << setfill('-') << setw(70) << "" << setfill(' ') << '\n';
+    }
+
     job.fileHandle = MP4Read( job.file.c_str() );
     if( job.fileHandle == MP4_INVALID_FILE_HANDLE )
         return herrf( "unable to open for read: %s\n", job.file.c_str() );
 
-    verbose1f( "NOT IMPLEMENTED\n" );
-    return FAILURE;
+    int line = 0;
+    const uint32_t numTracks = MP4GetNumberOfTracks( job.fileHandle, MP4_SUBTITLE_TRACK_TYPE );
+    for( uint32_t i = 0; i < numTracks; i++ ) {
+        MP4TrackId trackId = MP4FindTrackId( job.fileHandle, i, MP4_SUBTITLE_TRACK_TYPE );
+
+        MP4TextCue* cues = NULL;
+        uint32_t numCues = 0;
+        if( !MP4ReadTextCues( job.fileHandle, trackId, &cues, &numCues ))
+            return herrf( "unable to read subtitles: %s\n", job.file.c_str() );
+        MP4Free( cues );
+
+        MP4Timestamp duration = MP4ConvertFromTrackDuration( job.fileHandle, trackId,
+            MP4GetTrackDuration( job.fileHandle, trackId ), MP4_MSECS_TIME_SCALE );
+
+        report << setw(wid) << right << trackId
+               << sep << setw(wcues) << numCues
+               << sep << setw(wdur) << formatTime( duration, '.' ) << left;
+
+        if( line++ == 0 )
+            report << sep << setw(0) << job.file;
+
+        report << '\n';
+    }
+
+    verbose1f( "%s", report.str().c_str() );
+    return SUCCESS;
 }
 
 ///////////////////////////////////////////////////////////////////////////////
@@ -138,12 +293,145 @@ SubtitleUtility::actionList( JobContext& job )
 bool
 SubtitleUtility::actionRemove( JobContext& job )
 {
+    verbose1f( "Removing subtitle tracks from file \"%s\"\n", job.file.c_str() );
+    if( dryrunAbort() )
+        return SUCCESS;
+
     job.fileHandle = MP4Modify( job.file.c_str() );
     if( job.fileHandle == MP4_INVALID_FILE_HANDLE )
         return herrf( "unable to open for write: %s\n", job.file.c_str() );
 
-    verbose1f( "NOT IMPLEMENTED" );
-    return FAILURE;
+    for( MP4TrackId trackId; (trackId = findSubtitleTrack( job.fileHandle )) != MP4_INVALID_TRACK_ID; ) {
+        if( !MP4DeleteTrack( job.fileHandle, trackId ))
+            return herrf( "unable to remove track %u: %s\n", trackId, job.file.c_str() );
+    }
+
+    job.optimizeApplicable = true;
+    return SUCCESS;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+MP4TrackId
+SubtitleUtility::findSubtitleTrack( MP4FileHandle file )
+{
+    if( MP4GetNumberOfTracks( file, MP4_SUBTITLE_TRACK_TYPE ) == 0 )
+        return MP4_INVALID_TRACK_ID;
+
+    return MP4FindTrackId( file, 0, MP4_SUBTITLE_TRACK_TYPE );
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+/** Read a SubRip file.
+ *
+ *  Cues are sorted by start time, and a cue that still runs when the next
+ *  one starts is cut short. Texts are kept in <b>texts</b>, which must
+ *  outlive <b>cues</b>.
+ *
+ *  @return true if there was an error, false otherwise
+ */
+bool
+SubtitleUtility::parseSubtitleFile( const string& filename, vector<MP4TextCue>& cues, vector<string>& texts )
+{
+    File in( filename, File::MODE_READ );
+    if( in.open() )
+        return herrf( "opening subtitle file '%s' failed: %s\n", filename.c_str(), sys::getLastErrorStr() );
+
+    string content( (string::size_type)in.size, '\0' );
+    File::Size nin;
+    if( !content.empty() && ( in.read( &content[0], content.size(), nin ) || nin != (File::Size)content.size() )) {
+        in.close();
+        return herrf( "reading subtitle file '%s' failed: %s\n", filename.c_str(), sys::getLastErrorStr() );
+    }
+    in.close();
+
+    // UTF-8 BOM
+    if( content.compare( 0, 3, "\xEF\xBB\xBF" ) == 0 )
+        content.erase( 0, 3 );
+
+    struct Cue {
+        MP4Timestamp start;
+        MP4Timestamp end;
+        string       text;
+        bool operator<( const Cue& other ) const { return start < other.start; }
+    };
+    vector<Cue> parsed;
+
+    istringstream lines( content );
+    string line;
+    uint32_t lineNo = 0;
+    Cue* current = NULL;
+
+    while( getline( lines, line )) {
+        lineNo++;
+        if( !line.empty() && line[line.size() - 1] == '\r' )
+            line.erase( line.size() - 1 );
+
+        if( line.empty() ) {
+            current = NULL;
+            continue;
+        }
+
+        if( line.find( "-->" ) != string::npos ) {
+            unsigned h[2], m[2], sec[2], ms[2];
+            char sep[2];
+            if( sscanf( line.c_str(), "%u:%u:%u%c%u --> %u:%u:%u%c%u",
+                        &h[0], &m[0], &sec[0], &sep[0], &ms[0],
+                        &h[1], &m[1], &sec[1], &sep[1], &ms[1] ) != 10 )
+            {
+                return herrf( "%s:%u: invalid time line\n", filename.c_str(), lineNo );
+            }
+
+            Cue cue;
+            cue.start = ((h[0] * 60ULL + m[0]) * 60 + sec[0]) * 1000 + ms[0];
+            cue.end   = ((h[1] * 60ULL + m[1]) * 60 + sec[1]) * 1000 + ms[1];
+            parsed.push_back( cue );
+            current = &parsed.back();
+            continue;
+        }
+
+        // a number on its own before the time line is the cue index
+        if( !current )
+            continue;
+
+        if( !current->text.empty() )
+            current->text += '\n';
+        current->text += line;
+    }
+
+    // drop cues without text or time before the overlaps are resolved
+    vector<Cue>::size_type kept = 0;
+    for( vector<Cue>::size_type i = 0; i < parsed.size(); i++ ) {
+        if( parsed[i].end > parsed[i].start && !parsed[i].text.empty() )
+            parsed[kept++] = parsed[i];
+    }
+    parsed.resize( kept );
+
+    stable_sort( parsed.begin(), parsed.end() );
+
+    texts.clear();
+    texts.reserve( parsed.size() );
+    cues.clear();
+    cues.reserve( parsed.size() );
+
+    for( vector<Cue>::size_type i = 0; i < parsed.size(); i++ ) {
+        MP4Timestamp end = parsed[i].end;
+        if( i + 1 < parsed.size() && end > parsed[i+1].start )
+            end = parsed[i+1].start;
+        if( end <= parsed[i].start )
+            continue;
+
+        texts.push_back( parsed[i].text );
+
+        MP4TextCue cue;
+        cue.text     = texts.back().c_str();
+        cue.start    = parsed[i].start;
+        cue.duration = end - parsed[i].start;
+        cues.push_back( cue );
+    }
+
+    return SUCCESS;
 }
 
 ///////////////////////////////////////////////////////////////////////////////
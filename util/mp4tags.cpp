@@ -70,6 +70,8 @@ enum Option {
     OPT_SORT_COMPOSER     = 0x0106,
     OPT_SORT_TV_SHOW      = 0x0107,
     OPT_PURCHASE_DATE     = 0x0108,
+    OPT_JOBS              = 0x0109,
+    OPT_KEEPGOING         = 0x010a,
 
     MAX_OPT
 };
@@ -84,6 +86,8 @@ static const char* const help_text =
     "\n"
     "      -help                 Display this help text and exit\n"
     "      -version              Display version information and exit\n"
+    "      -jobs            NUM  Process up to NUM files in parallel\n"
+    "      -keepgoing            Continue with the remaining files after an error\n"
     "  -A, -album           STR  Set the album title\n"
     "  -a, -artist          STR  Set the artist information\n"
     "  -b, -tempo           NUM  Set the tempo (beats per minute)\n"
@@ -132,12 +136,444 @@ static const char* const help_text =
     "  -r, -remove          STR  Remove tags by code (e.g. \"-r comment,song\" or\n"
     "                            \"-r cs\" removes the comment and song tags)";
 
+///////////////////////////////////////////////////////////////////////////////
+
+/* Modifies the tags of one file per job as requested by the options. */
+class TagBatch : public BatchRunner
+{
+public:
+    TagBatch( char** files, const char* const* tags, const uint64_t* nums,
+              const prog::Option* options, uint32_t jobs, bool keepgoing )
+        : BatchRunner( jobs, keepgoing )
+        , _files( files )
+        , _tags( tags )
+        , _nums( nums )
+        , _options( options )
+        , _keepgoing( keepgoing )
+    {
+    }
+
+protected:
+    bool runJob( uint32_t job );
+
+private:
+    char** const              _files;
+    const char* const* const  _tags;
+    const uint64_t* const     _nums;
+    const prog::Option* const _options;
+    const bool                _keepgoing;
+};
+
+bool
+TagBatch::runJob( uint32_t job )
+{
+    const char* mp4 = _files[job];
+    const char* const* tags = _tags;
+    const uint64_t* nums = _nums;
+    const prog::Option* long_options = _options;
+
+    MP4FileHandle h = MP4Modify( mp4 );
+    if ( h == MP4_INVALID_FILE_HANDLE ) {
+        BatchRunner::print( stderr, "Could not open '%s'... %s\n", mp4,
+                            _keepgoing ? "skipping" : "aborting" );
+        return Utility::FAILURE;
+    }
+    /* Read out the existing metadata */
+    const MP4Tags* mdata = MP4TagsAlloc();
+    MP4TagsFetch( mdata, h );
+
+    /* Remove any tags */
+    if ( ELEMENT_OF(tags,OPT_REMOVE) ) {
+        for ( const char *p = ELEMENT_OF(tags,OPT_REMOVE); *p; p++ ) {
+            int index = *p;
+            for ( int i = 0; long_options[i].name != NULL; i++ ) {
+                size_t len = strlen( long_options[i].name );
+                if ( strnequal( p, long_options[i].name, len ) && ( p[len] == ',' || p[len] == 0 ) ) {
+                    p += len - 1;
+                    index = long_options[i].val;
+                    break;
+                }
+            }
+            switch ( index ) {
+                case OPT_ALBUM:
+                    MP4TagsSetAlbum( mdata, NULL );
+                    break;
+                case OPT_ARTIST:
+                    MP4TagsSetArtist( mdata, NULL );
+                    break;
+                case OPT_TEMPO:
+                    MP4TagsSetTempo( mdata, NULL );
+                    break;
+                case OPT_COMMENT:
+                    MP4TagsSetComments( mdata, NULL );
+                    break;
+                case OPT_COPYRIGHT:
+                    MP4TagsSetCopyright( mdata, NULL );
+                    break;
+                case OPT_DISK:
+                    MP4TagsSetDisk( mdata, NULL );
+                    break;
+                case OPT_DISKS:
+                    MP4TagsSetDisk( mdata, NULL );
+                    break;
+                case OPT_ENCODEDBY:
+                    MP4TagsSetEncodedBy( mdata, NULL );
+                    break;
+                case OPT_TOOL:
+                    MP4TagsSetEncodingTool( mdata, NULL );
+                    break;
+                case OPT_GENRE:
+                    MP4TagsSetGenre( mdata, NULL );
+                    break;
+                case OPT_GROUPING:
+                    MP4TagsSetGrouping( mdata, NULL );
+                    break;
+                case OPT_HD:
+                    MP4TagsSetHDVideo( mdata, NULL );
+                    break;
+                case OPT_MEDIA_TYPE:
+                    MP4TagsSetMediaType( mdata, NULL );
+                    break;
+                case OPT_CONTENTID:
+                    MP4TagsSetContentID( mdata, NULL );
+                    break;
+                case OPT_LONGDESC:
+                    MP4TagsSetLongDescription( mdata, NULL );
+                    break;
+                case OPT_GENREID:
+                    MP4TagsSetGenreID( mdata, NULL );
+                    break;
+                case OPT_LYRICS:
+                    MP4TagsSetLyrics( mdata, NULL );
+                    break;
+                case OPT_DESCRIPTION:
+                    MP4TagsSetDescription( mdata, NULL );
+                    break;
+                case OPT_TVEPISODE:
+                    MP4TagsSetTVEpisode( mdata, NULL );
+                    break;
+                case OPT_TVSEASON:
+                    MP4TagsSetTVSeason( mdata, NULL );
+                    break;
+                case OPT_TVNETWORK:
+                    MP4TagsSetTVNetwork( mdata, NULL );
+                    break;
+                case OPT_TVEPISODEID:
+                    MP4TagsSetTVEpisodeID( mdata, NULL );
+                    break;
+                case OPT_PLAYLISTID:
+                    MP4TagsSetPlaylistID( mdata, NULL );
+                    break;
+                case OPT_PICTURE:
+                    if( mdata->artworkCount )
+                        MP4TagsRemoveArtwork( mdata, 0 );
+                    break;
+                case OPT_ALBUM_ARTIST:
+                    MP4TagsSetAlbumArtist( mdata, NULL );
+                    break ;
+                case OPT_NAME:
+                    MP4TagsSetName( mdata, NULL );
+                    break;
+                case OPT_TVSHOW:
+                    MP4TagsSetTVShow( mdata, NULL );
+                    break;
+                case OPT_TRACK:
+                    MP4TagsSetTrack( mdata, NULL );
+                    break;
+                case OPT_TRACKS:
+                    MP4TagsSetTrack( mdata, NULL );
+                    break;
+                case OPT_XID:
+                    MP4TagsSetXID( mdata, NULL );
+                    break;
+                case OPT_COMPOSER:
+                    MP4TagsSetComposer( mdata, NULL );
+                    break;
+                case OPT_RELEASEDATE:
+                    MP4TagsSetReleaseDate( mdata, NULL );
+                    break;
+                case OPT_ARTISTID:
+                    MP4TagsSetArtistID( mdata, NULL );
+                    break;
+                case OPT_COMPOSERID:
+                    MP4TagsSetComposerID( mdata, NULL );
+                    break;
+                case OPT_PODCAST:
+                    MP4TagsSetPodcast( mdata, NULL );
+                    break;
+                case OPT_CATEGORY:
+                    MP4TagsSetCategory( mdata, NULL );
+                    break;
+                case OPT_RATING:
+                    MP4TagsSetContentRating( mdata, NULL );
+                    break;
+                case OPT_SORT_NAME:
+                    MP4TagsSetSortName( mdata, NULL );
+                    break;
+                case OPT_SORT_ARTIST:
+                    MP4TagsSetSortArtist( mdata, NULL );
+                    break;
+                case OPT_SORT_ALBUM_ARTIST:
+                    MP4TagsSetSortAlbumArtist( mdata, NULL );
+                    break;
+                case OPT_SORT_ALBUM:
+                    MP4TagsSetSortAlbum( mdata, NULL );
+                    break;
+                case OPT_SORT_COMPOSER:
+                    MP4TagsSetSortComposer( mdata, NULL );
+                    break;
+                case OPT_SORT_TV_SHOW:
+                    MP4TagsSetSortTVShow( mdata, NULL );
+                    break;
+                case OPT_PURCHASE_DATE:
+                    MP4TagsSetPurchaseDate( mdata, NULL );
+                    break;
+            }
+        }
+    }
+
+    /* Track/disk numbers need to be set all at once, but we'd like to
+       allow users to just specify -T 12 to indicate that all existing
+       track numbers are out of 12.  This means we need to look up the
+       current info if it is not being set. */
+
+    if ( ELEMENT_OF(tags,OPT_TRACK) || ELEMENT_OF(tags,OPT_TRACKS) ) {
+        MP4TagTrack tt;
+        tt.index = 0;
+        tt.total = 0;
+
+        if( mdata->track ) {
+            tt.index = mdata->track->index;
+            tt.total = mdata->track->total;
+        }
+
+        if( ELEMENT_OF(tags,OPT_TRACK) )
+            tt.index = static_cast<uint16_t>( ELEMENT_OF(nums,OPT_TRACK) );
+        if( ELEMENT_OF(tags,OPT_TRACKS) )
+            tt.total = static_cast<uint16_t>( ELEMENT_OF(nums,OPT_TRACKS) );
+
+        MP4TagsSetTrack( mdata, &tt );
+    }
+
+    if ( ELEMENT_OF(tags,OPT_DISK) || ELEMENT_OF(tags,OPT_DISKS) ) {
+        MP4TagDisk td;
+        td.index = 0;
+        td.total = 0;
+
+        if( mdata->disk ) {
+            td.index = mdata->disk->index;
+            td.total = mdata->disk->total;
+        }
+
+        if( ELEMENT_OF(tags,OPT_DISK) )
+            td.index = static_cast<uint16_t>( ELEMENT_OF(nums,OPT_DISK) );
+        if( ELEMENT_OF(tags,OPT_DISKS) )
+            td.total = static_cast<uint16_t>( ELEMENT_OF(nums,OPT_DISKS) );
+
+        MP4TagsSetDisk( mdata, &td );
+    }
+
+    /* Set the other relevant attributes */
+    for ( int i = 0;  i < MAX_OPT;  i++ ) {
+        if ( tags[i] ) {
+            switch ( i ) {
+                case OPT_ALBUM:
+                    MP4TagsSetAlbum( mdata, tags[i] );
+                    break;
+                case OPT_ARTIST:
+                    MP4TagsSetArtist( mdata, tags[i] );
+                    break;
+                case OPT_TEMPO:
+                {
+                    uint16_t value = static_cast<uint16_t>( nums[i] );
+                    MP4TagsSetTempo( mdata, &value );
+                    break;
+                }
+                case OPT_COMMENT:
+                    MP4TagsSetComments( mdata, tags[i] );
+                    break;
+                case OPT_COPYRIGHT:
+                    MP4TagsSetCopyright( mdata, tags[i] );
+                    break;
+                case OPT_ENCODEDBY:
+                    MP4TagsSetEncodedBy( mdata, tags[i] );
+                    break;
+                case OPT_TOOL:
+                    MP4TagsSetEncodingTool( mdata, tags[i] );
+                    break;
+                case OPT_GENRE:
+                    MP4TagsSetGenre( mdata, tags[i] );
+                    break;
+                case OPT_GROUPING:
+                    MP4TagsSetGrouping( mdata, tags[i] );
+                    break;
+                case OPT_HD:
+                {
+                    uint8_t value = static_cast<uint8_t>( nums[i] );
+                    MP4TagsSetHDVideo( mdata, &value );
+                    break;
+                }
+                case OPT_MEDIA_TYPE:
+                {
+                    uint8_t st = static_cast<uint8_t>( itmf::enumStikType.toType( tags[i] ) ) ;
+                    MP4TagsSetMediaType( mdata, &st );
+                    break;
+                }
+                case OPT_CONTENTID:
+                {
+                    uint32_t value = static_cast<uint32_t>( nums[i] );
+                    MP4TagsSetContentID( mdata, &value );
+                    break;
+                }
+                case OPT_LONGDESC:
+                    MP4TagsSetLongDescription( mdata, tags[i] );
+                    break;
+                case OPT_GENREID:
+                {
+                    uint32_t value = static_cast<uint32_t>( nums[i] );
+                    MP4TagsSetGenreID( mdata, &value );
+                    break;
+                }
+                case OPT_LYRICS:
+                    MP4TagsSetLyrics( mdata, tags[i] );
+                    break;
+                case OPT_DESCRIPTION:
+                    MP4TagsSetDescription( mdata, tags[i] );
+                    break;
+                case OPT_TVEPISODE:
+                {
+                    uint32_t value = static_cast<uint32_t>( nums[i] );
+                    MP4TagsSetTVEpisode( mdata, &value );
+                    break;
+                }
+                case OPT_TVSEASON:
+                {
+                    uint32_t value = static_cast<uint32_t>( nums[i] );
+                    MP4TagsSetTVSeason( mdata, &value );
+                    break;
+                }
+                case OPT_TVNETWORK:
+                    MP4TagsSetTVNetwork( mdata, tags[i] );
+                    break;
+                case OPT_TVEPISODEID:
+                    MP4TagsSetTVEpisodeID( mdata, tags[i] );
+                    break;
+                case OPT_PLAYLISTID:
+                {
+                    uint64_t value = static_cast<uint64_t>( nums[i] );
+                    MP4TagsSetPlaylistID( mdata, &value );
+                    break;
+                }
+                case OPT_PICTURE:
+                {
+                    File in( tags[i], File::MODE_READ );
+                    if( !in.open() ) {
+                        MP4TagArtwork art;
+                        art.size = (uint32_t)in.size;
+                        art.data = malloc( art.size );
+                        art.type = MP4_ART_UNDEFINED;
+
+                        File::Size nin;
+                        if( !in.read( art.data, art.size, nin ) && nin == art.size ) {
+                            if( mdata->artworkCount )
+                                MP4TagsRemoveArtwork( mdata, 0 );
+                            MP4TagsAddArtwork( mdata, &art ); 
+                        }
+
+                        free( art.data );
+                        in.close();
+                    }
+                    else {
+                        BatchRunner::print( stderr, "Art file %s not found\n", tags[i] );
+                    }
+                    break;
+                }
+                case OPT_ALBUM_ARTIST:
+                    MP4TagsSetAlbumArtist( mdata, tags[i] );
+                    break;
+                case OPT_NAME:
+                    MP4TagsSetName( mdata, tags[i] );
+                    break;
+                case OPT_TVSHOW:
+                    MP4TagsSetTVShow( mdata, tags[i] );
+                    break;
+                case OPT_XID:
+                    MP4TagsSetXID( mdata, tags[i] );
+                    break;
+                case OPT_COMPOSER:
+                    MP4TagsSetComposer( mdata, tags[i] );
+                    break;
+                case OPT_RELEASEDATE:
+                    MP4TagsSetReleaseDate( mdata, tags[i] );
+                    break;
+                case OPT_ARTISTID:
+                {
+                    uint32_t value = static_cast<uint32_t>( nums[i] );
+                    MP4TagsSetArtistID( mdata, &value );
+                    break;
+                }
+                case OPT_COMPOSERID:
+                {
+                    uint32_t value = static_cast<uint32_t>( nums[i] );
+                    MP4TagsSetComposerID( mdata, &value );
+                    break;
+                }
+                case OPT_PODCAST:
+                {
+                    uint8_t value = static_cast<uint8_t>( nums[i] );
+                    MP4TagsSetPodcast( mdata, &value );
+                    break;
+                }
+                case OPT_CATEGORY:
+                    MP4TagsSetCategory( mdata, tags[i] );
+                    break;
+                case OPT_RATING:
+                {
+                    uint8_t rating = static_cast<uint8_t>( itmf::enumContentRating.toType( tags[i] ) ) ;
+                    MP4TagsSetContentRating( mdata, &rating );
+                    break;
+                }
+                case OPT_SORT_NAME:
+                    MP4TagsSetSortName( mdata, tags[i] );
+                    break;
+                case OPT_SORT_ARTIST:
+                    MP4TagsSetSortArtist( mdata, tags[i] );
+                    break;
+                case OPT_SORT_ALBUM_ARTIST:
+                    MP4TagsSetSortAlbumArtist( mdata, tags[i] );
+                    break;
+                case OPT_SORT_ALBUM:
+                    MP4TagsSetSortAlbum( mdata, tags[i] );
+                    break;
+                case OPT_SORT_COMPOSER:
+                    MP4TagsSetSortComposer( mdata, tags[i] );
+                    break;
+                case OPT_SORT_TV_SHOW:
+                    MP4TagsSetSortTVShow( mdata, tags[i] );
+                    break;
+                case OPT_PURCHASE_DATE:
+                    MP4TagsSetPurchaseDate( mdata, tags[i] );
+                    break;
+            }
+        }
+    }
+    /* Write out all tag modifications, free and close */
+    MP4TagsStore( mdata, h );
+    MP4TagsFree( mdata );
+    MP4Close( h );
+    return Utility::SUCCESS;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
 extern "C" int
     main( int argc, char** argv )
 {
     const prog::Option long_options[] = {
         { "help",            prog::Option::NO_ARG,       0, OPT_HELP              },
         { "version",         prog::Option::NO_ARG,       0, OPT_VERSION           },
+        { "jobs",            prog::Option::REQUIRED_ARG, 0, OPT_JOBS              },
+        { "keepgoing",       prog::Option::NO_ARG,       0, OPT_KEEPGOING         },
         { "album",           prog::Option::REQUIRED_ARG, 0, OPT_ALBUM             },
         { "artist",          prog::Option::REQUIRED_ARG, 0, OPT_ARTIST            },
         { "comment",         prog::Option::REQUIRED_ARG, 0, OPT_COMMENT           },
@@ -198,6 +634,10 @@ extern "C" int
     /* Any modifications requested? */
     int mods = 0;
 
+    /* Batch options */
+    uint32_t jobs = 1;
+    bool keepgoing = false;
+
     /* Option-processing loop. */
     int c = prog::getOptionSingle( argc, argv, OPT_STRING, long_options, NULL );
     while ( c != -1 ) {
@@ -216,6 +656,22 @@ extern "C" int
                 fprintf( stdout, "%s - %s\n", "mp4tags", MP4V2_PROJECT_name_formal );
                 return 0;
 
+                /* Batch options, which are not tag modifications. */
+            case OPT_JOBS:
+            {
+                unsigned int n;
+                if ( sscanf( prog::optarg, "%u", &n ) < 1 ) {
+                    fprintf( stderr, "%s: option requires integer argument -- jobs\n",
+                             argv[0] );
+                    return 2;
+                }
+                jobs = n ? n : 1;
+                break;
+            }
+            case OPT_KEEPGOING:
+                keepgoing = true;
+                break;
+
                 /* Integer arguments: convert them using sscanf(). */
             case OPT_TEMPO:
             case OPT_DISK:
@@ -277,399 +733,11 @@ extern "C" int
         return 4;
     }
 
-    /* Loop through the non-option arguments, and modify the tags as
-       requested. */
-    while ( prog::optind < argc ) {
-        char *mp4 = argv[prog::optind++];
-
-        MP4FileHandle h = MP4Modify( mp4 );
-        if ( h == MP4_INVALID_FILE_HANDLE ) {
-            fprintf( stderr, "Could not open '%s'... aborting\n", mp4 );
-            return 5;
-        }
-        /* Read out the existing metadata */
-        const MP4Tags* mdata = MP4TagsAlloc();
-        MP4TagsFetch( mdata, h );
-
-        /* Remove any tags */
-        if ( ELEMENT_OF(tags,OPT_REMOVE) ) {
-            for ( const char *p = ELEMENT_OF(tags,OPT_REMOVE); *p; p++ ) {
-                int index = *p;
-                for ( int i = 0; long_options[i].name != NULL; i++ ) {
-                    size_t len = strlen( long_options[i].name );
-                    if ( strnequal( p, long_options[i].name, len ) && ( p[len] == ',' || p[len] == 0 ) ) {
-                        p += len - 1;
-                        index = long_options[i].val;
-                        break;
-                    }
-                }
-                switch ( index ) {
-                    case OPT_ALBUM:
-                        MP4TagsSetAlbum( mdata, NULL );
-                        break;
-                    case OPT_ARTIST:
-                        MP4TagsSetArtist( mdata, NULL );
-                        break;
-                    case OPT_TEMPO:
-                        MP4TagsSetTempo( mdata, NULL );
-                        break;
-                    case OPT_COMMENT:
-                        MP4TagsSetComments( mdata, NULL );
-                        break;
-                    case OPT_COPYRIGHT:
-                        MP4TagsSetCopyright( mdata, NULL );
-                        break;
-                    case OPT_DISK:
-                        MP4TagsSetDisk( mdata, NULL );
-                        break;
-                    case OPT_DISKS:
-                        MP4TagsSetDisk( mdata, NULL );
-                        break;
-                    case OPT_ENCODEDBY:
-                        MP4TagsSetEncodedBy( mdata, NULL );
-                        break;
-                    case OPT_TOOL:
-                        MP4TagsSetEncodingTool( mdata, NULL );
-                        break;
-                    case OPT_GENRE:
-                        MP4TagsSetGenre( mdata, NULL );
-                        break;
-                    case OPT_GROUPING:
-                        MP4TagsSetGrouping( mdata, NULL );
-                        break;
-                    case OPT_HD:
-                        MP4TagsSetHDVideo( mdata, NULL );
-                        break;
-                    case OPT_MEDIA_TYPE:
-                        MP4TagsSetMediaType( mdata, NULL );
-                        break;
-                    case OPT_CONTENTID:
-                        MP4TagsSetContentID( mdata, NULL );
-                        break;
-                    case OPT_LONGDESC:
-                        MP4TagsSetLongDescription( mdata, NULL );
-                        break;
-                    case OPT_GENREID:
-                        MP4TagsSetGenreID( mdata, NULL );
-                        break;
-                    case OPT_LYRICS:
-                        MP4TagsSetLyrics( mdata, NULL );
-                        break;
-                    case OPT_DESCRIPTION:
-                        MP4TagsSetDescription( mdata, NULL );
-                        break;
-                    case OPT_TVEPISODE:
-                        MP4TagsSetTVEpisode( mdata, NULL );
-                        break;
-                    case OPT_TVSEASON:
-                        MP4TagsSetTVSeason( mdata, NULL );
-                        break;
-                    case OPT_TVNETWORK:
-                        MP4TagsSetTVNetwork( mdata, NULL );
-                        break;
-                    case OPT_TVEPISODEID:
-                        MP4TagsSetTVEpisodeID( mdata, NULL );
-                        break;
-                    case OPT_PLAYLISTID:
-                        MP4TagsSetPlaylistID( mdata, NULL );
-                        break;
-                    case OPT_PICTURE:
-                        if( mdata->artworkCount )
-                            MP4TagsRemoveArtwork( mdata, 0 );
-                        break;
-                    case OPT_ALBUM_ARTIST:
-                        MP4TagsSetAlbumArtist( mdata, NULL );
-                        break ;
-                    case OPT_NAME:
-                        MP4TagsSetName( mdata, NULL );
-                        break;
-                    case OPT_TVSHOW:
-                        MP4TagsSetTVShow( mdata, NULL );
-                        break;
-                    case OPT_TRACK:
-                        MP4TagsSetTrack( mdata, NULL );
-                        break;
-                    case OPT_TRACKS:
-                        MP4TagsSetTrack( mdata, NULL );
-                        break;
-                    case OPT_XID:
-                        MP4TagsSetXID( mdata, NULL );
-                        break;
-                    case OPT_COMPOSER:
-                        MP4TagsSetComposer( mdata, NULL );
-                        break;
-                    case OPT_RELEASEDATE:
-                        MP4TagsSetReleaseDate( mdata, NULL );
-                        break;
-                    case OPT_ARTISTID:
-                        MP4TagsSetArtistID( mdata, NULL );
-                        break;
-                    case OPT_COMPOSERID:
-                        MP4TagsSetComposerID( mdata, NULL );
-                        break;
-                    case OPT_PODCAST:
-                        MP4TagsSetPodcast( mdata, NULL );
-                        break;
-                    case OPT_CATEGORY:
-                        MP4TagsSetCategory( mdata, NULL );
-                        break;
-                    case OPT_RATING:
-                        MP4TagsSetContentRating( mdata, NULL );
-                        break;
-                    case OPT_SORT_NAME:
-                        MP4TagsSetSortName( mdata, NULL );
-                        break;
-                    case OPT_SORT_ARTIST:
-                        MP4TagsSetSortArtist( mdata, NULL );
-                        break;
-                    case OPT_SORT_ALBUM_ARTIST:
-                        MP4TagsSetSortAlbumArtist( mdata, NULL );
-                        break;
-                    case OPT_SORT_ALBUM:
-                        MP4TagsSetSortAlbum( mdata, NULL );
-                        break;
-                    case OPT_SORT_COMPOSER:
-                        MP4TagsSetSortComposer( mdata, NULL );
-                        break;
-                    case OPT_SORT_TV_SHOW:
-                        MP4TagsSetSortTVShow( mdata, NULL );
-                        break;
-                    case OPT_PURCHASE_DATE:
-                        MP4TagsSetPurchaseDate( mdata, NULL );
-                        break;
-                }
-            }
-        }
-
-        /* Track/disk numbers need to be set all at once, but we'd like to
-           allow users to just specify -T 12 to indicate that all existing
-           track numbers are out of 12.  This means we need to look up the
-           current info if it is not being set. */
-
-        if ( ELEMENT_OF(tags,OPT_TRACK) || ELEMENT_OF(tags,OPT_TRACKS) ) {
-            MP4TagTrack tt;
-            tt.index = 0;
-            tt.total = 0;
-
-            if( mdata->track ) {
-                tt.index = mdata->track->index;
-                tt.total = mdata->track->total;
-            }
+    /* Modify the tags of the non-option arguments as requested, of
+       several files at once with -jobs. */
+    TagBatch batch( argv + prog::optind, tags, nums, long_options, jobs, keepgoing );
+    if ( batch.run( argc - prog::optind ) || batch.numFailed() )
+        return 5;
 
-            if( ELEMENT_OF(tags,OPT_TRACK) )
-                tt.index = static_cast<uint16_t>( ELEMENT_OF(nums,OPT_TRACK) );
-            if( ELEMENT_OF(tags,OPT_TRACKS) )
-                tt.total = static_cast<uint16_t>( ELEMENT_OF(nums,OPT_TRACKS) );
-
-            MP4TagsSetTrack( mdata, &tt );
-        }
-
-        if ( ELEMENT_OF(tags,OPT_DISK) || ELEMENT_OF(tags,OPT_DISKS) ) {
-            MP4TagDisk td;
-            td.index = 0;
-            td.total = 0;
-
-            if( mdata->disk ) {
-                td.index = mdata->disk->index;
-                td.total = mdata->disk->total;
-            }
-
-            if( ELEMENT_OF(tags,OPT_DISK) )
-                td.index = static_cast<uint16_t>( ELEMENT_OF(nums,OPT_DISK) );
-            if( ELEMENT_OF(tags,OPT_DISKS) )
-                td.total = static_cast<uint16_t>( ELEMENT_OF(nums,OPT_DISKS) );
-
-            MP4TagsSetDisk( mdata, &td );
-        }
-
-        /* Set the other relevant attributes */
-        for ( int i = 0;  i < MAX_OPT;  i++ ) {
-            if ( tags[i] ) {
-                switch ( i ) {
-                    case OPT_ALBUM:
-                        MP4TagsSetAlbum( mdata, tags[i] );
-                        break;
-                    case OPT_ARTIST:
-                        MP4TagsSetArtist( mdata, tags[i] );
-                        break;
-                    case OPT_TEMPO:
-                    {
-                        uint16_t value = static_cast<uint16_t>( nums[i] );
-                        MP4TagsSetTempo( mdata, &value );
-                        break;
-                    }
-                    case OPT_COMMENT:
-                        MP4TagsSetComments( mdata, tags[i] );
-                        break;
-                    case OPT_COPYRIGHT:
-                        MP4TagsSetCopyright( mdata, tags[i] );
-                        break;
-                    case OPT_ENCODEDBY:
-                        MP4TagsSetEncodedBy( mdata, tags[i] );
-                        break;
-                    case OPT_TOOL:
-                        MP4TagsSetEncodingTool( mdata, tags[i] );
-                        break;
-                    case OPT_GENRE:
-                        MP4TagsSetGenre( mdata, tags[i] );
-                        break;
-                    case OPT_GROUPING:
-                        MP4TagsSetGrouping( mdata, tags[i] );
-                        break;
-                    case OPT_HD:
-                    {
-                        uint8_t value = static_cast<uint8_t>( nums[i] );
-                        MP4TagsSetHDVideo( mdata, &value );
-                        break;
-                    }
-                    case OPT_MEDIA_TYPE:
-                    {
-                        uint8_t st = static_cast<uint8_t>( itmf::enumStikType.toType( tags[i] ) ) ;
-                        MP4TagsSetMediaType( mdata, &st );
-                        break;
-                    }
-                    case OPT_CONTENTID:
-                    {
-                        uint32_t value = static_cast<uint32_t>( nums[i] );
-                        MP4TagsSetContentID( mdata, &value );
-                        break;
-                    }
-                    case OPT_LONGDESC:
-                        MP4TagsSetLongDescription( mdata, tags[i] );
-                        break;
-                    case OPT_GENREID:
-                    {
-                        uint32_t value = static_cast<uint32_t>( nums[i] );
-                        MP4TagsSetGenreID( mdata, &value );
-                        break;
-                    }
-                    case OPT_LYRICS:
-                        MP4TagsSetLyrics( mdata, tags[i] );
-                        break;
-                    case OPT_DESCRIPTION:
-                        MP4TagsSetDescription( mdata, tags[i] );
-                        break;
-                    case OPT_TVEPISODE:
-                    {
-                        uint32_t value = static_cast<uint32_t>( nums[i] );
-                        MP4TagsSetTVEpisode( mdata, &value );
-                        break;
-                    }
-                    case OPT_TVSEASON:
-                    {
-                        uint32_t value = static_cast<uint32_t>( nums[i] );
-                        MP4TagsSetTVSeason( mdata, &value );
-                        break;
-                    }
-                    case OPT_TVNETWORK:
-                        MP4TagsSetTVNetwork( mdata, tags[i] );
-                        break;
-                    case OPT_TVEPISODEID:
-                        MP4TagsSetTVEpisodeID( mdata, tags[i] );
-                        break;
-                    case OPT_PLAYLISTID:
-                    {
-                        uint64_t value = static_cast<uint64_t>( nums[i] );
-                        MP4TagsSetPlaylistID( mdata, &value );
-                        break;
-                    }
-                    case OPT_PICTURE:
-                    {
-                        File in( tags[i], File::MODE_READ );
-                        if( !in.open() ) {
-                            MP4TagArtwork art;
-                            art.size = (uint32_t)in.size;
-                            art.data = malloc( art.size );
-                            art.type = MP4_ART_UNDEFINED;
-
-                            File::Size nin;
-                            if( !in.read( art.data, art.size, nin ) && nin == art.size ) {
-                                if( mdata->artworkCount )
-                                    MP4TagsRemoveArtwork( mdata, 0 );
-                                MP4TagsAddArtwork( mdata, &art ); 
-                            }
-
-                            free( art.data );
-                            in.close();
-                        }
-                        else {
-                            fprintf( stderr, "Art file %s not found\n", tags[i] );
-                        }
-                        break;
-                    }
-                    case OPT_ALBUM_ARTIST:
-                        MP4TagsSetAlbumArtist( mdata, tags[i] );
-                        break;
-                    case OPT_NAME:
-                        MP4TagsSetName( mdata, tags[i] );
-                        break;
-                    case OPT_TVSHOW:
-                        MP4TagsSetTVShow( mdata, tags[i] );
-                        break;
-                    case OPT_XID:
-                        MP4TagsSetXID( mdata, tags[i] );
-                        break;
-                    case OPT_COMPOSER:
-                        MP4TagsSetComposer( mdata, tags[i] );
-                        break;
-                    case OPT_RELEASEDATE:
-                        MP4TagsSetReleaseDate( mdata, tags[i] );
-                        break;
-                    case OPT_ARTISTID:
-                    {
-                        uint32_t value = static_cast<uint32_t>( nums[i] );
-                        MP4TagsSetArtistID( mdata, &value );
-                        break;
-                    }
-                    case OPT_COMPOSERID:
-                    {
-                        uint32_t value = static_cast<uint32_t>( nums[i] );
-                        MP4TagsSetComposerID( mdata, &value );
-                        break;
-                    }
-                    case OPT_PODCAST:
-                    {
-                        uint8_t value = static_cast<uint8_t>( nums[i] );
-                        MP4TagsSetPodcast( mdata, &value );
-                        break;
-                    }
-                    case OPT_CATEGORY:
-                        MP4TagsSetCategory( mdata, tags[i] );
-                        break;
-                    case OPT_RATING:
-                    {
-                        uint8_t rating = static_cast<uint8_t>( itmf::enumContentRating.toType( tags[i] ) ) ;
-                        MP4TagsSetContentRating( mdata, &rating );
-                        break;
-                    }
-                    case OPT_SORT_NAME:
-                        MP4TagsSetSortName( mdata, tags[i] );
-                        break;
-                    case OPT_SORT_ARTIST:
-                        MP4TagsSetSortArtist( mdata, tags[i] );
-                        break;
-                    case OPT_SORT_ALBUM_ARTIST:
-                        MP4TagsSetSortAlbumArtist( mdata, tags[i] );
-                        break;
-                    case OPT_SORT_ALBUM:
-                        MP4TagsSetSortAlbum( mdata, tags[i] );
-                        break;
-                    case OPT_SORT_COMPOSER:
-                        MP4TagsSetSortComposer( mdata, tags[i] );
-                        break;
-                    case OPT_SORT_TV_SHOW:
-                        MP4TagsSetSortTVShow( mdata, tags[i] );
-                        break;
-                    case OPT_PURCHASE_DATE:
-                        MP4TagsSetPurchaseDate( mdata, tags[i] );
-                        break;
-                }
-            }
-        }
-        /* Write out all tag modifications, free and close */
-        MP4TagsStore( mdata, h );
-        MP4TagsFree( mdata );
-        MP4Close( h );
-    } /* end while optind < argc */
     return 0;
 }
@@ -145,6 +145,7 @@ TrackUtility::TrackUtility( int argc, char** argv )
     _group.add( STD_OPTIMIZE );
     _group.add( STD_DRYRUN );
     _group.add( STD_KEEPGOING );
+    _group.add( STD_JOBS );
     _group.add( STD_OVERWRITE );
     _group.add( STD_FORCE );
     _group.add( STD_QUIET );
@@ -265,7 +266,7 @@ TrackUtility::actionColorParameterList( JobContext& job )
     const int wparm = 6;
     const string sep = "  ";
 
-    if( _jobCount == 0 ) {
+    if( job.index == 0 ) {
         report << setw(widx) << right << "IDX"
                << sep << setw(wid) << "ID"
                << sep << setw(wtype) << left << "TYPE"
@@ -358,12 +359,11 @@ TrackUtility::actionColorParameterRemove( JobContext& job )
             if( qtff::ColorParameterBox::list( job.fileHandle, itemList ))
                 return herrf( "unable to fetch list of colr-boxes" );
 
-            _trackMode = TM_INDEX;
             const qtff::ColorParameterBox::ItemList::size_type max = itemList.size();
             for( qtff::ColorParameterBox::ItemList::size_type i = 0; i < max; i++ ) {
                 const qtff::ColorParameterBox::IndexedItem& xitem = itemList[i];
-                _trackIndex = xitem.trackIndex;
-                actionColorParameterRemove( job );
+                if( qtff::ColorParameterBox::remove( job.fileHandle, xitem.trackIndex ))
+                    return herrf( "unable to remove colr-box\n" );
             }
             break;
         }
@@ -424,7 +424,7 @@ bool
 TrackUtility::actionList( JobContext& job )
 {
     if( _jobTotal > 1 )
-        verbose1f( "file %u of %u: %s\n", _jobCount+1, _jobTotal, job.file.c_str() );
+        verbose1f( "file %u of %u: %s\n", job.index+1, _jobTotal, job.file.c_str() );
 
     job.fileHandle = MP4Read( job.file.c_str() );
     if( job.fileHandle == MP4_INVALID_FILE_HANDLE )
@@ -528,7 +528,7 @@ TrackUtility::actionPictureAspectRatioList( JobContext& job )
     const int wparm = 6;
     const string sep = "  ";
 
-    if( _jobCount == 0 ) {
+    if( job.index == 0 ) {
         report << setw(widx) << right << "IDX"
                << sep << setw(wid) << "ID"
                << sep << setw(wtype) << left << "TYPE"
@@ -616,12 +616,11 @@ TrackUtility::actionPictureAspectRatioRemove( JobContext& job )
             if( qtff::PictureAspectRatioBox::list( job.fileHandle, itemList ))
                 return herrf( "unable to fetch list of pasp-boxes" );
 
-            _trackMode = TM_INDEX;
             const qtff::PictureAspectRatioBox::ItemList::size_type max = itemList.size();
             for( qtff::PictureAspectRatioBox::ItemList::size_type i = 0; i < max; i++ ) {
                 const qtff::PictureAspectRatioBox::IndexedItem& xitem = itemList[i];
-                _trackIndex = xitem.trackIndex;
-                actionPictureAspectRatioRemove( job );
+                if( qtff::PictureAspectRatioBox::remove( job.fileHandle, xitem.trackIndex ))
+                    return herrf( "unable to remove pasp-box\n" );
             }
             break;
         }
@@ -706,10 +705,11 @@ TrackUtility::actionTrackModifierRemove( JobContext& job )
     if( job.fileHandle == MP4_INVALID_FILE_HANDLE )
         return herrf( "unable to open for write: %s\n", job.file.c_str() );
 
-    if( _trackMode == TM_ID )
-        _trackIndex = MP4FindTrackIndex( job.fileHandle, _trackId );
+    const uint16_t trackIndex = ( _trackMode == TM_ID )
+        ? MP4FindTrackIndex( job.fileHandle, _trackId )
+        : _trackIndex;
 
-    TrackModifier tm( job.fileHandle, _trackIndex );
+    TrackModifier tm( job.fileHandle, trackIndex );
     (tm.*_actionTrackModifierRemove_function)();
 
     return SUCCESS;
@@ -745,10 +745,11 @@ TrackUtility::actionTrackModifierSet( JobContext& job )
     if( job.fileHandle == MP4_INVALID_FILE_HANDLE )
         return herrf( "unable to open for write: %s\n", job.file.c_str() );
 
-    if( _trackMode == TM_ID )
-        _trackIndex = MP4FindTrackIndex( job.fileHandle, _trackId );
+    const uint16_t trackIndex = ( _trackMode == TM_ID )
+        ? MP4FindTrackIndex( job.fileHandle, _trackId )
+        : _trackIndex;
 
-    TrackModifier tm( job.fileHandle, _trackIndex );
+    TrackModifier tm( job.fileHandle, trackIndex );
     (tm.*_actionTrackModifierSet_function)( _actionTrackModifierSet_value );
 
     return SUCCESS;